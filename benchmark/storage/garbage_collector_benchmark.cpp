@@ -52,16 +52,17 @@ class GarbageCollectorBenchmark : public benchmark::Fixture {
 };
 
 // Create a table with 100,000 tuples, then run 100,000 txns running update statements. Then run GC and profile how long
-// the unlinking stage takes for those txns
+// the unlinking stage takes for those txns, with the number of GC workers given by the benchmark argument
 // NOLINTNEXTLINE
 BENCHMARK_DEFINE_F(GarbageCollectorBenchmark, UnlinkTime)(benchmark::State &state) {
+  const auto num_workers = static_cast<uint32_t>(state.range(0));
   // NOLINTNEXTLINE
   for (auto _ : state) {
     // generate our table and instantiate GC
     LargeDataTableBenchmarkObject tested({8, 8, 8}, initial_table_size_, txn_length_, update_select_ratio_,
                                          &block_store_, &buffer_pool_, &generator_, true);
     gc_ = new storage::GarbageCollector(common::ManagedPointer(tested.GetTimestampManager()), DISABLED,
-                                        common::ManagedPointer(tested.GetTxnManager()), DISABLED);
+                                        common::ManagedPointer(tested.GetTxnManager()), DISABLED, num_workers);
 
     // clean up insert txn
     gc_->PerformGarbageCollection();
@@ -154,7 +155,14 @@ BENCHMARK_DEFINE_F(GarbageCollectorBenchmark, HighContention)(benchmark::State &
   state.SetItemsProcessed(state.iterations() * num_txns_ - lag_count);
 }
 
-BENCHMARK_REGISTER_F(GarbageCollectorBenchmark, UnlinkTime)->Unit(benchmark::kMillisecond)->UseManualTime()->MinTime(1);
+BENCHMARK_REGISTER_F(GarbageCollectorBenchmark, UnlinkTime)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime()
+    ->MinTime(1)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4);
 BENCHMARK_REGISTER_F(GarbageCollectorBenchmark, ReclaimTime)
     ->Unit(benchmark::kMillisecond)
     ->UseManualTime()
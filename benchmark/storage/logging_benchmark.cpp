@@ -14,6 +14,12 @@ class LoggingBenchmark : public benchmark::Fixture {
  public:
   void TearDown(const benchmark::State &state) final { unlink(terrier::BenchmarkConfig::logfile_path.data()); }
 
+  // Removes the log files of all the given log streams
+  static void UnlinkLogFiles(const uint32_t num_streams) {
+    for (uint32_t i = 0; i < num_streams; i++)
+      unlink(storage::LogManager::StreamFilePath(terrier::BenchmarkConfig::logfile_path.data(), i).c_str());
+  }
+
   const std::vector<uint16_t> attr_sizes_ = {8, 8, 8, 8, 8, 8, 8, 8, 8, 8};
   const uint32_t initial_table_size_ = 1000000;
   const uint32_t num_txns_ = 100000;
@@ -239,6 +245,50 @@ BENCHMARK_DEFINE_F(LoggingBenchmark, SingleStatementSelect)(benchmark::State &st
   state.SetItemsProcessed(state.iterations() * num_txns_ - abort_count);
 }
 
+/**
+ * Single statement insert throughput with the log split into state.range(0) streams. Redo bandwidth should scale with
+ * the number of streams, as long as there are enough worker threads to feed them.
+ */
+// NOLINTNEXTLINE
+BENCHMARK_DEFINE_F(LoggingBenchmark, MultiStreamInsert)(benchmark::State &state) {
+  uint64_t abort_count = 0;
+  const uint32_t txn_length = 1;
+  const std::vector<double> insert_update_select_ratio = {1, 0, 0};
+  const auto num_streams = static_cast<uint32_t>(state.range(0));
+  // NOLINTNEXTLINE
+  for (auto _ : state) {
+    UnlinkLogFiles(num_streams);
+    log_manager_ = new storage::LogManager(
+        terrier::BenchmarkConfig::logfile_path.data(), num_log_buffers_, log_serialization_interval_,
+        log_persist_interval_, log_persist_threshold_, common::ManagedPointer(&buffer_pool_),
+        common::ManagedPointer<common::DedicatedThreadRegistry>(&thread_registry_), std::chrono::microseconds(1000), 64,
+        num_streams);
+    log_manager_->Start();
+    LargeDataTableBenchmarkObject tested(attr_sizes_, 0, txn_length, insert_update_select_ratio, &block_store_,
+                                         &buffer_pool_, &generator_, true, log_manager_);
+    // log all of the Inserts from table creation
+    log_manager_->ForceFlush();
+
+    gc_ = new storage::GarbageCollector(common::ManagedPointer(tested.GetTimestampManager()), DISABLED,
+                                        common::ManagedPointer(tested.GetTxnManager()), DISABLED);
+    gc_thread_ = new storage::GarbageCollectorThread(common::ManagedPointer(gc_), gc_period_, nullptr);
+    const auto result = tested.SimulateOltp(num_txns_, BenchmarkConfig::num_threads);
+    abort_count += result.first;
+    uint64_t elapsed_ms;
+    {
+      common::ScopedTimer<std::chrono::milliseconds> timer(&elapsed_ms);
+      log_manager_->ForceFlush();
+    }
+    state.SetIterationTime(static_cast<double>(result.second + elapsed_ms) / 1000.0);
+    log_manager_->PersistAndStop();
+    delete log_manager_;
+    delete gc_thread_;
+    delete gc_;
+    UnlinkLogFiles(num_streams);
+  }
+  state.SetItemsProcessed(state.iterations() * num_txns_ - abort_count);
+}
+
 // ----------------------------------------------------------------------------
 // BENCHMARK REGISTRATION
 // ----------------------------------------------------------------------------
@@ -263,6 +313,14 @@ BENCHMARK_REGISTER_F(LoggingBenchmark, SingleStatementSelect)
     ->Unit(benchmark::kMillisecond)
     ->UseManualTime()
     ->MinTime(1);
+BENCHMARK_REGISTER_F(LoggingBenchmark, MultiStreamInsert)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime()
+    ->MinTime(3)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8);
 // clang-format on
 
 }  // namespace terrier
@@ -1,3 +1,4 @@
+#include <string>
 #include <vector>
 
 #include "benchmark/benchmark.h"
@@ -5,6 +6,7 @@
 #include "catalog/catalog_accessor.h"
 #include "common/scoped_timer.h"
 #include "main/db_main.h"
+#include "storage/recovery/checkpoint_manager.h"
 #include "storage/recovery/disk_log_provider.h"
 #include "storage/recovery/recovery_manager.h"
 #include "storage/storage_defs.h"
@@ -14,20 +16,46 @@ namespace terrier {
 
 class RecoveryBenchmark : public benchmark::Fixture {
  public:
-  void SetUp(const benchmark::State &state) final { unlink(terrier::BenchmarkConfig::logfile_path.data()); }
-  void TearDown(const benchmark::State &state) final { unlink(terrier::BenchmarkConfig::logfile_path.data()); }
+  void SetUp(const benchmark::State &state) final {
+    unlink(terrier::BenchmarkConfig::logfile_path.data());
+    RemoveCheckpoint();
+  }
+  void TearDown(const benchmark::State &state) final {
+    unlink(terrier::BenchmarkConfig::logfile_path.data());
+    RemoveCheckpoint();
+  }
 
   const uint32_t initial_table_size_ = 1000000;
   const uint32_t num_txns_ = 100000;
+  // Txns run after the checkpoint, which recovery replays on top of it
+  const uint32_t num_post_checkpoint_txns_ = 10000;
   const uint32_t num_indexes_ = 5;
+  const std::string checkpoint_dir_ = std::string(terrier::BenchmarkConfig::logfile_path) + ".checkpoint";
   std::default_random_engine generator_;
 
+  void RemoveCheckpoint() {
+    storage::CheckpointManager::CheckpointMetadata checkpoint;
+    if (!storage::CheckpointManager::ReadMetadata(checkpoint_dir_, &checkpoint)) return;
+    for (const auto &table : checkpoint.tables_) {
+      unlink(storage::CheckpointManager::TableFilePath(checkpoint_dir_, checkpoint.checkpoint_time_, table).c_str());
+      unlink(
+          storage::CheckpointManager::TupleSlotsFilePath(checkpoint_dir_, checkpoint.checkpoint_time_, table).c_str());
+    }
+    unlink(storage::CheckpointManager::MetadataFilePath(checkpoint_dir_).c_str());
+    rmdir(checkpoint_dir_.c_str());
+  }
+
   /**
    * Runs the recovery benchmark with the provided config
    * @param state benchmark state
    * @param config config to use for test object
+   * @param checkpoint true to take a checkpoint after the workload and recover from it, in which case the duration and
+   *        size of the checkpoint are reported as well
    */
-  void RunBenchmark(benchmark::State *state, const LargeSqlTableTestConfiguration &config) {
+  void RunBenchmark(benchmark::State *state, const LargeSqlTableTestConfiguration &config,
+                    const bool checkpoint = false) {
+    uint64_t checkpoint_ms = 0;
+    uint64_t checkpoint_bytes = 0;
     // NOLINTNEXTLINE
     for (auto _ : *state) {
       // Blow away log file after every benchmark iteration
@@ -51,6 +79,20 @@ class RecoveryBenchmark : public benchmark::Fixture {
       auto *tested =
           new LargeSqlTableTestObject(config, txn_manager.Get(), catalog.Get(), block_store.Get(), &generator_);
       tested->SimulateOltp(num_txns_, BenchmarkConfig::num_threads);
+
+      if (checkpoint) {
+        storage::CheckpointManager checkpoint_manager(
+            catalog, txn_manager, db_main->GetTransactionLayer()->GetTimestampManager(), BenchmarkConfig::num_threads);
+        storage::CheckpointManager::CheckpointMetadata metadata;
+        uint64_t elapsed_ms;
+        {
+          common::ScopedTimer<std::chrono::milliseconds> timer(&elapsed_ms);
+          metadata = checkpoint_manager.TakeCheckpoint(checkpoint_dir_);
+        }
+        checkpoint_ms += elapsed_ms;
+        for (const auto &table : metadata.tables_) checkpoint_bytes += table.num_bytes_;
+        tested->SimulateOltp(num_post_checkpoint_txns_, BenchmarkConfig::num_threads);
+      }
       log_manager->ForceFlush();
 
       // Start a new components with logging disabled, we don't want to log the log replaying
@@ -71,7 +113,8 @@ class RecoveryBenchmark : public benchmark::Fixture {
       storage::DiskLogProvider log_provider(terrier::BenchmarkConfig::logfile_path.data());
       storage::RecoveryManager recovery_manager(
           common::ManagedPointer<storage::AbstractLogProvider>(&log_provider), recovery_catalog, recovery_txn_manager,
-          recovery_deferred_action_manager, recovery_thread_registry, recovery_block_store);
+          recovery_deferred_action_manager, recovery_thread_registry, recovery_block_store,
+          checkpoint ? checkpoint_dir_ : "");
 
       uint64_t elapsed_ms;
       {
@@ -86,7 +129,13 @@ class RecoveryBenchmark : public benchmark::Fixture {
       // DeferredAction
       db_main->GetTransactionLayer()->GetDeferredActionManager()->RegisterDeferredAction([=]() { delete tested; });
     }
-    state->SetItemsProcessed(num_txns_ * state->iterations());
+    state->SetItemsProcessed((checkpoint ? num_txns_ + num_post_checkpoint_txns_ : num_txns_) * state->iterations());
+    if (checkpoint) {
+      state->counters["CheckpointMs"] =
+          benchmark::Counter(static_cast<double>(checkpoint_ms), benchmark::Counter::kAvgIterations);
+      state->counters["CheckpointBytes"] =
+          benchmark::Counter(static_cast<double>(checkpoint_bytes), benchmark::Counter::kAvgIterations);
+    }
   }
 };
 
@@ -126,6 +175,25 @@ BENCHMARK_DEFINE_F(RecoveryBenchmark, HighStress)(benchmark::State &state) {
   RunBenchmark(&state, config);
 }
 
+/**
+ * Same workload as ReadWriteWorkload, but checkpointed at the end of it. Recovery loads the checkpoint and only replays
+ * the txns that ran after it. Reports the duration and size of the checkpoint along with the recovery time.
+ */
+// NOLINTNEXTLINE
+BENCHMARK_DEFINE_F(RecoveryBenchmark, CheckpointRecovery)(benchmark::State &state) {
+  LargeSqlTableTestConfiguration config = LargeSqlTableTestConfiguration::Builder()
+                                              .SetNumDatabases(1)
+                                              .SetNumTables(1)
+                                              .SetMaxColumns(5)
+                                              .SetInitialTableSize(initial_table_size_)
+                                              .SetTxnLength(5)
+                                              .SetInsertUpdateSelectDeleteRatio({0.5, 0.0, 0.5, 0.0})
+                                              .SetVarlenAllowed(true)
+                                              .Build();
+
+  RunBenchmark(&state, config, true);
+}
+
 /**
  * Similar to high-stress workload, blast a narrow table with inserts (1 statements per txn, 100% inserts), but also
  * recovery indexes built on the table
@@ -248,6 +316,10 @@ BENCHMARK_REGISTER_F(RecoveryBenchmark, HighStress)
     ->Unit(benchmark::kMillisecond)
     ->UseManualTime()
     ->MinTime(10);
+BENCHMARK_REGISTER_F(RecoveryBenchmark, CheckpointRecovery)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime()
+    ->MinTime(10);
 BENCHMARK_REGISTER_F(RecoveryBenchmark, IndexRecovery)
     ->Unit(benchmark::kMillisecond)
     ->UseManualTime()
@@ -142,6 +142,32 @@ BENCHMARK_DEFINE_F(LargeTransactionBenchmark, SingleStatementSelect)(benchmark::
   state.SetItemsProcessed(state.iterations() * num_txns_ - abort_count);
 }
 
+/**
+ * Single statement select throughput with a growing number of threads. The txns do next to no work, so this mostly
+ * measures how well beginning and committing txns scales.
+ */
+// NOLINTNEXTLINE
+BENCHMARK_DEFINE_F(LargeTransactionBenchmark, SingleStatementSelectScaling)(benchmark::State &state) {
+  uint64_t abort_count = 0;
+  const uint32_t txn_length = 1;
+  const std::vector<double> insert_update_select_ratio = {0, 0, 1};
+  const auto num_threads = static_cast<uint32_t>(state.range(0));
+  // NOLINTNEXTLINE
+  for (auto _ : state) {
+    LargeDataTableBenchmarkObject tested(attr_sizes_, initial_table_size_, txn_length, insert_update_select_ratio,
+                                         &block_store_, &buffer_pool_, &generator_, true);
+    gc_ = new storage::GarbageCollector(common::ManagedPointer(tested.GetTimestampManager()), DISABLED,
+                                        common::ManagedPointer(tested.GetTxnManager()), DISABLED);
+    gc_thread_ = new storage::GarbageCollectorThread(common::ManagedPointer(gc_), gc_period_, nullptr);
+    const auto result = tested.SimulateOltp(num_txns_, num_threads);
+    abort_count += result.first;
+    state.SetIterationTime(static_cast<double>(result.second) / 1000.0);
+    delete gc_thread_;
+    delete gc_;
+  }
+  state.SetItemsProcessed(state.iterations() * num_txns_ - abort_count);
+}
+
 // ----------------------------------------------------------------------------
 // BENCHMARK REGISTRATION
 // ----------------------------------------------------------------------------
@@ -166,6 +192,15 @@ BENCHMARK_REGISTER_F(LargeTransactionBenchmark, SingleStatementSelect)
     ->Unit(benchmark::kMillisecond)
     ->UseManualTime()
     ->MinTime(1);
+BENCHMARK_REGISTER_F(LargeTransactionBenchmark, SingleStatementSelectScaling)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime()
+    ->MinTime(1)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16);
 // clang-format on
 
 }  // namespace terrier
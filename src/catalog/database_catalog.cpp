@@ -839,11 +839,14 @@ bool DatabaseCatalog::DeleteTable(const common::ManagedPointer<transaction::Tran
   // function comment.
   txn->RegisterCommitAction([=](transaction::DeferredActionManager *deferred_action_manager) {
     deferred_action_manager->RegisterDeferredAction([=]() {
-      deferred_action_manager->RegisterDeferredAction([=]() {
+      deferred_action_manager->RegisterChunkedDeferredAction([=](transaction::timestamp_t /*unused*/) {
         // Defer an action upon commit to delete the table. Delete table will need a double deferral because there could
-        // be transactions not yet unlinked by the GC that depend on the table
+        // be transactions not yet unlinked by the GC that depend on the table. The blocks of a large table are freed a
+        // slice at a time, so that the rest of the GC does not have to wait on it.
+        if (!table_ptr->ReleaseBlocks(DROP_TABLE_BLOCKS_PER_CHUNK)) return false;
         delete schema_ptr;
         delete table_ptr;
+        return true;
       });
     });
   });
@@ -1168,10 +1171,12 @@ bool DatabaseCatalog::DeleteIndex(const common::ManagedPointer<transaction::Tran
         }
         // Unregistering from GC can happen immediately, but we have to double-defer freeing the actual objects
         deferred_action_manager->RegisterDeferredAction([=]() {
-          deferred_action_manager->RegisterDeferredAction([=]() {
-            delete schema_ptr;
-            delete index_ptr;
-          });
+          deferred_action_manager->RegisterDeferredAction(
+              [=]() {
+                delete schema_ptr;
+                delete index_ptr;
+              },
+              transaction::DeferredActionCost::EXPENSIVE);
         });
       });
 
@@ -15,7 +15,7 @@ void IndexIterator::Init() {
   // Initialize projected rows for the index and the table
   TERRIER_ASSERT(!col_oids_.empty(), "There must be at least one col oid!");
   // Table's PR
-  auto table_pri = table_->InitializerForProjectedRow(col_oids_);
+  const auto &table_pri = table_->InitializerForProjectedRow(col_oids_);
   table_buffer_ = exec_ctx_->GetMemoryPool()->AllocateAligned(table_pri.ProjectedRowSize(), alignof(uint64_t), false);
   table_pr_ = table_pri.InitializeRow(table_buffer_);
 
@@ -17,6 +17,7 @@ class TransactionManager;
 }
 
 namespace terrier::storage {
+class CheckpointManager;
 class GarbageCollector;
 }
 
@@ -133,6 +134,7 @@ class Catalog {
  private:
   DISALLOW_COPY_AND_MOVE(Catalog);
   friend class storage::RecoveryManager;
+  friend class storage::CheckpointManager;
   const common::ManagedPointer<transaction::TransactionManager> txn_manager_;
   const common::ManagedPointer<storage::BlockStore> catalog_block_store_;
   const common::ManagedPointer<storage::GarbageCollector> garbage_collector_;
@@ -9,6 +9,8 @@ namespace terrier::catalog {
 
 constexpr uint32_t NULL_OID = 0;  // error return value
 constexpr uint32_t START_OID = 1001;
+// number of blocks of a dropped table freed by each slice of its deferred deletion
+constexpr uint32_t DROP_TABLE_BLOCKS_PER_CHUNK = 64;
 
 // in name order
 STRONG_TYPEDEF(col_oid_t, uint32_t);
@@ -18,6 +18,10 @@
 #include "transaction/transaction_context.h"
 #include "transaction/transaction_defs.h"
 
+namespace terrier::storage {
+class CheckpointManager;
+}
+
 namespace terrier::catalog {
 
 /**
@@ -498,6 +502,7 @@ class DatabaseCatalog {
   friend class Catalog;
   friend class postgres::Builder;
   friend class storage::RecoveryManager;
+  friend class storage::CheckpointManager;
 
   /**
    * Internal function to DatabaseCatalog to disallow concurrent DDL changes. This also disallows older txns to enact
@@ -10,6 +10,7 @@
 #include "execution/exec/execution_context.h"
 #include "execution/sql/runtime_types.h"
 #include "execution/util/execution_common.h"
+#include "storage/varlen_arena.h"
 #include "type/type_id.h"
 #include "util/time_util.h"
 
@@ -253,7 +254,8 @@ struct StringVal : public Val {
     }
     if (str.len_ > storage::VarlenEntry::InlineThreshold()) {
       if (own) {
-        byte *contents = common::AllocationUtil::AllocateAligned(str.len_);
+        // The storage engine takes ownership, and hands the buffer back to the arena once it is no longer visible
+        byte *contents = storage::VarlenArena::Allocate(str.len_);
         std::memcpy(contents, str.Content(), str.len_);
         return terrier::storage::VarlenEntry::Create(contents, str.len_, true);
       }
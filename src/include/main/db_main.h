@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -69,13 +70,15 @@ class DBMain {
      * @param buffer_segment_pool non-null required component
      * @param gc_enabled argument to the TransactionManager
      * @param log_manager argument to the TransactionManager
+     * @param deferred_action_num_workers argument to the DeferredActionManager
      */
     TransactionLayer(const common::ManagedPointer<storage::RecordBufferSegmentPool> buffer_segment_pool,
-                     const bool gc_enabled, const common::ManagedPointer<storage::LogManager> log_manager) {
+                     const bool gc_enabled, const common::ManagedPointer<storage::LogManager> log_manager,
+                     const uint32_t deferred_action_num_workers = 0) {
       TERRIER_ASSERT(buffer_segment_pool != nullptr, "Need a buffer segment pool for Transaction layer.");
       timestamp_manager_ = std::make_unique<transaction::TimestampManager>();
-      deferred_action_manager_ =
-          std::make_unique<transaction::DeferredActionManager>(common::ManagedPointer(timestamp_manager_));
+      deferred_action_manager_ = std::make_unique<transaction::DeferredActionManager>(
+          common::ManagedPointer(timestamp_manager_), deferred_action_num_workers);
       txn_manager_ = std::make_unique<transaction::TransactionManager>(common::ManagedPointer(timestamp_manager_),
                                                                        common::ManagedPointer(deferred_action_manager_),
                                                                        buffer_segment_pool, gc_enabled, log_manager);
@@ -120,15 +123,16 @@ class DBMain {
      * @param block_store_reuse_limit argument to the BlockStore
      * @param use_gc enable GarbageCollector
      * @param log_manager needed for safe destruction of StorageLayer
+     * @param gc_num_workers argument to the GarbageCollector
      */
     StorageLayer(const common::ManagedPointer<TransactionLayer> txn_layer, const uint64_t block_store_size_limit,
                  const uint64_t block_store_reuse_limit, const bool use_gc,
-                 const common::ManagedPointer<storage::LogManager> log_manager)
+                 const common::ManagedPointer<storage::LogManager> log_manager, const uint32_t gc_num_workers = 0)
         : deferred_action_manager_(txn_layer->GetDeferredActionManager()), log_manager_(log_manager) {
       if (use_gc)
-        garbage_collector_ = std::make_unique<storage::GarbageCollector>(txn_layer->GetTimestampManager(),
-                                                                         txn_layer->GetDeferredActionManager(),
-                                                                         txn_layer->GetTransactionManager(), DISABLED);
+        garbage_collector_ = std::make_unique<storage::GarbageCollector>(
+            txn_layer->GetTimestampManager(), txn_layer->GetDeferredActionManager(),
+            txn_layer->GetTransactionManager(), DISABLED, gc_num_workers);
 
       block_store_ = std::make_unique<storage::BlockStore>(block_store_size_limit, block_store_reuse_limit);
     }
@@ -303,16 +307,19 @@ class DBMain {
         log_manager = std::make_unique<storage::LogManager>(
             log_file_path_, num_log_manager_buffers_, std::chrono::microseconds{log_serialization_interval_},
             std::chrono::milliseconds{log_persist_interval_}, log_persist_threshold_,
-            common::ManagedPointer(buffer_segment_pool), common::ManagedPointer(thread_registry));
+            common::ManagedPointer(buffer_segment_pool), common::ManagedPointer(thread_registry),
+            std::chrono::microseconds{log_group_commit_window_}, log_group_commit_size_, num_log_streams_,
+            log_preallocate_size_, log_max_persists_in_flight_, log_segment_size_);
         log_manager->Start();
       }
 
       auto txn_layer = std::make_unique<TransactionLayer>(common::ManagedPointer(buffer_segment_pool), use_gc_,
-                                                          common::ManagedPointer(log_manager));
+                                                          common::ManagedPointer(log_manager),
+                                                          deferred_action_num_workers_);
 
       auto storage_layer =
           std::make_unique<StorageLayer>(common::ManagedPointer(txn_layer), block_store_size_, block_store_reuse_,
-                                         use_gc_, common::ManagedPointer(log_manager));
+                                         use_gc_, common::ManagedPointer(log_manager), gc_num_workers_);
 
       std::unique_ptr<CatalogLayer> catalog_layer = DISABLED;
       if (use_catalog_) {
@@ -326,9 +333,11 @@ class DBMain {
       if (use_gc_thread_) {
         TERRIER_ASSERT(use_gc_ && storage_layer->GetGarbageCollector() != DISABLED,
                        "GarbageCollectorThread needs GarbageCollector.");
-        gc_thread = std::make_unique<storage::GarbageCollectorThread>(storage_layer->GetGarbageCollector(),
-                                                                      std::chrono::milliseconds{gc_interval_},
-                                                                      common::ManagedPointer(metrics_manager));
+        gc_thread = std::make_unique<storage::GarbageCollectorThread>(
+            storage_layer->GetGarbageCollector(), std::chrono::milliseconds{gc_interval_},
+            common::ManagedPointer(metrics_manager), txn_layer->GetTransactionManager(),
+            std::chrono::milliseconds{std::min(gc_interval_min_, gc_interval_)},
+            std::chrono::milliseconds{std::max(gc_interval_max_, gc_interval_)});
       }
 
       std::unique_ptr<optimizer::StatsStorage> stats_storage = DISABLED;
@@ -476,6 +485,60 @@ class DBMain {
       return *this;
     }
 
+    /**
+     * @param value LogManager argument
+     * @return self reference for chaining
+     */
+    Builder &SetLogGroupCommitWindow(const int32_t value) {
+      log_group_commit_window_ = value;
+      return *this;
+    }
+
+    /**
+     * @param value LogManager argument
+     * @return self reference for chaining
+     */
+    Builder &SetLogGroupCommitSize(const uint64_t value) {
+      log_group_commit_size_ = value;
+      return *this;
+    }
+
+    /**
+     * @param value LogManager argument
+     * @return self reference for chaining
+     */
+    Builder &SetNumLogStreams(const uint32_t value) {
+      num_log_streams_ = value;
+      return *this;
+    }
+
+    /**
+     * @param value LogManager argument
+     * @return self reference for chaining
+     */
+    Builder &SetLogPreallocateSize(const uint64_t value) {
+      log_preallocate_size_ = value;
+      return *this;
+    }
+
+    /**
+     * @param value LogManager argument
+     * @return self reference for chaining
+     */
+    Builder &SetLogMaxPersistsInFlight(const uint32_t value) {
+      log_max_persists_in_flight_ = value;
+      return *this;
+    }
+
+    /**
+     * @param value LogManager argument
+     * @return self reference for chaining
+     */
+    Builder &SetLogSegmentSize(const uint64_t value) {
+      log_segment_size_ = value;
+      return *this;
+    }
+
     /**
      * @param value use component
      * @return self reference for chaining
@@ -512,6 +575,24 @@ class DBMain {
       return *this;
     }
 
+    /**
+     * @param value GarbageCollector argument
+     * @return self reference for chaining
+     */
+    Builder &SetGCNumWorkers(const uint32_t value) {
+      gc_num_workers_ = value;
+      return *this;
+    }
+
+    /**
+     * @param value DeferredActionManager argument
+     * @return self reference for chaining
+     */
+    Builder &SetDeferredActionNumWorkers(const uint32_t value) {
+      deferred_action_num_workers_ = value;
+      return *this;
+    }
+
     /**
      * @param value use component
      * @return self reference for chaining
@@ -611,6 +692,12 @@ class DBMain {
     int32_t log_serialization_interval_ = 10;
     int32_t log_persist_interval_ = 10;
     uint64_t log_persist_threshold_ = static_cast<uint64_t>(1 << 20);
+    int32_t log_group_commit_window_ = 1000;
+    uint64_t log_group_commit_size_ = 64;
+    uint32_t num_log_streams_ = 1;
+    uint64_t log_preallocate_size_ = static_cast<uint64_t>(1 << 24);
+    uint32_t log_max_persists_in_flight_ = 0;
+    uint64_t log_segment_size_ = static_cast<uint64_t>(1 << 28);
     bool use_logging_ = false;
     bool use_gc_ = false;
     bool use_catalog_ = false;
@@ -618,6 +705,10 @@ class DBMain {
     uint64_t block_store_size_ = 1e5;
     uint64_t block_store_reuse_ = 1e3;
     int32_t gc_interval_ = 10;
+    int32_t gc_interval_min_ = 10;
+    int32_t gc_interval_max_ = 10;
+    uint32_t gc_num_workers_ = 0;
+    uint32_t deferred_action_num_workers_ = 0;
     bool use_gc_thread_ = false;
     bool use_stats_storage_ = false;
     bool use_execution_ = false;
@@ -649,8 +740,21 @@ class DBMain {
       log_persist_interval_ = settings_manager->GetInt(settings::Param::log_persist_interval);
       log_persist_threshold_ =
           static_cast<uint64_t>(settings_manager->GetInt64(settings::Param::log_persist_threshold));
+      log_group_commit_window_ = settings_manager->GetInt(settings::Param::log_group_commit_window);
+      log_group_commit_size_ = static_cast<uint64_t>(settings_manager->GetInt(settings::Param::log_group_commit_size));
+      num_log_streams_ = static_cast<uint32_t>(settings_manager->GetInt(settings::Param::num_log_streams));
+      log_preallocate_size_ =
+          static_cast<uint64_t>(settings_manager->GetInt64(settings::Param::log_preallocate_size));
+      log_max_persists_in_flight_ =
+          static_cast<uint32_t>(settings_manager->GetInt(settings::Param::log_max_persists_in_flight));
+      log_segment_size_ = static_cast<uint64_t>(settings_manager->GetInt64(settings::Param::log_segment_size));
 
       gc_interval_ = settings_manager->GetInt(settings::Param::gc_interval);
+      gc_interval_min_ = settings_manager->GetInt(settings::Param::gc_interval_min);
+      gc_interval_max_ = settings_manager->GetInt(settings::Param::gc_interval_max);
+      gc_num_workers_ = static_cast<uint32_t>(settings_manager->GetInt(settings::Param::gc_num_workers));
+      deferred_action_num_workers_ =
+          static_cast<uint32_t>(settings_manager->GetInt(settings::Param::deferred_action_num_workers));
 
       network_port_ = static_cast<uint16_t>(settings_manager->GetInt(settings::Param::port));
       optimizer_timeout_ = static_cast<uint64_t>(settings_manager->GetInt(settings::Param::task_execution_timeout));
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "common/resource_tracker.h"
+#include "metrics/abstract_metric.h"
+#include "metrics/metrics_util.h"
+
+namespace terrier::metrics {
+
+/**
+ * Raw data object for holding stats collected for the access observer
+ */
+class AccessObserverMetricRawData : public AbstractRawData {
+ public:
+  void Aggregate(AbstractRawData *const other) override {
+    auto other_db_metric = dynamic_cast<AccessObserverMetricRawData *>(other);
+    if (!other_db_metric->access_observer_data_.empty()) {
+      access_observer_data_.splice(access_observer_data_.cbegin(), other_db_metric->access_observer_data_);
+    }
+  }
+
+  /**
+   * @return the type of the metric this object is holding the data for
+   */
+  MetricsComponent GetMetricType() const override { return MetricsComponent::ACCESS_OBSERVER; }
+
+  /**
+   * Writes the data out to ofstreams
+   * @param outfiles vector of ofstreams to write to that have been opened by the MetricsManager
+   */
+  void ToCSV(std::vector<std::ofstream> *const outfiles) final {
+    TERRIER_ASSERT(outfiles->size() == FILES.size(), "Number of files passed to metric is wrong.");
+    TERRIER_ASSERT(std::count_if(outfiles->cbegin(), outfiles->cend(),
+                                 [](const std::ofstream &outfile) { return !outfile.is_open(); }) == 0,
+                   "Not all files are open.");
+
+    auto &outfile = (*outfiles)[0];
+
+    for (const auto &data : access_observer_data_) {
+      outfile << data.num_blocks_cooled_ << ", " << data.num_blocks_thawed_ << ", " << data.num_wasted_compactions_
+              << ", " << data.num_forced_freezes_ << ", ";
+      data.resource_metrics_.ToCSV(outfile);
+      outfile << std::endl;
+    }
+    access_observer_data_.clear();
+  }
+
+  /**
+   * Files to use for writing to CSV.
+   */
+  static constexpr std::array<std::string_view, 1> FILES = {"./access_observer.csv"};
+  /**
+   * Columns to use for writing to CSV.
+   * Note: This includes the columns for the input feature, but not the output (resource counters)
+   */
+  static constexpr std::array<std::string_view, 1> FEATURE_COLUMNS = {
+      "num_blocks_cooled, num_blocks_thawed, num_wasted_compactions, num_forced_freezes"};
+
+ private:
+  friend class AccessObserverMetric;
+
+  void RecordAccessObserverData(const uint64_t num_blocks_cooled, const uint64_t num_blocks_thawed,
+                                const uint64_t num_wasted_compactions, const uint64_t num_forced_freezes,
+                                const common::ResourceTracker::Metrics &resource_metrics) {
+    access_observer_data_.emplace_front(num_blocks_cooled, num_blocks_thawed, num_wasted_compactions,
+                                        num_forced_freezes, resource_metrics);
+  }
+
+  struct AccessObserverData {
+    AccessObserverData(const uint64_t num_blocks_cooled, const uint64_t num_blocks_thawed,
+                       const uint64_t num_wasted_compactions, const uint64_t num_forced_freezes,
+                       const common::ResourceTracker::Metrics &resource_metrics)
+        : num_blocks_cooled_(num_blocks_cooled),
+          num_blocks_thawed_(num_blocks_thawed),
+          num_wasted_compactions_(num_wasted_compactions),
+          num_forced_freezes_(num_forced_freezes),
+          resource_metrics_(resource_metrics) {}
+    const uint64_t num_blocks_cooled_;
+    const uint64_t num_blocks_thawed_;
+    const uint64_t num_wasted_compactions_;
+    const uint64_t num_forced_freezes_;
+    const common::ResourceTracker::Metrics resource_metrics_;
+  };
+
+  std::list<AccessObserverData> access_observer_data_;
+};
+
+/**
+ * Metrics for the access observer: blocks it decided were cold, and how often that decision turned out to be wrong
+ */
+class AccessObserverMetric : public AbstractMetric<AccessObserverMetricRawData> {
+ private:
+  friend class MetricsStore;
+
+  void RecordAccessObserverData(const uint64_t num_blocks_cooled, const uint64_t num_blocks_thawed,
+                                const uint64_t num_wasted_compactions, const uint64_t num_forced_freezes,
+                                const common::ResourceTracker::Metrics &resource_metrics) {
+    GetRawData()->RecordAccessObserverData(num_blocks_cooled, num_blocks_thawed, num_wasted_compactions,
+                                           num_forced_freezes, resource_metrics);
+  }
+};
+}  // namespace terrier::metrics
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "common/resource_tracker.h"
+#include "metrics/abstract_metric.h"
+#include "metrics/metrics_util.h"
+
+namespace terrier::metrics {
+
+/**
+ * Raw data object for holding stats collected for the block eviction manager
+ */
+class BlockEvictionMetricRawData : public AbstractRawData {
+ public:
+  void Aggregate(AbstractRawData *const other) override {
+    auto other_db_metric = dynamic_cast<BlockEvictionMetricRawData *>(other);
+    if (!other_db_metric->eviction_data_.empty()) {
+      eviction_data_.splice(eviction_data_.cbegin(), other_db_metric->eviction_data_);
+    }
+  }
+
+  /**
+   * @return the type of the metric this object is holding the data for
+   */
+  MetricsComponent GetMetricType() const override { return MetricsComponent::BLOCK_EVICTION; }
+
+  /**
+   * Writes the data out to ofstreams
+   * @param outfiles vector of ofstreams to write to that have been opened by the MetricsManager
+   */
+  void ToCSV(std::vector<std::ofstream> *const outfiles) final {
+    TERRIER_ASSERT(outfiles->size() == FILES.size(), "Number of files passed to metric is wrong.");
+    TERRIER_ASSERT(std::count_if(outfiles->cbegin(), outfiles->cend(),
+                                 [](const std::ofstream &outfile) { return !outfile.is_open(); }) == 0,
+                   "Not all files are open.");
+
+    auto &outfile = (*outfiles)[0];
+
+    for (const auto &data : eviction_data_) {
+      outfile << data.num_evicted_ << ", " << data.num_hits_ << ", " << data.num_misses_ << ", "
+              << data.num_bytes_written_ << ", " << data.num_bytes_read_ << ", ";
+      data.resource_metrics_.ToCSV(outfile);
+      outfile << std::endl;
+    }
+    eviction_data_.clear();
+  }
+
+  /**
+   * Files to use for writing to CSV.
+   */
+  static constexpr std::array<std::string_view, 1> FILES = {"./block_eviction.csv"};
+  /**
+   * Columns to use for writing to CSV.
+   * Note: This includes the columns for the input feature, but not the output (resource counters)
+   */
+  static constexpr std::array<std::string_view, 1> FEATURE_COLUMNS = {
+      "num_evicted, num_hits, num_misses, num_bytes_written, num_bytes_read"};
+
+ private:
+  friend class BlockEvictionMetric;
+
+  void RecordEvictionData(const uint64_t num_evicted, const uint64_t num_hits, const uint64_t num_misses,
+                          const uint64_t num_bytes_written, const uint64_t num_bytes_read,
+                          const common::ResourceTracker::Metrics &resource_metrics) {
+    eviction_data_.emplace_front(num_evicted, num_hits, num_misses, num_bytes_written, num_bytes_read,
+                                 resource_metrics);
+  }
+
+  struct EvictionData {
+    EvictionData(const uint64_t num_evicted, const uint64_t num_hits, const uint64_t num_misses,
+                 const uint64_t num_bytes_written, const uint64_t num_bytes_read,
+                 const common::ResourceTracker::Metrics &resource_metrics)
+        : num_evicted_(num_evicted),
+          num_hits_(num_hits),
+          num_misses_(num_misses),
+          num_bytes_written_(num_bytes_written),
+          num_bytes_read_(num_bytes_read),
+          resource_metrics_(resource_metrics) {}
+    const uint64_t num_evicted_;
+    const uint64_t num_hits_;
+    const uint64_t num_misses_;
+    const uint64_t num_bytes_written_;
+    const uint64_t num_bytes_read_;
+    const common::ResourceTracker::Metrics resource_metrics_;
+  };
+
+  std::list<EvictionData> eviction_data_;
+};
+
+/**
+ * Metrics for the block eviction manager: blocks evicted, and accesses to evicted blocks that were still in memory
+ * (hits) or had to be read back from disk (misses)
+ */
+class BlockEvictionMetric : public AbstractMetric<BlockEvictionMetricRawData> {
+ private:
+  friend class MetricsStore;
+
+  void RecordEvictionData(const uint64_t num_evicted, const uint64_t num_hits, const uint64_t num_misses,
+                          const uint64_t num_bytes_written, const uint64_t num_bytes_read,
+                          const common::ResourceTracker::Metrics &resource_metrics) {
+    GetRawData()->RecordEvictionData(num_evicted, num_hits, num_misses, num_bytes_written, num_bytes_read,
+                                     resource_metrics);
+  }
+};
+}  // namespace terrier::metrics
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "common/resource_tracker.h"
+#include "metrics/abstract_metric.h"
+#include "metrics/metrics_util.h"
+
+namespace terrier::metrics {
+
+/**
+ * Raw data object for holding stats collected for the block compactor
+ */
+class CompactionMetricRawData : public AbstractRawData {
+ public:
+  void Aggregate(AbstractRawData *const other) override {
+    auto other_db_metric = dynamic_cast<CompactionMetricRawData *>(other);
+    if (!other_db_metric->compaction_data_.empty()) {
+      compaction_data_.splice(compaction_data_.cbegin(), other_db_metric->compaction_data_);
+    }
+  }
+
+  /**
+   * @return the type of the metric this object is holding the data for
+   */
+  MetricsComponent GetMetricType() const override { return MetricsComponent::COMPACTION; }
+
+  /**
+   * Writes the data out to ofstreams
+   * @param outfiles vector of ofstreams to write to that have been opened by the MetricsManager
+   */
+  void ToCSV(std::vector<std::ofstream> *const outfiles) final {
+    TERRIER_ASSERT(outfiles->size() == FILES.size(), "Number of files passed to metric is wrong.");
+    TERRIER_ASSERT(std::count_if(outfiles->cbegin(), outfiles->cend(),
+                                 [](const std::ofstream &outfile) { return !outfile.is_open(); }) == 0,
+                   "Not all files are open.");
+
+    auto &outfile = (*outfiles)[0];
+
+    for (const auto &data : compaction_data_) {
+      outfile << data.num_groups_ << ", " << data.num_groups_aborted_ << ", " << data.num_blocks_compacted_ << ", "
+              << data.num_tuples_moved_ << ", " << data.num_blocks_emptied_ << ", " << data.num_blocks_frozen_ << ", ";
+      data.resource_metrics_.ToCSV(outfile);
+      outfile << std::endl;
+    }
+    compaction_data_.clear();
+  }
+
+  /**
+   * Files to use for writing to CSV.
+   */
+  static constexpr std::array<std::string_view, 1> FILES = {"./compaction.csv"};
+  /**
+   * Columns to use for writing to CSV.
+   * Note: This includes the columns for the input feature, but not the output (resource counters)
+   */
+  static constexpr std::array<std::string_view, 1> FEATURE_COLUMNS = {
+      "num_groups, num_groups_aborted, num_blocks_compacted, num_tuples_moved, num_blocks_emptied, num_blocks_frozen"};
+
+ private:
+  friend class CompactionMetric;
+
+  void RecordCompactionData(const uint64_t num_groups, const uint64_t num_groups_aborted,
+                            const uint64_t num_blocks_compacted, const uint64_t num_tuples_moved,
+                            const uint64_t num_blocks_emptied, const uint64_t num_blocks_frozen,
+                            const common::ResourceTracker::Metrics &resource_metrics) {
+    compaction_data_.emplace_front(num_groups, num_groups_aborted, num_blocks_compacted, num_tuples_moved,
+                                   num_blocks_emptied, num_blocks_frozen, resource_metrics);
+  }
+
+  struct CompactionData {
+    CompactionData(const uint64_t num_groups, const uint64_t num_groups_aborted, const uint64_t num_blocks_compacted,
+                   const uint64_t num_tuples_moved, const uint64_t num_blocks_emptied, const uint64_t num_blocks_frozen,
+                   const common::ResourceTracker::Metrics &resource_metrics)
+        : num_groups_(num_groups),
+          num_groups_aborted_(num_groups_aborted),
+          num_blocks_compacted_(num_blocks_compacted),
+          num_tuples_moved_(num_tuples_moved),
+          num_blocks_emptied_(num_blocks_emptied),
+          num_blocks_frozen_(num_blocks_frozen),
+          resource_metrics_(resource_metrics) {}
+    const uint64_t num_groups_;
+    const uint64_t num_groups_aborted_;
+    const uint64_t num_blocks_compacted_;
+    const uint64_t num_tuples_moved_;
+    const uint64_t num_blocks_emptied_;
+    const uint64_t num_blocks_frozen_;
+    const common::ResourceTracker::Metrics resource_metrics_;
+  };
+
+  std::list<CompactionData> compaction_data_;
+};
+
+/**
+ * Metrics for the block compactor: compaction groups processed, tuples moved, and blocks emptied or frozen as a result
+ */
+class CompactionMetric : public AbstractMetric<CompactionMetricRawData> {
+ private:
+  friend class MetricsStore;
+
+  void RecordCompactionData(const uint64_t num_groups, const uint64_t num_groups_aborted,
+                            const uint64_t num_blocks_compacted, const uint64_t num_tuples_moved,
+                            const uint64_t num_blocks_emptied, const uint64_t num_blocks_frozen,
+                            const common::ResourceTracker::Metrics &resource_metrics) {
+    GetRawData()->RecordCompactionData(num_groups, num_groups_aborted, num_blocks_compacted, num_tuples_moved,
+                                       num_blocks_emptied, num_blocks_frozen, resource_metrics);
+  }
+};
+}  // namespace terrier::metrics
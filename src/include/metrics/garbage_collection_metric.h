@@ -28,6 +28,12 @@ class GarbageCollectionMetricRawData : public AbstractRawData {
     if (!other_db_metric->unlink_data_.empty()) {
       unlink_data_.splice(unlink_data_.cbegin(), other_db_metric->unlink_data_);
     }
+    if (!other_db_metric->unlink_worker_data_.empty()) {
+      unlink_worker_data_.splice(unlink_worker_data_.cbegin(), other_db_metric->unlink_worker_data_);
+    }
+    if (!other_db_metric->interval_data_.empty()) {
+      interval_data_.splice(interval_data_.cbegin(), other_db_metric->interval_data_);
+    }
   }
 
   /**
@@ -47,6 +53,8 @@ class GarbageCollectionMetricRawData : public AbstractRawData {
 
     auto &serializer_outfile = (*outfiles)[0];
     auto &consumer_outfile = (*outfiles)[1];
+    auto &worker_outfile = (*outfiles)[2];
+    auto &interval_outfile = (*outfiles)[3];
 
     for (const auto &data : deallocate_data_) {
       serializer_outfile << data.num_processed_ << ", ";
@@ -58,20 +66,35 @@ class GarbageCollectionMetricRawData : public AbstractRawData {
       data.resource_metrics_.ToCSV(consumer_outfile);
       consumer_outfile << std::endl;
     }
+    for (const auto &data : unlink_worker_data_) {
+      worker_outfile << data.worker_id_ << ", " << data.num_buffers_ << ", ";
+      data.resource_metrics_.ToCSV(worker_outfile);
+      worker_outfile << std::endl;
+    }
+    for (const auto &data : interval_data_) {
+      interval_outfile << data.interval_ms_ << ", " << data.num_txns_ << ", " << data.undo_bytes_ << ", "
+                       << data.avg_chain_length_ << ", ";
+      data.resource_metrics_.ToCSV(interval_outfile);
+      interval_outfile << std::endl;
+    }
     deallocate_data_.clear();
     unlink_data_.clear();
+    unlink_worker_data_.clear();
+    interval_data_.clear();
   }
 
   /**
    * Files to use for writing to CSV.
    */
-  static constexpr std::array<std::string_view, 2> FILES = {"./gc_deallocate.csv", "./gc_unlink.csv"};
+  static constexpr std::array<std::string_view, 4> FILES = {"./gc_deallocate.csv", "./gc_unlink.csv",
+                                                            "./gc_unlink_worker.csv", "./gc_interval.csv"};
   /**
    * Columns to use for writing to CSV.
    * Note: This includes the columns for the input feature, but not the output (resource counters)
    */
-  static constexpr std::array<std::string_view, 2> FEATURE_COLUMNS = {"num_processed",
-                                                                      "num_processed, num_buffers, num_readonly"};
+  static constexpr std::array<std::string_view, 4> FEATURE_COLUMNS = {
+      "num_processed", "num_processed, num_buffers, num_readonly", "worker_id, num_buffers",
+      "interval_ms, num_txns, undo_bytes, avg_chain_length"};
 
  private:
   friend class GarbageCollectionMetric;
@@ -86,6 +109,16 @@ class GarbageCollectionMetricRawData : public AbstractRawData {
     unlink_data_.emplace_front(num_processed, num_buffers, num_readonly, resource_metrics);
   }
 
+  void RecordUnlinkWorkerData(const uint32_t worker_id, const uint64_t num_buffers,
+                              const common::ResourceTracker::Metrics &resource_metrics) {
+    unlink_worker_data_.emplace_front(worker_id, num_buffers, resource_metrics);
+  }
+
+  void RecordIntervalData(const uint64_t interval_ms, const uint64_t num_txns, const uint64_t undo_bytes,
+                          const double avg_chain_length, const common::ResourceTracker::Metrics &resource_metrics) {
+    interval_data_.emplace_front(interval_ms, num_txns, undo_bytes, avg_chain_length, resource_metrics);
+  }
+
   struct DeallocateData {
     DeallocateData(const uint64_t num_processed, const common::ResourceTracker::Metrics &resource_metrics)
         : num_processed_(num_processed), resource_metrics_(resource_metrics) {}
@@ -106,12 +139,39 @@ class GarbageCollectionMetricRawData : public AbstractRawData {
     const common::ResourceTracker::Metrics resource_metrics_;
   };
 
+  struct UnlinkWorkerData {
+    UnlinkWorkerData(const uint32_t worker_id, const uint64_t num_buffers,
+                     const common::ResourceTracker::Metrics &resource_metrics)
+        : worker_id_(worker_id), num_buffers_(num_buffers), resource_metrics_(resource_metrics) {}
+    const uint32_t worker_id_;
+    const uint64_t num_buffers_;
+    const common::ResourceTracker::Metrics resource_metrics_;
+  };
+
+  struct IntervalData {
+    IntervalData(const uint64_t interval_ms, const uint64_t num_txns, const uint64_t undo_bytes,
+                 const double avg_chain_length, const common::ResourceTracker::Metrics &resource_metrics)
+        : interval_ms_(interval_ms),
+          num_txns_(num_txns),
+          undo_bytes_(undo_bytes),
+          avg_chain_length_(avg_chain_length),
+          resource_metrics_(resource_metrics) {}
+    const uint64_t interval_ms_;
+    const uint64_t num_txns_;
+    const uint64_t undo_bytes_;
+    const double avg_chain_length_;
+    const common::ResourceTracker::Metrics resource_metrics_;
+  };
+
   std::list<DeallocateData> deallocate_data_;
   std::list<UnlinkData> unlink_data_;
+  std::list<UnlinkWorkerData> unlink_worker_data_;
+  std::list<IntervalData> interval_data_;
 };
 
 /**
- * Metrics for the garbage collection components of the system: currently deallocation and unlinking
+ * Metrics for the garbage collection components of the system: currently deallocation and unlinking, the latter also
+ * broken down by GC worker, and the interval the GC thread picks between invocations
  */
 class GarbageCollectionMetric : public AbstractMetric<GarbageCollectionMetricRawData> {
  private:
@@ -124,5 +184,13 @@ class GarbageCollectionMetric : public AbstractMetric<GarbageCollectionMetricRaw
                         const common::ResourceTracker::Metrics &resource_metrics) {
     GetRawData()->RecordUnlinkData(num_processed, num_buffers, num_readonly, resource_metrics);
   }
+  void RecordUnlinkWorkerData(const uint32_t worker_id, const uint64_t num_buffers,
+                              const common::ResourceTracker::Metrics &resource_metrics) {
+    GetRawData()->RecordUnlinkWorkerData(worker_id, num_buffers, resource_metrics);
+  }
+  void RecordIntervalData(const uint64_t interval_ms, const uint64_t num_txns, const uint64_t undo_bytes,
+                          const double avg_chain_length, const common::ResourceTracker::Metrics &resource_metrics) {
+    GetRawData()->RecordIntervalData(interval_ms, num_txns, undo_bytes, avg_chain_length, resource_metrics);
+  }
 };
 }  // namespace terrier::metrics
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "common/macros.h"
+
+namespace terrier::metrics {
+
+/**
+ * HDR-style histogram of latencies in microseconds. Values are bucketed by their magnitude (power of two), and within a
+ * magnitude linearly into SUB_BUCKETS sub-buckets. Every bucket is thus at most 1/SUB_BUCKETS as wide as its lower
+ * bound, so percentiles read off the histogram are off by at most that much, while the histogram keeps a small fixed
+ * size no matter how many values it has seen or how far apart they are.
+ */
+class LatencyHistogram {
+ public:
+  /**
+   * Number of linear sub-buckets per power of two, as a power of two itself
+   */
+  static constexpr uint32_t SUB_BUCKET_BITS = 3;
+  /**
+   * Number of linear sub-buckets per power of two
+   */
+  static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+  /**
+   * Number of buckets. Values under SUB_BUCKETS have a bucket each, and every power of two past them SUB_BUCKETS.
+   */
+  static constexpr uint32_t NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  /**
+   * Counts a value
+   * @param value latency in microseconds
+   */
+  void Record(const uint64_t value) {
+    counts_[BucketOf(value)]++;
+    total_count_++;
+  }
+
+  /**
+   * Adds the counts of another histogram to this one, and clears the other one
+   * @param other histogram to take the counts of
+   */
+  void Merge(LatencyHistogram *const other) {
+    for (uint32_t i = 0; i < NUM_BUCKETS; i++) counts_[i] += other->counts_[i];
+    total_count_ += other->total_count_;
+    other->Reset();
+  }
+
+  /**
+   * Clears all counts
+   */
+  void Reset() {
+    counts_.fill(0);
+    total_count_ = 0;
+  }
+
+  /**
+   * @return number of values counted
+   */
+  uint64_t TotalCount() const { return total_count_; }
+
+  /**
+   * @param bucket index of the bucket
+   * @return number of values counted in the bucket
+   */
+  uint64_t BucketCount(const uint32_t bucket) const { return counts_[bucket]; }
+
+  /**
+   * @param bucket index of the bucket
+   * @return smallest value counted in the bucket
+   */
+  static uint64_t BucketLowerBound(const uint32_t bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    const uint32_t shift = bucket / SUB_BUCKETS - 1;
+    return static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+  }
+
+  /**
+   * @param bucket index of the bucket
+   * @return largest value counted in the bucket
+   */
+  static uint64_t BucketUpperBound(const uint32_t bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    const uint32_t shift = bucket / SUB_BUCKETS - 1;
+    return BucketLowerBound(bucket) + ((UINT64_C(1) << shift) - 1);
+  }
+
+  /**
+   * @param value latency in microseconds
+   * @return index of the bucket the value is counted in
+   */
+  static uint32_t BucketOf(const uint64_t value) {
+    if (value < SUB_BUCKETS) return static_cast<uint32_t>(value);
+    // Position of the highest set bit, at least SUB_BUCKET_BITS here
+    const auto magnitude = static_cast<uint32_t>(63 - __builtin_clzll(value));
+    const uint32_t shift = magnitude - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + static_cast<uint32_t>(value >> shift) - SUB_BUCKETS;
+  }
+
+  /**
+   * @param percentile percentile to look up, between 0 and 100
+   * @return largest value of the bucket the percentile falls into, or 0 if nothing is counted
+   */
+  uint64_t ValueAtPercentile(const double percentile) const {
+    TERRIER_ASSERT(percentile >= 0 && percentile <= 100, "percentile out of range");
+    if (total_count_ == 0) return 0;
+    // Number of values at or below the percentile, at least one
+    auto rank = static_cast<uint64_t>(std::ceil(percentile / 100 * static_cast<double>(total_count_)));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < NUM_BUCKETS; i++) {
+      seen += counts_[i];
+      if (seen >= rank) return BucketUpperBound(i);
+    }
+    return BucketUpperBound(NUM_BUCKETS - 1);
+  }
+
+ private:
+  std::array<uint64_t, NUM_BUCKETS> counts_{};
+  uint64_t total_count_ = 0;
+};
+
+}  // namespace terrier::metrics
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <chrono>  //NOLINT
 #include <fstream>
 #include <list>
@@ -10,6 +11,8 @@
 #include "catalog/catalog_defs.h"
 #include "common/resource_tracker.h"
 #include "metrics/abstract_metric.h"
+#include "metrics/latency_histogram.h"
+#include "metrics/metrics_defs.h"
 #include "metrics/metrics_util.h"
 #include "transaction/transaction_defs.h"
 
@@ -28,6 +31,12 @@ class LoggingMetricRawData : public AbstractRawData {
     if (!other_db_metric->consumer_data_.empty()) {
       consumer_data_.splice(consumer_data_.cbegin(), other_db_metric->consumer_data_);
     }
+    for (uint32_t i = 0; i < PERSIST_LATENCY_BUCKETS; i++) {
+      persist_latency_histogram_[i] += other_db_metric->persist_latency_histogram_[i];
+      other_db_metric->persist_latency_histogram_[i] = 0;
+    }
+    for (uint8_t stage = 0; stage < NUM_COMMIT_STAGES; stage++)
+      commit_latency_histograms_[stage].Merge(&other_db_metric->commit_latency_histograms_[stage]);
   }
 
   /**
@@ -47,6 +56,9 @@ class LoggingMetricRawData : public AbstractRawData {
 
     auto &serializer_outfile = (*outfiles)[0];
     auto &consumer_outfile = (*outfiles)[1];
+    auto &persist_latency_outfile = (*outfiles)[2];
+    auto &commit_latency_outfile = (*outfiles)[3];
+    auto &commit_latency_summary_outfile = (*outfiles)[4];
 
     for (const auto &data : serializer_data_) {
       serializer_outfile << data.num_bytes_ << ", " << data.num_records_ << ", ";
@@ -58,21 +70,65 @@ class LoggingMetricRawData : public AbstractRawData {
       data.resource_metrics_.ToCSV(consumer_outfile);
       consumer_outfile << std::endl;
     }
+    // Nothing is timed for the histogram, the resource columns are only written to keep the files in the same shape
+    const common::ResourceTracker::Metrics no_resource_metrics{};
+    for (uint32_t i = 0; i < PERSIST_LATENCY_BUCKETS; i++) {
+      if (persist_latency_histogram_[i] == 0) continue;
+      const uint64_t lower = i == 0 ? 0 : UINT64_C(1) << (i - 1);
+      persist_latency_outfile << lower << ", " << (UINT64_C(1) << i) << ", " << persist_latency_histogram_[i] << ", ";
+      no_resource_metrics.ToCSV(persist_latency_outfile);
+      persist_latency_outfile << std::endl;
+    }
+    for (uint8_t stage = 0; stage < NUM_COMMIT_STAGES; stage++) {
+      const auto &histogram = commit_latency_histograms_[stage];
+      if (histogram.TotalCount() == 0) continue;
+      for (uint32_t i = 0; i < LatencyHistogram::NUM_BUCKETS; i++) {
+        if (histogram.BucketCount(i) == 0) continue;
+        commit_latency_outfile << COMMIT_STAGE_NAMES[stage] << ", " << LatencyHistogram::BucketLowerBound(i) << ", "
+                               << LatencyHistogram::BucketUpperBound(i) << ", " << histogram.BucketCount(i) << ", ";
+        no_resource_metrics.ToCSV(commit_latency_outfile);
+        commit_latency_outfile << std::endl;
+      }
+      commit_latency_summary_outfile << COMMIT_STAGE_NAMES[stage] << ", " << histogram.TotalCount() << ", "
+                                     << histogram.ValueAtPercentile(50) << ", " << histogram.ValueAtPercentile(90)
+                                     << ", " << histogram.ValueAtPercentile(99) << ", "
+                                     << histogram.ValueAtPercentile(99.9) << ", " << histogram.ValueAtPercentile(100)
+                                     << ", ";
+      no_resource_metrics.ToCSV(commit_latency_summary_outfile);
+      commit_latency_summary_outfile << std::endl;
+    }
     serializer_data_.clear();
     consumer_data_.clear();
+    persist_latency_histogram_.fill(0);
+    for (auto &histogram : commit_latency_histograms_) histogram.Reset();
   }
 
   /**
    * Files to use for writing to CSV.
    */
-  static constexpr std::array<std::string_view, 2> FILES = {"./log_serializer_task.csv",
-                                                            "./disk_log_consumer_task.csv"};
+  static constexpr std::array<std::string_view, 5> FILES = {
+      "./log_serializer_task.csv", "./disk_log_consumer_task.csv", "./log_persist_latency.csv",
+      "./log_commit_latency.csv", "./log_commit_latency_summary.csv"};
   /**
    * Columns to use for writing to CSV.
    * Note: This includes the columns for the input feature, but not the output (resource counters)
    */
-  static constexpr std::array<std::string_view, 2> FEATURE_COLUMNS = {"num_bytes, num_records",
-                                                                      "num_bytes, num_buffers"};
+  static constexpr std::array<std::string_view, 5> FEATURE_COLUMNS = {
+      "num_bytes, num_records", "num_bytes, num_buffers", "latency_lower_us, latency_upper_us, num_persists",
+      "stage, latency_lower_us, latency_upper_us, num_commits",
+      "stage, num_commits, p50_us, p90_us, p99_us, p999_us, max_us"};
+
+  /**
+   * Number of buckets of the persist latency histogram. Bucket 0 counts persists under 1us, and bucket i > 0 the ones
+   * that took [2^(i-1), 2^i) us. The last bucket also takes everything slower.
+   */
+  static constexpr uint32_t PERSIST_LATENCY_BUCKETS = 32;
+
+  /**
+   * Names of the commit stages in the CSV files, in the order of CommitStage
+   */
+  static constexpr std::array<std::string_view, NUM_COMMIT_STAGES> COMMIT_STAGE_NAMES = {
+      "serialization_wait", "serialization", "queue_wait", "write", "group_wait", "persist", "callback_dispatch"};
 
  private:
   friend class LoggingMetric;
@@ -88,6 +144,17 @@ class LoggingMetricRawData : public AbstractRawData {
     consumer_data_.emplace_front(num_bytes, num_buffers, resource_metrics);
   }
 
+  void RecordPersistLatency(const uint64_t latency_us) {
+    uint32_t bucket = 0;
+    while (bucket < PERSIST_LATENCY_BUCKETS - 1 && (latency_us >> bucket) != 0) bucket++;
+    persist_latency_histogram_[bucket]++;
+  }
+
+  void RecordCommitLatency(const std::array<uint64_t, NUM_COMMIT_STAGES> &stage_latencies_us) {
+    for (uint8_t stage = 0; stage < NUM_COMMIT_STAGES; stage++)
+      commit_latency_histograms_[stage].Record(stage_latencies_us[stage]);
+  }
+
   struct SerializerData {
     SerializerData(const uint64_t num_bytes, const uint64_t num_records,
                    const common::ResourceTracker::Metrics &resource_metrics)
@@ -108,11 +175,14 @@ class LoggingMetricRawData : public AbstractRawData {
 
   std::list<SerializerData> serializer_data_;
   std::list<ConsumerData> consumer_data_;
+  std::array<uint64_t, PERSIST_LATENCY_BUCKETS> persist_latency_histogram_{};
+  std::array<LatencyHistogram, NUM_COMMIT_STAGES> commit_latency_histograms_;
 };
 
 /**
  * Metrics for the logging components of the system: currently buffer consumer (writes to disk) and the record
- * serializer
+ * serializer, a histogram of how long the consumer's persists take, and histograms of how long sampled synchronous
+ * commits spend in each CommitStage
  */
 class LoggingMetric : public AbstractMetric<LoggingMetricRawData> {
  private:
@@ -126,5 +196,9 @@ class LoggingMetric : public AbstractMetric<LoggingMetricRawData> {
                           const common::ResourceTracker::Metrics &resource_metrics) {
     GetRawData()->RecordConsumerData(num_bytes, num_buffers, resource_metrics);
   }
+  void RecordPersistLatency(const uint64_t latency_us) { GetRawData()->RecordPersistLatency(latency_us); }
+  void RecordCommitLatency(const std::array<uint64_t, NUM_COMMIT_STAGES> &stage_latencies_us) {
+    GetRawData()->RecordCommitLatency(stage_latencies_us);
+  }
 };
 }  // namespace terrier::metrics
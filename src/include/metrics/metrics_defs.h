@@ -5,8 +5,34 @@ namespace terrier::metrics {
 /**
  * Metric types
  */
-enum class MetricsComponent : uint8_t { LOGGING, TRANSACTION, GARBAGECOLLECTION, EXECUTION, EXECUTION_PIPELINE };
+enum class MetricsComponent : uint8_t {
+  LOGGING,
+  TRANSACTION,
+  GARBAGECOLLECTION,
+  EXECUTION,
+  EXECUTION_PIPELINE,
+  BLOCK_EVICTION,
+  COMPACTION,
+  ACCESS_OBSERVER,
+  WRITE_CONFLICT,
+  REPLICATION
+};
 
-constexpr uint8_t NUM_COMPONENTS = 5;
+constexpr uint8_t NUM_COMPONENTS = 10;
+
+/**
+ * Stages a synchronous commit goes through in the log manager, in order, which its latency is broken down into
+ */
+enum class CommitStage : uint8_t {
+  SERIALIZATION_WAIT,  // redo buffer holding the commit record waits for the serializer
+  SERIALIZATION,       // serializer works until it hands over the log buffer holding the commit record
+  QUEUE_WAIT,          // log buffer waits for the consumer
+  WRITE,               // consumer writes the log buffer to the log file
+  GROUP_WAIT,          // written commit waits for the persist of its group to start
+  PERSIST,             // fdatasync of the log file
+  CALLBACK_DISPATCH    // from durable until the commit's callback has been invoked
+};
+
+constexpr uint8_t NUM_COMMIT_STAGES = 7;
 
 }  // namespace terrier::metrics
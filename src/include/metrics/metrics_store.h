@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <bitset>
 #include <memory>
 #include <unordered_map>
@@ -10,12 +11,17 @@
 #include "execution/exec_defs.h"
 #include "metrics/abstract_metric.h"
 #include "metrics/abstract_raw_data.h"
+#include "metrics/access_observer_metric.h"
+#include "metrics/block_eviction_metric.h"
+#include "metrics/compaction_metric.h"
 #include "metrics/execution_metric.h"
 #include "metrics/garbage_collection_metric.h"
 #include "metrics/logging_metric.h"
 #include "metrics/metrics_defs.h"
 #include "metrics/pipeline_metric.h"
+#include "metrics/replication_metric.h"
 #include "metrics/transaction_metric.h"
+#include "metrics/write_conflict_metric.h"
 
 namespace terrier::metrics {
 
@@ -57,6 +63,25 @@ class MetricsStore {
     logging_metric_->RecordConsumerData(num_bytes, num_records, resource_metrics);
   }
 
+  /**
+   * Record the latency of a persist of the LogConsumerTask
+   * @param latency_us first entry of metrics datapoint
+   */
+  void RecordPersistLatency(const uint64_t latency_us) {
+    TERRIER_ASSERT(ComponentEnabled(MetricsComponent::LOGGING), "LoggingMetric not enabled.");
+    TERRIER_ASSERT(logging_metric_ != nullptr, "LoggingMetric not allocated. Check MetricsStore constructor.");
+    logging_metric_->RecordPersistLatency(latency_us);
+  }
+  /**
+   * Record how long a sampled synchronous commit spent in each stage of the log manager
+   * @param stage_latencies_us first entry of metrics datapoint, indexed by CommitStage
+   */
+  void RecordCommitLatency(const std::array<uint64_t, NUM_COMMIT_STAGES> &stage_latencies_us) {
+    TERRIER_ASSERT(ComponentEnabled(MetricsComponent::LOGGING), "LoggingMetric not enabled.");
+    TERRIER_ASSERT(logging_metric_ != nullptr, "LoggingMetric not allocated. Check MetricsStore constructor.");
+    logging_metric_->RecordCommitLatency(stage_latencies_us);
+  }
+
   /**
    * Record metrics from the GC deallocation
    * @param num_processed first entry of metrics datapoint
@@ -82,6 +107,34 @@ class MetricsStore {
     gc_metric_->RecordUnlinkData(num_processed, num_buffers, num_readonly, resource_metrics);
   }
 
+  /**
+   * Record metrics from a single GC worker's unlinking
+   * @param worker_id first entry of metrics datapoint
+   * @param num_buffers second entry of metrics datapoint
+   * @param resource_metrics third entry of metrics datapoint
+   */
+  void RecordUnlinkWorkerData(const uint32_t worker_id, const uint64_t num_buffers,
+                              const common::ResourceTracker::Metrics &resource_metrics) {
+    TERRIER_ASSERT(ComponentEnabled(MetricsComponent::GARBAGECOLLECTION), "GarbageCollectionMetric not enabled.");
+    TERRIER_ASSERT(gc_metric_ != nullptr, "GarbageCollectionMetric not allocated. Check MetricsStore constructor.");
+    gc_metric_->RecordUnlinkWorkerData(worker_id, num_buffers, resource_metrics);
+  }
+
+  /**
+   * Record the interval picked by the GC thread
+   * @param interval_ms first entry of metrics datapoint
+   * @param num_txns second entry of metrics datapoint
+   * @param undo_bytes third entry of metrics datapoint
+   * @param avg_chain_length fourth entry of metrics datapoint
+   * @param resource_metrics fifth entry of metrics datapoint
+   */
+  void RecordGCIntervalData(const uint64_t interval_ms, const uint64_t num_txns, const uint64_t undo_bytes,
+                            const double avg_chain_length, const common::ResourceTracker::Metrics &resource_metrics) {
+    TERRIER_ASSERT(ComponentEnabled(MetricsComponent::GARBAGECOLLECTION), "GarbageCollectionMetric not enabled.");
+    TERRIER_ASSERT(gc_metric_ != nullptr, "GarbageCollectionMetric not allocated. Check MetricsStore constructor.");
+    gc_metric_->RecordIntervalData(interval_ms, num_txns, undo_bytes, avg_chain_length, resource_metrics);
+  }
+
   /**
    * Record metrics for transaction manager when beginning transaction
    * @param resource_metrics first entry of txn datapoint
@@ -95,12 +148,14 @@ class MetricsStore {
   /**
    * Record metrics for transaction manager when ending transaction
    * @param is_readonly first entry of txn datapoint
-   * @param resource_metrics second entry of txn datapoint
+   * @param synchronous_commit second entry of txn datapoint
+   * @param resource_metrics third entry of txn datapoint
    */
-  void RecordCommitData(const uint64_t is_readonly, const common::ResourceTracker::Metrics &resource_metrics) {
+  void RecordCommitData(const uint64_t is_readonly, const uint64_t synchronous_commit,
+                        const common::ResourceTracker::Metrics &resource_metrics) {
     TERRIER_ASSERT(ComponentEnabled(MetricsComponent::TRANSACTION), "TransactionMetric not enabled.");
     TERRIER_ASSERT(txn_metric_ != nullptr, "TransactionMetric not allocated. Check MetricsStore constructor.");
-    txn_metric_->RecordCommitData(is_readonly, resource_metrics);
+    txn_metric_->RecordCommitData(is_readonly, synchronous_commit, resource_metrics);
   }
 
   /**
@@ -133,6 +188,89 @@ class MetricsStore {
     pipeline_metric_->RecordPipelineData(query_id, pipeline_id, execution_mode, std::move(features), resource_metrics);
   }
 
+  /**
+   * Record metrics from the BlockEvictionManager
+   * @param num_evicted first entry of metrics datapoint
+   * @param num_hits second entry of metrics datapoint
+   * @param num_misses third entry of metrics datapoint
+   * @param num_bytes_written forth entry of metrics datapoint
+   * @param num_bytes_read fifth entry of metrics datapoint
+   * @param resource_metrics sixth entry of metrics datapoint
+   */
+  void RecordEvictionData(const uint64_t num_evicted, const uint64_t num_hits, const uint64_t num_misses,
+                          const uint64_t num_bytes_written, const uint64_t num_bytes_read,
+                          const common::ResourceTracker::Metrics &resource_metrics) {
+    TERRIER_ASSERT(ComponentEnabled(MetricsComponent::BLOCK_EVICTION), "BlockEvictionMetric not enabled.");
+    TERRIER_ASSERT(block_eviction_metric_ != nullptr,
+                   "BlockEvictionMetric not allocated. Check MetricsStore constructor.");
+    block_eviction_metric_->RecordEvictionData(num_evicted, num_hits, num_misses, num_bytes_written, num_bytes_read,
+                                               resource_metrics);
+  }
+
+  /**
+   * Record metrics from the BlockCompactor
+   * @param num_groups first entry of metrics datapoint
+   * @param num_groups_aborted second entry of metrics datapoint
+   * @param num_blocks_compacted third entry of metrics datapoint
+   * @param num_tuples_moved forth entry of metrics datapoint
+   * @param num_blocks_emptied fifth entry of metrics datapoint
+   * @param num_blocks_frozen sixth entry of metrics datapoint
+   * @param resource_metrics seventh entry of metrics datapoint
+   */
+  void RecordCompactionData(const uint64_t num_groups, const uint64_t num_groups_aborted,
+                            const uint64_t num_blocks_compacted, const uint64_t num_tuples_moved,
+                            const uint64_t num_blocks_emptied, const uint64_t num_blocks_frozen,
+                            const common::ResourceTracker::Metrics &resource_metrics) {
+    TERRIER_ASSERT(ComponentEnabled(MetricsComponent::COMPACTION), "CompactionMetric not enabled.");
+    TERRIER_ASSERT(compaction_metric_ != nullptr, "CompactionMetric not allocated. Check MetricsStore constructor.");
+    compaction_metric_->RecordCompactionData(num_groups, num_groups_aborted, num_blocks_compacted, num_tuples_moved,
+                                             num_blocks_emptied, num_blocks_frozen, resource_metrics);
+  }
+
+  /**
+   * Record metrics from the AccessObserver
+   * @param num_blocks_cooled first entry of metrics datapoint
+   * @param num_blocks_thawed second entry of metrics datapoint
+   * @param num_wasted_compactions third entry of metrics datapoint
+   * @param num_forced_freezes forth entry of metrics datapoint
+   * @param resource_metrics fifth entry of metrics datapoint
+   */
+  void RecordAccessObserverData(const uint64_t num_blocks_cooled, const uint64_t num_blocks_thawed,
+                                const uint64_t num_wasted_compactions, const uint64_t num_forced_freezes,
+                                const common::ResourceTracker::Metrics &resource_metrics) {
+    TERRIER_ASSERT(ComponentEnabled(MetricsComponent::ACCESS_OBSERVER), "AccessObserverMetric not enabled.");
+    TERRIER_ASSERT(access_observer_metric_ != nullptr,
+                   "AccessObserverMetric not allocated. Check MetricsStore constructor.");
+    access_observer_metric_->RecordAccessObserverData(num_blocks_cooled, num_blocks_thawed, num_wasted_compactions,
+                                                      num_forced_freezes, resource_metrics);
+  }
+
+  /**
+   * Record a sampled update or delete
+   * @param table_id first entry of metrics datapoint
+   * @param block_id second entry of metrics datapoint
+   * @param offset third entry of metrics datapoint
+   * @param outcome fourth entry of metrics datapoint
+   */
+  void RecordWriteConflictData(const uint64_t table_id, const uint64_t block_id, const uint32_t offset,
+                               const WriteOutcome outcome) {
+    TERRIER_ASSERT(ComponentEnabled(MetricsComponent::WRITE_CONFLICT), "WriteConflictMetric not enabled.");
+    TERRIER_ASSERT(write_conflict_metric_ != nullptr,
+                   "WriteConflictMetric not allocated. Check MetricsStore constructor.");
+    write_conflict_metric_->RecordWriteData(table_id, block_id, offset, outcome);
+  }
+
+  /**
+   * Record the lag of a replica when it acknowledges shipped logs
+   * @param lag_bytes first entry of metrics datapoint
+   * @param lag_us second entry of metrics datapoint
+   */
+  void RecordReplicationLag(const uint64_t lag_bytes, const uint64_t lag_us) {
+    TERRIER_ASSERT(ComponentEnabled(MetricsComponent::REPLICATION), "ReplicationMetric not enabled.");
+    TERRIER_ASSERT(replication_metric_ != nullptr, "ReplicationMetric not allocated. Check MetricsStore constructor.");
+    replication_metric_->RecordReplicationLag(lag_bytes, lag_us);
+  }
+
   /**
    * @param component metrics component to test
    * @return true if metrics enabled for this component, false otherwise
@@ -177,6 +315,11 @@ class MetricsStore {
   std::unique_ptr<GarbageCollectionMetric> gc_metric_;
   std::unique_ptr<ExecutionMetric> execution_metric_;
   std::unique_ptr<PipelineMetric> pipeline_metric_;
+  std::unique_ptr<BlockEvictionMetric> block_eviction_metric_;
+  std::unique_ptr<CompactionMetric> compaction_metric_;
+  std::unique_ptr<AccessObserverMetric> access_observer_metric_;
+  std::unique_ptr<WriteConflictMetric> write_conflict_metric_;
+  std::unique_ptr<ReplicationMetric> replication_metric_;
 
   const std::bitset<NUM_COMPONENTS> &enabled_metrics_;
   const std::array<uint32_t, NUM_COMPONENTS> &sample_interval_;
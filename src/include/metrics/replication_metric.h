@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <list>
+#include <vector>
+
+#include "common/resource_tracker.h"
+#include "metrics/abstract_metric.h"
+#include "metrics/metrics_util.h"
+
+namespace terrier::metrics {
+
+/**
+ * Raw data object for holding stats collected on log shipping to replicas
+ */
+class ReplicationMetricRawData : public AbstractRawData {
+ public:
+  void Aggregate(AbstractRawData *const other) override {
+    auto other_db_metric = dynamic_cast<ReplicationMetricRawData *>(other);
+    if (!other_db_metric->lag_data_.empty()) {
+      lag_data_.splice(lag_data_.cbegin(), other_db_metric->lag_data_);
+    }
+  }
+
+  /**
+   * @return the type of the metric this object is holding the data for
+   */
+  MetricsComponent GetMetricType() const override { return MetricsComponent::REPLICATION; }
+
+  /**
+   * Writes the data out to ofstreams
+   * @param outfiles vector of ofstreams to write to that have been opened by the MetricsManager
+   */
+  void ToCSV(std::vector<std::ofstream> *const outfiles) final {
+    TERRIER_ASSERT(outfiles->size() == FILES.size(), "Number of files passed to metric is wrong.");
+    TERRIER_ASSERT(std::count_if(outfiles->cbegin(), outfiles->cend(),
+                                 [](const std::ofstream &outfile) { return !outfile.is_open(); }) == 0,
+                   "Not all files are open.");
+
+    auto &lag_outfile = (*outfiles)[0];
+    // Nothing is timed here, the resource columns are only written to keep the files in the same shape as the others
+    const common::ResourceTracker::Metrics no_resource_metrics{};
+
+    for (const auto &data : lag_data_) {
+      lag_outfile << data.lag_bytes_ << ", " << static_cast<double>(data.lag_us_) / 1000.0 << ", ";
+      no_resource_metrics.ToCSV(lag_outfile);
+      lag_outfile << std::endl;
+    }
+    lag_data_.clear();
+  }
+
+  /**
+   * Files to use for writing to CSV.
+   */
+  static constexpr std::array<std::string_view, 1> FILES = {"./replication_lag.csv"};
+  /**
+   * Columns to use for writing to CSV.
+   * Note: This includes the columns for the input feature, but not the output (resource counters)
+   */
+  static constexpr std::array<std::string_view, 1> FEATURE_COLUMNS = {"lag_bytes, lag_ms"};
+
+ private:
+  friend class ReplicationMetric;
+  FRIEND_TEST(MetricsTests, ReplicationCSVTest);
+
+  void RecordReplicationLag(const uint64_t lag_bytes, const uint64_t lag_us) {
+    lag_data_.emplace_front(lag_bytes, lag_us);
+  }
+
+  struct LagData {
+    LagData(const uint64_t lag_bytes, const uint64_t lag_us) : lag_bytes_(lag_bytes), lag_us_(lag_us) {}
+    const uint64_t lag_bytes_;
+    const uint64_t lag_us_;
+  };
+
+  std::list<LagData> lag_data_;
+};
+
+/**
+ * Metrics for log shipping: every time a replica acknowledges the logs it has read, how many bytes shipped to it it
+ * has not read yet, and how long ago the last logs it acknowledged were sent
+ */
+class ReplicationMetric : public AbstractMetric<ReplicationMetricRawData> {
+ private:
+  friend class MetricsStore;
+
+  void RecordReplicationLag(const uint64_t lag_bytes, const uint64_t lag_us) {
+    GetRawData()->RecordReplicationLag(lag_bytes, lag_us);
+  }
+};
+}  // namespace terrier::metrics
@@ -52,7 +52,7 @@ class TransactionMetricRawData : public AbstractRawData {
       begin_outfile << std::endl;
     }
     for (const auto &data : commit_data_) {
-      commit_outfile << data.is_readonly_ << ", ";
+      commit_outfile << data.is_readonly_ << ", " << data.synchronous_commit_ << ", ";
       data.resource_metrics_.ToCSV(commit_outfile);
       commit_outfile << std::endl;
     }
@@ -68,7 +68,7 @@ class TransactionMetricRawData : public AbstractRawData {
   /**
    * Columns to use for writing to CSV.
    */
-  static constexpr std::array<std::string_view, 2> FEATURE_COLUMNS = {"", "is_readonly"};
+  static constexpr std::array<std::string_view, 2> FEATURE_COLUMNS = {"", "is_readonly, synchronous_commit"};
 
  private:
   friend class TransactionMetric;
@@ -78,8 +78,9 @@ class TransactionMetricRawData : public AbstractRawData {
     begin_data_.emplace_back(resource_metrics);
   }
 
-  void RecordCommitData(const uint64_t is_readonly, const common::ResourceTracker::Metrics &resource_metrics) {
-    commit_data_.emplace_back(is_readonly, resource_metrics);
+  void RecordCommitData(const uint64_t is_readonly, const uint64_t synchronous_commit,
+                        const common::ResourceTracker::Metrics &resource_metrics) {
+    commit_data_.emplace_back(is_readonly, synchronous_commit, resource_metrics);
   }
 
   struct BeginData {
@@ -89,9 +90,11 @@ class TransactionMetricRawData : public AbstractRawData {
   };
 
   struct CommitData {
-    CommitData(const uint64_t is_readonly, const common::ResourceTracker::Metrics &resource_metrics)
-        : is_readonly_(is_readonly), resource_metrics_(resource_metrics) {}
+    CommitData(const uint64_t is_readonly, const uint64_t synchronous_commit,
+               const common::ResourceTracker::Metrics &resource_metrics)
+        : is_readonly_(is_readonly), synchronous_commit_(synchronous_commit), resource_metrics_(resource_metrics) {}
     const uint64_t is_readonly_;
+    const uint64_t synchronous_commit_;
     const common::ResourceTracker::Metrics resource_metrics_;
   };
 
@@ -109,8 +112,9 @@ class TransactionMetric : public AbstractMetric<TransactionMetricRawData> {
   void RecordBeginData(const common::ResourceTracker::Metrics &resource_metrics) {
     GetRawData()->RecordBeginData(resource_metrics);
   }
-  void RecordCommitData(const uint64_t is_readonly, const common::ResourceTracker::Metrics &resource_metrics) {
-    GetRawData()->RecordCommitData(is_readonly, resource_metrics);
+  void RecordCommitData(const uint64_t is_readonly, const uint64_t synchronous_commit,
+                        const common::ResourceTracker::Metrics &resource_metrics) {
+    GetRawData()->RecordCommitData(is_readonly, synchronous_commit, resource_metrics);
   }
 };
 }  // namespace terrier::metrics
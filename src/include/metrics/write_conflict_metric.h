@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/resource_tracker.h"
+#include "metrics/abstract_metric.h"
+#include "metrics/metrics_util.h"
+
+namespace terrier::metrics {
+
+/**
+ * Outcome of a sampled update or delete
+ */
+enum class WriteOutcome : uint8_t {
+  /** the write went through */
+  SUCCESS,
+  /** another txn owns the tuple, or committed a newer version of it */
+  WRITE_WRITE_CONFLICT,
+  /** the tuple was already deleted */
+  NOT_VISIBLE
+};
+
+/**
+ * Raw data object for holding stats collected on write-write conflicts
+ */
+class WriteConflictMetricRawData : public AbstractRawData {
+ public:
+  void Aggregate(AbstractRawData *const other) override {
+    auto other_db_metric = dynamic_cast<WriteConflictMetricRawData *>(other);
+    for (auto &entry : other_db_metric->table_data_) {
+      auto &table = table_data_[entry.first];
+      table.num_writes_ += entry.second.num_writes_;
+      table.num_conflicts_ += entry.second.num_conflicts_;
+      table.num_not_visible_ += entry.second.num_not_visible_;
+      for (const auto &slot : entry.second.slot_conflicts_) table.slot_conflicts_[slot.first] += slot.second;
+    }
+    other_db_metric->table_data_.clear();
+  }
+
+  /**
+   * @return the type of the metric this object is holding the data for
+   */
+  MetricsComponent GetMetricType() const override { return MetricsComponent::WRITE_CONFLICT; }
+
+  /**
+   * Writes the data out to ofstreams
+   * @param outfiles vector of ofstreams to write to that have been opened by the MetricsManager
+   */
+  void ToCSV(std::vector<std::ofstream> *const outfiles) final {
+    TERRIER_ASSERT(outfiles->size() == FILES.size(), "Number of files passed to metric is wrong.");
+    TERRIER_ASSERT(std::count_if(outfiles->cbegin(), outfiles->cend(),
+                                 [](const std::ofstream &outfile) { return !outfile.is_open(); }) == 0,
+                   "Not all files are open.");
+
+    auto &table_outfile = (*outfiles)[0];
+    auto &hot_row_outfile = (*outfiles)[1];
+    // Nothing is timed here, the resource columns are only written to keep the files in the same shape as the others
+    const common::ResourceTracker::Metrics no_resource_metrics{};
+
+    for (const auto &entry : table_data_) {
+      const auto &table = entry.second;
+      const uint64_t num_failed = table.num_conflicts_ + table.num_not_visible_;
+      const double abort_rate =
+          table.num_writes_ == 0 ? 0.0 : static_cast<double>(num_failed) / static_cast<double>(table.num_writes_);
+      table_outfile << entry.first << ", " << table.num_writes_ << ", " << table.num_conflicts_ << ", "
+                    << table.num_not_visible_ << ", " << abort_rate << ", ";
+      no_resource_metrics.ToCSV(table_outfile);
+      table_outfile << std::endl;
+
+      // Only report the rows that conflicted the most in each table
+      std::vector<std::pair<std::pair<uint64_t, uint32_t>, uint64_t>> hot_rows(table.slot_conflicts_.cbegin(),
+                                                                                table.slot_conflicts_.cend());
+      const auto num_hot_rows = std::min<size_t>(hot_rows.size(), HOT_ROWS_PER_TABLE);
+      std::partial_sort(hot_rows.begin(), hot_rows.begin() + num_hot_rows, hot_rows.end(),
+                        [](const auto &a, const auto &b) { return a.second > b.second; });
+      for (size_t i = 0; i < num_hot_rows; i++) {
+        hot_row_outfile << entry.first << ", " << hot_rows[i].first.first << ", " << hot_rows[i].first.second << ", "
+                        << hot_rows[i].second << ", ";
+        no_resource_metrics.ToCSV(hot_row_outfile);
+        hot_row_outfile << std::endl;
+      }
+    }
+    table_data_.clear();
+  }
+
+  /**
+   * Files to use for writing to CSV.
+   */
+  static constexpr std::array<std::string_view, 2> FILES = {"./write_conflict_table.csv",
+                                                            "./write_conflict_hot_row.csv"};
+  /**
+   * Columns to use for writing to CSV.
+   * Note: This includes the columns for the input feature, but not the output (resource counters)
+   */
+  static constexpr std::array<std::string_view, 2> FEATURE_COLUMNS = {
+      "table, num_writes, num_conflicts, num_not_visible, abort_rate", "table, block, offset, num_conflicts"};
+
+  /**
+   * Number of rows reported per table and aggregation
+   */
+  static constexpr size_t HOT_ROWS_PER_TABLE = 10;
+
+ private:
+  friend class WriteConflictMetric;
+  FRIEND_TEST(MetricsTests, WriteConflictCSVTest);
+
+  void RecordWriteData(const uint64_t table_id, const uint64_t block_id, const uint32_t offset,
+                       const WriteOutcome outcome) {
+    auto &table = table_data_[table_id];
+    table.num_writes_++;
+    switch (outcome) {
+      case WriteOutcome::SUCCESS:
+        break;
+      case WriteOutcome::WRITE_WRITE_CONFLICT:
+        table.num_conflicts_++;
+        table.slot_conflicts_[{block_id, offset}]++;
+        break;
+      case WriteOutcome::NOT_VISIBLE:
+        table.num_not_visible_++;
+        break;
+    }
+  }
+
+  struct TableData {
+    uint64_t num_writes_ = 0;
+    uint64_t num_conflicts_ = 0;
+    uint64_t num_not_visible_ = 0;
+    // (block, offset) -> number of write-write conflicts on that tuple
+    std::map<std::pair<uint64_t, uint32_t>, uint64_t> slot_conflicts_;
+  };
+
+  std::unordered_map<uint64_t, TableData> table_data_;
+};
+
+/**
+ * Metrics for write-write conflicts: sampled updates and deletes per table, how many of them failed and why, and the
+ * tuples that conflicted the most. Tables and blocks are identified by their address.
+ */
+class WriteConflictMetric : public AbstractMetric<WriteConflictMetricRawData> {
+ private:
+  friend class MetricsStore;
+
+  void RecordWriteData(const uint64_t table_id, const uint64_t block_id, const uint32_t offset,
+                       const WriteOutcome outcome) {
+    GetRawData()->RecordWriteData(table_id, block_id, offset, outcome);
+  }
+};
+}  // namespace terrier::metrics
@@ -38,6 +38,7 @@ class ConnectionContext {
     db_oid_ = catalog::INVALID_DATABASE_OID;
     db_name_.clear();
     temp_namespace_oid_ = catalog::INVALID_NAMESPACE_OID;
+    synchronous_commit_ = true;
     txn_ = nullptr;
     accessor_ = nullptr;
     callback_ = nullptr;
@@ -89,6 +90,16 @@ class ConnectionContext {
    */
   void SetConnectionID(const connection_id_t connection_id) { connection_id_ = connection_id; }
 
+  /**
+   * @return false if txns begun by this connection acknowledge commits once they are serialized instead of persisted
+   */
+  bool SynchronousCommit() const { return synchronous_commit_; }
+
+  /**
+   * @param synchronous_commit new value, set by the session's synchronous_commit variable
+   */
+  void SetSynchronousCommit(const bool synchronous_commit) { synchronous_commit_ = synchronous_commit; }
+
   /**
    * @return const reference to cmdline_args_ for reading values back out
    */
@@ -194,6 +205,12 @@ class ConnectionContext {
    */
   catalog::namespace_oid_t temp_namespace_oid_ = catalog::INVALID_NAMESPACE_OID;
 
+  /**
+   * Whether txns begun by this connection wait for their commits to be persisted. Only mutable by SET
+   * synchronous_commit, or Reset
+   */
+  bool synchronous_commit_ = true;
+
   /**
    * In theory the ConnectionContext owns this too, but for legacy reasons (and safety about who can delete them) we
    * don't use unique_ptrs for txns. If that ever changes, then the ConnectionContext should probably own it and
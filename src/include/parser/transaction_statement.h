@@ -7,7 +7,7 @@ namespace terrier::parser {
 
 /**
  * @class TransactionStatement
- * @brief Represents "BEGIN or COMMIT or ROLLBACK [TRANSACTION]"
+ * @brief Represents "BEGIN [READ ONLY] or COMMIT or ROLLBACK [TRANSACTION]"
  */
 class TransactionStatement : public SQLStatement {
  public:
@@ -22,8 +22,10 @@ class TransactionStatement : public SQLStatement {
 
   /**
    * @param type transaction command
+   * @param read_only true if a transaction begun by this command is read-only
    */
-  explicit TransactionStatement(CommandType type) : SQLStatement(StatementType::TRANSACTION), type_(type) {}
+  explicit TransactionStatement(CommandType type, bool read_only = false)
+      : SQLStatement(StatementType::TRANSACTION), type_(type), read_only_(read_only) {}
 
   void Accept(common::ManagedPointer<binder::SqlNodeVisitor> v,
               common::ManagedPointer<binder::BinderSherpa> sherpa) override {
@@ -35,8 +37,14 @@ class TransactionStatement : public SQLStatement {
    */
   CommandType GetTransactionType() { return type_; }
 
+  /**
+   * @return true if the transaction begun by this command is read-only
+   */
+  bool IsReadOnly() { return read_only_; }
+
  private:
   const CommandType type_;
+  const bool read_only_;
 };
 
 }  // namespace terrier::parser
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <utility>
+
 #include "binder/sql_node_visitor.h"
 #include "parser/sql_statement.h"
 #include "parser/table_ref.h"
@@ -7,18 +10,53 @@
 namespace terrier {
 namespace parser {
 /**
- * Not sure what this is for. Inherited from old codebase.
+ * VariableSetStatement represents SET [LOCAL] name = value, as well as SET name TO DEFAULT and RESET name.
  */
 class VariableSetStatement : public SQLStatement {
   // TODO(WAN): inherited from old codebase.
   // It was added to the parser to avoid connection error by Yuchen,
   // because JDBC on starting connection will send SET and require a response.
  public:
+  /**
+   * Creates a statement that does not set anything the system knows about
+   */
   VariableSetStatement() : SQLStatement(StatementType::VARIABLE_SET) {}
+
+  /**
+   * @param name name of the variable
+   * @param value new value of the variable, or empty to reset it to its default
+   * @param is_local true if the value only holds until the end of the current transaction
+   */
+  VariableSetStatement(std::string name, std::string value, const bool is_local)
+      : SQLStatement(StatementType::VARIABLE_SET),
+        name_(std::move(name)),
+        value_(std::move(value)),
+        is_local_(is_local) {}
+
   ~VariableSetStatement() override = default;
 
   void Accept(common::ManagedPointer<binder::SqlNodeVisitor> v,
               common::ManagedPointer<binder::BinderSherpa> sherpa) override {}
+
+  /**
+   * @return name of the variable
+   */
+  const std::string &GetName() const { return name_; }
+
+  /**
+   * @return new value of the variable, or empty to reset it to its default
+   */
+  const std::string &GetValue() const { return value_; }
+
+  /**
+   * @return true if the value only holds until the end of the current transaction
+   */
+  bool IsLocal() const { return is_local_; }
+
+ private:
+  const std::string name_;
+  const std::string value_;
+  const bool is_local_ = false;
 };
 }  // namespace parser
 }  // namespace terrier
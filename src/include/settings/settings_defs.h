@@ -66,6 +66,50 @@ SETTING_int(
     terrier::settings::Callbacks::NoOp
 )
 
+// Lower bound on the garbage collector thread interval
+SETTING_int(
+    gc_interval_min,
+    "Lower bound the garbage collector thread interval adapts down to under load (default: 1)",
+    1,
+    1,
+    10000,
+    false,
+    terrier::settings::Callbacks::NoOp
+)
+
+// Upper bound on the garbage collector thread interval
+SETTING_int(
+    gc_interval_max,
+    "Upper bound the garbage collector thread interval adapts up to when idle (default: 100)",
+    100,
+    1,
+    10000,
+    false,
+    terrier::settings::Callbacks::NoOp
+)
+
+// Number of garbage collector worker threads
+SETTING_int(
+    gc_num_workers,
+    "The number of threads the garbage collector unlinks undo records on, 0 to unlink on the GC thread (default: 0)",
+    0,
+    0,
+    64,
+    false,
+    terrier::settings::Callbacks::NoOp
+)
+
+// Number of deferred action worker threads
+SETTING_int(
+    deferred_action_num_workers,
+    "The number of threads expensive deferred actions run on, 0 to run them on the GC thread (default: 0)",
+    0,
+    0,
+    64,
+    false,
+    terrier::settings::Callbacks::NoOp
+)
+
 // Path to log file for WAL
 SETTING_string(
     log_file_path,
@@ -123,6 +167,77 @@ SETTING_bool(
     terrier::settings::Callbacks::NoOp
 )
 
+// Upper bound of the group commit window
+SETTING_int(
+    log_group_commit_window,
+    "Longest time (us) a commit waits for others to be persisted with it. The window follows the observed fsync "
+    "latency up to this bound (default: 1000)",
+    1000,
+    0,
+    1000000,
+    false,
+    terrier::settings::Callbacks::NoOp
+)
+
+// Group commit size
+SETTING_int(
+    log_group_commit_size,
+    "Number of commits that are persisted together without waiting for the group commit window (default: 64)",
+    64,
+    1,
+    100000,
+    false,
+    terrier::settings::Callbacks::NoOp
+)
+
+// Log file preallocation
+SETTING_int64(
+    log_preallocate_size,
+    "Size (bytes) of the chunks log files are preallocated in ahead of the writes, 0 to let them grow on demand "
+    "(default: 16MB)",
+    (1 << 24) /* 16MB */,
+    0,
+    (1 << 30) /* 1GB */,
+    false,
+    terrier::settings::Callbacks::NoOp
+)
+
+// Log segment size
+SETTING_int64(
+    log_segment_size,
+    "Size (bytes) past which the log file of a stream moves on to a new segment, 0 to never rotate it. Segment i > 0 "
+    "of a stream is written to <log file>.seg<i> (default: 256MB)",
+    (1 << 28) /* 256MB */,
+    0,
+    (1 << 30) /* 1GB */,
+    false,
+    terrier::settings::Callbacks::NoOp
+)
+
+// Log persists in flight
+SETTING_int(
+    log_max_persists_in_flight,
+    "Number of log file persists each log stream can have running in the background while it keeps writing, 0 to "
+    "persist inline (default: 0)",
+    0,
+    0,
+    64,
+    false,
+    terrier::settings::Callbacks::NoOp
+)
+
+// Number of log streams
+SETTING_int(
+    num_log_streams,
+    "Number of log streams, each with its own serializer and log file. Stream i > 0 writes to <log_file_path>.i "
+    "(default: 1)",
+    1,
+    1,
+    64,
+    false,
+    terrier::settings::Callbacks::NoOp
+)
+
 // Log file persisting threshold
 SETTING_int64(
     log_persist_threshold,
@@ -1,11 +1,16 @@
 #pragma once
 
+#include <array>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "common/spin_latch.h"
 #include "storage/storage_defs.h"
 
 namespace terrier::storage {
 class DataTable;
 class BlockCompactor;
+class BlockEvictionManager;
 // TODO(Tianyu): Probably need to be smarter than this to identify true hot or cold data, but this
 // will do for now.
 // Specifically, when the system is under load, and the GC does not get its own dedicated physical core,
@@ -15,13 +20,23 @@ class BlockCompactor;
 // expressed in physical time. This fix does not address the issue that detection may be slow
 // (GC is still invoked less frequently), but at least it lowers the impact because the access observer
 // will not wait for some fixed number of invocations.
+// Threshold used for tables that have not seen enough writes yet to derive their own
 #define COLD_DATA_EPOCH_THRESHOLD 10
+// Bounds on the threshold derived from a table's writes
+#define MIN_COLD_DATA_EPOCH_THRESHOLD 2
+#define MAX_COLD_DATA_EPOCH_THRESHOLD 1000
 /**
  * The access observer is attached to the storage engine's garbage collector in order to make decisions about
  * whether a block is cooling down from frequent access. Its observe methods are invoked from the garbage collector
  * when relavent events fire. It is then free to make a decision whether to send a block into the compactor's queue
  * to freeze asynchronously.
  *
+ * How long a block needs to go without writes before it is considered cold is decided per table. The observer keeps a
+ * histogram of the number of GC invocations between consecutive writes to the same block, and picks a threshold past
+ * which few blocks of the table see another write. A block that is written to again soon after being sent to the
+ * compactor (a wasted compaction) makes the table back off by doubling its threshold, which decays again after a
+ * while without wasted compactions. This keeps blocks from thrashing between hot and frozen.
+ *
  * Notice that although the observation step is light weight, it does happen on the garbage collection thread and thus
  * has some minor performance impact on GC and consequently the rest of the system. Care should be taken to not do
  * any computationally-intensive work here to figure out whether a block is cold. The entire hot-cold mechanism is
@@ -29,11 +44,34 @@ class BlockCompactor;
  */
 class AccessObserver {
  public:
+  /**
+   * Counters of the observer's decisions, since it was constructed
+   */
+  struct Statistics {
+    /**
+     * Number of blocks sent to the compactor
+     */
+    uint64_t num_blocks_cooled_;
+    /**
+     * Number of writes to blocks that were sent to the compactor
+     */
+    uint64_t num_blocks_thawed_;
+    /**
+     * Number of blocks written to again before they would be considered cold again
+     */
+    uint64_t num_wasted_compactions_;
+    /**
+     * Number of blocks sent to the compactor because their table was forced to freeze
+     */
+    uint64_t num_forced_freezes_;
+  };
+
   /**
    * Constructs a new AccessObserver that will send its observations to the given block compactor
    * @param compactor the compactor to use after identifying a cold block
+   * @param eviction_manager if not null, cold blocks are also offered to it as eviction candidates
    */
-  explicit AccessObserver(BlockCompactor *compactor) : compactor_(compactor) {}
+  explicit AccessObserver(BlockCompactor *compactor, BlockEvictionManager *eviction_manager = nullptr);
 
   /**
    * Signals to the AccessObserver that a new GC run has begun. This is useful as a measurement of time to the
@@ -49,12 +87,86 @@ class AccessObserver {
    */
   void ObserveWrite(RawBlock *block);
 
+  /**
+   * Signals to the AccessObserver that the given block has been handed back to the block store, and must not be
+   * sent to the compactor anymore.
+   * @param block The block that was released
+   */
+  void ObserveBlockReleased(RawBlock *block) {
+    last_touched_.erase(block);
+    cooled_.erase(block);
+  }
+
+  /**
+   * Keeps all blocks of the given table hot, regardless of how often they are written to. Safe to call from any
+   * thread.
+   * @param table the table to pin
+   */
+  void PinHot(const DataTable *table);
+
+  /**
+   * Undoes PinHot. Safe to call from any thread.
+   * @param table the table to unpin
+   */
+  void UnpinHot(const DataTable *table);
+
+  /**
+   * Sends every full block of the given table to the compactor on the next GC invocation, regardless of how often
+   * they are written to. Safe to call from any thread. The table must stay alive until the next GC invocation.
+   * @param table the table to freeze
+   */
+  void ForceFreeze(DataTable *table);
+
+  /**
+   * Not safe to call concurrently with the garbage collector.
+   * @param table the table to look up
+   * @return the number of GC invocations a block of the table currently needs to go without writes to be cold
+   */
+  uint64_t ColdThreshold(const DataTable *table) const {
+    auto it = tables_.find(table);
+    return it == tables_.end() ? COLD_DATA_EPOCH_THRESHOLD : it->second.EffectiveThreshold();
+  }
+
+  /**
+   * Not safe to call concurrently with the garbage collector.
+   * @return counters of the observer's decisions
+   */
+  Statistics GetStatistics() const { return statistics_; }
+
  private:
+  // How a table's blocks are written to over time
+  struct TableState {
+    // Number of times consecutive writes to a block were between [2^i, 2^(i+1)) GC invocations apart
+    std::array<uint64_t, 64> gap_histogram_{};
+    uint64_t num_gaps_ = 0;
+    // Threshold derived from the histogram
+    uint64_t threshold_ = COLD_DATA_EPOCH_THRESHOLD;
+    // Number of times the threshold is doubled, because of wasted compactions
+    uint32_t backoff_ = 0;
+    // Epoch of the last change to backoff_
+    uint64_t last_backoff_change_ = 0;
+
+    uint64_t EffectiveThreshold() const { return threshold_ << backoff_; }
+    void RecordGap(uint64_t gap);
+  };
+
   uint64_t gc_epoch_ = 0;  // estimate time using the number of times GC has run
   // Here RawBlock * should suffice as a unique identifier of the block. Although a block can be
   // reused, that process should only be triggered through compaction, which happens only if the
   // reference to said block is identified as cold and leaves the table.
   std::unordered_map<RawBlock *, uint64_t> last_touched_;
+  // Blocks sent to the compactor, and the epoch they were sent in
+  std::unordered_map<RawBlock *, uint64_t> cooled_;
+  std::unordered_map<const DataTable *, TableState> tables_;
   BlockCompactor *compactor_;
+  BlockEvictionManager *eviction_manager_;
+  Statistics statistics_{0, 0, 0, 0};
+
+  // Requests from outside the GC thread, protected by requests_latch_
+  common::SpinLatch requests_latch_;
+  std::unordered_set<const DataTable *> pinned_tables_;
+  std::vector<DataTable *> force_freeze_requests_;
+
+  void Cool(RawBlock *block);
 };
 }  // namespace terrier::storage
@@ -2,6 +2,7 @@
 #include <flatbuffers/flatbuffers.h>
 #include <flatbuffers/generated/Message_generated.h>
 #include <flatbuffers/generated/Schema_generated.h>
+#include <sys/uio.h>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -17,6 +18,9 @@ namespace terrier::storage {
  * An Arrow Serializer is an auxiliary object bound to a data table so that the in-memory blocks
  * which are organized in arrow format can be exported to external storage in arrow IPC format.
  * The exported table can be read by other frameworks that are compatible with arrow, e.g., pandas.
+ *
+ * Blocks are exported without any intermediate copies: every Buffer in the message body is handed to the kernel as an
+ * iovec that points directly into the (frozen) block, and a whole message is written out with a single writev.
  */
 class ArrowSerializer {
  public:
@@ -60,16 +64,44 @@ class ArrowSerializer {
    */
   void ExportTable(const std::string &file_name, std::vector<terrier::type::TypeId> *col_types);
 
+  /**
+   * Dump the tuples of a table visible to a transaction to disk in the same format as ExportTable. Unlike ExportTable,
+   * blocks do not need to be frozen: the snapshot is copied out through a staging block, one block's worth of tuples
+   * at a time, so this can run alongside transactions that write to the table. Column types are derived from the
+   * layout, varlen columns are written gathered and fixed length columns as integers of their width.
+   *
+   * @param file_name the file that the snapshot will be exported to
+   * @param txn the transaction whose snapshot is exported
+   * @param tuple_slots the slots of the exported tuples in the order they are written out, populated by this function
+   * @return number of tuples exported
+   */
+  uint64_t ExportSnapshot(const std::string &file_name, common::ManagedPointer<transaction::TransactionContext> txn,
+                          std::vector<TupleSlot> *tuple_slots);
+
  private:
   const DataTable &data_table_;
+  // Regions of memory queued up to be written out as the current message. These point directly into the blocks,
+  // the arrow varlen buffers and the flatbuffer builder, so nothing is copied before it reaches the kernel.
+  std::vector<struct iovec> iovecs_;
+  // Continuation marker and size of the metadata_flatbuffer of the message that is currently queued
+  int32_t metadata_prefix_[2];
+
   /**
-   * WriteDataBlock write a memory block to file. Such a memory block can be: offsets of varlen column,
-   * data of a fixed-size column, bitmap of a column, etc.
-   * @param outfile the output file
+   * WriteDataBlock queues a memory block to be written to file. Such a memory block can be: offsets of varlen column,
+   * data of a fixed-size column, bitmap of a column, etc. The memory is not copied and must remain valid until
+   * the next FlushMessage call.
    * @param src the memory block
    * @param len the size, will be padded to arrow alignment according to the specification
    */
-  void WriteDataBlock(std::ofstream &outfile, const char *src, size_t len);
+  void WriteDataBlock(const byte *src, size_t len);
+
+  /**
+   * Writes out all the memory blocks queued for the current message, and resets the flatbuffer builder for the
+   * next message.
+   * @param out_fd fd of the output file
+   * @param flatbuf_builder flatbuffer builder, which holds the metadata_flatbuffer of the current message
+   */
+  void FlushMessage(int out_fd, flatbuffers::FlatBufferBuilder *flatbuf_builder);
 
   /**
    * AddBufferInfo adds a buffer info to the buffers array. A buffer is a continuous memory region defined by its
@@ -82,14 +114,13 @@ class ArrowSerializer {
   void AddBufferInfo(size_t *offset, size_t len, std::vector<flatbuf::Buffer> *buffers);
 
   /**
-   * Build the metadata_flatbuffer from all its components and export it to the file.
-   * @param outfile the output file
+   * Build the metadata_flatbuffer from all its components and queue it to be written to the file.
    * @param header_type one of MessageHeader_Schema, MessageHeader_RecordBatch, or MessageHeader_DictionaryBatch
    * @param header the auto-generated offset of the header
    * @param body_len the length of follwoing message body (not the length of this metadata_flatbuffer)
    * @param flatbuf_builder flatbuffer builder
    */
-  void AssembleMetadataBuffer(std::ofstream &outfile, flatbuf::MessageHeader header_type,
+  void AssembleMetadataBuffer(flatbuf::MessageHeader header_type,
                               flatbuffers::Offset<void> header, int64_t body_len,
                               flatbuffers::FlatBufferBuilder *flatbuf_builder);
 
@@ -105,13 +136,13 @@ class ArrowSerializer {
    * For the flatbuffer schema of Schema message, please refer to:
    *    https://github.com/apache/arrow/blob/master/format/Schema.fbs
    *
-   * @param outfile the output file
+   * @param out_fd fd of the output file
    * @param dictionary_ids The dictionary entries and the indices for a batch of rows are written seperately.
    *                       Therefore, when a column is dictionary-compressed, we need to assign an id to it,
    *                       so that the dictionary and the indices can be paired.
    * @param flatbuf_builder flatbuffer builder
    */
-  void WriteSchemaMessage(std::ofstream &outfile, std::unordered_map<col_id_t, int64_t> *dictionary_ids,
+  void WriteSchemaMessage(int out_fd, std::unordered_map<col_id_t, int64_t> *dictionary_ids,
                           std::vector<type::TypeId> *col_types, flatbuffers::FlatBufferBuilder *flatbuf_builder);
 
   /**
@@ -124,12 +155,115 @@ class ArrowSerializer {
    * For the flatbuffer schema of Dictionary message, please refer to:
    *    https://github.com/apache/arrow/blob/master/format/Message.fbs
    *
-   * @param outfile the output file
+   * @param out_fd fd of the output file
    * @param dictionary_id id of this dictionary, should have been assigned previously when writing the schema message.
    * @param varlen_col varlen_col stores the dictionray for a dictionary compressed column
    * @param flatbuf_builder flatbuffer builder
    */
-  void WriteDictionaryMessage(std::ofstream &outfile, int64_t dictionary_id, const ArrowVarlenColumn &varlen_col,
+  void WriteDictionaryMessage(int out_fd, int64_t dictionary_id, const ArrowVarlenColumn &varlen_col,
                               flatbuffers::FlatBufferBuilder *flatbuf_builder);
+
+  /**
+   * Writes a frozen block as a RecordBatch message, preceded by the Dictionary messages of its dictionary compressed
+   * columns. The block is read in place, so it is kept frozen until the message is written out.
+   * @param out_fd fd of the output file
+   * @param block the block to write
+   * @param dictionary_ids dictionary ids assigned by the schema message
+   * @param flatbuf_builder flatbuffer builder
+   */
+  void WriteRecordBatch(int out_fd, RawBlock *block, std::unordered_map<col_id_t, int64_t> *dictionary_ids,
+                        flatbuffers::FlatBufferBuilder *flatbuf_builder);
+};
+
+/**
+ * An Arrow Deserializer is the counterpart of the ArrowSerializer. It loads a table that was dumped in arrow IPC format
+ * back into a data table, installing every RecordBatch message as a new frozen block.
+ *
+ * The file is mapped into memory instead of being read through a buffer, so every Buffer in a message body is copied
+ * exactly once, straight from the page cache into its final place in the block. (Blocks need to be aligned to block
+ * size and carry an in-memory header, so the pages of the file cannot be used as blocks themselves.)
+ */
+class ArrowDeserializer {
+ public:
+  /**
+   * Constructor of an arrow deserializer. Each arrow deserializer is bound to a specific data table, whose layout
+   * must match the layout of the table the file was exported from.
+   *
+   * @param data_table the data table to load blocks into
+   */
+  explicit ArrowDeserializer(DataTable *data_table) : data_table_(data_table) {}
+
+  /**
+   * Load a table dumped by ArrowSerializer::ExportTable into the bound data table. Each RecordBatch message becomes a
+   * frozen block appended to the table. Imported tuples are not versioned and thus visible to all transactions, so
+   * this should only be done when loading a table before it is accessed transactionally.
+   *
+   * @param file_name the file that the table will be imported from
+   * @param imported_slots if not null, the slots of the imported tuples are appended to it in the order they appear in
+   *        the file
+   * @throws std::runtime_error if the file is malformed or does not match the layout of the data table
+   * @return number of tuples imported
+   */
+  uint64_t ImportTable(const std::string &file_name, std::vector<TupleSlot> *imported_slots = nullptr);
+
+ private:
+  DataTable *data_table_;
+
+  /**
+   * A dictionary read from a Dictionary message. It points into the mapped file.
+   */
+  struct Dictionary {
+    const uint64_t *offsets_;
+    const byte *values_;
+    uint32_t num_entries_;
+  };
+
+  /**
+   * Checks the column types declared in the Schema message against the layout of the data table.
+   * @param schema the schema message
+   * @param col_types the arrow column type of each column, populated by this function
+   * @param dictionary_ids the dictionary id of each dictionary compressed column, populated by this function
+   */
+  void ReadSchemaMessage(const flatbuf::Schema *schema, std::unordered_map<col_id_t, ArrowColumnType> *col_types,
+                         std::unordered_map<col_id_t, int64_t> *dictionary_ids);
+
+  /**
+   * Reads a Dictionary message.
+   * @param dictionary_batch the dictionary message
+   * @param body start of the message body
+   * @param body_len length of the message body
+   * @return the dictionary
+   */
+  Dictionary ReadDictionaryMessage(const flatbuf::DictionaryBatch *dictionary_batch, const byte *body,
+                                   int64_t body_len);
+
+  /**
+   * Builds a new frozen block out of a RecordBatch message and appends it to the data table.
+   * @param record_batch the record batch message
+   * @param body start of the message body
+   * @param body_len length of the message body
+   * @param col_types the arrow column type of each column, as declared by the schema message
+   * @param dictionary_ids the dictionary id of each dictionary compressed column
+   * @param dictionaries the most recent dictionary read for each dictionary id
+   * @param imported_slots if not null, the slots of the tuples in the block are appended to it
+   * @return number of tuples in the block
+   */
+  uint32_t ReadRecordBatchMessage(const flatbuf::RecordBatch *record_batch, const byte *body, int64_t body_len,
+                                  const std::unordered_map<col_id_t, ArrowColumnType> &col_types,
+                                  const std::unordered_map<col_id_t, int64_t> &dictionary_ids,
+                                  const std::unordered_map<int64_t, Dictionary> &dictionaries,
+                                  std::vector<TupleSlot> *imported_slots);
+
+  /**
+   * Locates a Buffer in the message body, making sure it is within bounds.
+   * @param buffers the buffers array of the message
+   * @param index index of the buffer to locate
+   * @param body start of the message body
+   * @param body_len length of the message body
+   * @param min_len minimum length the buffer is expected to have
+   * @return start of the buffer
+   */
+  const byte *LocateBuffer(const flatbuffers::Vector<const flatbuf::Buffer *> *buffers, uint32_t index,
+                           const byte *body, int64_t body_len, uint64_t min_len);
 };
 }  // namespace terrier::storage
@@ -30,7 +30,18 @@ enum class BlockState : uint32_t {
    * This block is fully Arrow-compatible, and can be read in-place by readers. Transactions need to wait
    * for active readers to finish and flip block status back to hot before proceeding.
    */
-  FROZEN
+  FROZEN,
+  /**
+   * This frozen block has been picked for eviction by the BlockEvictionManager, but its contents are still in memory
+   * until no transaction that could have seen it as frozen is alive. Any access flips the block back to frozen (or
+   * hot, for writes) and cancels the eviction. In-place readers are not allowed.
+   */
+  EVICTING,
+  /**
+   * The contents of this block live on disk, and only the block header remains in memory as a tombstone. The block
+   * has to be faulted back in through the BlockEvictionManager before it can be accessed in any way.
+   */
+  EVICTED
 };
 
 // TODO(Tianyu): I need a better name for this...
@@ -93,6 +104,11 @@ class BlockAccessController {
       switch (current_state) {
         case BlockState::FREEZING:
           continue;  // Wait until the compactor finishes before doing anything
+        case BlockState::EVICTING:
+          // The block is still in memory, so the eviction can simply be called off
+          if (!GetBlockState()->compare_exchange_strong(current_state, BlockState::HOT)) continue;
+          // No need to wait for readers, as a block is only picked for eviction when no in-place readers are around
+          break;
         case BlockState::COOLING:
           if (!GetBlockState()->compare_exchange_strong(current_state, BlockState::HOT)) continue;
           // wait until the compactor finishes before doing anything
@@ -104,6 +120,8 @@ class BlockAccessController {
           // Although the block is already hot, we may need to wait for any straggling readers to finish
           while (GetReaderCount()->load() != 0) _mm_pause();
           break;
+        case BlockState::EVICTED:
+          throw std::runtime_error("evicted block must be faulted back in before it is written to");
         default:
           throw std::runtime_error("unexpected control flow");
       }
@@ -118,6 +136,7 @@ class BlockAccessController {
 
  private:
   friend class BlockCompactor;
+  friend class BlockEvictionManager;
   // we are breaking this down to two fields, (| BlockState (32-bits) | Reader Count (32-bits) |)
   // but may need to compare and swap on the two together sometimes
   byte bytes_[sizeof(uint64_t)];
@@ -1,13 +1,17 @@
 #pragma once
+#include <atomic>
 #include <queue>
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include "common/spin_latch.h"
+#include "common/worker_pool.h"
 #include "storage/arrow_block_metadata.h"
 #include "storage/data_table.h"
 #include "storage/storage_defs.h"
 #include "transaction/transaction_manager.h"
 namespace terrier::storage {
+class AccessObserver;
 
 /**
  * Typedef for a standard hash map with varlen entry as the key. The map uses deep equality checks (whether
@@ -21,6 +25,11 @@ using VarlenEntryMap = std::unordered_map<VarlenEntry, T, VarlenContentHasher, V
  * arrow-compatible. In the process, any gaps resulting from deletes or aborted transactions are also eliminated.
  * If the compaction is successful, the block is considered to be fully cold and will be accessed mostly as read-only
  * data.
+ *
+ * Cold blocks of the same table are compacted together in groups, with the emptiest blocks grouped together so that
+ * their tuples fit into as few blocks as possible. Blocks left without any tuples are handed back to the block store
+ * once no running transaction can reach them anymore. Compaction groups can be processed in parallel on a pool of
+ * worker threads.
  */
 class BlockCompactor {
  private:
@@ -44,11 +53,37 @@ class BlockCompactor {
     transaction::TransactionContext *txn_;
     DataTable *table_;
     std::unordered_map<RawBlock *, std::vector<uint32_t>> blocks_to_compact_;
+    // Blocks that no longer hold any tuples once the compaction goes through
+    std::vector<RawBlock *> blocks_emptied_;
+    // Number of tuples moved by the compaction
+    uint32_t num_tuples_moved_ = 0;
     ProjectedRowInitializer all_cols_initializer_;
     ProjectedRow *read_buffer_;
   };
 
+  // Counters for a single invocation of ProcessCompactionQueue, shared between the workers
+  struct CompactionStats {
+    std::atomic<uint64_t> num_groups_ = 0, num_groups_aborted_ = 0, num_blocks_compacted_ = 0, num_tuples_moved_ = 0,
+                          num_blocks_emptied_ = 0, num_blocks_frozen_ = 0;
+  };
+
  public:
+  /**
+   * Constructs a block compactor that compacts every block on its own, on the thread processing the compaction queue.
+   */
+  BlockCompactor() : BlockCompactor(0, 1, 1.0) {}
+
+  /**
+   * Constructs a block compactor with the given grouping policy.
+   * @param num_workers number of threads to process compaction groups on. If 0, groups are processed on the thread
+   *                    invoking ProcessCompactionQueue.
+   * @param max_blocks_per_group maximum number of blocks of the same table compacted together. Larger groups free up
+   *                             more memory, but make for larger compaction transactions.
+   * @param max_group_fill_factor blocks filled above this fraction of their slots are compacted on their own, as
+   *                              moving tuples into or out of them frees up little memory
+   */
+  BlockCompactor(uint32_t num_workers, uint32_t max_blocks_per_group, double max_group_fill_factor);
+
   FAKED_IN_TEST ~BlockCompactor() = default;
 
   /**
@@ -63,9 +98,34 @@ class BlockCompactor {
    * Adds a block associated with a data table to the compaction to be processed in the future.
    * @param block the block that needs to be processed by the compactor
    */
-  FAKED_IN_TEST void PutInQueue(RawBlock *block) { compaction_queue_.push(block); }
+  FAKED_IN_TEST void PutInQueue(RawBlock *block) {
+    common::SpinLatch::ScopedSpinLatch guard(&queue_latch_);
+    compaction_queue_.push(block);
+  }
+
+  /**
+   * Sets the access observer to notify when an emptied block is handed back to the block store, so that it does not
+   * hold on to the block. Notifications are delivered from deferred actions, i.e. on the garbage collector thread.
+   * @param observer the access observer sending cold blocks to this compactor
+   */
+  void SetAccessObserver(AccessObserver *observer) { observer_ = observer; }
 
  private:
+  void CompactGroup(const std::vector<RawBlock *> &blocks, transaction::DeferredActionManager *deferred_action_manager,
+                    transaction::TransactionManager *txn_manager, CompactionStats *stats);
+
+  void FreezeBlock(RawBlock *block, transaction::DeferredActionManager *deferred_action_manager,
+                   CompactionStats *stats);
+
+  // Runs the task on the worker pool if there is one, or right away otherwise
+  template <class F>
+  void RunTask(const F &task) {
+    if (num_workers_ == 0)
+      task();
+    else
+      workers_.SubmitTask(task);
+  }
+
   bool EliminateGaps(CompactionGroup *cg);
 
   bool CheckForVersionsAndGaps(const TupleAccessStrategy &accessor, RawBlock *block);
@@ -94,6 +154,13 @@ class BlockCompactor {
     }
   }
 
+  const uint32_t num_workers_;
+  const uint32_t max_blocks_per_group_;
+  const double max_group_fill_factor_;
+  common::WorkerPool workers_;
+  AccessObserver *observer_ = nullptr;
+
+  common::SpinLatch queue_latch_;
   std::queue<RawBlock *> compaction_queue_;
 };
 }  // namespace terrier::storage
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <list>
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/managed_pointer.h"
+#include "common/worker_pool.h"
+#include "storage/storage_defs.h"
+
+namespace terrier::transaction {
+class DeferredActionManager;
+}  // namespace terrier::transaction
+
+namespace terrier::storage {
+class DataTable;
+
+/**
+ * The block eviction manager implements anti-caching for cold data. Blocks that the AccessObserver identifies as cold
+ * are handed to it as eviction candidates. Whenever more candidates are resident than the memory budget allows, the
+ * coldest frozen ones are written out to an on-disk block file and their memory is given back to the operating system.
+ *
+ * Because tuple slots encode the address of their block, an evicted block keeps its address and header in memory as a
+ * tombstone (BlockState::EVICTED). Everything past the first page of the block, as well as the Arrow varlen buffers,
+ * is released. Any access to the block faults it back in from the block file. Sequential scans additionally fault in
+ * upcoming evicted blocks in the background.
+ *
+ * Eviction is a two step process, as transactional readers of frozen blocks do not register with the block's access
+ * controller. A block is first marked EVICTING, which turns away in-place readers but keeps its contents in memory.
+ * Only when every transaction that could have seen the block as frozen has finished is the block written out and
+ * released, on the next invocation of ProcessEvictionQueue. Any access in between calls off the eviction for free.
+ */
+class BlockEvictionManager {
+ public:
+  /**
+   * Constructs a new BlockEvictionManager.
+   * @param deferred_action_manager used to wait out transactions that may still be reading a block marked for eviction
+   * @param block_file_path path of the file evicted blocks are written to. The file is truncated if it exists.
+   * @param max_resident_blocks number of cold blocks allowed to remain in memory before they are evicted
+   */
+  BlockEvictionManager(common::ManagedPointer<transaction::DeferredActionManager> deferred_action_manager,
+                       std::string block_file_path, uint32_t max_resident_blocks);
+
+  /**
+   * Destructs the BlockEvictionManager and removes the block file. All tables with evicted blocks must have been
+   * destroyed, and the deferred action manager fully drained, before this happens.
+   */
+  ~BlockEvictionManager();
+
+  DISALLOW_COPY_AND_MOVE(BlockEvictionManager)
+
+  /**
+   * Registers a cold block as a candidate for eviction. Blocks that are not frozen by the time they are considered
+   * for eviction are skipped.
+   * @param block the block that has gone cold
+   */
+  void AddCandidate(RawBlock *block);
+
+  /**
+   * Evicts blocks until no more than the configured number of cold blocks remain in memory. Blocks marked for
+   * eviction on a previous invocation whose grace period has passed are written out to disk on this invocation.
+   * @return number of blocks written out to disk
+   * @throws std::runtime_error if a block could not be written out, in which case it stays in memory
+   */
+  uint32_t ProcessEvictionQueue();
+
+  /**
+   * Brings an evicted block back into memory, or calls off the eviction if the block has not been written out yet.
+   * This is a no-op if the block is not evicted. Blocks until the block is readable.
+   * @param block the block to bring back
+   * @throws std::runtime_error if the block could not be read back, in which case it stays evicted
+   */
+  void FaultIn(RawBlock *block);
+
+  /**
+   * Asynchronously brings an evicted block back into memory, so that a later access to it does not have to wait.
+   * @param block the block to bring back
+   */
+  void FaultInAsync(RawBlock *block);
+
+  /**
+   * Drops all references to the given block, and the on-disk copy of it if there is one. Called when the table
+   * owning the block is destroyed.
+   * @param block the block to forget
+   * @return whether the block's contents are on disk, in which case its varlen buffers are already released
+   */
+  bool ForgetBlock(RawBlock *block);
+
+  /**
+   * @return number of blocks currently on disk
+   */
+  uint64_t NumEvictedBlocks() const {
+    std::lock_guard<std::mutex> guard(latch_);
+    uint64_t result = 0;
+    for (auto &entry : evicted_blocks_)
+      if (entry.second.on_disk_) result++;
+    return result;
+  }
+
+ private:
+  // Bookkeeping for a block that is marked for eviction or evicted
+  struct EvictionEntry {
+    // Distinguishes repeated evictions of the same block, so a stale grace period does not evict a block early
+    uint64_t generation_;
+    bool on_disk_;
+    // Set while the block is being written out or read back, which happens outside the latch
+    bool io_in_progress_;
+    uint64_t file_offset_;
+    uint64_t length_;
+  };
+
+  const common::ManagedPointer<transaction::DeferredActionManager> deferred_action_manager_;
+  const std::string block_file_path_;
+  const uint32_t max_resident_blocks_;
+  int block_file_;
+  // Everything of the block before this offset stays in memory while it is evicted
+  const uint32_t resident_prefix_size_;
+
+  // Latch protecting everything below. It is never held over I/O, so that fault-ins do not queue up behind evictions.
+  // Anyone who needs a block whose I/O is in progress waits on the condition variable until that I/O is done.
+  mutable std::mutex latch_;
+  std::condition_variable io_done_cv_;
+  // Cold blocks in memory, oldest first
+  std::list<RawBlock *> candidates_;
+  std::unordered_map<RawBlock *, std::list<RawBlock *>::iterator> candidate_index_;
+  std::unordered_map<RawBlock *, EvictionEntry> evicted_blocks_;
+  // Blocks marked for eviction whose grace period has passed, along with the generation they were marked in
+  std::vector<std::pair<RawBlock *, uint64_t>> ready_to_evict_;
+  uint64_t next_generation_ = 0;
+  // Free extents in the block file, keyed by offset
+  std::map<uint64_t, uint64_t> free_extents_;
+  uint64_t file_end_ = 0;
+
+  // Counters reported to the metrics manager on the next invocation of ProcessEvictionQueue
+  std::atomic<uint64_t> num_hits_ = 0, num_misses_ = 0, num_bytes_read_ = 0;
+
+  // Fault-ins on behalf of sequential scans are served in the background
+  common::WorkerPool fault_in_pool_;
+
+  bool MarkForEviction(RawBlock *block);
+  EvictionEntry *WaitForIo(RawBlock *block, std::unique_lock<std::mutex> *lock);
+  uint64_t Evict(RawBlock *block);
+  void Restore(RawBlock *block, std::unique_lock<std::mutex> *lock);
+  void RemoveCandidate(RawBlock *block);
+  uint64_t AllocateExtent(uint64_t length);
+  void FreeExtent(uint64_t offset, uint64_t length);
+};
+}  // namespace terrier::storage
@@ -1,6 +1,8 @@
 #pragma once
+#include <atomic>
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/managed_pointer.h"
@@ -18,8 +20,18 @@ class TransactionContext;
 class TransactionManager;
 }  // namespace terrier::transaction
 
+namespace terrier::metrics {
+enum class WriteOutcome : uint8_t;
+}  // namespace terrier::metrics
+
 namespace terrier::storage {
 
+class BlockEvictionManager;
+
+// Length of a version chain past which transactions that come across it prune it on the spot instead of leaving it to
+// the next GC pass
+constexpr uint32_t VERSION_CHAIN_PRUNE_THRESHOLD = 16;
+
 namespace index {
 class Index;
 template <typename KeyType>
@@ -34,7 +46,8 @@ class HashIndex;
   f(uint64_t, NumUpdate) \
   f(uint64_t, NumInsert) \
   f(uint64_t, NumDelete) \
-  f(uint64_t, NumNewBlock)
+  f(uint64_t, NumNewBlock) \
+  f(uint64_t, NumVersionChainPrune)
 // clang-format on
 DEFINE_PERFORMANCE_CLASS(DataTableCounter, DataTableCounterMembers)
 #undef DataTableCounterMembers
@@ -125,6 +138,14 @@ class DataTable {
    */
   ~DataTable();
 
+  /**
+   * Frees up to the given number of blocks and their varlen entries, so that a dropped table can be freed in slices
+   * before it is destructed. The table must no longer be accessed by anyone.
+   * @param max_blocks maximum number of blocks to free
+   * @return true if the table has no blocks left
+   */
+  bool ReleaseBlocks(uint32_t max_blocks);
+
   /**
    * Materializes a single tuple from the given slot, as visible to the transaction given, according to the format
    * described by the given output buffer.
@@ -162,7 +183,7 @@ class DataTable {
    */
   SlotIterator begin() const {  // NOLINT for STL name compability
     common::SpinLatch::ScopedSpinLatch guard(&blocks_latch_);
-    return {this, blocks_.begin(), 0};
+    return {this, SkipRetiredBlocks(blocks_.begin()), 0};
   }
 
   /**
@@ -223,6 +244,8 @@ class DataTable {
  private:
   // The ArrowSerializer needs access to its blocks.
   friend class ArrowSerializer;
+  // The ArrowDeserializer needs to install new blocks
+  friend class ArrowDeserializer;
   // The GarbageCollector needs to modify VersionPtrs when pruning version chains
   friend class GarbageCollector;
   // The TransactionManager needs to modify VersionPtrs when rolling back aborts
@@ -236,6 +259,10 @@ class DataTable {
   // The block compactor elides transactional protection in the gather/compression phase and
   // needs raw access to the underlying table.
   friend class BlockCompactor;
+  // The block eviction manager needs to read out evicted blocks and register itself with the table
+  friend class BlockEvictionManager;
+  // The access observer needs to find the blocks of a table that is forced to freeze
+  friend class AccessObserver;
 
   const common::ManagedPointer<BlockStore> block_store_;
   const layout_version_t layout_version_;
@@ -250,6 +277,9 @@ class DataTable {
   // We also might need our own implementation because we need to handle GC of an unlinked block, as a sequential scan
   // might be on it
   std::list<RawBlock *> blocks_;
+  // Blocks emptied by the block compactor that are about to be removed from the block list. Scans and inserts step
+  // over them, so that nobody is left on one when it goes away. Protected by blocks_latch_.
+  std::unordered_set<RawBlock *> retired_blocks_;
   // latch used to protect block list
   mutable common::SpinLatch blocks_latch_;
   // latch used to protect insertion_head_
@@ -259,6 +289,8 @@ class DataTable {
   // This function uses header_latch_ to ensure correctness
   void CheckMoveHead(std::list<RawBlock *>::iterator block);
   mutable DataTableCounter data_table_counter_;
+  // Set once any block of this table is handed to an eviction manager
+  std::atomic<BlockEvictionManager *> eviction_manager_ = nullptr;
 
   // A templatized version for select, so that we can use the same code for both row and column access.
   // the method is explicitly instantiated for ProjectedRow and ProjectedColumns::RowView
@@ -288,13 +320,68 @@ class DataTable {
   // (logical delete bitmap is non-NULL).
   bool Visible(TupleSlot slot, const TupleAccessStrategy &accessor) const;
 
+  // Reports the outcome of an update or delete to the write conflict metrics, if this write is sampled
+  void RecordWriteOutcome(TupleSlot slot, metrics::WriteOutcome outcome) const;
+
   // Compares and swaps the version pointer to be the undo record, only if its value is equal to the expected one.
   bool CompareAndSwapVersionPtr(TupleSlot slot, const TupleAccessStrategy &accessor, UndoRecord *expected,
                                 UndoRecord *desired);
 
+  // Whether any running transaction can still need the given version. Only consults the cached oldest running
+  // transaction, so this is cheap enough to be asked on every write but may keep some versions around for longer.
+  bool VersionNeeded(const transaction::TransactionContext &txn, const UndoRecord *version_ptr) const;
+
+  // Cuts off all versions of the tuple that no transaction started at or after oldest can see. This is safe to call
+  // concurrently with running transactions, the GC and other truncations of the same version chain. The truncated
+  // records stay valid until the GC deallocates their transactions.
+  void TruncateVersionChain(TupleSlot slot, transaction::timestamp_t oldest);
+
+  // Truncates the version chain of the tuple at the recent oldest running transaction, if that cuts anything off.
+  // Called by transactions that have come across a long version chain, so that hot tuples do not pile up versions
+  // between GC passes.
+  void PruneVersionChain(common::ManagedPointer<transaction::TransactionContext> txn, TupleSlot slot);
+
+  // Prunes the version chain if there are at least VERSION_CHAIN_PRUNE_THRESHOLD versions following the given record
+  void PruneVersionChainIfLong(common::ManagedPointer<transaction::TransactionContext> txn, TupleSlot slot,
+                               const UndoRecord *head);
+
+  // The read path's way into PruneVersionChain. Reads are const to their callers, but a reader that walked a long
+  // version chain cuts off the versions nobody can see anymore. This is the only const method that rewrites a version
+  // chain.
+  void PruneVersionChainOnRead(common::ManagedPointer<transaction::TransactionContext> txn, TupleSlot slot) const {
+    const_cast<DataTable *>(this)->PruneVersionChain(txn, slot);
+  }
+
   // Allocates a new block to be used as insertion head.
   RawBlock *NewBlock();
 
+  // Advances the iterator past any retired blocks. Must be called with blocks_latch_ held.
+  template <class Iterator>
+  Iterator SkipRetiredBlocks(Iterator block) const {
+    if (retired_blocks_.empty()) return block;
+    while (block != blocks_.end() && retired_blocks_.count(*block) != 0) ++block;
+    return block;
+  }
+
+  // Turns new scans and inserts away from a block emptied by the block compactor
+  void RetireBlock(RawBlock *block);
+
+  // Removes a retired block from the table and hands it back to the block store. Nobody must be on the block anymore.
+  void ReleaseRetiredBlock(RawBlock *block);
+
+  // Brings the block back into memory if it has been marked for eviction or evicted. This needs to happen before the
+  // contents of the block are accessed.
+  void EnsureResident(RawBlock *block) const {
+    BlockState state = block->controller_.GetBlockState()->load();
+    if (state == BlockState::EVICTING || state == BlockState::EVICTED) FaultIn(block);
+  }
+
+  void FaultIn(RawBlock *block) const;
+
+  // Starts bringing the block after the given one back into memory in the background if it has been evicted, so a
+  // sequential scan does not have to wait on it.
+  void PrefetchNextBlock(const SlotIterator &pos) const;
+
   /**
    * Determine if a Tuple is visible (present and not deleted) to the given transaction. It's effectively Select's logic
    * (follow a version chain if present) without the materialization. If the logic of Select changes, this should change
@@ -3,8 +3,11 @@
 #include <queue>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
+#include "common/resource_tracker.h"
 #include "common/shared_latch.h"
+#include "common/worker_pool.h"
 #include "storage/access_observer.h"
 #include "storage/index/index.h"
 #include "transaction/transaction_context.h"
@@ -18,6 +21,10 @@ namespace terrier::storage {
  * Based on the contents of this queue, it unlinks the UndoRecords from their version chains when no running
  * transactions can view those versions anymore. It then stores those transactions to attempt to deallocate on the next
  * iteration if no running transactions can still hold references to them.
+ *
+ * Unlinking can optionally be spread over a pool of worker threads. The undo records of all transactions that are safe
+ * to unlink are then split up by the block they point into, so that every version chain is still truncated by a single
+ * thread, and each worker unlinks one partition.
  */
 class GarbageCollector {
  public:
@@ -31,19 +38,25 @@ class GarbageCollector {
    *                 it is not null. The observer can then gain insight invoke other components to perform actions.
    *                 The observer's function implementation needs to be lightweight because it is called on the GC
    *                 thread.
+   * @param num_workers number of threads to unlink undo records on. If 0, records are unlinked on the thread invoking
+   *                    PerformGarbageCollection.
    */
   // TODO(Tianyu): Eventually the GC will be re-written to be purely on the deferred action manager. which will
   //  eliminate this perceived redundancy of taking in a transaction manager.
   GarbageCollector(const common::ManagedPointer<transaction::TimestampManager> timestamp_manager,
                    const common::ManagedPointer<transaction::DeferredActionManager> deferred_action_manager,
-                   const common::ManagedPointer<transaction::TransactionManager> txn_manager, AccessObserver *observer)
+                   const common::ManagedPointer<transaction::TransactionManager> txn_manager, AccessObserver *observer,
+                   const uint32_t num_workers = 0)
       : timestamp_manager_(timestamp_manager),
         deferred_action_manager_(deferred_action_manager),
         txn_manager_(txn_manager),
         observer_(observer),
-        last_unlinked_{0} {
+        last_unlinked_{0},
+        num_workers_(num_workers),
+        workers_(num_workers, {}) {
     TERRIER_ASSERT(txn_manager_->GCEnabled(),
                    "The TransactionManager needs to be instantiated with gc_enabled true for GC to work!");
+    if (num_workers_ > 0) workers_.Startup();
   }
 
   ~GarbageCollector() {
@@ -75,6 +88,14 @@ class GarbageCollector {
   void UnregisterIndexForGC(common::ManagedPointer<index::Index> index);
 
  private:
+  // The undo records unlinked by a single worker in a GC invocation
+  struct UnlinkPartition {
+    std::vector<std::pair<transaction::TransactionContext *, UndoRecord *>> records_;
+    // Varlen buffers no longer reachable once the records are unlinked
+    std::vector<const byte *> loose_ptrs_;
+    common::ResourceTracker::Metrics resource_metrics_;
+  };
+
   /**
    * Process the deallocate queue
    * @return number of txns (not UndoRecords) processed for debugging/testing
@@ -94,9 +115,10 @@ class GarbageCollector {
 
   void ReclaimSlotIfDeleted(UndoRecord *undo_record) const;
 
-  void ReclaimBufferIfVarlen(transaction::TransactionContext *txn, UndoRecord *undo_record) const;
+  void ReclaimBufferIfVarlen(std::vector<const byte *> *loose_ptrs, UndoRecord *undo_record) const;
 
-  void TruncateVersionChain(DataTable *table, TupleSlot slot, transaction::timestamp_t oldest) const;
+  void ProcessUnlinkPartition(UnlinkPartition *partition, transaction::timestamp_t oldest_txn,
+                              bool gc_metrics_enabled) const;
 
   void ProcessIndexes();
 
@@ -111,6 +133,9 @@ class GarbageCollector {
   // queue of txns that need to be unlinked
   transaction::TransactionQueue txns_to_unlink_;
 
+  const uint32_t num_workers_;
+  common::WorkerPool workers_;
+
   std::unordered_set<common::ManagedPointer<index::Index>> indexes_;
   common::SharedLatch indexes_latch_;
 };
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>  //NOLINT
 #include <thread>  //NOLINT
 
 #include "storage/garbage_collector.h"
 #include "transaction/deferred_action_manager.h"
+#include "transaction/transaction_manager.h"
 
 namespace terrier::metrics {
 class MetricsManager;
@@ -13,8 +15,13 @@ class MetricsManager;
 namespace terrier::storage {
 
 /**
- * Class for spinning off a thread that runs garbage collection at a fixed interval. This should be used in most cases
+ * Class for spinning off a thread that runs garbage collection at an interval. This should be used in most cases
  * to enable GC in the system unless you need fine-grained control over table state or profiling.
+ *
+ * The interval can be left to adapt between two bounds. Before every invocation the thread looks at how much work the
+ * transaction manager has piled up for the GC since the last one: when readers had to walk long version chains or a lot
+ * of undo records are waiting, the interval is halved. When there is nothing to do, the interval is doubled, and
+ * otherwise it creeps up by a millisecond at a time until pressure builds up again.
  */
 class GarbageCollectorThread {
  public:
@@ -24,7 +31,21 @@ class GarbageCollectorThread {
    * @param metrics_manager Metrics Manager
    */
   GarbageCollectorThread(common::ManagedPointer<GarbageCollector> gc, std::chrono::milliseconds gc_period,
-                         common::ManagedPointer<metrics::MetricsManager> metrics_manager);
+                         common::ManagedPointer<metrics::MetricsManager> metrics_manager)
+      : GarbageCollectorThread(gc, gc_period, metrics_manager, DISABLED, gc_period, gc_period) {}
+
+  /**
+   * @param gc pointer to the garbage collector object to be run on this thread
+   * @param gc_period initial sleep time between GC invocations
+   * @param metrics_manager Metrics Manager
+   * @param txn_manager transaction manager to read the GC's backlog from. If nullptr, the interval does not change.
+   * @param min_gc_period lower bound on the sleep time between GC invocations
+   * @param max_gc_period upper bound on the sleep time between GC invocations
+   */
+  GarbageCollectorThread(common::ManagedPointer<GarbageCollector> gc, std::chrono::milliseconds gc_period,
+                         common::ManagedPointer<metrics::MetricsManager> metrics_manager,
+                         common::ManagedPointer<transaction::TransactionManager> txn_manager,
+                         std::chrono::milliseconds min_gc_period, std::chrono::milliseconds max_gc_period);
 
   ~GarbageCollectorThread() { StopGC(); }
 
@@ -71,20 +92,33 @@ class GarbageCollectorThread {
    */
   common::ManagedPointer<GarbageCollector> GetGarbageCollector() { return gc_; }
 
+  /**
+   * @return the current sleep time between GC invocations
+   */
+  std::chrono::milliseconds GetGCPeriod() const { return gc_period_.load(); }
+
  private:
   const common::ManagedPointer<storage::GarbageCollector> gc_;
   const common::ManagedPointer<metrics::MetricsManager> metrics_manager_;
+  const common::ManagedPointer<transaction::TransactionManager> txn_manager_;
+  const std::chrono::milliseconds min_gc_period_, max_gc_period_;
   volatile bool run_gc_;
   volatile bool gc_paused_;
-  std::chrono::milliseconds gc_period_;
+  std::atomic<std::chrono::milliseconds> gc_period_;
   std::thread gc_thread_;
 
   void GCThreadLoop() {
     while (run_gc_) {
-      std::this_thread::sleep_for(gc_period_);
-      if (!gc_paused_) gc_->PerformGarbageCollection();
+      std::this_thread::sleep_for(gc_period_.load());
+      if (!gc_paused_) {
+        // This has to happen before the GC takes the completed txns off the transaction manager
+        if (txn_manager_ != DISABLED) AdaptGCPeriod();
+        gc_->PerformGarbageCollection();
+      }
     }
   }
+
+  void AdaptGCPeriod();
 };
 
 }  // namespace terrier::storage
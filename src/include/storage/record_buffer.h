@@ -297,6 +297,15 @@ class UndoBuffer {
    */
   bool Empty() const { return buffers_.empty(); }
 
+  /**
+   * @return number of bytes taken up by the undo records in this buffer
+   */
+  uint64_t Size() const {
+    uint64_t result = 0;
+    for (const auto *segment : buffers_) result += segment->size_;
+    return result;
+  }
+
   /**
    * Reserve an undo record with the given size.
    * @param size the size of the undo record to allocate
@@ -329,8 +338,7 @@ class RedoBuffer {
    * @param log_manager the log manager this redo buffer talks to, or nullptr if logging is disabled
    * @param buffer_pool The buffer pool to draw buffer segments from. Must be the same buffer pool the log manager uses.
    */
-  RedoBuffer(LogManager *log_manager, RecordBufferSegmentPool *buffer_pool)
-      : has_flushed_(false), log_manager_(log_manager), buffer_pool_(buffer_pool) {}
+  RedoBuffer(LogManager *log_manager, RecordBufferSegmentPool *buffer_pool);
 
   /**
    * Reserve a redo record with the given size, in bytes. The returned pointer is guaranteed to be valid until NewEntry
@@ -371,6 +379,8 @@ class RedoBuffer {
   // changes from aborted txns
   bool has_flushed_;
   LogManager *const log_manager_;
+  // Log stream all of our segments go to, so that recovery finds the records of a txn in one place
+  const uint32_t log_stream_;
   RecordBufferSegmentPool *const buffer_pool_;
   RecordBufferSegment *buffer_seg_ = nullptr;
   // reserved for aborts where we will potentially need to garbage collect the last operation (which caused the abort)
@@ -5,6 +5,7 @@
 #include <vector>
 #include "catalog/catalog_defs.h"
 #include "storage/sql_table.h"
+#include "storage/write_ahead_log/log_encoding.h"
 #include "storage/write_ahead_log/log_record.h"
 
 namespace terrier::storage {
@@ -60,6 +61,14 @@ class AbstractLogProvider {
     return result;
   }
 
+  /**
+   * Read an integer written as a varint from log provider
+   * @return the value read
+   */
+  uint64_t ReadVarint() {
+    return LogEncoding::DecodeVarint([this] { return ReadValue<uint8_t>(); });
+  }
+
   /**
    * Reads in the next log record from the log provider
    * @warning If the serialization format of logs ever changes, this function will need to be updated.
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "catalog/catalog_defs.h"
+#include "common/managed_pointer.h"
+#include "common/worker_pool.h"
+#include "storage/sql_table.h"
+#include "storage/storage_defs.h"
+#include "transaction/timestamp_manager.h"
+#include "transaction/transaction_defs.h"
+#include "transaction/transaction_manager.h"
+
+namespace terrier::storage {
+
+/**
+ * The checkpoint manager writes fuzzy checkpoints, so that recovery does not need to replay the log from its very
+ * beginning. A checkpoint is taken under a read-only transaction, without blocking any writers: every user table is
+ * written out as of the snapshot of that transaction, in the Arrow IPC format of the ArrowSerializer, one table per
+ * worker. The slots the tuples had are written next to each table, so that log records written after the checkpoint
+ * can still be mapped to the tuples they refer to.
+ *
+ * A checkpoint only counts once its metadata file is in place, which is written last. It holds the start time of the
+ * checkpoint transaction: the checkpoint contains exactly the txns that committed before it. The files of a checkpoint
+ * are named after that timestamp, so that taking a checkpoint never overwrites the files of the one it replaces.
+ *
+ * The catalog is not written out. It is rebuilt from the DDL records in the log, which recovery still replays for the
+ * txns covered by the checkpoint. Truncating the log up to the oldest txn running at the checkpoint keeps these records
+ * in the catalog log of each stream (see LogSegmentManifest), so that recovery only reads them and the rest of the log.
+ */
+class CheckpointManager {
+ public:
+  /**
+   * A table written out by a checkpoint
+   */
+  struct CheckpointTable {
+    /** database of the table */
+    catalog::db_oid_t db_oid_;
+    /** the table */
+    catalog::table_oid_t table_oid_;
+    /** number of tuples written out */
+    uint64_t num_tuples_;
+    /** size of the files written for the table */
+    uint64_t num_bytes_;
+  };
+
+  /**
+   * Describes a complete checkpoint
+   */
+  struct CheckpointMetadata {
+    /** start time of the checkpoint txn, txns that committed before it are in the checkpoint */
+    transaction::timestamp_t checkpoint_time_;
+    /** oldest txn running when the checkpoint was taken */
+    transaction::timestamp_t oldest_active_txn_;
+    /** the tables in the checkpoint */
+    std::vector<CheckpointTable> tables_;
+  };
+
+  /**
+   * @param catalog catalog to look up the tables to write out
+   * @param txn_manager txn manager to begin the checkpoint txn with
+   * @param timestamp_manager timestamp manager to find the oldest running txn
+   * @param num_workers number of tables written out in parallel
+   */
+  CheckpointManager(const common::ManagedPointer<catalog::Catalog> catalog,
+                    const common::ManagedPointer<transaction::TransactionManager> txn_manager,
+                    const common::ManagedPointer<transaction::TimestampManager> timestamp_manager,
+                    const uint32_t num_workers)
+      : catalog_(catalog),
+        txn_manager_(txn_manager),
+        timestamp_manager_(timestamp_manager),
+        num_workers_(num_workers),
+        workers_(num_workers, {}) {
+    TERRIER_ASSERT(num_workers_ > 0, "checkpoints need at least one worker");
+    workers_.Startup();
+  }
+
+  /**
+   * Takes a checkpoint. Once it is complete, it replaces the checkpoint previously taken into the same directory, whose
+   * files are then deleted.
+   * @param checkpoint_dir directory to write the checkpoint into, created if it does not exist
+   * @return metadata of the checkpoint
+   * @throws std::runtime_error if the checkpoint could not be written, in which case the previous one stays in use
+   */
+  CheckpointMetadata TakeCheckpoint(const std::string &checkpoint_dir);
+
+  /**
+   * Reads the metadata of the checkpoint in a directory.
+   * @param checkpoint_dir directory the checkpoint was written into
+   * @param metadata populated with the metadata of the checkpoint
+   * @return false if there is no complete checkpoint in the directory
+   * @throws std::runtime_error if the metadata is malformed
+   */
+  static bool ReadMetadata(const std::string &checkpoint_dir, CheckpointMetadata *metadata);
+
+  /**
+   * Reads the slots the tuples of a table had when the checkpoint was taken.
+   * @param checkpoint_dir directory the checkpoint was written into
+   * @param checkpoint_time timestamp of the checkpoint
+   * @param table the table
+   * @return the slots, in the order the tuples are in the table's file
+   * @throws std::runtime_error if the file does not hold a slot for every tuple of the table
+   */
+  static std::vector<TupleSlot> ReadTupleSlots(const std::string &checkpoint_dir,
+                                               transaction::timestamp_t checkpoint_time, const CheckpointTable &table);
+
+  /**
+   * @param checkpoint_dir directory the checkpoint was written into
+   * @param checkpoint_time timestamp of the checkpoint
+   * @param table the table
+   * @return path of the Arrow file of the table
+   */
+  static std::string TableFilePath(const std::string &checkpoint_dir, const transaction::timestamp_t checkpoint_time,
+                                   const CheckpointTable &table) {
+    return FilePathPrefix(checkpoint_dir, checkpoint_time, table) + ".arrow";
+  }
+
+  /**
+   * @param checkpoint_dir directory the checkpoint was written into
+   * @param checkpoint_time timestamp of the checkpoint
+   * @param table the table
+   * @return path of the file holding the slots of the tuples of the table
+   */
+  static std::string TupleSlotsFilePath(const std::string &checkpoint_dir,
+                                        const transaction::timestamp_t checkpoint_time, const CheckpointTable &table) {
+    return FilePathPrefix(checkpoint_dir, checkpoint_time, table) + ".slots";
+  }
+
+  /**
+   * @param checkpoint_dir directory the checkpoint was written into
+   * @return path of the metadata file of the checkpoint
+   */
+  static std::string MetadataFilePath(const std::string &checkpoint_dir) { return checkpoint_dir + "/checkpoint.meta"; }
+
+ private:
+  const common::ManagedPointer<catalog::Catalog> catalog_;
+  const common::ManagedPointer<transaction::TransactionManager> txn_manager_;
+  const common::ManagedPointer<transaction::TimestampManager> timestamp_manager_;
+  const uint32_t num_workers_;
+  common::WorkerPool workers_;
+
+  static std::string FilePathPrefix(const std::string &checkpoint_dir, const transaction::timestamp_t checkpoint_time,
+                                    const CheckpointTable &table) {
+    return checkpoint_dir + "/" + std::to_string(!checkpoint_time) + "_" + std::to_string(!table.db_oid_) + "_" +
+           std::to_string(!table.table_oid_);
+  }
+
+  // Finds the user tables visible to the checkpoint txn
+  std::vector<std::pair<CheckpointTable, common::ManagedPointer<SqlTable>>> CollectTables(
+      common::ManagedPointer<transaction::TransactionContext> txn);
+
+  // Writes out a table and the slots of its tuples as of the checkpoint txn, and fills in the sizes in the table
+  void WriteTable(const std::string &checkpoint_dir, common::ManagedPointer<transaction::TransactionContext> txn,
+                  common::ManagedPointer<SqlTable> sql_table, CheckpointTable *table);
+
+  // Deletes the files of the tables of a checkpoint
+  static void RemoveTableFiles(const std::string &checkpoint_dir, const CheckpointMetadata &metadata);
+
+  // Writes the metadata file through a temporary file, so that a crash leaves either the old or the new checkpoint
+  static void WriteMetadata(const std::string &checkpoint_dir, const CheckpointMetadata &metadata);
+};
+
+}  // namespace terrier::storage
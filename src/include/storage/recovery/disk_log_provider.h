@@ -1,31 +1,75 @@
 #pragma once
 
+#include <unistd.h>
+#include <memory>
 #include <string>
+#include <utility>
 #include "storage/recovery/abstract_log_provider.h"
 #include "storage/write_ahead_log/log_io.h"
+#include "storage/write_ahead_log/log_segment_manifest.h"
 
 namespace terrier::storage {
 
 /**
  * @brief Log provider for logs stored on disk
  * Provides logs to the recovery manager from logs persisted on disk. The log file is read in using the
- * BufferedLogReader.
+ * BufferedLogReader, one segment after the other, starting from any segment (see LogSegmentManifest). Reading from the
+ * oldest segment left starts with the catalog log, which holds the catalog changes of the segments truncated before it.
  */
 class DiskLogProvider : public AbstractLogProvider {
  public:
   /**
+   * Reads the catalog log, and then the log from the oldest segment that has not been truncated
    * @param log_file_path path to log file to read logs from
    */
-  explicit DiskLogProvider(const std::string &log_file_path) : in_(BufferedLogReader(log_file_path.c_str())) {}
+  explicit DiskLogProvider(const std::string &log_file_path)
+      : DiskLogProvider(log_file_path, LogSegmentManifest(log_file_path)) {}
+
+  /**
+   * Reads the log from the given segment on, skipping the history before it
+   * @param log_file_path path to log file to read logs from
+   * @param first_segment segment to start reading from
+   */
+  DiskLogProvider(std::string log_file_path, const uint64_t first_segment)
+      : log_file_path_(std::move(log_file_path)),
+        segment_(first_segment),
+        in_(std::make_unique<BufferedLogReader>(
+            LogSegmentManifest::SegmentFilePath(log_file_path_, segment_).c_str())) {}
 
  private:
+  const std::string log_file_path_;
+  // Segment currently being read, or the first one to read after the catalog log
+  uint64_t segment_;
   // Buffered log file reader
-  storage::BufferedLogReader in_;
+  std::unique_ptr<BufferedLogReader> in_;
+  // Whether the catalog log is being read
+  bool reading_catalog_log_ = false;
+
+  DiskLogProvider(const std::string &log_file_path, const LogSegmentManifest &manifest)
+      : log_file_path_(log_file_path),
+        segment_(manifest.FirstSegment()),
+        reading_catalog_log_(manifest.CatalogLog() != 0) {
+    const std::string path = reading_catalog_log_
+                                 ? LogSegmentManifest::CatalogLogFilePath(log_file_path_, manifest.CatalogLog())
+                                 : LogSegmentManifest::SegmentFilePath(log_file_path_, segment_);
+    in_ = std::make_unique<BufferedLogReader>(path.c_str());
+  }
 
   /**
    * @return true if log file contains more records, false otherwise
    */
-  bool HasMoreRecords() override { return in_.HasMore(); }
+  bool HasMoreRecords() override {
+    // Segments end on a record boundary, so we only move on to the next segment between records
+    while (!in_->HasMore()) {
+      const uint64_t next_segment = reading_catalog_log_ ? segment_ : segment_ + 1;
+      const std::string next_path = LogSegmentManifest::SegmentFilePath(log_file_path_, next_segment);
+      if (access(next_path.c_str(), F_OK) != 0) return false;
+      reading_catalog_log_ = false;
+      segment_ = next_segment;
+      in_ = std::make_unique<BufferedLogReader>(next_path.c_str());
+    }
+    return true;
+  }
 
   /**
    * Read data from the log file into the destination provided
@@ -33,7 +77,7 @@ class DiskLogProvider : public AbstractLogProvider {
    * @param size number of bytes to read
    * @return true if we read the given number of bytes
    */
-  bool Read(void *dest, uint32_t size) override { return in_.Read(dest, size); }
+  bool Read(void *dest, uint32_t size) override { return in_->Read(dest, size); }
 };
 
 }  // namespace terrier::storage
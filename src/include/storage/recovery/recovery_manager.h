@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -15,7 +16,11 @@
 #include "catalog/postgres/pg_index.h"
 #include "catalog/postgres/pg_namespace.h"
 #include "common/dedicated_thread_owner.h"
+#include "common/shared_latch.h"
+#include "common/spin_latch.h"
+#include "common/worker_pool.h"
 #include "storage/recovery/abstract_log_provider.h"
+#include "storage/recovery/checkpoint_manager.h"
 #include "storage/sql_table.h"
 #include "transaction/transaction_manager.h"
 
@@ -63,20 +68,50 @@ class RecoveryManager : public common::DedicatedThreadOwner {
    * @param deferred_action_manager manager to use for deferred deletes
    * @param thread_registry thread registry to register tasks
    * @param store block store used for SQLTable creation during recovery
+   * @param checkpoint_dir directory checkpoints were taken into, recovery starts from the checkpoint there if there is
+   *        one. Empty to replay the whole log.
+   * @param num_replay_workers number of threads changes to user tables are replayed and indexes rebuilt on
    */
   explicit RecoveryManager(const common::ManagedPointer<AbstractLogProvider> log_provider,
                            const common::ManagedPointer<catalog::Catalog> catalog,
                            const common::ManagedPointer<transaction::TransactionManager> txn_manager,
                            const common::ManagedPointer<transaction::DeferredActionManager> deferred_action_manager,
                            const common::ManagedPointer<terrier::common::DedicatedThreadRegistry> thread_registry,
-                           const common::ManagedPointer<BlockStore> store)
+                           const common::ManagedPointer<BlockStore> store, std::string checkpoint_dir = "",
+                           const uint32_t num_replay_workers = DEFAULT_REPLAY_WORKERS)
+      : RecoveryManager(std::vector<common::ManagedPointer<AbstractLogProvider>>{log_provider}, catalog, txn_manager,
+                        deferred_action_manager, thread_registry, store, std::move(checkpoint_dir),
+                        num_replay_workers) {}
+
+  /**
+   * @param log_providers one provider per log stream, the streams are merged back together during recovery
+   * @param catalog system catalog to interface with sql tables
+   * @param txn_manager txn manager to use for re-executing recovered transactions
+   * @param deferred_action_manager manager to use for deferred deletes
+   * @param thread_registry thread registry to register tasks
+   * @param store block store used for SQLTable creation during recovery
+   * @param checkpoint_dir directory checkpoints were taken into, recovery starts from the checkpoint there if there is
+   *        one. Empty to replay the whole log.
+   * @param num_replay_workers number of threads changes to user tables are replayed and indexes rebuilt on
+   */
+  explicit RecoveryManager(std::vector<common::ManagedPointer<AbstractLogProvider>> log_providers,
+                           const common::ManagedPointer<catalog::Catalog> catalog,
+                           const common::ManagedPointer<transaction::TransactionManager> txn_manager,
+                           const common::ManagedPointer<transaction::DeferredActionManager> deferred_action_manager,
+                           const common::ManagedPointer<terrier::common::DedicatedThreadRegistry> thread_registry,
+                           const common::ManagedPointer<BlockStore> store, std::string checkpoint_dir = "",
+                           const uint32_t num_replay_workers = DEFAULT_REPLAY_WORKERS)
       : DedicatedThreadOwner(thread_registry),
-        log_provider_(log_provider),
+        log_providers_(std::move(log_providers)),
         catalog_(catalog),
         txn_manager_(txn_manager),
         deferred_action_manager_(deferred_action_manager),
         block_store_(store),
+        checkpoint_dir_(std::move(checkpoint_dir)),
+        replay_workers_(num_replay_workers, {}),
         recovered_txns_(0) {
+    TERRIER_ASSERT(num_replay_workers > 0, "replay needs at least one worker");
+    replay_workers_.Startup();
     // Initialize catalog_table_schemas_ map
     catalog_table_schemas_[catalog::postgres::CLASS_TABLE_OID] = catalog::postgres::Builder::GetClassTableSchema();
     catalog_table_schemas_[catalog::postgres::NAMESPACE_TABLE_OID] =
@@ -88,11 +123,48 @@ class RecoveryManager : public common::DedicatedThreadOwner {
     catalog_table_schemas_[catalog::postgres::TYPE_TABLE_OID] = catalog::postgres::Builder::GetTypeTableSchema();
   }
 
+  /**
+   * Number of replay workers used unless told otherwise
+   */
+  static constexpr uint32_t DEFAULT_REPLAY_WORKERS = 4;
+
+  /**
+   * Lets read-only txns run on the recovered tables while recovery is still going, as on a replica that serves reads
+   * while it replays the log of its primary. Snapshots begin through BeginSnapshotTransaction, and the indexes on user
+   * tables are kept up to date as the changes are replayed instead of being rebuilt at the end.
+   * Must be called before StartRecovery.
+   */
+  void ServeReads() {
+    TERRIER_ASSERT(recovery_task_ == nullptr, "Recovery already started");
+    serve_reads_ = true;
+  }
+
+  /**
+   * Begins a read-only txn on what has been replayed so far. Snapshots only begin in between batches of replayed txns,
+   * so every txn of the primary is either fully visible to one or not at all, and the usual MVCC rules keep what is
+   * replayed later out of it. Blocks until the first watermark is published.
+   * @param watermark if given, set to the watermark the snapshot is at, see ReplayedWatermark
+   * @return the txn, to be committed or aborted through the transaction manager of the recovery manager
+   */
+  transaction::TransactionContext *BeginSnapshotTransaction(transaction::timestamp_t *watermark = nullptr);
+
+  /**
+   * @return commit timestamp on the primary up to which the log has been replayed: every txn that committed before it
+   * is visible to new snapshots. Txns that committed later, but began before it, may be visible as well, since txns are
+   * replayed in the order they began in. INVALID_TXN_TIMESTAMP until the first watermark is published.
+   */
+  transaction::timestamp_t ReplayedWatermark() const { return replayed_watermark_.load(); }
+
   /**
    * Starts a background recovery task. Recovery will fully recover until the log provider stops providing logs.
    */
   void StartRecovery() {
     TERRIER_ASSERT(recovery_task_ == nullptr, "Recovery already started");
+    // Snapshots wait for the first watermark. Taken here, so that no snapshot can slip in before the task runs.
+    if (serve_reads_) {
+      snapshot_latch_.LockExclusive();
+      snapshot_latch_held_ = true;
+    }
     recovery_task_ =
         thread_registry_->RegisterDedicatedThread<RecoveryTask>(this /* dedicated thread owner */, this /* task arg */);
   }
@@ -109,11 +181,13 @@ class RecoveryManager : public common::DedicatedThreadOwner {
 
  private:
   FRIEND_TEST(RecoveryTests, DoubleRecoveryTest);
+  FRIEND_TEST(RecoveryTests, ReplicationTest);
+  FRIEND_TEST(RecoveryTests, ReplicaReadTest);
   friend class RecoveryTests;
   friend class terrier::RecoveryBenchmark;
 
-  // Log provider for reading in logs
-  const common::ManagedPointer<AbstractLogProvider> log_provider_;
+  // Log providers for reading in logs, one per log stream
+  const std::vector<common::ManagedPointer<AbstractLogProvider>> log_providers_;
 
   // Catalog to fetch table pointers
   const common::ManagedPointer<catalog::Catalog> catalog_;
@@ -129,17 +203,61 @@ class RecoveryManager : public common::DedicatedThreadOwner {
   // tables during recovery
   const common::ManagedPointer<BlockStore> block_store_;
 
+  // Directory of the checkpoint to recover from, empty if there is none
+  const std::string checkpoint_dir_;
+
+  // The checkpoint recovery starts from
+  CheckpointManager::CheckpointMetadata checkpoint_;
+
+  // Whether the tables of the checkpoint still need to be loaded. Until then, only the catalog changes of the txns that
+  // committed before the checkpoint are replayed, and the txns that committed after it are held back.
+  bool checkpoint_pending_ = false;
+
+  // Used during recovery from a checkpoint. Txns that committed after the checkpoint, in the same order as
+  // deferred_txns_. They join the deferred txns once the checkpoint is loaded.
+  std::set<transaction::timestamp_t> post_checkpoint_txns_;
+
+  // Replays the changes to user tables and rebuilds the indexes on them
+  common::WorkerPool replay_workers_;
+
   // Used during recovery from log. Maps old tuple slot to new tuple slot
   // TODO(Gus): This map may get huge, benchmark whether this becomes a problem and if we need a more sophisticated data
   // structure
   std::unordered_map<TupleSlot, TupleSlot> tuple_slot_map_;
 
+  // Protects tuple_slot_map_ while the replay workers run. Catalog changes are only replayed while they are idle.
+  mutable common::SpinLatch tuple_slot_map_latch_;
+
+  // User tables recreated during recovery. Their indexes are only filled once all changes are replayed.
+  std::vector<std::pair<catalog::db_oid_t, catalog::table_oid_t>> recovered_tables_;
+
+  // Whether read-only txns run on the recovered tables during recovery, see ServeReads
+  bool serve_reads_ = false;
+
+  // Held exclusively by the recovery thread while it replays a batch of txns, and shared by snapshots while they begin
+  common::SharedLatch snapshot_latch_;
+
+  // Whether the recovery thread holds snapshot_latch_ in between batches, which it does until the first watermark
+  bool snapshot_latch_held_ = false;
+
+  // Published once every replayed batch, see ReplayedWatermark
+  std::atomic<transaction::timestamp_t> replayed_watermark_{transaction::INVALID_TXN_TIMESTAMP};
+
+  // Latest commit timestamp of the commit records read so far
+  transaction::timestamp_t max_commit_time_read_ = transaction::INITIAL_TXN_TIMESTAMP;
+
   // Used during recovery from log. Stores deferred transactions in sorted sorted order to be able to execute them in
   // serial order. Transactions are defered when there is an older active transaction at the time it committed. Even
   // though snapshot isolation would handle write-write conflicts, DDL changes such as DROP TABLE combined with GC could
   // lead to issues if we don't execute transactions in complete serial order.
   std::set<transaction::timestamp_t> deferred_txns_;
 
+  // Commit timestamps of the deferred txns, only kept if the log has several streams. A txn that committed after the
+  // last watermark of a stream that ran out may depend on commits the stream lost, so it is not replayed. The bound is
+  // the oldest such watermark, or INVALID_TXN_TIMESTAMP while no stream has run out (see CommitWatermark).
+  std::unordered_map<transaction::timestamp_t, transaction::timestamp_t> commit_times_;
+  transaction::timestamp_t replay_commit_bound_ = transaction::INVALID_TXN_TIMESTAMP;
+
   // Used during recovery from log. Maps a the txn id from the persisted txn to its changes we have buffered. We buffer
   // changes until commit time. This ensures serializability, and allows us to skip changes from aborted txns.
   std::unordered_map<transaction::timestamp_t, std::vector<std::pair<LogRecord *, std::vector<byte *>>>>
@@ -156,23 +274,79 @@ class RecoveryManager : public common::DedicatedThreadOwner {
   uint32_t recovered_txns_;
 
   /**
-   * Recovers the databases using the provided log provider
-   * @return number of committed transactions replayed
+   * Recovers the databases using the provided log provider, starting from the checkpoint if there is one
    */
-  void Recover() { RecoverFromLogs(); }
+  void Recover() {
+    RecoverFromCheckpoint();
+    RecoverFromLogs();
+    if (!serve_reads_) RebuildIndexes(recovered_tables_);
+  }
+
+  /**
+   * Reads the metadata of the checkpoint to recover from, if there is one. Its tables are only loaded during log
+   * replay, since the catalog they belong to is rebuilt from the log.
+   */
+  void RecoverFromCheckpoint();
 
   /**
    * Recovers the databases from the logs.
-   * @note this is a separate method so in the future, we can also have a RecoverFromCheckpoint method
    */
   void RecoverFromLogs();
 
+  /**
+   * Loads the tables of the checkpoint into the recovered tables, and maps the slots their tuples had to the new ones.
+   * The catalog must have been replayed up to the checkpoint.
+   */
+  void LoadCheckpointTables();
+
+  /**
+   * Drops the buffered changes of a txn to user tables, which the checkpoint already holds. Changes to the catalog
+   * tables are kept.
+   * @param txn_id start timestamp of a txn that committed before the checkpoint
+   */
+  void DiscardCheckpointedChanges(transaction::timestamp_t txn_id);
+
   /**
    * @brief Replay a committed transaction corresponding to txn_id.
    * @param txn_id start timestamp for committed transaction
    */
   void ProcessCommittedTransaction(transaction::timestamp_t txn_id);
 
+  /**
+   * Replays committed transactions that only change user tables on the replay workers. The records are split into
+   * partitions by the block their tuple was in before recovery, and every partition is replayed on one worker in the
+   * order of the txns. All records of a tuple thus apply in commit order, while tuples in different partitions, which
+   * do not depend on each other, are replayed concurrently. When serving reads, a table with a unique index is replayed
+   * in a single partition, so that its keys can move between tuples.
+   * @param txn_ids start timestamps of the committed transactions, in the order they have to be replayed in
+   */
+  void ProcessDataTransactions(const std::vector<transaction::timestamp_t> &txn_ids);
+
+  /**
+   * @param txn_id start timestamp of a committed transaction
+   * @return true if the transaction only changes user tables, and thus can be replayed by ProcessDataTransactions
+   */
+  bool IsDataTransaction(transaction::timestamp_t txn_id);
+
+  /**
+   * Fills the indexes on user tables from the replayed tuples, one index per replay worker. Unless serving reads,
+   * indexes on user tables are not maintained while replaying, since nothing reads them before recovery is done.
+   * @param tables the tables, which may have been dropped since
+   */
+  void RebuildIndexes(const std::vector<std::pair<catalog::db_oid_t, catalog::table_oid_t>> &tables);
+
+  /**
+   * Inserts every tuple of a table visible to a txn into an index on it
+   * @param txn txn to insert with
+   * @param sql_table the table
+   * @param table_schema schema of the table
+   * @param index the index
+   * @param index_schema schema of the index
+   */
+  void RebuildIndex(transaction::TransactionContext *txn, common::ManagedPointer<SqlTable> sql_table,
+                    const catalog::Schema &table_schema, common::ManagedPointer<index::Index> index,
+                    const catalog::IndexSchema &index_schema);
+
   /**
    * Defers log records deletes with the transaction manager
    * @param txn_id txn_id for txn who's records to delete
@@ -188,16 +362,64 @@ class RecoveryManager : public common::DedicatedThreadOwner {
    */
   uint32_t ProcessDeferredTransactions(transaction::timestamp_t upper_bound);
 
+  /**
+   * Replays the deferred txns up to the upper bound as ProcessDeferredTransactions does. When serving reads, this is
+   * one batch: no snapshot begins while it replays, and the watermark is published once it is done.
+   * @param upper_bound upper bound for replaying
+   * @return number of transactions replayed
+   */
+  uint32_t ReplayDeferredTransactions(transaction::timestamp_t upper_bound);
+
   /**
    * Handles mapping of old tuple slot (before recovery) to new tuple slot (after recovery)
    * @param slot old tuple slot
    * @return new tuple slot
    */
   TupleSlot GetTupleSlotMapping(TupleSlot slot) {
+    common::SpinLatch::ScopedSpinLatch guard(&tuple_slot_map_latch_);
     TERRIER_ASSERT(tuple_slot_map_.find(slot) != tuple_slot_map_.end(), "No tuple slot mapping exists");
     return tuple_slot_map_[slot];
   }
 
+  /**
+   * Maps an old tuple slot (before recovery) to a new tuple slot (after recovery)
+   * @param old_slot old tuple slot
+   * @param new_slot new tuple slot
+   */
+  void SetTupleSlotMapping(const TupleSlot old_slot, const TupleSlot new_slot) {
+    common::SpinLatch::ScopedSpinLatch guard(&tuple_slot_map_latch_);
+    tuple_slot_map_[old_slot] = new_slot;
+  }
+
+  /**
+   * Removes the mapping of an old tuple slot (before recovery), once the tuple is deleted
+   * @param old_slot old tuple slot
+   */
+  void RemoveTupleSlotMapping(const TupleSlot old_slot) {
+    common::SpinLatch::ScopedSpinLatch guard(&tuple_slot_map_latch_);
+    tuple_slot_map_.erase(old_slot);
+  }
+
+  /**
+   * @param record a redo or delete record
+   * @return oid of the database of the table the record changes
+   */
+  static catalog::db_oid_t GetRecordDatabaseOid(const LogRecord *record) {
+    return record->RecordType() == LogRecordType::REDO
+               ? record->GetUnderlyingRecordBodyAs<RedoRecord>()->GetDatabaseOid()
+               : record->GetUnderlyingRecordBodyAs<DeleteRecord>()->GetDatabaseOid();
+  }
+
+  /**
+   * @param record a redo or delete record
+   * @return oid of the table the record changes
+   */
+  static catalog::table_oid_t GetRecordTableOid(const LogRecord *record) {
+    return record->RecordType() == LogRecordType::REDO
+               ? record->GetUnderlyingRecordBodyAs<RedoRecord>()->GetTableOid()
+               : record->GetUnderlyingRecordBodyAs<DeleteRecord>()->GetTableOid();
+  }
+
   /**
    * Wrapper over GetDatabaseCatalog method that asserts the database exists
    * @param txn txn for catalog lookup
@@ -223,7 +445,7 @@ class RecoveryManager : public common::DedicatedThreadOwner {
                                                         catalog::table_oid_t table_oid);
 
   /**
-   * Inserts or deletes a tuple slot from all indexes on a table.
+   * Inserts or deletes a tuple slot from all indexes on a catalog table.
    * @warning For an insert, must be called after the tuple slot is inserted into the table, for a delete, it must be
    * called before it is deleted from the table
    * @param txn transaction to delete with
@@ -238,6 +460,56 @@ class RecoveryManager : public common::DedicatedThreadOwner {
                             catalog::table_oid_t table_oid, common::ManagedPointer<storage::SqlTable> table_ptr,
                             const TupleSlot &tuple_slot, ProjectedRow *table_pr, bool insert);
 
+  /**
+   * Inserts or deletes a tuple slot from the given indexes on a table, with the same rules as UpdateIndexesOnTable
+   * @param txn transaction to update with
+   * @param indexes indexes on the table and their schemas
+   * @param table_schema schema of the table
+   * @param table_ptr pointer to sql table
+   * @param tuple_slot tuple slot to insert or delete
+   * @param table_pr pointer to PR with values for every column of the table
+   * @param insert true if we should insert into indexes, false for delete
+   */
+  static void UpdateIndexes(
+      transaction::TransactionContext *txn,
+      const std::vector<std::pair<common::ManagedPointer<index::Index>, const catalog::IndexSchema &>> &indexes,
+      const catalog::Schema &table_schema, common::ManagedPointer<storage::SqlTable> table_ptr,
+      const TupleSlot &tuple_slot, ProjectedRow *table_pr, bool insert);
+
+  /**
+   * A user table looked up for replay. When serving reads, it also comes with what it takes to keep its indexes up to
+   * date during replay.
+   */
+  struct ReplayTable {
+    /** The table */
+    common::ManagedPointer<SqlTable> sql_table_;
+    /** Indexes on the table and their schemas, left empty unless serving reads */
+    std::vector<std::pair<common::ManagedPointer<index::Index>, const catalog::IndexSchema &>> indexes_;
+    /** Schema of the table, only set when serving reads */
+    const catalog::Schema *schema_ = nullptr;
+    /** Whether any of the indexes is unique */
+    bool has_unique_index_ = false;
+  };
+
+  /**
+   * Looks up a user table for replay. Only reads the catalog, so it does not take the lock on the database catalog.
+   * @param txn transaction to use for catalog lookup
+   * @param db_oid database oid for requested table
+   * @param table_oid table oid for requested table
+   * @return the table
+   */
+  ReplayTable LookupReplayTable(transaction::TransactionContext *txn, catalog::db_oid_t db_oid,
+                                catalog::table_oid_t table_oid);
+
+  /**
+   * Replays a redo or delete record on a user table that was already looked up, and keeps the indexes that came with
+   * it up to date. Safe to call from the replay workers.
+   * @param txn txn to use for replay
+   * @param record record to replay
+   * @param table table the record changes
+   */
+  void ReplayDataRecord(transaction::TransactionContext *txn, LogRecord *record, const ReplayTable &table);
+
   /**
    * NYS = Not yet supported
    * Returns whether a delete or redo record is a special case catalog record. The special cases we consider are:
@@ -280,6 +552,7 @@ class RecoveryManager : public common::DedicatedThreadOwner {
    * @return true if record is an insert redo, false if it is an update redo
    */
   bool IsInsertRecord(const RedoRecord *record) const {
+    common::SpinLatch::ScopedSpinLatch guard(&tuple_slot_map_latch_);
     return tuple_slot_map_.find(record->GetTupleSlot()) == tuple_slot_map_.end();
   }
 
@@ -322,14 +595,51 @@ class RecoveryManager : public common::DedicatedThreadOwner {
    * @param txn txn to use for replay
    * @param record record to replay
    */
-  void ReplayRedoRecord(transaction::TransactionContext *txn, LogRecord *record);
+  void ReplayRedoRecord(transaction::TransactionContext *txn, LogRecord *record) {
+    auto *redo_record = record->GetUnderlyingRecordBodyAs<RedoRecord>();
+    ReplayRedoRecord(txn, record, GetSqlTable(txn, redo_record->GetDatabaseOid(), redo_record->GetTableOid()));
+  }
+
+  /**
+   * Replays a redo record into a table that was already looked up. Safe to call from the replay workers for records
+   * on user tables, as it does not go through the catalog for them.
+   * @param txn txn to use for replay
+   * @param record record to replay
+   * @param sql_table_ptr table the record changes
+   */
+  void ReplayRedoRecord(transaction::TransactionContext *txn, LogRecord *record,
+                        common::ManagedPointer<SqlTable> sql_table_ptr);
 
   /**
    * Replays a delete record. Updates necessary metadata
    * @param txn txn to use for delete
    * @param record record to replay
    */
-  void ReplayDeleteRecord(transaction::TransactionContext *txn, LogRecord *record);
+  void ReplayDeleteRecord(transaction::TransactionContext *txn, LogRecord *record) {
+    auto *delete_record = record->GetUnderlyingRecordBodyAs<DeleteRecord>();
+    ReplayDeleteRecord(txn, record, GetSqlTable(txn, delete_record->GetDatabaseOid(), delete_record->GetTableOid()));
+  }
+
+  /**
+   * Replays a delete record on a table that was already looked up. Safe to call from the replay workers for records
+   * on user tables, as it does not go through the catalog for them.
+   * @param txn txn to use for delete
+   * @param record record to replay
+   * @param sql_table_ptr table the record deletes from
+   */
+  void ReplayDeleteRecord(transaction::TransactionContext *txn, LogRecord *record,
+                          common::ManagedPointer<SqlTable> sql_table_ptr);
+
+  /**
+   * Fills in the key of a tuple for an index on its table
+   * @param index the index
+   * @param index_schema schema of the index
+   * @param pr_map projection map of the table PR
+   * @param table_pr PR with every column of the tuple
+   * @param index_pr PR initialized for the index, populated with the key
+   */
+  static void PopulateIndexKey(common::ManagedPointer<index::Index> index, const catalog::IndexSchema &index_schema,
+                               const ProjectionMap &pr_map, const ProjectedRow &table_pr, ProjectedRow *index_pr);
 
   /**
    * Returns the list of col oids this redo record modified
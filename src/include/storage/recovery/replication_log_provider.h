@@ -1,19 +1,81 @@
 #pragma once
 
 #include <memory>
+#include <vector>
+
+#include "common/container/concurrent_blocking_queue.h"
+#include "network/network_io_utils.h"
 #include "storage/recovery/abstract_log_provider.h"
 
 namespace terrier::storage {
 
 /**
- * TODO(Tianlei/Gus): Replace this file with Gus's version
+ * @brief Log provider for logs shipped from a primary
+ * Provides the log of one stream of a primary to the recovery manager of a replica as it comes in, so the replica
+ * replays the primary's changes while the primary keeps running. The log arrives in batches from the LogShipperTask at
+ * the other end of a connected socket. Whenever the recovery manager has read a whole batch, the provider acknowledges
+ * how far into the stream it has read before waiting for the next one, which moves the shipper's window forward. The
+ * log ends when the primary shuts down its end of the socket.
+ *
+ * Batches can also be handed over by the network layer instead, in which case nobody is sent acknowledgements.
  */
-class ReplicationLogProvider {
+class ReplicationLogProvider : public AbstractLogProvider {
  public:
   /**
-   * Passes the content of the buffer to traffic cop
-   * @param buffer content to pass to traffic cop
+   * Reads batches handed over through HandBufferToReplication
+   */
+  ReplicationLogProvider() : primary_fd_(-1) {}
+
+  /**
+   * Reads batches from the shipper of a primary
+   * @param primary_fd connected socket to the primary, owned by the caller
+   */
+  explicit ReplicationLogProvider(const int primary_fd) : primary_fd_(primary_fd) {}
+
+  /**
+   * Hands the content of the buffer to the replica as the next batch of logs
+   * @param buffer content to pass on, read in full
+   */
+  void HandBufferToReplication(std::unique_ptr<network::ReadBuffer> buffer);
+
+  /**
+   * Marks the end of the logs handed over through HandBufferToReplication
+   */
+  void EndReplication() { handed_batches_.Enqueue(std::vector<char>()); }
+
+  /**
+   * @return offset in the stream up to which the batches have been read
+   */
+  uint64_t BytesRead() const { return bytes_read_; }
+
+ private:
+  const int primary_fd_;
+  // Batches handed over by the network layer, an empty one marks the end
+  common::ConcurrentBlockingQueue<std::vector<char>> handed_batches_;
+  // The batch being read, and how far into it we are
+  std::vector<char> batch_;
+  uint64_t batch_offset_ = 0;
+  // Offset in the stream of the end of the batches read before the current one
+  uint64_t bytes_read_ = 0;
+  bool ended_ = false;
+
+  /**
+   * @return true if the primary shipped more records, false once the log ended. Blocks until the next batch arrives.
    */
-  virtual void HandBufferToReplication(std::unique_ptr<network::ReadBuffer> buffer);
+  bool HasMoreRecords() override;
+
+  /**
+   * Read data from the shipped batches into the destination provided, across batch boundaries
+   * @param dest pointer to location to read into
+   * @param size number of bytes to read
+   * @return true if we read the given number of bytes
+   */
+  bool Read(void *dest, uint32_t size) override;
+
+  // Acknowledges the batches read so far, then waits for the next one. Returns false once the log ended.
+  bool NextBatch();
+
+  // Receives up to the given number of bytes from the primary, fewer only if the log ended
+  uint64_t Receive(void *dest, uint64_t size);
 };
 }  // namespace terrier::storage
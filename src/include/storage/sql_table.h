@@ -1,11 +1,15 @@
 #pragma once
 #include <list>
+#include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/hash_util.h"
+#include "common/shared_latch.h"
 #include "storage/data_table.h"
 #include "storage/projected_columns.h"
 #include "storage/projected_row.h"
@@ -37,6 +41,7 @@ class SqlTable {
     DataTable *data_table_;
     BlockLayout layout_;
     ColumnMap column_map_;
+    layout_version_t layout_version_;
   };
 
  public:
@@ -54,6 +59,14 @@ class SqlTable {
    */
   ~SqlTable() { delete table_.data_table_; }
 
+  /**
+   * Frees up to the given number of blocks of the table, so that a dropped table can be freed in slices.
+   * @see DataTable::ReleaseBlocks
+   * @param max_blocks maximum number of blocks to free
+   * @return true if the table has no blocks left
+   */
+  bool ReleaseBlocks(const uint32_t max_blocks) { return table_.data_table_->ReleaseBlocks(max_blocks); }
+
   /**
    * Materializes a single tuple from the given slot, as visible at the timestamp of the calling txn.
    *
@@ -164,46 +177,35 @@ class SqlTable {
   /**
    * Generates an ProjectedColumnsInitializer for the execution layer to use. This performs the translation from col_oid
    * to col_id for the Initializer's constructor so that the execution layer doesn't need to know anything about col_id.
+   * The initializer is computed once per set of columns and cached.
    * @param col_oids set of col_oids to be projected
    * @param max_tuples the maximum number of tuples to store in the ProjectedColumn
-   * @return initializer to create ProjectedColumns
+   * @return initializer to create ProjectedColumns, valid for as long as the table
    * @warning col_oids must be a set (no repeats)
    */
-  ProjectedColumnsInitializer InitializerForProjectedColumns(const std::vector<catalog::col_oid_t> &col_oids,
-                                                             const uint32_t max_tuples) const {
-    TERRIER_ASSERT((std::set<catalog::col_oid_t>(col_oids.cbegin(), col_oids.cend())).size() == col_oids.size(),
-                   "There should not be any duplicated in the col_ids!");
-    auto col_ids = ColIdsForOids(col_oids);
-    TERRIER_ASSERT(col_ids.size() == col_oids.size(),
-                   "Projection should be the same number of columns as requested col_oids.");
-    return ProjectedColumnsInitializer(table_.layout_, col_ids, max_tuples);
-  }
+  const ProjectedColumnsInitializer &InitializerForProjectedColumns(const std::vector<catalog::col_oid_t> &col_oids,
+                                                                    uint32_t max_tuples) const;
 
   /**
    * Generates an ProjectedRowInitializer for the execution layer to use. This performs the translation from col_oid to
    * col_id for the Initializer's constructor so that the execution layer doesn't need to know anything about col_id.
+   * The initializer is computed once per set of columns and cached.
    * @param col_oids set of col_oids to be projected
-   * @return initializer to create ProjectedRow
+   * @return initializer to create ProjectedRow, valid for as long as the table
    * @warning col_oids must be a set (no repeats)
    */
-  ProjectedRowInitializer InitializerForProjectedRow(const std::vector<catalog::col_oid_t> &col_oids) const {
-    TERRIER_ASSERT((std::set<catalog::col_oid_t>(col_oids.cbegin(), col_oids.cend())).size() == col_oids.size(),
-                   "There should not be any duplicated in the col_ids!");
-    auto col_ids = ColIdsForOids(col_oids);
-    TERRIER_ASSERT(col_ids.size() == col_oids.size(),
-                   "Projection should be the same number of columns as requested col_oids.");
-    return ProjectedRowInitializer::Create(table_.layout_, col_ids);
-  }
+  const ProjectedRowInitializer &InitializerForProjectedRow(const std::vector<catalog::col_oid_t> &col_oids) const;
 
   /**
-   * Generate a projection map given column oids
+   * Generate a projection map given column oids. The map is computed once per set of columns and cached.
    * @param col_oids oids that will be scanned.
-   * @return the projection map
+   * @return the projection map, valid for as long as the table
    */
-  ProjectionMap ProjectionMapForOids(const std::vector<catalog::col_oid_t> &col_oids);
+  const ProjectionMap &ProjectionMapForOids(const std::vector<catalog::col_oid_t> &col_oids) const;
 
  private:
   friend class RecoveryManager;  // Needs access to OID and ID mappings
+  friend class CheckpointManager;
   friend class terrier::RandomSqlTableTransaction;
   friend class terrier::LargeSqlTableTestObject;
   friend class RecoveryTests;
@@ -214,6 +216,33 @@ class SqlTable {
   // Eventually we'll support adding more tables when schema changes. For now we'll always access the one DataTable.
   DataTableVersion table_;
 
+  // Everything derived from a list of col_oids for a version of the table, so that point queries do not have to
+  // translate and sort the same columns every time. Entries are never removed, so references to them stay valid for
+  // the lifetime of the table. Entries for the same columns listed in a different order are separate.
+  struct CachedProjection {
+    std::optional<ProjectedRowInitializer> row_initializer_;
+    std::optional<ProjectionMap> projection_map_;
+    // Keyed by the maximum number of tuples
+    std::unordered_map<uint32_t, ProjectedColumnsInitializer> columns_initializers_;
+  };
+
+  struct ColOidsHasher {
+    size_t operator()(const std::vector<catalog::col_oid_t> &col_oids) const {
+      return common::HashUtil::HashBytes(reinterpret_cast<const byte *>(col_oids.data()),
+                                         col_oids.size() * sizeof(catalog::col_oid_t));
+    }
+  };
+
+  using ProjectionCache = std::unordered_map<std::vector<catalog::col_oid_t>, CachedProjection, ColOidsHasher>;
+
+  mutable common::SharedLatch projection_cache_latch_;
+  // Keyed by layout version, so a new version of the table starts out with an empty cache
+  mutable std::unordered_map<layout_version_t, ProjectionCache> projection_caches_;
+
+  // Returns the cache entry for the given columns in the current version, or nullptr if there is none. The caller must
+  // hold projection_cache_latch_.
+  const CachedProjection *FindCachedProjection(const std::vector<catalog::col_oid_t> &col_oids) const;
+
   /**
    * Given a set of col_oids, return a vector of corresponding col_ids to use for ProjectionInitialization
    * @param col_oids set of col_oids, they must be in the table's ColumnMap
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <functional>
 #include <ostream>
 #include <string>
@@ -212,18 +213,56 @@ enum class DeltaRecordType : uint8_t { UPDATE = 0, INSERT, DELETE };
 /**
  * Types of LogRecords
  */
-enum class LogRecordType : uint8_t { REDO = 1, DELETE, COMMIT, ABORT };
+enum class LogRecordType : uint8_t { REDO = 1, DELETE, COMMIT, ABORT, WATERMARK };
 
 /**
  * Callback function and arguments to be called when record is persisted
  */
 using CommitCallback = std::pair<transaction::callback_fn, void *>;
 
+/**
+ * Points in time a sampled synchronous commit passes in the log manager, which break its latency down into the stages
+ * of metrics::CommitStage
+ */
+struct CommitLatencySample {
+  /**
+   * Index of the commit's callback among the callbacks it is handed over with
+   */
+  uint64_t callback_index_;
+  /**
+   * Points in time, in the order the commit passes them: redo buffer handed to the serializer, serializer started on
+   * it, log buffer handed to the consumer, consumer took it, written, persist started, persisted, callback invoked
+   */
+  std::chrono::high_resolution_clock::time_point handed_, serializing_, serialized_, dequeued_, written_, persisting_,
+      persisted_, notified_;
+};
+
 /**
  * A BufferedLogWriter containing serialized logs, as well as all commit callbacks for transaction's whose commit are
  * serialized in this BufferedLogWriter
  */
-using SerializedLogs = std::pair<BufferedLogWriter *, std::vector<CommitCallback>>;
+struct SerializedLogs {
+  /**
+   * Buffer holding the logs, nullptr if only read-only txns committed
+   */
+  BufferedLogWriter *buffer_ = nullptr;
+  /**
+   * Callbacks of the synchronous commits in the buffer
+   */
+  std::vector<CommitCallback> commit_callbacks_;
+  /**
+   * Commit timestamps of these commits, only kept if the log has several streams
+   */
+  std::vector<transaction::timestamp_t> commit_times_;
+  /**
+   * The commits among them sampled for their latency
+   */
+  std::vector<CommitLatencySample> commit_samples_;
+  /**
+   * Watermark written at the end of the buffer, or INITIAL_TXN_TIMESTAMP if there is none (see CommitWatermark)
+   */
+  transaction::timestamp_t watermark_ = transaction::INITIAL_TXN_TIMESTAMP;
+};
 
 /**
  * A varlen entry is always a 32-bit size field and the varlen content,
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/allocator.h"
+
+namespace terrier::storage {
+/**
+ * Allocator for the contents of reclaimable varlen entries that transactions write into the storage engine.
+ *
+ * Small and medium sized varlens are bump-allocated from size-classed slabs, with each thread allocating from its own
+ * slab per size class so that the writes of a transaction end up next to each other. Individual varlens are never
+ * reused. Instead, a slab counts the varlens it holds that are still alive, and goes back to the system as a whole once
+ * the last of them has been freed (i.e. when the GC has proven all versions pointing into it dead). This saves the
+ * per-value malloc and free calls on string-heavy write workloads, and keeps their varlens from fragmenting the heap.
+ *
+ * Varlens larger than the largest size class fall back to common::AllocationUtil::AllocateAligned. Free accepts both
+ * kinds of pointers, as well as any other pointer allocated with new[] and handed to the storage engine as a
+ * reclaimable varlen.
+ */
+class VarlenArena {
+ public:
+  VarlenArena() = delete;
+
+  /**
+   * Size of a slab, in bytes. Slabs are aligned to their size, so the slab a pointer belongs to can be computed.
+   */
+  static constexpr uint64_t SLAB_SIZE = 1 << 18;
+  /**
+   * Smallest size class, in bytes. Size classes are the powers of two up to MAX_CLASS_SIZE.
+   */
+  static constexpr uint32_t MIN_CLASS_SIZE = 16;
+  /**
+   * Largest size class, in bytes. Anything larger is allocated on its own.
+   */
+  static constexpr uint32_t MAX_CLASS_SIZE = 4096;
+  /**
+   * Number of size classes
+   */
+  static constexpr uint32_t NUM_SIZE_CLASSES = 9;
+
+  /**
+   * Allocates a buffer for the contents of a varlen entry. The returned pointer is aligned to 8 bytes.
+   * @param size size of the varlen contents, in bytes
+   * @return allocated buffer, to be given back with Free
+   */
+  static byte *Allocate(uint32_t size);
+
+  /**
+   * Frees the contents of a reclaimable varlen entry.
+   * @param ptr pointer obtained from Allocate, or from new[]
+   */
+  static void Free(const byte *ptr);
+
+  /**
+   * @return number of slabs currently allocated by all threads
+   */
+  static uint64_t NumSlabs();
+};
+}  // namespace terrier::storage
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "common/spin_latch.h"
+#include "storage/storage_defs.h"
+#include "transaction/transaction_defs.h"
+
+namespace terrier::storage {
+
+/**
+ * Holds back the commit callbacks of a log split into several streams until their commits are durable together with
+ * every commit they can depend on, which may have gone to another stream.
+ *
+ * Every serializer round starts by reading the newest commit time any stream has serialized, and ends by writing it
+ * out as a watermark record. A txn only sees a commit once the commit record is handed to its stream (see
+ * TransactionManager::UpdatingCommitCriticalSection), so a commit the round did not pick up was handed over after the
+ * round started, and every commit that depends on it is newer than the watermark. Once a stream has persisted a
+ * watermark, it thus holds everything a commit up to the watermark can depend on.
+ *
+ * A callback is released once every stream has persisted a watermark at least as new as its commit. Recovery replays
+ * no commit newer than the last watermark of every stream, which covers every commit whose callback was released.
+ */
+class CommitWatermark {
+ public:
+  /**
+   * @param num_streams number of log streams
+   */
+  explicit CommitWatermark(const uint32_t num_streams)
+      : stream_watermarks_(num_streams, transaction::INITIAL_TXN_TIMESTAMP) {}
+
+  /**
+   * Called by the serializer of a stream for every commit it serializes
+   * @param commit_time commit timestamp of the txn
+   */
+  void Serialized(const transaction::timestamp_t commit_time) {
+    auto newest = max_serialized_.load();
+    while (newest < commit_time && !max_serialized_.compare_exchange_weak(newest, commit_time)) {
+    }
+  }
+
+  /**
+   * @return newest commit time serialized by any stream, which a serializer round writes out as its watermark
+   */
+  transaction::timestamp_t MaxSerialized() const { return max_serialized_.load(); }
+
+  /**
+   * Wakes up the serializers waiting for commits of other streams to write a watermark for
+   */
+  void NotifySerialized();
+
+  /**
+   * Blocks the serializer of an idle stream until another stream serializes a commit newer than the given one, or the
+   * timeout passes
+   * @param watermark watermark the stream last wrote out
+   * @param timeout longest time to wait
+   */
+  void WaitForSerialized(transaction::timestamp_t watermark, std::chrono::microseconds timeout);
+
+  /**
+   * Called by the consumer of a stream once a persist is done. Releases every held back callback, of any stream, that
+   * the persist lets through, and holds back the rest of the given ones.
+   * @param stream the stream that persisted
+   * @param watermark newest watermark the persist made durable, which never goes back for a stream
+   * @param commit_times commit timestamps of the synchronous commits the persist made durable
+   * @param commit_callbacks their callbacks
+   */
+  void Persisted(uint32_t stream, transaction::timestamp_t watermark,
+                 const std::vector<transaction::timestamp_t> &commit_times,
+                 const std::vector<CommitCallback> &commit_callbacks);
+
+  /**
+   * @return commit time up to which every stream has persisted all commits, and their callbacks are released
+   */
+  transaction::timestamp_t Get() const {
+    common::SpinLatch::ScopedSpinLatch guard(&latch_);
+    return DurableWatermark();
+  }
+
+ private:
+  using PendingCommit = std::pair<transaction::timestamp_t, CommitCallback>;
+  struct NewerCommit {
+    bool operator()(const PendingCommit &a, const PendingCommit &b) const { return a.first > b.first; }
+  };
+
+  // Oldest watermark persisted by any stream, must hold latch_
+  transaction::timestamp_t DurableWatermark() const;
+
+  std::atomic<transaction::timestamp_t> max_serialized_{transaction::INITIAL_TXN_TIMESTAMP};
+  // Serializers of idle streams wait on this for others to serialize commits
+  std::mutex serialized_latch_;
+  std::condition_variable serialized_cv_;
+
+  // Protects the persisted watermarks and the held back callbacks
+  mutable common::SpinLatch latch_;
+  std::vector<transaction::timestamp_t> stream_watermarks_;
+  // Callbacks of persisted commits that some stream has not caught up with yet, oldest commit first
+  std::priority_queue<PendingCommit, std::vector<PendingCommit>, NewerCommit> pending_commits_;
+};
+
+}  // namespace terrier::storage
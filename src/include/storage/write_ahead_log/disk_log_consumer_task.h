@@ -1,18 +1,47 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
 #include <utility>
 #include <vector>
 #include "common/container/concurrent_blocking_queue.h"
 #include "common/container/concurrent_queue.h"
 #include "common/dedicated_thread_registry.h"
+#include "common/spin_latch.h"
+#include "common/worker_pool.h"
 #include "storage/storage_defs.h"
+#include "storage/write_ahead_log/commit_watermark.h"
 #include "storage/write_ahead_log/log_io.h"
+#include "storage/write_ahead_log/log_segment_manifest.h"
+#include "storage/write_ahead_log/log_shipper_task.h"
 
 namespace terrier::storage {
 
 /**
  * A DiskLogConsumerTask is responsible for writing serialized log records out to disk by processing buffers in the log
  * manager's filled buffer queue
+ *
+ * Commits are made durable in groups. A group opens with the first commit written after a persist, and is persisted
+ * together once the group commit window has passed or enough commits have joined it. The window follows the observed
+ * fsync latency, up to a configured maximum: while one group is being persisted, about as many commits arrive as can
+ * be made durable by the next fsync, so waiting longer only adds latency.
+ *
+ * Persists can be handed to a pool of workers, so that the task keeps writing the next group out while earlier groups
+ * are still being synced, with up to a configured number of persists in flight. The log file can also be preallocated
+ * in large chunks ahead of the writes, so that appending to it does not have to allocate blocks on the way.
+ *
+ * Once the open log segment has grown past the segment size, the task persists it and moves all buffers over to the
+ * next segment at the first record boundary (see LogSegmentManifest).
+ *
+ * If the stream ships its log to a replica, the task hands every buffer it writes to the LogShipperTask as well, and
+ * releases what a persist covered for shipping once the persist is done.
+ *
+ * If the log has several streams, a persist hands its commits to the CommitWatermark instead of invoking their
+ * callbacks, along with the newest watermark it made durable. A new watermark opens a group just like a commit does,
+ * since the commits of the other streams may be waiting for it.
  */
 class DiskLogConsumerTask : public common::DedicatedThreadTask {
  public:
@@ -20,21 +49,48 @@ class DiskLogConsumerTask : public common::DedicatedThreadTask {
    * Constructs a new DiskLogConsumerTask
    * @param persist_interval Interval time for when to persist log file
    * @param persist_threshold threshold of data written since the last persist to trigger another persist
+   * @param max_group_commit_window upper bound on how long the first commit of a group waits for others to join it
+   * @param group_commit_size number of commits that make a group persist right away
    * @param buffers pointer to list of all buffers used by log manager, used to persist log file
    * @param empty_buffer_queue pointer to queue to push empty buffers to
    * @param filled_buffer_queue pointer to queue to pop filled buffers from
+   * @param preallocate_size size of the chunks the log file is preallocated in, or 0 to let it grow on demand
+   * @param max_persists_in_flight number of persists that can run in the background, or 0 to persist inline
+   * @param manifest manifest of the log segments the buffers write to, or nullptr to never rotate the log file
+   * @param segment_size size past which the open log segment is closed and the next one opened
+   * @param shipper shipper of the stream's log to a replica, or nullptr if the stream has no replica
+   * @param commit_watermark watermark shared by the streams of the log, or nullptr if it only has one
+   * @param stream the stream the task writes out
    */
   explicit DiskLogConsumerTask(const std::chrono::milliseconds persist_interval, uint64_t persist_threshold,
-                               std::vector<BufferedLogWriter> *buffers,
+                               const std::chrono::microseconds max_group_commit_window,
+                               const uint64_t group_commit_size, std::vector<BufferedLogWriter> *buffers,
                                common::ConcurrentBlockingQueue<BufferedLogWriter *> *empty_buffer_queue,
-                               common::ConcurrentQueue<storage::SerializedLogs> *filled_buffer_queue)
+                               common::ConcurrentQueue<storage::SerializedLogs> *filled_buffer_queue,
+                               const uint64_t preallocate_size = 0, const uint32_t max_persists_in_flight = 0,
+                               LogSegmentManifest *manifest = nullptr, const uint64_t segment_size = 0,
+                               LogShipperTask *shipper = nullptr, CommitWatermark *commit_watermark = nullptr,
+                               const uint32_t stream = 0)
       : run_task_(false),
         persist_interval_(persist_interval),
         persist_threshold_(persist_threshold),
+        max_group_commit_window_(max_group_commit_window),
+        group_commit_size_(group_commit_size),
+        group_commit_window_(max_group_commit_window),
         current_data_written_(0),
         buffers_(buffers),
         empty_buffer_queue_(empty_buffer_queue),
-        filled_buffer_queue_(filled_buffer_queue) {}
+        filled_buffer_queue_(filled_buffer_queue),
+        preallocate_size_(preallocate_size),
+        max_persists_in_flight_(max_persists_in_flight),
+        persist_workers_(max_persists_in_flight, {}),
+        manifest_(manifest),
+        segment_size_(segment_size),
+        shipper_(shipper),
+        commit_watermark_(commit_watermark),
+        stream_(stream) {
+    if (max_persists_in_flight_ > 0) persist_workers_.Startup();
+  }
 
   /**
    * Runs main disk log writer loop. Called by thread registry upon initialization of thread
@@ -46,17 +102,43 @@ class DiskLogConsumerTask : public common::DedicatedThreadTask {
    */
   void Terminate() override;
 
+  /**
+   * @return how long the first commit of a group currently waits for others to join it
+   */
+  std::chrono::microseconds GetGroupCommitWindow() const { return group_commit_window_.load(); }
+
  private:
   friend class LogManager;
   // Flag to signal task to run or stop
   bool run_task_;
   // Stores callbacks for commit records written to disk but not yet persisted
   std::vector<storage::CommitCallback> commit_callbacks_;
+  // Their commit times, if the log has several streams
+  std::vector<transaction::timestamp_t> commit_times_;
+  // Sampled commits among them
+  std::vector<storage::CommitLatencySample> commit_samples_;
 
   // Interval time for when to persist log file
   const std::chrono::milliseconds persist_interval_;
   // Threshold of data written since the last persist to trigger another persist
   uint64_t persist_threshold_;
+  // Upper bound of the group commit window
+  const std::chrono::microseconds max_group_commit_window_;
+  // Number of commits that make a group persist right away
+  const uint64_t group_commit_size_;
+  // Current group commit window, following the fsync latency
+  std::atomic<std::chrono::microseconds> group_commit_window_;
+  // Protects the fsync latency statistics, which persists in flight update concurrently
+  common::SpinLatch fsync_latency_latch_;
+  // Moving average of the fsync latency in microseconds
+  double fsync_latency_ = 0;
+  // Latencies of the persists done since the metrics last picked them up, if logging metrics are on
+  bool record_persist_latencies_ = false;
+  std::vector<std::chrono::microseconds> persist_latencies_;
+  // Sampled commits whose callbacks have been invoked since the metrics last picked them up
+  std::vector<storage::CommitLatencySample> finished_commit_samples_;
+  // When the first commit of the open group was written
+  std::chrono::high_resolution_clock::time_point group_start_;
   // Amount of data written since last persist
   uint64_t current_data_written_;
 
@@ -67,6 +149,38 @@ class DiskLogConsumerTask : public common::DedicatedThreadTask {
   // The queue containing filled buffers. Task should dequeue filled buffers from this queue to flush
   common::ConcurrentQueue<SerializedLogs> *filled_buffer_queue_;
 
+  // Size of the chunks the log file is preallocated in, or 0 to let it grow on demand
+  const uint64_t preallocate_size_;
+  // Size of the log file, and end of the part of it that is preallocated
+  uint64_t file_size_ = 0, preallocated_end_ = 0;
+
+  // Workers persisting groups of commits in the background, if there are any
+  const uint32_t max_persists_in_flight_;
+  common::WorkerPool persist_workers_;
+  // Number of persists handed to the workers and not done yet. The task waits on the condition variable for a worker
+  // to free up, instead of spinning through a whole fsync.
+  uint32_t persists_in_flight_ = 0;
+  std::mutex persists_in_flight_latch_;
+  std::condition_variable persists_in_flight_cv_;
+
+  // Manifest of the log segments, or nullptr if the log file is never rotated
+  LogSegmentManifest *const manifest_;
+  // Size past which the open log segment is closed
+  const uint64_t segment_size_;
+  // Range of begin timestamps of the txns with records in the open log segment
+  transaction::timestamp_t segment_min_txn_begin_ = transaction::timestamp_t(UINT64_MAX);
+  transaction::timestamp_t segment_max_txn_begin_ = transaction::INITIAL_TXN_TIMESTAMP;
+
+  // Shipper of the log to a replica, or nullptr if the stream has no replica
+  LogShipperTask *const shipper_;
+
+  // Watermark shared by the streams of the log, or nullptr if it only has one, and the stream this task writes out
+  CommitWatermark *const commit_watermark_;
+  const uint32_t stream_;
+  // Newest watermark written to the log file, and whether it has been written since the last persist
+  transaction::timestamp_t written_watermark_ = transaction::INITIAL_TXN_TIMESTAMP;
+  bool watermark_unpersisted_ = false;
+
   // Flag used by the serializer thread to signal the disk log consumer task thread to persist the data on disk
   volatile bool do_persist_;
 
@@ -88,11 +202,69 @@ class DiskLogConsumerTask : public common::DedicatedThreadTask {
    */
   void WriteBuffersToLogFile();
 
+  /**
+   * @return whether a group is open, i.e. commits or a watermark have been written since the last persist
+   */
+  bool GroupOpen() const { return !commit_callbacks_.empty() || watermark_unpersisted_; }
+
+  /**
+   * @return whether the open group of commits, if any, should be persisted now
+   */
+  bool GroupCommitDue() const;
+
+  /**
+   * Folds the latency of an fsync into the moving average, and sets the group commit window from it
+   * @param latency time the fsync took
+   */
+  void AdaptGroupCommitWindow(std::chrono::microseconds latency);
+
+  /**
+   * Makes sure the log file has space allocated for another full buffer past its end, if preallocation is on
+   * @param writer buffer to preallocate through, all buffers write to the same file
+   */
+  void PreallocateLogFile(BufferedLogWriter *writer);
+
+  /**
+   * @return whether the open log segment has grown past the segment size, and should be closed at the next record
+   *         boundary
+   */
+  bool SegmentFull() const { return manifest_ != nullptr && segment_size_ > 0 && file_size_ >= segment_size_; }
+
+  /**
+   * Persists the open log segment, records it as closed, and moves all buffers over to the next segment
+   */
+  void RotateLogSegment();
+
   /*
    * Persists the log file on disk by calling fsync, as well as calling callbacks for all committed transactions that
-   * were persisted
+   * were persisted. The persist runs in the background if persists are allowed to be in flight.
    * @return number of buffers persisted, used for metrics
    */
   uint64_t PersistLogFile();
+
+  /**
+   * Calls fsync on the log file, then the callbacks of the group of commits written before it, or hands them to the
+   * watermark if the log has several streams
+   * @param commit_callbacks callbacks of the group of commits
+   * @param commit_times commit times of the group, if the log has several streams
+   * @param watermark newest watermark written before the persist
+   * @param commit_samples sampled commits of the group, whose persist and callback are stamped along the way
+   * @param shipped_offset offset in the shipped stream the persist covers, released for shipping once it is done
+   */
+  void PersistGroup(const std::vector<storage::CommitCallback> &commit_callbacks,
+                    const std::vector<transaction::timestamp_t> &commit_times, transaction::timestamp_t watermark,
+                    std::vector<storage::CommitLatencySample> commit_samples, uint64_t shipped_offset);
+
+  /**
+   * Records the latency breakdowns of the sampled commits that finished, if logging metrics are on
+   */
+  void RecordCommitLatencies();
+
+  /**
+   * Blocks until all persists in flight are done
+   */
+  void WaitForPersistsInFlight() {
+    if (max_persists_in_flight_ > 0) persist_workers_.WaitUntilAllFinished();
+  }
 };
 }  // namespace terrier::storage
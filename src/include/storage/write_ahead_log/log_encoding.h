@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace terrier::storage {
+
+/**
+ * Helpers for the compact encoding of serialized log records. Integers are written as LEB128 varints, 7 bits per byte
+ * with the high bit set on every byte but the last, so the small oids, column ids and lengths that make up most of a
+ * record take a byte or two. Signed differences are zigzag-encoded first, so that small negative values stay short.
+ */
+struct LogEncoding {
+  LogEncoding() = delete;  // Un-instantiable
+
+  /**
+   * Most bytes a varint of a 64-bit value takes
+   */
+  static constexpr uint32_t MAX_VARINT_SIZE = 10;
+
+  /**
+   * @param value value to encode
+   * @param out buffer of at least MAX_VARINT_SIZE bytes to encode into
+   * @return number of bytes the encoded value takes
+   */
+  static uint32_t EncodeVarint(uint64_t value, uint8_t *const out) {
+    uint32_t size = 0;
+    while (value >= 0x80) {
+      out[size++] = static_cast<uint8_t>(value | 0x80);
+      value >>= 7;
+    }
+    out[size++] = static_cast<uint8_t>(value);
+    return size;
+  }
+
+  /**
+   * @tparam ReadByte callable returning the next byte of the log
+   * @param read_byte reads the next byte of the log
+   * @throws runtime_error if the varint runs longer than any 64-bit value could
+   * @return the decoded value
+   */
+  template <class ReadByte>
+  static uint64_t DecodeVarint(ReadByte read_byte) {
+    uint64_t value = 0;
+    for (uint32_t shift = 0; shift < 7 * MAX_VARINT_SIZE; shift += 7) {
+      const uint8_t next = read_byte();
+      value |= static_cast<uint64_t>(next & 0x7F) << shift;
+      if ((next & 0x80) == 0) return value;
+    }
+    throw std::runtime_error("Malformed varint deserialized from the log, possible data corruption");
+  }
+
+  /**
+   * @param value signed value
+   * @return value mapped to an unsigned one, with small magnitudes mapped to small values
+   */
+  static constexpr uint64_t ZigZagEncode(const int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+  }
+
+  /**
+   * @param value value produced by ZigZagEncode
+   * @return the original signed value
+   */
+  static constexpr int64_t ZigZagDecode(const uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+};
+
+}  // namespace terrier::storage
@@ -5,11 +5,20 @@
 #include <sys/uio.h>
 #include <unistd.h>
 #include <cerrno>
+#include <algorithm>
 #include <cstring>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "common/constants.h"
 #include "common/macros.h"
 #include "loggers/storage_logger.h"
+#include "storage/write_ahead_log/log_encoding.h"
+#include "transaction/transaction_defs.h"
+
+namespace terrier::transaction {
+class TimestampManager;
+}  // namespace terrier::transaction
 
 namespace terrier::storage {
 
@@ -68,12 +77,106 @@ struct PosixIoWrappers {
    * @throws runtime_error if the underlying posix call failed
    */
   static void WriteFully(int fd, const void *buf, size_t nbyte);
+
+  /**
+   * Wrapper around the posix writev call, where a single function call will always write out all of the given buffers.
+   * (unlike posix writev, which can write arbitrarily many bytes less than the given amount, and caps the number of
+   * buffers at IOV_MAX)
+   * @param fd posix fildes arg
+   * @param iov posix iov arg. The array is consumed (modified in place) as the buffers are written out.
+   * @param iovcnt posix iovcnt arg, can be larger than IOV_MAX
+   * @throws runtime_error if the underlying posix call failed
+   */
+  static void WriteVFully(int fd, struct iovec *iov, size_t iovcnt);
+
+  /**
+   * Same as ReadFully, but reads from the given offset with pread, so the file offset is left alone and several threads
+   * can read from the same file at once.
+   * @param fd posix fildes arg
+   * @param buf posix buf arg
+   * @param nbyte posix nbyte arg
+   * @param offset posix offset arg
+   * @throws runtime_error if the underlying posix call failed
+   * @return nbyte if the read is successful, or the number of bytes actually read if eof is read before nbytes are read
+   */
+  static uint32_t PreadFully(int fd, void *buf, size_t nbyte, off_t offset);
+
+  /**
+   * Same as WriteVFully, but writes at the given offset with pwritev, so the file offset is left alone and several
+   * threads can write to the same file at once.
+   * @param fd posix fildes arg
+   * @param iov posix iov arg. The array is consumed (modified in place) as the buffers are written out.
+   * @param iovcnt posix iovcnt arg, can be larger than IOV_MAX
+   * @param offset posix offset arg
+   * @throws runtime_error if the underlying posix call failed
+   */
+  static void PwriteVFully(int fd, struct iovec *iov, size_t iovcnt, off_t offset);
+
+  /**
+   * Wrapper around the linux fallocate call, reserving disk space for the given range of the file without changing its
+   * size, so that later writes into the range do not have to allocate blocks.
+   * @param fd file descriptor of the file
+   * @param offset start of the range
+   * @param len length of the range
+   * @return whether the space was reserved. This fails if the file system does not support it, which is not an error.
+   */
+  static bool Preallocate(int fd, off_t offset, off_t len);
+
+  /**
+   * Wrapper around the posix fstat call
+   * @param fd file descriptor of the file
+   * @throws runtime_error if the underlying posix call failed
+   * @return size of the file in bytes
+   */
+  static uint64_t FileSize(int fd);
 };
+
+/**
+ * Owns a file descriptor and closes it when going out of scope, so that it is not leaked when an error is thrown
+ * while the file is open. Errors closing the file are only reported when it is closed explicitly.
+ */
+class ScopedFileDescriptor {
+ public:
+  /**
+   * @param fd file descriptor to take ownership of
+   */
+  explicit ScopedFileDescriptor(const int fd) : fd_(fd) {}
+
+  ~ScopedFileDescriptor() {
+    if (fd_ != -1) close(fd_);
+  }
+
+  DISALLOW_COPY_AND_MOVE(ScopedFileDescriptor)
+
+  /**
+   * @return the file descriptor
+   */
+  int Get() const { return fd_; }
+
+  /**
+   * Closes the file
+   * @throws runtime_error if the underlying posix call failed
+   */
+  void Close() {
+    const int fd = fd_;
+    fd_ = -1;
+    PosixIoWrappers::Close(fd);
+  }
+
+ private:
+  int fd_;
+};
+
 // TODO(Tianyu):  we need control over when and what to flush as the log manager. Thus, we need to write our
 // own wrapper around lower level I/O functions. I could be wrong, and in that case we should
 // revert to using STL.
 /**
  * Handles buffered writes to the write ahead log, and provides control over flushing.
+ *
+ * Besides the bytes copied into its buffer, a BufferedLogWriter can hold references to memory it writes out in place
+ * when it is flushed, all in one writev. The referenced memory is kept alive by pinning the txns it belongs to: they
+ * stay in their TimestampManager's running set, which keeps GC from freeing their varlens, until the flush releases
+ * them.
  */
 class BufferedLogWriter {
   // TODO(Tianyu): Checksum
@@ -92,6 +195,15 @@ class BufferedLogWriter {
    */
   void Close() { PosixIoWrappers::Close(out_); }
 
+  /**
+   * Switch to writing to another log file. Anything still buffered is written to the new file when flushed.
+   * @param log_file_path path to the log file to write to from now on
+   */
+  void Reopen(const char *log_file_path) {
+    Close();
+    out_ = PosixIoWrappers::Open(log_file_path, O_WRONLY | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR);
+  }
+
   /**
    * Write to the log file the given amount of bytes from the given location in memory, but buffer the write so the
    * update is only written out when the BufferedLogWriter is persisted. Note that this function writes to the buffer
@@ -114,37 +226,128 @@ class BufferedLogWriter {
   }
 
   /**
-   * Call fsync to make sure that all writes are consistent.
+   * Write to the log file the given amount of bytes from the given location in memory without copying them, as if
+   * they were buffered after everything buffered so far. The memory has to stay valid and unchanged until the buffer
+   * is flushed, see PinTxn.
+   * @param data memory location of the bytes to write
+   * @param size number of bytes to write
+   */
+  void BufferWriteReference(const void *data, uint32_t size) {
+    TERRIER_ASSERT(!IsBufferFull(), "buffer must not be full when referencing more data");
+    references_.push_back({buffer_size_, data, size});
+    referenced_size_ += size;
+  }
+
+  /**
+   * Keep the txn with the given begin timestamp in the running set of its TimestampManager until this buffer is
+   * flushed, which keeps the memory referenced by its records alive until then
+   * @param timestamp_manager timestamp manager the txn belongs to
+   * @param txn_begin begin timestamp of the txn
+   */
+  void PinTxn(transaction::TimestampManager *timestamp_manager, const transaction::timestamp_t txn_begin) {
+    pinned_txns_[timestamp_manager].push_back(txn_begin);
+  }
+
+  /**
+   * Call fdatasync to make sure that all writes are consistent. Unlike fsync, this skips metadata that is not needed to
+   * read the data back, but still persists the file size, so appended records are covered.
    */
   void Persist() {
-    if (fsync(out_) == -1) throw std::runtime_error("fsync failed with errno " + std::to_string(errno));
+    if (fdatasync(out_) == -1) throw std::runtime_error("fdatasync failed with errno " + std::to_string(errno));
+  }
+
+  /**
+   * Reserve disk space for the given range of the log file, without changing its size
+   * @param offset start of the range
+   * @param size length of the range
+   */
+  void Preallocate(uint64_t offset, uint64_t size) {
+    PosixIoWrappers::Preallocate(out_, static_cast<off_t>(offset), static_cast<off_t>(size));
   }
 
   /**
-   * Flush any buffered writes.
+   * @return current size of the log file
+   */
+  uint64_t FileSize() const { return PosixIoWrappers::FileSize(out_); }
+
+  /**
+   * Flush any buffered writes, including the referenced ones, and release the pinned txns afterwards.
    * @return amount of data flushed
    */
-  uint64_t FlushBuffer() {
-    auto size = buffer_size_;
-    WriteUnsynced(buffer_, buffer_size_);
-    buffer_size_ = 0;
-    return size;
+  uint64_t FlushBuffer();
+
+  /**
+   * Note that a record of the txn with the given begin timestamp is (partly) written to the buffer
+   * @param txn_begin begin timestamp of the txn
+   */
+  void AddTxn(const transaction::timestamp_t txn_begin) {
+    min_txn_begin_ = std::min(min_txn_begin_, txn_begin);
+    max_txn_begin_ = std::max(max_txn_begin_, txn_begin);
+  }
+
+  /**
+   * @return oldest begin timestamp of the txns with records in the buffer
+   */
+  transaction::timestamp_t MinTxnBegin() const { return min_txn_begin_; }
+
+  /**
+   * @return newest begin timestamp of the txns with records in the buffer
+   */
+  transaction::timestamp_t MaxTxnBegin() const { return max_txn_begin_; }
+
+  /**
+   * Note that the buffer ends on a record boundary, so that the log file can be switched after flushing it
+   */
+  void MarkEndsOnRecord() { ends_on_record_ = true; }
+
+  /**
+   * @return whether the buffer ends on a record boundary
+   */
+  bool EndsOnRecord() const { return ends_on_record_; }
+
+  /**
+   * @return if the buffer is full, either because it has no space left or it can't hold any more references
+   */
+  bool IsBufferFull() {
+    return buffer_size_ == common::Constants::LOG_BUFFER_SIZE || references_.size() == MAX_REFERENCES;
   }
 
   /**
-   * @return if the buffer is full
+   * @return the writes buffered since the last flush, in the order they go to the log file
+   */
+  std::vector<struct iovec> BufferedWrites() const;
+
+  /**
+   * @return number of bytes buffered since the last flush, including the referenced ones
    */
-  bool IsBufferFull() { return buffer_size_ == common::Constants::LOG_BUFFER_SIZE; }
+  uint64_t BufferedSize() const { return buffer_size_ + referenced_size_; }
 
  private:
+  // Caps the number of references in the buffer, so that every buffer can be written out with a single writev
+  static constexpr uint32_t MAX_REFERENCES = 64;
+
+  // Memory referenced by the buffer, written out after the first offset_ bytes of the buffer
+  struct Reference {
+    uint32_t offset_;
+    const void *data_;
+    uint32_t size_;
+  };
+
   int out_;  // fd of the output files
   char buffer_[common::Constants::LOG_BUFFER_SIZE];
 
   uint32_t buffer_size_ = 0;
+  std::vector<Reference> references_;
+  uint64_t referenced_size_ = 0;
+  // Txns that keep the referenced memory alive, released once the buffer is flushed
+  std::unordered_map<transaction::TimestampManager *, std::vector<transaction::timestamp_t>> pinned_txns_;
+  // Range of begin timestamps of the txns with records in the buffer, empty if min > max
+  transaction::timestamp_t min_txn_begin_ = transaction::timestamp_t(UINT64_MAX);
+  transaction::timestamp_t max_txn_begin_ = transaction::INITIAL_TXN_TIMESTAMP;
+  bool ends_on_record_ = false;
 
   bool CanBuffer(uint32_t size) { return common::Constants::LOG_BUFFER_SIZE - buffer_size_ >= size; }
 
-  void WriteUnsynced(const void *data, uint32_t size) { PosixIoWrappers::WriteFully(out_, data, size); }
 };
 
 /**
@@ -197,6 +400,14 @@ class BufferedLogReader {
     return result;
   }
 
+  /**
+   * Read an integer written as a varint from the log
+   * @return the value read
+   */
+  uint64_t ReadVarint() {
+    return LogEncoding::DecodeVarint([this] { return ReadValue<uint8_t>(); });
+  }
+
  private:
   int in_;  // or -1 if closed
   uint32_t read_head_ = 0, filled_size_ = 0;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <queue>
 #include <string>
@@ -14,10 +15,13 @@
 #include "common/strong_typedef.h"
 #include "settings/settings_manager.h"
 #include "storage/record_buffer.h"
+#include "storage/write_ahead_log/commit_watermark.h"
 #include "storage/write_ahead_log/disk_log_consumer_task.h"
 #include "storage/write_ahead_log/log_io.h"
 #include "storage/write_ahead_log/log_record.h"
+#include "storage/write_ahead_log/log_segment_manifest.h"
 #include "storage/write_ahead_log/log_serializer_task.h"
+#include "storage/write_ahead_log/log_shipper_task.h"
 #include "transaction/transaction_defs.h"
 
 namespace terrier::storage {
@@ -36,8 +40,24 @@ namespace terrier::storage {
  *          a) Someone calls ForceFlush on the LogManager, or
  *          b) Periodically
  *          c) A sufficient amount of data has been written since the last persist
+ *          d) A group of commits has waited for the group commit window, or grown large enough
  *      5. When the persist is done, the `DiskLogConsumerTask` will call the commit callbacks for any CommitRecords that
  * were just persisted.
+ *
+ * The log can be split into several streams, each with its own serializer, consumer, buffers and log file, so that
+ * redo bandwidth is not capped by a single serializer thread. A transaction sends all of its records to the stream of
+ * the thread that began it. The first stream writes to the given log file, stream i > 0 writes to "<log file>.i".
+ * Recovery reads all of the streams and merges them back together (see RecoveryManager). A commit can depend on
+ * commits in other streams, so its callback is only invoked once every stream has caught up with it (see
+ * CommitWatermark).
+ *
+ * The log file of each stream is further split into segments of a configured size, which can be truncated once a
+ * checkpoint makes them unnecessary for recovery (see LogSegmentManifest).
+ *
+ * Each stream can also ship its log to a replica over a connected socket (see LogShipperTask), which replays it with a
+ * RecoveryManager reading from ReplicationLogProviders. When it starts shipping, a stream first sends the log it has
+ * kept on disk, so a replica starts out empty, unless the log was truncated, in which case the replica has to start
+ * from the checkpoint the truncation relied on.
  */
 class LogManager : public common::DedicatedThreadOwner {
  public:
@@ -53,11 +73,20 @@ class LogManager : public common::DedicatedThreadOwner {
    * @param buffer_pool the object pool to draw log buffers from. This must be the same pool transactions draw their
    *                    buffers from
    * @param thread_registry DedicatedThreadRegistry dependency injection
+   * @param max_group_commit_window upper bound on how long the first commit of a group waits for others to join it
+   * @param group_commit_size number of commits that make a group persist right away
+   * @param num_streams number of log streams, each with its own serializer, consumer and log file
+   * @param preallocate_size size of the chunks log files are preallocated in, or 0 to let them grow on demand
+   * @param max_persists_in_flight number of persists each stream can run in the background, or 0 to persist inline
+   * @param segment_size size past which the log file of a stream moves on to a new segment, or 0 to never rotate it
    */
   LogManager(std::string log_file_path, uint64_t num_buffers, std::chrono::microseconds serialization_interval,
              std::chrono::milliseconds persist_interval, uint64_t persist_threshold,
              common::ManagedPointer<RecordBufferSegmentPool> buffer_pool,
-             common::ManagedPointer<terrier::common::DedicatedThreadRegistry> thread_registry)
+             common::ManagedPointer<terrier::common::DedicatedThreadRegistry> thread_registry,
+             std::chrono::microseconds max_group_commit_window = std::chrono::microseconds(1000),
+             uint64_t group_commit_size = 64, uint32_t num_streams = 1, uint64_t preallocate_size = 0,
+             uint32_t max_persists_in_flight = 0, uint64_t segment_size = 0)
       : DedicatedThreadOwner(thread_registry),
         run_log_manager_(false),
         log_file_path_(std::move(log_file_path)),
@@ -65,15 +94,49 @@ class LogManager : public common::DedicatedThreadOwner {
         buffer_pool_(buffer_pool.Get()),
         serialization_interval_(serialization_interval),
         persist_interval_(persist_interval),
-        persist_threshold_(persist_threshold) {}
+        persist_threshold_(persist_threshold),
+        max_group_commit_window_(max_group_commit_window),
+        group_commit_size_(group_commit_size),
+        preallocate_size_(preallocate_size),
+        max_persists_in_flight_(max_persists_in_flight),
+        segment_size_(segment_size) {
+    TERRIER_ASSERT(num_streams > 0, "The log needs at least one stream");
+    for (uint32_t i = 0; i < num_streams; i++)
+      streams_.emplace_back(std::make_unique<LogStream>(StreamFilePath(log_file_path_, i)));
+    if (num_streams > 1) commit_watermark_ = std::make_unique<CommitWatermark>(num_streams);
+  }
   /**
-   * Starts log manager. Does the following in order:
+   * Starts log manager. Does the following in order for every stream:
    *    1. Initialize buffers to pass serialized logs to log consumers
    *    2. Starts up DiskLogConsumerTask
    *    3. Starts up LogSerializerTask
    */
   void Start();
 
+  /**
+   * Ships the log of every stream to a replica from the next Start() on. Stream i ships over the i-th socket, and the
+   * replica reads it with its own ReplicationLogProvider. The sockets stay open until the log manager is stopped for
+   * the last time, and belong to the caller.
+   * @warning The log manager must not be running
+   * @warning A replica that reads several streams merges them like recovery does, so a stream without new logs holds
+   * back the replay of the others until it gets some.
+   * @param replica_fds one connected socket per stream, or none to stop shipping
+   * @param batch_size size past which a batch of logs is sent without waiting for the next persist
+   * @param max_bytes_in_flight durable bytes a replica may lag behind before the commits of the stream block
+   */
+  void SetReplicas(std::vector<int> replica_fds, uint64_t batch_size = DEFAULT_REPLICATION_BATCH_SIZE,
+                   uint64_t max_bytes_in_flight = DEFAULT_REPLICATION_WINDOW);
+
+  /**
+   * Default size past which a batch of shipped logs is sent without waiting for the next persist
+   */
+  static constexpr uint64_t DEFAULT_REPLICATION_BATCH_SIZE = 1 << 18;
+
+  /**
+   * Default number of durable bytes a replica may lag behind before the commits of a stream block
+   */
+  static constexpr uint64_t DEFAULT_REPLICATION_WINDOW = 1 << 24;
+
   /**
    * Serialize and flush the logs to make sure all serialized records are persistent. Callbacks from committed
    * transactions are invoked by log consumers when the commit records are persisted on disk.
@@ -83,7 +146,7 @@ class LogManager : public common::DedicatedThreadOwner {
   void ForceFlush();
 
   /**
-   * Persists all unpersisted logs and stops the log manager. Does what Start() does in reverse order:
+   * Persists all unpersisted logs and stops the log manager. Does what Start() does in reverse order for every stream:
    *    1. Stops LogSerializerTask
    *    2. Stops DiskLogConsumerTask
    *    3. Closes all open buffers
@@ -97,8 +160,51 @@ class LogManager : public common::DedicatedThreadOwner {
    * write to the buffer. This method can be called safely from concurrent execution threads.
    *
    * @param buffer_segment the (perhaps partially) filled log buffer ready to be consumed
+   * @param stream the log stream to write the buffer to. All buffers of a transaction must go to the same stream.
+   */
+  void AddBufferToFlushQueue(RecordBufferSegment *buffer_segment, uint32_t stream = 0);
+
+  /**
+   * Picks the log stream for transactions begun on the calling thread. Threads are spread round-robin over the
+   * streams the first time they ask, and keep their stream afterwards.
+   * @return the log stream the calling thread writes to
+   */
+  uint32_t StreamForCurrentThread() const;
+
+  /**
+   * @return number of log streams
+   */
+  uint32_t NumStreams() const { return static_cast<uint32_t>(streams_.size()); }
+
+  /**
+   * @param log_file_path path of the log file given to the log manager
+   * @param stream a log stream
+   * @return path of the log file the given stream writes to
    */
-  void AddBufferToFlushQueue(RecordBufferSegment *buffer_segment);
+  static std::string StreamFilePath(const std::string &log_file_path, const uint32_t stream) {
+    return stream == 0 ? log_file_path : log_file_path + "." + std::to_string(stream);
+  }
+
+  /**
+   * Deletes the closed log segments of every stream that only hold records of txns that began before the given
+   * timestamp. Their catalog changes are kept in the stream's catalog log, which recovery reads before the oldest
+   * segment left.
+   * @param oldest_needed_begin begin timestamp of the oldest txn whose records still need to be kept, e.g. the oldest
+   *                            txn running when the last durable checkpoint started
+   * @return number of segments deleted
+   */
+  uint64_t TruncateLog(transaction::timestamp_t oldest_needed_begin);
+
+  /**
+   * @return how long the first commit of a group currently waits for others to join it before being persisted, the
+   *         longest over all streams
+   */
+  std::chrono::microseconds GetGroupCommitWindow() const {
+    std::chrono::microseconds window{0};
+    for (const auto &stream : streams_)
+      window = std::max(window, stream->disk_log_writer_task_->GetGroupCommitWindow());
+    return window;
+  }
 
   /**
    * For testing only
@@ -107,8 +213,8 @@ class LogManager : public common::DedicatedThreadOwner {
   uint64_t TestGetNumBuffers() { return num_buffers_; }
 
   /**
-   * Set the number of buffers used for buffering logs. The operation fails if the LogManager has already allocated more
-   * buffers than the new size
+   * Set the number of buffers each stream uses for buffering logs. The operation fails if the LogManager has already
+   * allocated more buffers than the new size
    *
    * @param new_num_buffers the new number of buffers the log manager can use
    * @return true if new_num_buffers is successfully set and false the operation fails
@@ -116,9 +222,12 @@ class LogManager : public common::DedicatedThreadOwner {
   bool SetNumBuffers(uint64_t new_num_buffers) {
     if (new_num_buffers >= num_buffers_) {
       // Add in new buffers
-      for (size_t i = 0; i < new_num_buffers - num_buffers_; i++) {
-        buffers_.emplace_back(BufferedLogWriter(log_file_path_.c_str()));
-        empty_buffer_queue_.Enqueue(&buffers_[num_buffers_ + i]);
+      for (auto &stream : streams_) {
+        const std::string segment_path = stream->OpenSegmentPath();
+        for (size_t i = 0; i < new_num_buffers - num_buffers_; i++) {
+          stream->buffers_.emplace_back(BufferedLogWriter(segment_path.c_str()));
+          stream->empty_buffer_queue_.Enqueue(&stream->buffers_[num_buffers_ + i]);
+        }
       }
       num_buffers_ = new_num_buffers;
       return true;
@@ -127,39 +236,78 @@ class LogManager : public common::DedicatedThreadOwner {
   }
 
  private:
+  // Everything one log stream owns: the buffers its serializer fills, the queues handing them between its serializer
+  // and its consumer, and the two tasks themselves
+  struct LogStream {
+    explicit LogStream(std::string file_path) : file_path_(std::move(file_path)) {}
+
+    // Path of the log segment the stream currently writes to
+    std::string OpenSegmentPath() const {
+      if (manifest_ == nullptr) return file_path_;
+      return LogSegmentManifest::SegmentFilePath(file_path_, manifest_->OpenSegment());
+    }
+
+    // System path for the log file of this stream
+    const std::string file_path_;
+    // Manifest of the segments of the log file, loaded when the log manager starts
+    std::unique_ptr<LogSegmentManifest> manifest_;
+    // This stores a reference to all the buffers the serializer or the log consumer threads use
+    std::vector<BufferedLogWriter> buffers_;
+    // The queue containing empty buffers which the serializer thread will use. We use a blocking queue because the
+    // serializer thread should block when requesting a new buffer until it receives an empty buffer
+    common::ConcurrentBlockingQueue<BufferedLogWriter *> empty_buffer_queue_;
+    // The queue containing filled buffers pending flush to the disk
+    common::ConcurrentQueue<SerializedLogs> filled_buffer_queue_;
+    // Log serializer task that processes buffers handed over by transactions and serializes them into consumer buffers
+    common::ManagedPointer<LogSerializerTask> log_serializer_task_ = common::ManagedPointer<LogSerializerTask>(nullptr);
+    // The log consumer task which flushes filled buffers to the disk
+    common::ManagedPointer<DiskLogConsumerTask> disk_log_writer_task_ =
+        common::ManagedPointer<DiskLogConsumerTask>(nullptr);
+    // Socket to the replica the log is shipped to, or -1 if there is none
+    int replica_fd_ = -1;
+    // Offset in the stream the replica has been sent up to, and whether it has been sent the log kept on disk
+    uint64_t replica_offset_ = 0;
+    bool replica_caught_up_ = false;
+    // The task shipping the log to the replica while the log manager runs
+    common::ManagedPointer<LogShipperTask> log_shipper_task_ = common::ManagedPointer<LogShipperTask>(nullptr);
+  };
+
   // Flag to tell us when the log manager is running or during termination
   bool run_log_manager_;
 
   // System path for log file
   std::string log_file_path_;
 
-  // Number of buffers to use for buffering and serializing logs
+  // Number of buffers each stream uses for buffering and serializing logs
   uint64_t num_buffers_;
 
   // TODO(Tianyu): This can be changed later to be include things that are not necessarily backed by a disk
   //  (e.g. logs can be streamed out to the network for remote replication)
   RecordBufferSegmentPool *buffer_pool_;
 
-  // This stores a reference to all the buffers the serializer or the log consumer threads use
-  std::vector<BufferedLogWriter> buffers_;
-  // The queue containing empty buffers which the serializer thread will use. We use a blocking queue because the
-  // serializer thread should block when requesting a new buffer until it receives an empty buffer
-  common::ConcurrentBlockingQueue<BufferedLogWriter *> empty_buffer_queue_;
-  // The queue containing filled buffers pending flush to the disk
-  common::ConcurrentQueue<SerializedLogs> filled_buffer_queue_;
+  // The log streams. Pointers into a stream are handed to its tasks, so streams never move once created
+  std::vector<std::unique_ptr<LogStream>> streams_;
+  // Holds back commit callbacks until every stream has caught up with them, nullptr if there is only one stream
+  std::unique_ptr<CommitWatermark> commit_watermark_;
 
-  // Log serializer task that processes buffers handed over by transactions and serializes them into consumer buffers
-  common::ManagedPointer<LogSerializerTask> log_serializer_task_ = common::ManagedPointer<LogSerializerTask>(nullptr);
   // Interval used by log serialization task
   const std::chrono::microseconds serialization_interval_;
 
-  // The log consumer task which flushes filled buffers to the disk
-  common::ManagedPointer<DiskLogConsumerTask> disk_log_writer_task_ =
-      common::ManagedPointer<DiskLogConsumerTask>(nullptr);
   // Interval used by disk consumer task
   const std::chrono::milliseconds persist_interval_;
   // Threshold used by disk consumer task
   uint64_t persist_threshold_;
+  // Group commit parameters used by disk consumer task
+  const std::chrono::microseconds max_group_commit_window_;
+  const uint64_t group_commit_size_;
+  // Preallocation and persists in flight used by disk consumer task
+  const uint64_t preallocate_size_;
+  const uint32_t max_persists_in_flight_;
+  // Size past which the log file of a stream moves on to a new segment, or 0 to never rotate it
+  const uint64_t segment_size_;
+  // Batch size and window used by log shipper tasks
+  uint64_t replication_batch_size_ = DEFAULT_REPLICATION_BATCH_SIZE;
+  uint64_t replication_window_ = DEFAULT_REPLICATION_WINDOW;
 
   /**
    * If the central registry wants to removes our thread used for the disk log consumer task, we only allow removal if
@@ -170,6 +318,12 @@ class LogManager : public common::DedicatedThreadOwner {
     // We don't want to register a task if the log manager is shutting down though.
     return !run_log_manager_;
   }
+
+  /**
+   * Makes the serializer of every stream serialize the buffers handed to it. With several streams, they all end on the
+   * watermark of the last one, so that a persist of every stream releases all of the commits.
+   */
+  void SerializeAllStreams();
 };
 
 }  // namespace terrier::storage
@@ -286,6 +286,8 @@ class CommitRecord {
    * @param txn pointer to the committing transaction
    * @param timestamp_manager pointer to timestamp manager who provided timestamp to txn. Used to notify of
    * serialization
+   * @param synchronous_commit false if the commit callback may be invoked as soon as this record is serialized, instead
+   * of when it is persisted
    * @return pointer to the initialized log record, always equal in value to the given head
    */
   // TODO(Tianyu): txn should contain a lot of the information here. Maybe we can simplify the function.
@@ -294,7 +296,8 @@ class CommitRecord {
                                const transaction::timestamp_t txn_commit, transaction::callback_fn commit_callback,
                                void *commit_callback_arg, const transaction::timestamp_t oldest_active_txn,
                                const bool is_read_only, transaction::TransactionContext *const txn,
-                               transaction::TimestampManager *const timestamp_manager) {
+                               transaction::TimestampManager *const timestamp_manager,
+                               const bool synchronous_commit = true) {
     auto *result = LogRecord::InitializeHeader(head, LogRecordType::COMMIT, Size(), txn_begin);
     auto *body = result->GetUnderlyingRecordBodyAs<CommitRecord>();
     body->txn_commit_ = txn_commit;
@@ -304,6 +307,7 @@ class CommitRecord {
     body->timestamp_manager_ = timestamp_manager;
     body->txn_ = txn;
     body->is_read_only_ = is_read_only;
+    body->synchronous_commit_ = synchronous_commit;
     return result;
   }
 
@@ -342,6 +346,12 @@ class CommitRecord {
    */
   bool IsReadOnly() const { return is_read_only_; }
 
+  /**
+   * @return false if the commit callback may be invoked as soon as this record is serialized. Not necessarily populated
+   * if read back in from disk.
+   */
+  bool SynchronousCommit() const { return synchronous_commit_; }
+
  private:
   transaction::timestamp_t txn_commit_;
   transaction::callback_fn commit_callback_;
@@ -352,6 +362,7 @@ class CommitRecord {
   transaction::TransactionContext *txn_;
   transaction::TimestampManager *timestamp_manager_;
   bool is_read_only_;
+  bool synchronous_commit_;
 };
 
 /**
@@ -408,4 +419,49 @@ class AbortRecord {
   transaction::TimestampManager *timestamp_manager_;
   transaction::TransactionContext *txn_;
 };
+
+/**
+ * Record body of a watermark, which a log split into several streams writes at the end of every serializer round. The
+ * header is stored in the LogRecord class that would presumably return this object. A watermark belongs to no
+ * transaction: every commit up to it that any other commit up to it can depend on comes before it in its stream (see
+ * CommitWatermark).
+ */
+class WatermarkRecord {
+ public:
+  MEM_REINTERPRETATION_ONLY(WatermarkRecord)
+
+  /**
+   * @return type of record this type of body holds
+   */
+  static constexpr LogRecordType RecordType() { return LogRecordType::WATERMARK; }
+
+  /**
+   * @return Size of the entire record of this type, in bytes, in memory.
+   */
+  static uint32_t Size() { return static_cast<uint32_t>(sizeof(LogRecord) + sizeof(WatermarkRecord)); }
+
+  /**
+   * Initialize an entire LogRecord (header included) to have an underlying watermark record, using the parameters
+   * supplied.
+   *
+   * @param head pointer location to initialize, this is also the returned address (reinterpreted)
+   * @param watermark commit timestamp the watermark stands for
+   * @return pointer to the initialized log record, always equal in value to the given head
+   */
+  static LogRecord *Initialize(byte *const head, const transaction::timestamp_t watermark) {
+    auto *result =
+        LogRecord::InitializeHeader(head, LogRecordType::WATERMARK, Size(), transaction::INITIAL_TXN_TIMESTAMP);
+    auto *body = result->GetUnderlyingRecordBodyAs<WatermarkRecord>();
+    body->watermark_ = watermark;
+    return result;
+  }
+
+  /**
+   * @return commit timestamp the watermark stands for
+   */
+  transaction::timestamp_t Watermark() const { return watermark_; }
+
+ private:
+  transaction::timestamp_t watermark_;
+};
 }  // namespace terrier::storage
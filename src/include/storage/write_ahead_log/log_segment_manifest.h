@@ -0,0 +1,143 @@
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "transaction/transaction_defs.h"
+
+namespace terrier::storage {
+
+/**
+ * The log of a stream is split into numbered segments. Segment 0 is written to the stream's log file itself, segment
+ * i > 0 to "<log file>.seg<i>". Only the last segment is open for writes; once it has grown past the segment size, it
+ * is persisted, closed and recorded in the manifest ("<log file>.manifest") together with the range of begin timestamps
+ * of the transactions that have records in it. Segments always end on a record boundary, so every segment can be
+ * read on its own.
+ *
+ * Closed segments only holding records of transactions that began before some point can be truncated once a checkpoint
+ * covers that point. Checkpoints do not hold the catalog, so the changes to catalog tables in the truncated segments
+ * are carried over into the stream's catalog log ("<log file>.catalog<i>"), along with the commit and abort records
+ * of their transactions. The catalog log is the truncated part of the stream with everything else left out, and
+ * recovery reads it before the oldest segment left.
+ */
+class LogSegmentManifest {
+ public:
+  /**
+   * A closed segment
+   */
+  struct Segment {
+    /** number of the segment */
+    uint64_t id_;
+    /** oldest begin timestamp of the txns with records in the segment */
+    transaction::timestamp_t min_txn_begin_;
+    /** newest begin timestamp of the txns with records in the segment */
+    transaction::timestamp_t max_txn_begin_;
+  };
+
+  /**
+   * Loads the manifest of the given log file, if there is one. Without a manifest, the log file is the only segment.
+   * @param log_file_path path of the log file of a stream
+   * @throws runtime_error if the manifest exists but is malformed
+   */
+  explicit LogSegmentManifest(std::string log_file_path);
+
+  /**
+   * @param log_file_path path of the log file of a stream
+   * @param segment a segment of the stream
+   * @return path of the file the segment is written to
+   */
+  static std::string SegmentFilePath(const std::string &log_file_path, const uint64_t segment) {
+    return segment == 0 ? log_file_path : log_file_path + ".seg" + std::to_string(segment);
+  }
+
+  /**
+   * @param log_file_path path of the log file of a stream
+   * @return path of the manifest of the stream
+   */
+  static std::string ManifestFilePath(const std::string &log_file_path) { return log_file_path + ".manifest"; }
+
+  /**
+   * @param log_file_path path of the log file of a stream
+   * @param catalog_log a catalog log of the stream
+   * @return path of the file the catalog log is written to
+   */
+  static std::string CatalogLogFilePath(const std::string &log_file_path, const uint64_t catalog_log) {
+    return log_file_path + ".catalog" + std::to_string(catalog_log);
+  }
+
+  /**
+   * @return number of the segment currently open for writes
+   */
+  uint64_t OpenSegment() const {
+    std::lock_guard<std::mutex> guard(latch_);
+    return open_segment_;
+  }
+
+  /**
+   * @return number of the oldest segment that has not been truncated, where reading the log starts
+   */
+  uint64_t FirstSegment() const {
+    std::lock_guard<std::mutex> guard(latch_);
+    return closed_segments_.empty() ? open_segment_ : closed_segments_.front().id_;
+  }
+
+  /**
+   * @return number of the catalog log of the stream, 0 if no segment holding catalog changes has been truncated yet
+   */
+  uint64_t CatalogLog() const {
+    std::lock_guard<std::mutex> guard(latch_);
+    return catalog_log_;
+  }
+
+  /**
+   * @return the closed segments that have not been truncated, oldest first
+   */
+  std::vector<Segment> ClosedSegments() const {
+    std::lock_guard<std::mutex> guard(latch_);
+    return closed_segments_;
+  }
+
+  /**
+   * Records the open segment as closed, and opens the next one. The caller must have persisted the segment already.
+   * @param min_txn_begin oldest begin timestamp of the txns with records in the segment
+   * @param max_txn_begin newest begin timestamp of the txns with records in the segment
+   * @return path of the file of the segment that is now open
+   */
+  std::string CloseSegment(transaction::timestamp_t min_txn_begin, transaction::timestamp_t max_txn_begin);
+
+  /**
+   * Deletes the oldest closed segments, up to the first one that holds records of a txn that began at or after the
+   * given timestamp. Every txn that commits after a checkpoint was still running when the checkpoint started, so
+   * passing the oldest txn running at the start of a durable checkpoint keeps everything needed to recover from it.
+   * The catalog changes in the deleted segments are kept in the next catalog log, which replaces the current one.
+   * @param oldest_needed_begin begin timestamp of the oldest txn whose records still need to be kept
+   * @return number of segments deleted
+   */
+  uint64_t Truncate(transaction::timestamp_t oldest_needed_begin);
+
+ private:
+  const std::string log_file_path_;
+  // Protects the segment lists, which the consumer task updates while others truncate or read them
+  mutable std::mutex latch_;
+  uint64_t open_segment_ = 0;
+  std::vector<Segment> closed_segments_;
+  // The catalog log only counts once the manifest refers to it, so that a crash while writing the next one leaves
+  // either the old catalog log and segments or the new ones
+  uint64_t catalog_log_ = 0;
+  // Txns whose catalog changes are in the catalog log, but whose commit or abort record is still in a segment
+  std::vector<transaction::timestamp_t> open_catalog_txns_;
+  // Serializes truncations, which write the next catalog log without holding latch_
+  std::mutex truncate_latch_;
+
+  // Writes the catalog log that follows the given one: the given one, then the catalog changes in the given segments
+  // and the commit and abort records of their txns. Updates the txns left open, and returns false if there was nothing
+  // to add.
+  bool WriteCatalogLog(const std::vector<Segment> &segments, uint64_t catalog_log,
+                       std::vector<transaction::timestamp_t> *open_catalog_txns) const;
+
+  // Rewrites the manifest file through a temporary file, so that a crash leaves either the old or the new manifest
+  void WriteManifest() const;
+};
+
+}  // namespace terrier::storage
@@ -1,20 +1,35 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <queue>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 #include "common/container/concurrent_blocking_queue.h"
 #include "common/container/concurrent_queue.h"
 #include "common/dedicated_thread_task.h"
 #include "storage/record_buffer.h"
+#include "storage/write_ahead_log/commit_watermark.h"
+#include "storage/write_ahead_log/log_encoding.h"
 #include "storage/write_ahead_log/log_record.h"
 
 namespace terrier::storage {
 
 /**
  * Task that processes buffers handed over by transactions and serializes them into consumer buffers.
- * Transactions will wait to be GC'd until their logs are
+ * Transactions will wait to be GC'd until their logs are serialized.
+ *
+ * Large varlen values are not copied into the consumer buffers. The buffers reference them instead, and the consumer
+ * writes them out from where they are. A txn with referenced values waits to be GC'd until the consumer has flushed the
+ * buffer holding its commit or abort record, which keeps its values alive until they are written.
+ *
+ * While logging metrics are on, synchronous commits are sampled for a breakdown of their latency. The serializer stamps
+ * when a sampled commit was handed to it and serialized, and the consumer the later stages (see CommitLatencySample).
+ *
+ * If the log has several streams, every round ends on a watermark record, and the commit callbacks handed over carry
+ * their commit times (see CommitWatermark).
  */
 class LogSerializerTask : public common::DedicatedThreadTask {
  public:
@@ -24,19 +39,22 @@ class LogSerializerTask : public common::DedicatedThreadTask {
    * @param empty_buffer_queue pointer to queue to pop empty buffers from
    * @param filled_buffer_queue pointer to queue to push filled buffers to
    * @param disk_log_writer_thread_cv pointer to condition variable to notify consumer when a new buffer has handed over
+   * @param commit_watermark watermark shared by the streams of the log, or nullptr if it only has one
    */
   explicit LogSerializerTask(const std::chrono::microseconds serialization_interval,
                              RecordBufferSegmentPool *buffer_pool,
                              common::ConcurrentBlockingQueue<BufferedLogWriter *> *empty_buffer_queue,
                              common::ConcurrentQueue<storage::SerializedLogs> *filled_buffer_queue,
-                             std::condition_variable *disk_log_writer_thread_cv)
+                             std::condition_variable *disk_log_writer_thread_cv,
+                             CommitWatermark *commit_watermark = nullptr)
       : run_task_(false),
         serialization_interval_(serialization_interval),
         buffer_pool_(buffer_pool),
         filled_buffer_(nullptr),
         empty_buffer_queue_(empty_buffer_queue),
         filled_buffer_queue_(filled_buffer_queue),
-        disk_log_writer_thread_cv_(disk_log_writer_thread_cv) {}
+        disk_log_writer_thread_cv_(disk_log_writer_thread_cv),
+        commit_watermark_(commit_watermark) {}
 
   /**
    * Runs main disk log writer loop. Called by thread registry upon initialization of thread
@@ -61,12 +79,19 @@ class LogSerializerTask : public common::DedicatedThreadTask {
    * @param buffer_segment the (perhaps partially) filled log buffer ready to be consumed
    */
   void AddBufferToFlushQueue(RecordBufferSegment *const buffer_segment) {
+    // Commits only read the clock while their latencies are sampled
+    const auto handed = sample_commits_.load() ? std::chrono::high_resolution_clock::now()
+                                               : std::chrono::high_resolution_clock::time_point();
     common::SpinLatch::ScopedSpinLatch guard(&flush_queue_latch_);
-    flush_queue_.push(buffer_segment);
+    flush_queue_.emplace(buffer_segment, handed);
   }
 
  private:
   friend class LogManager;
+  // Varlen values of at least this size are referenced by the consumer buffers instead of copied into them. Smaller
+  // ones are cheaper to copy than to write out separately.
+  static constexpr uint32_t MIN_REFERENCED_VARLEN_SIZE = 512;
+
   // Flag to signal task to run or stop
   bool run_task_;
   // Interval for serialization
@@ -83,21 +108,34 @@ class LogSerializerTask : public common::DedicatedThreadTask {
   //  optimization we applied to the GC queue.
   // Latch to protect flush queue
   common::SpinLatch flush_queue_latch_;
-  // Stores unserialized buffers handed off by transactions
-  std::queue<RecordBufferSegment *> flush_queue_;
+  // Stores unserialized buffers handed off by transactions, and when they were handed off if commits are sampled
+  std::queue<std::pair<RecordBufferSegment *, std::chrono::high_resolution_clock::time_point>> flush_queue_;
+  // Whether commit latencies are sampled, follows whether logging metrics are on for the serializer
+  std::atomic<bool> sample_commits_ = false;
 
   // Current buffer we are serializing logs to
   BufferedLogWriter *filled_buffer_;
+  // Begin timestamp of the txn whose record is being serialized
+  transaction::timestamp_t current_txn_begin_ = transaction::INITIAL_TXN_TIMESTAMP;
   // Commit callbacks for commit records currently in filled_buffer
   std::vector<std::pair<transaction::callback_fn, void *>> commits_in_buffer_;
+  // Their commit times, if the log has several streams
+  std::vector<transaction::timestamp_t> commit_times_in_buffer_;
+  // Sampled commits among them
+  std::vector<CommitLatencySample> commit_samples_in_buffer_;
+  // When the redo buffer being serialized was handed off and picked up, default if its commits are not sampled
+  std::chrono::high_resolution_clock::time_point segment_handed_, segment_serializing_;
 
   // Used by the serializer thread to store buffers it has grabbed from the log manager
-  std::queue<RecordBufferSegment *> temp_flush_queue_;
+  std::queue<std::pair<RecordBufferSegment *, std::chrono::high_resolution_clock::time_point>> temp_flush_queue_;
 
   // We aggregate all transactions we serialize so we can bulk remove the from the timestamp manager
   // TODO(Gus): If we guarantee there is only one TSManager in the system, this can just be a vector. We could also pass
   // TS into the serializer instead of having a pointer for it in every commit/abort record
   std::unordered_map<transaction::TimestampManager *, std::vector<transaction::timestamp_t>> serialized_txns_;
+  // Begin timestamps of the txns with varlen values referenced by consumer buffers, which are pinned by the buffer that
+  // holds their commit or abort record instead
+  std::unordered_set<transaction::timestamp_t> referencing_txns_;
 
   // The queue containing empty buffers. Task will dequeue a buffer from this queue when it needs a new buffer
   common::ConcurrentBlockingQueue<BufferedLogWriter *> *empty_buffer_queue_;
@@ -107,6 +145,12 @@ class LogSerializerTask : public common::DedicatedThreadTask {
   // Condition variable to signal disk log consumer task thread that a new full buffer has been pushed to the queue
   std::condition_variable *disk_log_writer_thread_cv_;
 
+  // Watermark shared by the streams of the log, or nullptr if it only has one
+  CommitWatermark *const commit_watermark_;
+  // Last watermark written out, and the one at the end of filled_buffer_ if it has one
+  transaction::timestamp_t watermark_written_ = transaction::INITIAL_TXN_TIMESTAMP;
+  transaction::timestamp_t watermark_in_buffer_ = transaction::INITIAL_TXN_TIMESTAMP;
+
   /**
    * Main serialization loop. Calls Process every interval. Processes all the accumulated log records and
    * serializes them to log consumer tasks.
@@ -135,6 +179,12 @@ class LogSerializerTask : public common::DedicatedThreadTask {
    */
   uint64_t SerializeRecord(const LogRecord &record);
 
+  /**
+   * Serialize out a watermark record that ends the round
+   * @param watermark newest commit time serialized by any stream when the round started
+   */
+  void SerializeWatermark(transaction::timestamp_t watermark);
+
   /**
    * Serialize the data pointed to by val to current serialization buffer
    * @tparam T Type of the value
@@ -154,6 +204,30 @@ class LogSerializerTask : public common::DedicatedThreadTask {
    */
   uint32_t WriteValue(const void *val, uint32_t size);
 
+  /**
+   * Serialize the data pointed to by val to current serialization buffer without copying it. The data has to stay
+   * alive until the txn being serialized is removed from its TimestampManager.
+   * @param val the value
+   * @param size size of the value to serialize
+   * @return bytes written, used for metrics
+   */
+  uint32_t WriteReference(const void *val, uint32_t size);
+
+  /**
+   * Hand the serialized txn with the given begin timestamp over to be removed from its TimestampManager, once its
+   * records no longer reference any memory it keeps alive
+   * @param timestamp_manager timestamp manager the txn belongs to
+   * @param txn_begin begin timestamp of the txn
+   */
+  void ReleaseSerializedTxn(transaction::TimestampManager *timestamp_manager, transaction::timestamp_t txn_begin);
+
+  /**
+   * Serialize an integer to current serialization buffer as a varint
+   * @param val the value
+   * @return bytes written, used for metrics
+   */
+  uint32_t WriteVarint(uint64_t val);
+
   /**
    * Returns the current buffer to serialize logs to
    * @return buffer to write to
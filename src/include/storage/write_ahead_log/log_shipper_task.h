@@ -0,0 +1,159 @@
+#pragma once
+
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/dedicated_thread_task.h"
+
+namespace terrier::storage {
+
+/**
+ * A LogShipperTask ships the log of one stream to a replica over a connected socket, so that the replica can replay it
+ * while the primary keeps writing (see ReplicationLogProvider). The stream's DiskLogConsumerTask hands the shipper
+ * every buffer it writes to the log file, and tells it how far the log file is durable after each persist.
+ *
+ * Logs are shipped in batches. A batch is sealed when the consumer persists, or once it has grown past the batch size,
+ * and is only sent once the persist covering it is done, so the replica never gets ahead of what the primary would
+ * recover. Sending runs on the shipper's own thread, pipelined with the consumer writing and persisting the next batch.
+ * Each batch goes out as its size followed by its contents.
+ *
+ * The replica acknowledges how many bytes of the stream it has read so far. Once the durable bytes it has not
+ * acknowledged reach the configured window, the consumer blocks when it hands over more logs, which in turn holds back
+ * the serializer and the commits of the stream, until the replica catches up. Every acknowledgement records the lag of
+ * the replica, in bytes and in time since the acknowledged logs were sent, in the REPLICATION metrics component.
+ *
+ * If the socket fails, the shipper gives up on the replica and never blocks the consumer again.
+ */
+class LogShipperTask : public common::DedicatedThreadTask {
+ public:
+  /**
+   * @param replica_fd connected socket to the replica, owned by the caller
+   * @param start_offset offset in the stream the replica has received up to before this shipper, where it starts
+   * @param batch_size size past which a batch is sealed without waiting for a persist
+   * @param max_bytes_in_flight durable bytes the replica may lag behind before the consumer blocks
+   */
+  LogShipperTask(const int replica_fd, const uint64_t start_offset, const uint64_t batch_size,
+                 const uint64_t max_bytes_in_flight)
+      : replica_fd_(replica_fd),
+        batch_size_(batch_size),
+        max_bytes_in_flight_(max_bytes_in_flight),
+        bytes_written_(start_offset),
+        bytes_durable_(start_offset),
+        bytes_sent_(start_offset),
+        bytes_acknowledged_(start_offset) {}
+
+  /**
+   * Runs the shipper loop. Called by thread registry upon initialization of thread
+   */
+  void RunTask() override;
+
+  /**
+   * Signals the task to stop once it has sent every durable batch. Called by thread registry upon termination of thread
+   */
+  void Terminate() override;
+
+  /**
+   * Appends logs written to the log file to the open batch. Blocks while the replica lags too far behind.
+   * @param data logs as written to the log file
+   * @param size number of bytes
+   */
+  void ShipLogs(const char *data, uint64_t size);
+
+  /**
+   * Ships the contents of a log file that was written before the shipper started, all of which is durable.
+   * @param log_file_path path of the log file
+   */
+  void ShipLogFile(const std::string &log_file_path);
+
+  /**
+   * Seals the open batch, if it holds any logs
+   * @return offset in the stream up to which logs have been handed to the shipper
+   */
+  uint64_t SealBatch();
+
+  /**
+   * Releases the batches up to the given offset for sending, because the log file is durable up to there
+   * @param offset offset in the stream, as returned by SealBatch before the persist
+   */
+  void MarkDurable(uint64_t offset);
+
+  /**
+   * @return offset in the stream up to which logs have been handed to the shipper
+   */
+  uint64_t BytesWritten() const {
+    std::lock_guard<std::mutex> guard(latch_);
+    return bytes_written_;
+  }
+
+  /**
+   * @return offset in the stream up to which the replica has acknowledged the logs
+   */
+  uint64_t BytesAcknowledged() const {
+    std::lock_guard<std::mutex> guard(latch_);
+    return bytes_acknowledged_;
+  }
+
+  /**
+   * @return false if shipping to the replica failed
+   */
+  bool Connected() const {
+    std::lock_guard<std::mutex> guard(latch_);
+    return connected_;
+  }
+
+ private:
+  // How often the shipper looks for acknowledgements while it has nothing to send
+  static constexpr std::chrono::milliseconds ACK_POLL_INTERVAL{1};
+
+  // A sealed batch and the offset in the stream it ends at
+  struct Batch {
+    uint64_t end_;
+    std::vector<char> data_;
+  };
+
+  // A sent batch the replica has not acknowledged yet
+  struct SentBatch {
+    uint64_t end_;
+    std::chrono::high_resolution_clock::time_point sent_;
+  };
+
+  const int replica_fd_;
+  const uint64_t batch_size_;
+  const uint64_t max_bytes_in_flight_;
+
+  // Protects everything below, which the consumer, its persists in flight and the shipper thread share
+  mutable std::mutex latch_;
+  // Wakes the shipper thread when batches are released or the task stops
+  std::condition_variable shipper_cv_;
+  // Wakes the consumer blocked on the window when the replica acknowledges logs
+  std::condition_variable window_cv_;
+  bool terminated_ = false;
+  bool connected_ = true;
+  std::vector<char> open_batch_;
+  std::deque<Batch> sealed_batches_;
+  // Offsets in the stream: handed over, covered by a persist, sent, and read by the replica
+  uint64_t bytes_written_, bytes_durable_, bytes_sent_, bytes_acknowledged_;
+
+  // Only touched by the shipper thread
+  std::deque<SentBatch> unacknowledged_batches_;
+  // An acknowledgement may arrive in pieces
+  uint64_t ack_;
+  uint32_t ack_size_ = 0;
+
+  void SealOpenBatch();
+
+  // Sends a batch, returns false if the socket failed
+  bool SendBatch(const Batch &batch);
+
+  // Reads the acknowledgements that have arrived without blocking, and records the lag of the replica for each
+  void ReceiveAcknowledgements();
+
+  // Gives up on the replica, and releases a consumer blocked on it
+  void Disconnect(const char *operation);
+};
+
+}  // namespace terrier::storage
@@ -9,6 +9,7 @@
 #include "parser/create_statement.h"
 #include "parser/drop_statement.h"
 #include "parser/transaction_statement.h"
+#include "parser/variable_set_statement.h"
 #include "storage/recovery/replication_log_provider.h"
 
 namespace terrier::network {
@@ -24,6 +25,10 @@ namespace terrier::planner {
 class AbstractPlanNode;
 }
 
+namespace terrier::storage {
+class RecoveryManager;
+}
+
 namespace terrier::trafficcop {
 
 /**
@@ -106,10 +111,19 @@ class TrafficCop {
    */
   void SetOptimizerTimeout(const uint64_t optimizer_timeout) { optimizer_timeout_ = optimizer_timeout; }
 
+  /**
+   * Serves the connections of a replica. Every txn is a read-only snapshot of what the replica has replayed so far, so
+   * SELECTs run alongside the replay of the primary's log, and connections go without a temporary namespace, since
+   * only the replay may change the catalog.
+   * @param replica recovery manager that replays the log of the primary and serves reads, using the same transaction
+   * manager as the tcop
+   */
+  void SetReplica(const common::ManagedPointer<storage::RecoveryManager> replica) { replica_ = replica; }
+
  private:
   // Internal method to handle the logic of beginning a txn. Is not responsible for outputting results, only meant to be
-  // called by ExecuteTransactionStatement
-  void BeginTransaction(common::ManagedPointer<network::ConnectionContext> connection_ctx) const;
+  // called by ExecuteTransactionStatement. Read-only txns take the TransactionManager's fast path.
+  void BeginTransaction(common::ManagedPointer<network::ConnectionContext> connection_ctx, bool read_only) const;
 
   // Internal method to handle the logic of ending a txn. Is not responsible for outputting results, only meant to be
   // called by ExecuteTransactionStatement
@@ -119,8 +133,15 @@ class TrafficCop {
   // Contains the logic to reason about BEGIN, COMMIT, ROLLBACK execution. Responsible for outputting results.
   void ExecuteTransactionStatement(common::ManagedPointer<network::ConnectionContext> connection_ctx,
                                    common::ManagedPointer<network::PostgresPacketWriter> out,
+                                   common::ManagedPointer<parser::ParseResult> parse_result,
                                    terrier::network::QueryType query_type) const;
 
+  // Contains the logic to reason about SET and RESET. Only synchronous_commit is understood, everything else is
+  // accepted and ignored. Responsible for outputting results.
+  void ExecuteSetStatement(common::ManagedPointer<network::ConnectionContext> connection_ctx,
+                           common::ManagedPointer<network::PostgresPacketWriter> out,
+                           common::ManagedPointer<parser::ParseResult> parse_result) const;
+
   // Contains logic to reason about binding, and basic IF EXISTS logic. Responsible for outputting results.
   bool BindStatement(common::ManagedPointer<network::ConnectionContext> connection_ctx,
                      common::ManagedPointer<network::PostgresPacketWriter> out,
@@ -151,6 +172,8 @@ class TrafficCop {
   common::ManagedPointer<storage::ReplicationLogProvider> replication_log_provider_;
   common::ManagedPointer<optimizer::StatsStorage> stats_storage_;
   uint64_t optimizer_timeout_;
+  // Set on a replica, whose txns all begin through it
+  common::ManagedPointer<storage::RecoveryManager> replica_ = nullptr;
 };
 
 }  // namespace terrier::trafficcop
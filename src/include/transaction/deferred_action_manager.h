@@ -1,8 +1,10 @@
 #pragma once
+#include <atomic>
 #include <queue>
 #include <utility>
 #include <vector>
 
+#include "common/worker_pool.h"
 #include "storage/garbage_collector.h"
 #include "storage/write_ahead_log/log_manager.h"
 #include "transaction/timestamp_manager.h"
@@ -13,21 +15,33 @@ namespace terrier::transaction {
 constexpr uint8_t MIN_GC_INVOCATIONS = 3;
 
 /**
- * The deferred action manager tracks deferred actions and provides a function to process them
+ * The deferred action manager tracks deferred actions and provides a function to process them.
+ *
+ * Cheap actions run on the thread processing deferred actions, in the order they were registered. Expensive actions
+ * are handed off to a pool of worker threads once they are safe to run, so that a large DROP does not hold up the rest
+ * of the GC. Chunked actions are always expensive. Without workers, they get a single slice of work per call to
+ * Process, so that version unlinking keeps making progress in between.
  */
 class DeferredActionManager {
  public:
   /**
    * Constructs a new DeferredActionManager
    * @param timestamp_manager source of timestamps in the system
+   * @param num_workers number of threads to run expensive actions on. If 0, they are run on the thread invoking
+   *                    Process.
    */
-  explicit DeferredActionManager(const common::ManagedPointer<TimestampManager> timestamp_manager)
-      : timestamp_manager_(timestamp_manager) {}
+  explicit DeferredActionManager(const common::ManagedPointer<TimestampManager> timestamp_manager,
+                                 const uint32_t num_workers = 0)
+      : timestamp_manager_(timestamp_manager), num_workers_(num_workers), workers_(num_workers, {}) {
+    if (num_workers_ > 0) workers_.Startup();
+  }
 
   ~DeferredActionManager() {
+    if (num_workers_ > 0) workers_.WaitUntilAllFinished();
     common::SpinLatch::ScopedSpinLatch guard(&deferred_actions_latch_);
     TERRIER_ASSERT(back_log_.empty(), "Backlog is not empty");
     TERRIER_ASSERT(new_deferred_actions_.empty(), "Some deferred actions remaining at time of destruction");
+    TERRIER_ASSERT(unfinished_actions_.empty(), "Some chunked deferred actions unfinished at time of destruction");
   }
 
   /**
@@ -35,15 +49,16 @@ class DeferredActionManager {
    * be triggered no sooner than when the epoch (timestamp of oldest running
    * transaction) is more recent than the time this function was called.
    * @param a functional implementation of the action that is deferred. @see DeferredAction
+   * @param cost how much work the action does. @see DeferredActionCost
    */
-  timestamp_t RegisterDeferredAction(const DeferredAction &a) {
-    common::SpinLatch::ScopedSpinLatch guard(&deferred_actions_latch_);
-    // Timestamp needs to be fetched inside the critical section such that actions in the
-    // deferred action queue is in order. This simplifies the interleavings we need to deal
-    // with in the face of DDL changes.
-    timestamp_t result = timestamp_manager_->CurrentTime();
-    new_deferred_actions_.emplace(result, a);
-    return result;
+  timestamp_t RegisterDeferredAction(const DeferredAction &a,
+                                     const DeferredActionCost cost = DeferredActionCost::CHEAP) {
+    return RegisterAction(
+        [=](timestamp_t oldest_txn) {
+          a(oldest_txn);
+          return true;
+        },
+        cost);
   }
 
   /**
@@ -51,11 +66,22 @@ class DeferredActionManager {
    * be triggered no sooner than when the epoch (timestamp of oldest running
    * transaction) is more recent than the time this function was called.
    * @param a functional implementation of the action that is deferred
+   * @param cost how much work the action does. @see DeferredActionCost
    */
-  timestamp_t RegisterDeferredAction(const std::function<void()> &a) {
+  timestamp_t RegisterDeferredAction(const std::function<void()> &a,
+                                     const DeferredActionCost cost = DeferredActionCost::CHEAP) {
     // TODO(Tianyu): Will this be a performance problem? Hopefully C++ is smart enough
     // to optimize out this call...
-    return RegisterDeferredAction([=](timestamp_t /*unused*/) { a(); });
+    return RegisterDeferredAction([=](timestamp_t /*unused*/) { a(); }, cost);
+  }
+
+  /**
+   * Adds the expensive action to a buffered list of deferred actions. Once the epoch is more recent than the time this
+   * function was called, the action is applied over and over until it reports that it is done.
+   * @param a functional implementation of the action that is deferred. @see ChunkedDeferredAction
+   */
+  timestamp_t RegisterChunkedDeferredAction(const ChunkedDeferredAction &a) {
+    return RegisterAction(a, DeferredActionCost::EXPENSIVE);
   }
 
   /**
@@ -63,6 +89,8 @@ class DeferredActionManager {
    * @return numbers of deferred actions processed
    */
   uint32_t Process(transaction::timestamp_t oldest_txn) {
+    // Without workers, expensive actions handed off on earlier calls get one more slice of work each
+    RunUnfinishedActions(oldest_txn);
     // Check out a timestamp from the transaction manager to determine the progress of
     // running transactions in the system.
     const auto backlog_size = static_cast<uint32_t>(back_log_.size());
@@ -85,18 +113,86 @@ class DeferredActionManager {
    */
   void FullyPerformGC(const common::ManagedPointer<storage::GarbageCollector> gc,
                       const common::ManagedPointer<storage::LogManager> log_manager) {
-    for (int i = 0; i < MIN_GC_INVOCATIONS; i++) {
+    // Expensive actions may still be running on the workers, or be sliced over more invocations
+    for (int i = 0; i < MIN_GC_INVOCATIONS || expensive_actions_in_flight_.load() > 0; i++) {
       if (log_manager != DISABLED) log_manager->ForceFlush();
       gc->PerformGarbageCollection();
+      if (num_workers_ > 0) workers_.WaitUntilAllFinished();
     }
   }
 
+  /**
+   * @return number of expensive actions that were handed off and have not finished yet
+   */
+  uint32_t ExpensiveActionsInFlight() const { return expensive_actions_in_flight_.load(); }
+
  private:
+  struct PendingAction {
+    ChunkedDeferredAction action_;
+    DeferredActionCost cost_;
+  };
+
   const common::ManagedPointer<TimestampManager> timestamp_manager_;
   // TODO(Tianyu): We might want to change this data structure to be more specialized than std::queue
-  std::queue<std::pair<timestamp_t, DeferredAction>> new_deferred_actions_, back_log_;
+  std::queue<std::pair<timestamp_t, PendingAction>> new_deferred_actions_, back_log_;
   common::SpinLatch deferred_actions_latch_;
 
+  const uint32_t num_workers_;
+  common::WorkerPool workers_;
+  // Chunked actions that are safe to run but not done yet, when there are no workers. Only touched by the thread
+  // invoking Process.
+  std::vector<ChunkedDeferredAction> unfinished_actions_;
+  std::atomic<uint32_t> expensive_actions_in_flight_ = 0;
+
+  timestamp_t RegisterAction(const ChunkedDeferredAction &a, const DeferredActionCost cost) {
+    common::SpinLatch::ScopedSpinLatch guard(&deferred_actions_latch_);
+    // Timestamp needs to be fetched inside the critical section such that actions in the
+    // deferred action queue is in order. This simplifies the interleavings we need to deal
+    // with in the face of DDL changes.
+    timestamp_t result = timestamp_manager_->CurrentTime();
+    new_deferred_actions_.emplace(result, PendingAction{a, cost});
+    return result;
+  }
+
+  // Runs a cheap action right away, and hands an expensive one off to the workers
+  void Execute(const PendingAction &action, const timestamp_t oldest_txn) {
+    if (action.cost_ == DeferredActionCost::CHEAP) {
+      UNUSED_ATTRIBUTE const bool done = action.action_(oldest_txn);
+      TERRIER_ASSERT(done, "Cheap deferred actions cannot be chunked.");
+      return;
+    }
+    expensive_actions_in_flight_++;
+    if (num_workers_ > 0) {
+      workers_.SubmitTask([this, action{action.action_}, oldest_txn] { RunChunk(action, oldest_txn); });
+    } else {
+      unfinished_actions_.push_back(action.action_);
+    }
+  }
+
+  // Runs a slice of an expensive action on a worker. If there is more to do, the rest goes to the back of the task
+  // queue so that other expensive actions get their turn.
+  void RunChunk(const ChunkedDeferredAction &action, const timestamp_t oldest_txn) {
+    if (action(oldest_txn)) {
+      expensive_actions_in_flight_--;
+      return;
+    }
+    workers_.SubmitTask([this, action, oldest_txn] { RunChunk(action, oldest_txn); });
+  }
+
+  // Runs a slice of every unfinished expensive action, when there are no workers
+  void RunUnfinishedActions(const timestamp_t oldest_txn) {
+    auto it = unfinished_actions_.begin();
+    while (it != unfinished_actions_.end()) {
+      // An action can only become safer to apply, so it is fine to hand it the newer epoch
+      if ((*it)(oldest_txn)) {
+        it = unfinished_actions_.erase(it);
+        expensive_actions_in_flight_--;
+      } else {
+        ++it;
+      }
+    }
+  }
+
   uint32_t ClearBacklog(timestamp_t oldest_txn) {
     uint32_t processed = 0;
     // Execute as many deferred actions as we can at this time from the backlog.
@@ -105,7 +201,7 @@ class DeferredActionManager {
     //  (for uncommiitted transactions, or on overflow)
     // Although that should never happen, we need to be aware that this might be a problem in the future.
     while (!back_log_.empty() && oldest_txn >= back_log_.front().first) {
-      back_log_.front().second(oldest_txn);
+      Execute(back_log_.front().second, oldest_txn);
       processed++;
       back_log_.pop();
     }
@@ -116,7 +212,7 @@ class DeferredActionManager {
     uint32_t processed = 0;
     // swap the new actions queue with a local queue, so the rest of the system can continue
     // while we process actions
-    std::queue<std::pair<timestamp_t, DeferredAction>> new_actions_local;
+    std::queue<std::pair<timestamp_t, PendingAction>> new_actions_local;
     {
       common::SpinLatch::ScopedSpinLatch guard(&deferred_actions_latch_);
       new_actions_local = std::move(new_deferred_actions_);
@@ -124,7 +220,7 @@ class DeferredActionManager {
 
     // Iterate through the new actions queue and execute as many as possible
     while (!new_actions_local.empty() && oldest_txn >= new_actions_local.front().first) {
-      new_actions_local.front().second(oldest_txn);
+      Execute(new_actions_local.front().second, oldest_txn);
       processed++;
       new_actions_local.pop();
     }
@@ -1,27 +1,43 @@
 #pragma once
 #include <algorithm>
-#include <unordered_set>
+#include <array>
+#include <atomic>
+#include <set>
 #include <vector>
 
+#include "common/constants.h"
 #include "common/spin_latch.h"
 #include "common/strong_typedef.h"
 #include "transaction/transaction_defs.h"
 
 namespace terrier::storage {
 // Forward declaration
+class BufferedLogWriter;
 class LogSerializerTask;
 }  // namespace terrier::storage
 
 namespace terrier::transaction {
 class TransactionManager;
+
+// Number of shards the running txns are spread over by start timestamp
+constexpr uint32_t NUM_RUNNING_TXN_SHARDS = 64;
+// Number of slots for txns in the middle of beginning to announce themselves in
+constexpr uint32_t NUM_BEGIN_SLOTS = 256;
+// Number of timestamps checked out between two refreshes of the oldest running txn by RecentOldestTransactionStartTime
+constexpr uint64_t OLDEST_TXN_REFRESH_INTERVAL = 64;
+
 /**
  * Generates timestamps, and keeps track of the lifetime of transactions (whether they have entered or left the system)
+ *
+ * Running txns are spread over shards with a latch each, so that beginning and removing txns rarely contend with each
+ * other. Finding the oldest running txn only ever holds one shard latch at a time, and never stops txns from beginning.
  */
 class TimestampManager {
  public:
   ~TimestampManager() {
-    TERRIER_ASSERT(curr_running_txns_.empty(),
-                   "Destroying the TimestampManager while txns are still running. That seems wrong.");
+    for (auto &shard UNUSED_ATTRIBUTE : running_txns_)
+      TERRIER_ASSERT(shard.txns_.empty(),
+                     "Destroying the TimestampManager while txns are still running. That seems wrong.");
   }
 
   /**
@@ -38,9 +54,8 @@ class TimestampManager {
    * Get the oldest transaction alive (by start timestamp given out by this timestamp manager at this time)
    * Because of concurrent operations, it is not guaranteed that upon return the txn is still alive. However,
    * it is guaranteed that the return timestamp is older than any transactions live.
-   * @warning If logging is enabled, txns are not removed from the txn set until they are serialized. Thus, the active
-   * txn set can grow greatly in size, making this call expensive. Consider using CachedOldestTransactionStartTime for
-   * better peformance at the cost of a more stale timestamp.
+   * @warning This takes every shard latch in turn and looks at all slots of txns that are beginning. Consider using
+   * CachedOldestTransactionStartTime for better peformance at the cost of a more stale timestamp.
    * @return timestamp that is older than any transactions alive
    */
   timestamp_t OldestTransactionStartTime();
@@ -48,40 +63,65 @@ class TimestampManager {
   /**
    * Get the cached timestamp of the oldest active txn. The cached timestamp is only refreshed upon every invocation of
    * OldestTransactionStartTime, so it may be stale. On the other hand, this function does not require taking a latch or
-   * iterating through the running txns set, making it much cheaper than OldestTransactionStartTime. This has the same
+   * looking at the running txns, making it much cheaper than OldestTransactionStartTime. This has the same
    * correctness guarantee as OldestTransactionStartTime, but may cause performance degradations for processes that rely
    * on very fresh oldest txn timestamps
    * @return timestamp that is older than any transactions alive
    */
   timestamp_t CachedOldestTransactionStartTime();
 
+  /**
+   * Get the timestamp of the oldest active txn, refreshed as by OldestTransactionStartTime if at least
+   * OLDEST_TXN_REFRESH_INTERVAL timestamps have been checked out since the last refresh, or cached otherwise. Only one
+   * caller gets to do each refresh, so no matter how often this is called, the running txns are looked at about once
+   * every OLDEST_TXN_REFRESH_INTERVAL timestamps.
+   * @return timestamp that is older than any transactions alive
+   */
+  timestamp_t RecentOldestTransactionStartTime();
+
  private:
-  // TransactionManager needs to be able to use the curr_running_txns_latch to guard more than just the
-  // duration of the following method calls --- things such as adding to the GC queue needs to be atomic
-  // along with removing a transaction from the table of active transactions. We need this for correctness
-  // in the deferred action framework when dropping tables.
   friend class TransactionManager;
+  friend class storage::BufferedLogWriter;
   friend class storage::LogSerializerTask;
+
+  struct alignas(common::Constants::CACHELINE_SIZE) RunningTxnShard {
+    common::SpinLatch latch_;
+    // Ordered so that the oldest txn of the shard is always at the front. Txns mostly begin in timestamp order, so
+    // inserting is cheap.
+    std::set<timestamp_t> txns_;
+  };
+
+  struct alignas(common::Constants::CACHELINE_SIZE) BeginSlot {
+    // A lower bound on the start time of the txn beginning in this slot, or INVALID_TXN_TIMESTAMP if the slot is free.
+    // INVALID_TXN_TIMESTAMP is larger than every valid timestamp, so free slots never hold back the oldest txn.
+    std::atomic<timestamp_t> start_{INVALID_TXN_TIMESTAMP};
+  };
+
   timestamp_t BeginTransaction() {
-    timestamp_t start_time;
+    // There is a three-way race that needs to be prevented.  Specifically, we
+    // cannot allow both a transaction to commit and the GC to poll for the
+    // oldest running transaction in between this transaction acquiring its
+    // begin timestamp and getting inserted into the current running
+    // transactions. Instead of a latch that stops the GC from polling, the
+    // transaction first publishes a lower bound on its start time in a begin
+    // slot, which the GC takes into account.
+    std::atomic<timestamp_t> *const begin_slot = AcquireBeginSlot();
+    const timestamp_t start_time = time_++;
     {
-      common::SpinLatch::ScopedSpinLatch running_guard(&curr_running_txns_latch_);
-      // There is a three-way race that needs to be prevented.  Specifically, we
-      // cannot allow both a transaction to commit and the GC to poll for the
-      // oldest running transaction in between this transaction acquiring its
-      // begin timestamp and getting inserted into the current running
-      // transactions list.  Using the current running transactions latch
-      // prevents the GC from polling and stops the race.  This allows us to
-      // replace acquiring a shared instance of the commit latch with a
-      // read-only spin-latch and move the allocation out of a critical section.
-      start_time = time_++;
-
-      const auto ret UNUSED_ATTRIBUTE = curr_running_txns_.emplace(start_time);
-      TERRIER_ASSERT(ret.second, "commit start time should be globally unique");
-    }  // Release latch on current running transactions
+      RunningTxnShard &shard = ShardOf(start_time);
+      common::SpinLatch::ScopedSpinLatch running_guard(&shard.latch_);
+      const auto ret UNUSED_ATTRIBUTE = shard.txns_.emplace_hint(shard.txns_.end(), start_time);
+      TERRIER_ASSERT(*ret == start_time, "commit start time should be globally unique");
+    }  // Release latch on the shard
+    begin_slot->store(INVALID_TXN_TIMESTAMP);
     return start_time;
   }
 
+  // Claims a free begin slot and publishes the current time in it
+  std::atomic<timestamp_t> *AcquireBeginSlot();
+
+  RunningTxnShard &ShardOf(const timestamp_t timestamp) { return running_txns_[!timestamp % NUM_RUNNING_TXN_SHARDS]; }
+
   /**
    * Remove a timestamp from active txn set
    * @param timestamp timestamp to remove
@@ -89,8 +129,8 @@ class TimestampManager {
   void RemoveTransaction(timestamp_t timestamp);
 
   /**
-   * Bulk remove a set of timestamps from the active txn set. Only grabs the curr_running_txns_latch_ once for all the
-   * timestamps.
+   * Bulk remove a set of timestamps from the active txn set. Only grabs the latch of each shard once for all the
+   * timestamps in it.
    * @param timestamps vector of timestamps to remove
    */
   void RemoveTransactions(const std::vector<timestamp_t> &timestamps);
@@ -100,11 +140,10 @@ class TimestampManager {
   std::atomic<timestamp_t> time_{INITIAL_TXN_TIMESTAMP};
   // We cache the oldest txn start time
   std::atomic<timestamp_t> cached_oldest_txn_start_time_{INITIAL_TXN_TIMESTAMP};
-  // TODO(Matt): consider a different data structure if this becomes a measured bottleneck
-  // TODO(Gus): This data structure initially only held items in the order of # of workers. With the logging change, it
-  // can hold many more, since txns are only removed when serialized. We should consider if there is a possible better
-  // data structure
-  std::unordered_set<timestamp_t> curr_running_txns_;
-  mutable common::SpinLatch curr_running_txns_latch_;
+  // Time at which the cached timestamp was last refreshed
+  std::atomic<timestamp_t> last_oldest_txn_refresh_{INITIAL_TXN_TIMESTAMP};
+  // With logging, txns are only removed when serialized, so there can be many more running txns than workers
+  std::array<RunningTxnShard, NUM_RUNNING_TXN_SHARDS> running_txns_;
+  std::array<BeginSlot, NUM_BEGIN_SLOTS> begin_slots_;
 };
 }  // namespace terrier::transaction
@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <vector>
 
 #include "common/macros.h"
@@ -10,6 +11,7 @@
 #include "storage/storage_defs.h"
 #include "storage/tuple_access_strategy.h"
 #include "storage/undo_record.h"
+#include "storage/varlen_arena.h"
 #include "storage/write_ahead_log/log_record.h"
 #include "transaction/transaction_util.h"
 
@@ -25,6 +27,8 @@ class RecoveryTests;
 }  // namespace terrier::storage
 
 namespace terrier::transaction {
+class TimestampManager;
+
 /**
  * A transaction context encapsulates the information kept while the transaction is running
  */
@@ -42,14 +46,17 @@ class TransactionContext {
    * MVCC semantics
    * @param buffer_pool the buffer pool to draw this transaction's undo buffer from
    * @param log_manager pointer to log manager in the system, or nullptr, if logging is disabled
+   * @param declared_read_only true if the transaction promises to never write. Such a transaction never logs anything.
    */
   TransactionContext(const timestamp_t start, const timestamp_t finish,
                      const common::ManagedPointer<storage::RecordBufferSegmentPool> buffer_pool,
-                     const common::ManagedPointer<storage::LogManager> log_manager)
+                     const common::ManagedPointer<storage::LogManager> log_manager,
+                     const bool declared_read_only = false)
       : start_time_(start),
         finish_time_(finish),
         undo_buffer_(buffer_pool.Get()),
-        redo_buffer_(log_manager.Get(), buffer_pool.Get()) {}
+        redo_buffer_(declared_read_only ? nullptr : log_manager.Get(), buffer_pool.Get()),
+        declared_read_only_(declared_read_only) {}
 
   /**
    * @warning In the src/ folder this should only be called by the Garbage Collector to adhere to MVCC semantics. Tests
@@ -58,7 +65,7 @@ class TransactionContext {
    * DataTable.
    */
   ~TransactionContext() {
-    for (const byte *ptr : loose_ptrs_) delete[] ptr;
+    for (const byte *ptr : loose_ptrs_) storage::VarlenArena::Free(ptr);
   }
 
   /**
@@ -82,6 +89,23 @@ class TransactionContext {
    */
   timestamp_t FinishTime() const { return finish_time_.load(); }
 
+  /**
+   * @return the timestamp manager that handed out this transaction's start time, or nullptr if the transaction was not
+   * started by a TransactionManager (i.e. in tests). Used to find out which versions no running transaction can see
+   * anymore when pruning version chains.
+   */
+  common::ManagedPointer<TimestampManager> GetTimestampManager() const { return timestamp_manager_; }
+
+  /**
+   * Note down that a read by this transaction had to walk the given number of versions to find the one it can see.
+   * The TransactionManager hands these on to pace the GC.
+   * @param num_versions number of versions walked, at least 1
+   */
+  void RecordVersionChainWalk(const uint32_t num_versions) {
+    num_version_walks_.fetch_add(1, std::memory_order_relaxed);
+    num_versions_walked_.fetch_add(num_versions, std::memory_order_relaxed);
+  }
+
   /**
    * Reserve space on this transaction's undo buffer for a record to log the update given
    * @param table pointer to the updated DataTable object
@@ -91,6 +115,7 @@ class TransactionContext {
    */
   storage::UndoRecord *UndoRecordForUpdate(storage::DataTable *const table, const storage::TupleSlot slot,
                                            const storage::ProjectedRow &redo) {
+    TERRIER_ASSERT(!declared_read_only_, "Read-only transactions cannot write");
     const uint32_t size = storage::UndoRecord::Size(redo);
     return storage::UndoRecord::InitializeUpdate(undo_buffer_.NewEntry(size), finish_time_.load(), slot, table, redo);
   }
@@ -102,6 +127,7 @@ class TransactionContext {
    * @return a persistent pointer to the head of a memory chunk large enough to hold the undo record
    */
   storage::UndoRecord *UndoRecordForInsert(storage::DataTable *const table, const storage::TupleSlot slot) {
+    TERRIER_ASSERT(!declared_read_only_, "Read-only transactions cannot write");
     byte *const result = undo_buffer_.NewEntry(sizeof(storage::UndoRecord));
     return storage::UndoRecord::InitializeInsert(result, finish_time_.load(), slot, table);
   }
@@ -113,6 +139,7 @@ class TransactionContext {
    * @return a persistent pointer to the head of a memory chunk large enough to hold the undo record
    */
   storage::UndoRecord *UndoRecordForDelete(storage::DataTable *const table, const storage::TupleSlot slot) {
+    TERRIER_ASSERT(!declared_read_only_, "Read-only transactions cannot write");
     byte *const result = undo_buffer_.NewEntry(sizeof(storage::UndoRecord));
     return storage::UndoRecord::InitializeDelete(result, finish_time_.load(), slot, table);
   }
@@ -158,6 +185,26 @@ class TransactionContext {
    */
   bool IsReadOnly() const { return undo_buffer_.Empty() && loose_ptrs_.empty(); }
 
+  /**
+   * @return whether the transaction was begun as read-only, and thus takes the read-only fast path on commit and abort.
+   * A transaction can be read-only without having been declared so.
+   */
+  bool IsDeclaredReadOnly() const { return declared_read_only_; }
+
+  /**
+   * @return false if the commit callback of this transaction is invoked as soon as its commit record is serialized,
+   * instead of once it is persisted
+   */
+  bool SynchronousCommit() const { return synchronous_commit_; }
+
+  /**
+   * Sets whether the commit callback of this transaction waits for its commit record to be persisted. Without
+   * synchronous commit, a commit that has been acknowledged is lost if the system crashes before the log manager's next
+   * persist, which is bounded by its persist interval and threshold.
+   * @param synchronous_commit true to wait for persisting, false to only wait for serialization
+   */
+  void SetSynchronousCommit(const bool synchronous_commit) { synchronous_commit_ = synchronous_commit; }
+
   /**
    * Defers an action to be called if and only if the transaction aborts.  Actions executed LIFO.
    * @param a the action to be executed. A handle to the system's deferred action manager is supplied
@@ -216,6 +263,12 @@ class TransactionContext {
   std::atomic<timestamp_t> finish_time_;
   storage::UndoBuffer undo_buffer_;
   storage::RedoBuffer redo_buffer_;
+  const bool declared_read_only_;
+  bool synchronous_commit_ = true;
+  // Set by the TransactionManager on begin
+  common::ManagedPointer<TimestampManager> timestamp_manager_ = nullptr;
+  // Reads of this transaction may happen in parallel
+  std::atomic<uint64_t> num_version_walks_ = 0, num_versions_walked_ = 0;
   // TODO(Tianyu): Maybe not so much of a good idea to do this. Make explicit queue in GC?
   //
   std::vector<const byte *> loose_ptrs_;
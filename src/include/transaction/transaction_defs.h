@@ -41,4 +41,15 @@ using TransactionEndAction = std::function<void(DeferredActionManager *)>;
  * and in cases such as GC knowing the actual time enables optimizations.
  */
 using DeferredAction = std::function<void(timestamp_t)>;
+/**
+ * A ChunkedDeferredAction is a DeferredAction that does a bounded slice of its work every time it is applied, and
+ * returns true once there is nothing left to do. It keeps being applied until then.
+ */
+using ChunkedDeferredAction = std::function<bool(timestamp_t)>;
+
+/**
+ * A hint of how much work a deferred action does. Cheap actions run in registration order on the thread processing
+ * deferred actions. Expensive actions are handed off to worker threads once safe, and may run in any order.
+ */
+enum class DeferredActionCost : uint8_t { CHEAP, EXPENSIVE };
 }  // namespace terrier::transaction
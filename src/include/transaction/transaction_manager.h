@@ -45,12 +45,15 @@ class TransactionManager {
 
   /**
    * Begins a transaction.
+   * @param read_only true if the transaction promises to never write. Such a transaction reads the snapshot as of its
+   *                  start time and commits as of it, without writing a log record or going through the GC.
    * @return transaction context for the newly begun transaction
    */
-  TransactionContext *BeginTransaction();
+  TransactionContext *BeginTransaction(bool read_only = false);
 
   /**
    * Commits a transaction, making all of its changes visible to others.
+   * @warning A transaction begun as read-only is deleted before this returns.
    * @param txn the transaction to commit
    * @param callback function pointer of the callback to invoke when commit is
    * @param callback_arg a void * argument that can be passed to the callback function when invoked
@@ -60,6 +63,7 @@ class TransactionManager {
 
   /**
    * Aborts a transaction, rolling back its changes (if any).
+   * @warning A transaction begun as read-only is deleted before this returns.
    * @param txn the transaction to abort.
    * @return abort timestamp of this transaction.
    */
@@ -76,6 +80,29 @@ class TransactionManager {
    */
   TransactionQueue CompletedTransactionsForGC();
 
+  /**
+   * How much work has piled up for the GC since it last took the completed txns queue
+   */
+  struct GCPressure {
+    /** number of completed txns waiting to be handed to the GC */
+    uint64_t num_txns_;
+    /** size of the undo buffers of those txns */
+    uint64_t undo_bytes_;
+    /** number of reads of those txns that had to walk a version chain */
+    uint64_t num_version_walks_;
+    /** total number of versions walked by those reads */
+    uint64_t num_versions_walked_;
+  };
+
+  /**
+   * @return snapshot of the work waiting for the GC, for the GC thread to pace itself by
+   */
+  GCPressure GetGCPressure() const {
+    return {gc_queue_txns_.load(std::memory_order_relaxed), gc_queue_undo_bytes_.load(std::memory_order_relaxed),
+            gc_queue_version_walks_.load(std::memory_order_relaxed),
+            gc_queue_versions_walked_.load(std::memory_order_relaxed)};
+  }
+
  private:
   const common::ManagedPointer<TimestampManager> timestamp_manager_;
   const common::ManagedPointer<DeferredActionManager> deferred_action_manager_;
@@ -85,15 +112,24 @@ class TransactionManager {
 
   bool gc_enabled_ = false;
   TransactionQueue completed_txns_;
+  common::SpinLatch completed_txns_latch_;
+  // Summary of completed_txns_, kept for GetGCPressure. Written with the completed_txns_latch_ held.
+  std::atomic<uint64_t> gc_queue_txns_ = 0, gc_queue_undo_bytes_ = 0, gc_queue_version_walks_ = 0,
+                        gc_queue_versions_walked_ = 0;
   const common::ManagedPointer<storage::LogManager> log_manager_;
 
-  timestamp_t UpdatingCommitCriticalSection(TransactionContext *txn);
+  timestamp_t UpdatingCommitCriticalSection(TransactionContext *txn, transaction::callback_fn commit_callback,
+                                            void *commit_callback_arg, timestamp_t oldest_active_txn);
 
   void LogCommit(TransactionContext *txn, timestamp_t commit_time, transaction::callback_fn commit_callback,
                  void *commit_callback_arg, timestamp_t oldest_active_txn);
 
   void LogAbort(TransactionContext *txn);
 
+  void HandOffToGC(TransactionContext *txn);
+
+  void EndReadOnly(TransactionContext *txn);
+
   void Rollback(TransactionContext *txn, const storage::UndoRecord &record) const;
 
   void DeallocateColumnUpdateIfVarlen(TransactionContext *txn, storage::UndoRecord *undo,
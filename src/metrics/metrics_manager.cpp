@@ -74,6 +74,31 @@ void MetricsManager::ResetMetric(const MetricsComponent component) const {
         metric->Swap();
         break;
       }
+      case MetricsComponent::BLOCK_EVICTION: {
+        const auto &metric = metrics_store.second->block_eviction_metric_;
+        metric->Swap();
+        break;
+      }
+      case MetricsComponent::COMPACTION: {
+        const auto &metric = metrics_store.second->compaction_metric_;
+        metric->Swap();
+        break;
+      }
+      case MetricsComponent::ACCESS_OBSERVER: {
+        const auto &metric = metrics_store.second->access_observer_metric_;
+        metric->Swap();
+        break;
+      }
+      case MetricsComponent::WRITE_CONFLICT: {
+        const auto &metric = metrics_store.second->write_conflict_metric_;
+        metric->Swap();
+        break;
+      }
+      case MetricsComponent::REPLICATION: {
+        const auto &metric = metrics_store.second->replication_metric_;
+        metric->Swap();
+        break;
+      }
     }
   }
 }
@@ -126,6 +151,26 @@ void MetricsManager::ToCSV() const {
           OpenFiles<PipelineMetricRawData>(&outfiles);
           break;
         }
+        case MetricsComponent::BLOCK_EVICTION: {
+          OpenFiles<BlockEvictionMetricRawData>(&outfiles);
+          break;
+        }
+        case MetricsComponent::COMPACTION: {
+          OpenFiles<CompactionMetricRawData>(&outfiles);
+          break;
+        }
+        case MetricsComponent::ACCESS_OBSERVER: {
+          OpenFiles<AccessObserverMetricRawData>(&outfiles);
+          break;
+        }
+        case MetricsComponent::WRITE_CONFLICT: {
+          OpenFiles<WriteConflictMetricRawData>(&outfiles);
+          break;
+        }
+        case MetricsComponent::REPLICATION: {
+          OpenFiles<ReplicationMetricRawData>(&outfiles);
+          break;
+        }
       }
       aggregated_metrics_[component]->ToCSV(&outfiles);
       for (auto &file : outfiles) {
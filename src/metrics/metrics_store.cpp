@@ -16,6 +16,11 @@ MetricsStore::MetricsStore(const common::ManagedPointer<metrics::MetricsManager>
   gc_metric_ = std::make_unique<GarbageCollectionMetric>();
   execution_metric_ = std::make_unique<ExecutionMetric>();
   pipeline_metric_ = std::make_unique<PipelineMetric>();
+  block_eviction_metric_ = std::make_unique<BlockEvictionMetric>();
+  compaction_metric_ = std::make_unique<CompactionMetric>();
+  access_observer_metric_ = std::make_unique<AccessObserverMetric>();
+  write_conflict_metric_ = std::make_unique<WriteConflictMetric>();
+  replication_metric_ = std::make_unique<ReplicationMetric>();
 }
 
 std::array<std::unique_ptr<AbstractRawData>, NUM_COMPONENTS> MetricsStore::GetDataToAggregate() {
@@ -59,6 +64,41 @@ std::array<std::unique_ptr<AbstractRawData>, NUM_COMPONENTS> MetricsStore::GetDa
           result[component] = pipeline_metric_->Swap();
           break;
         }
+        case MetricsComponent::BLOCK_EVICTION: {
+          TERRIER_ASSERT(
+              block_eviction_metric_ != nullptr,
+              "BlockEvictionMetric cannot be a nullptr. Check the MetricsStore constructor that it was allocated.");
+          result[component] = block_eviction_metric_->Swap();
+          break;
+        }
+        case MetricsComponent::COMPACTION: {
+          TERRIER_ASSERT(
+              compaction_metric_ != nullptr,
+              "CompactionMetric cannot be a nullptr. Check the MetricsStore constructor that it was allocated.");
+          result[component] = compaction_metric_->Swap();
+          break;
+        }
+        case MetricsComponent::ACCESS_OBSERVER: {
+          TERRIER_ASSERT(
+              access_observer_metric_ != nullptr,
+              "AccessObserverMetric cannot be a nullptr. Check the MetricsStore constructor that it was allocated.");
+          result[component] = access_observer_metric_->Swap();
+          break;
+        }
+        case MetricsComponent::WRITE_CONFLICT: {
+          TERRIER_ASSERT(
+              write_conflict_metric_ != nullptr,
+              "WriteConflictMetric cannot be a nullptr. Check the MetricsStore constructor that it was allocated.");
+          result[component] = write_conflict_metric_->Swap();
+          break;
+        }
+        case MetricsComponent::REPLICATION: {
+          TERRIER_ASSERT(
+              replication_metric_ != nullptr,
+              "ReplicationMetric cannot be a nullptr. Check the MetricsStore constructor that it was allocated.");
+          result[component] = replication_metric_->Swap();
+          break;
+        }
       }
     }
   }
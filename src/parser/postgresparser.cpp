@@ -1924,7 +1924,16 @@ std::unique_ptr<TransactionStatement> PostgresParser::TransactionTransform(Trans
 
   switch (transaction_stmt->kind_) {
     case TRANS_STMT_BEGIN: {
-      result = std::make_unique<TransactionStatement>(TransactionStatement::kBegin);
+      bool read_only = false;
+      if (transaction_stmt->options_ != nullptr) {
+        for (auto cell = transaction_stmt->options_->head; cell != nullptr; cell = cell->next) {
+          auto def_elem = reinterpret_cast<DefElem *>(cell->data.ptr_value);
+          if (strcmp(def_elem->defname_, "transaction_read_only") == 0) {
+            read_only = reinterpret_cast<A_Const *>(def_elem->arg_)->val_.val_.ival_ != 0;
+          }
+        }
+      }
+      result = std::make_unique<TransactionStatement>(TransactionStatement::kBegin, read_only);
       break;
     }
     case TRANS_STMT_COMMIT: {
@@ -2002,9 +2011,30 @@ std::unique_ptr<UpdateStatement> PostgresParser::UpdateTransform(ParseResult *pa
 // TODO(WAN): Document why exactly this is required as a JDBC hack.
 // Postgres.VariableSetStmt -> terrier.VariableSetStatement
 std::unique_ptr<VariableSetStatement> PostgresParser::VariableSetTransform(ParseResult *parse_result,
-                                                                           UNUSED_ATTRIBUTE VariableSetStmt *root) {
-  auto result = std::make_unique<VariableSetStatement>();
-  return result;
+                                                                           VariableSetStmt *root) {
+  // Only single values and resets are understood, everything else is accepted and ignored
+  if (root->name_ == nullptr) return std::make_unique<VariableSetStatement>();
+  std::string value;
+  switch (root->kind_) {
+    case VAR_SET_VALUE: {
+      if (root->args_ == nullptr || root->args_->length != 1) return std::make_unique<VariableSetStatement>();
+      auto *const arg = reinterpret_cast<A_Const *>(root->args_->head->data.ptr_value);
+      if (arg->val_.type_ == T_String) {
+        value = arg->val_.val_.str_;
+      } else if (arg->val_.type_ == T_Integer) {
+        value = std::to_string(arg->val_.val_.ival_);
+      } else {
+        return std::make_unique<VariableSetStatement>();
+      }
+      break;
+    }
+    case VAR_SET_DEFAULT:
+    case VAR_RESET:
+      break;
+    default:
+      return std::make_unique<VariableSetStatement>();
+  }
+  return std::make_unique<VariableSetStatement>(root->name_, std::move(value), root->is_local_);
 }
 
 }  // namespace terrier::parser
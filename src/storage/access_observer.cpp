@@ -1,23 +1,172 @@
 #include "storage/access_observer.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+#include "common/thread_context.h"
+#include "metrics/metrics_store.h"
 #include "storage/block_compactor.h"
+#include "storage/block_eviction_manager.h"
+#include "storage/data_table.h"
 
 namespace terrier::storage {
+// A table's threshold is only derived from its writes once there are enough of them to go by
+constexpr uint64_t MIN_GAP_SAMPLES = 16;
+// Past this many samples, the histogram is aged so that it follows changes in the workload
+constexpr uint64_t MAX_GAP_SAMPLES = 1024;
+// Upper bound on the number of times a table's threshold is doubled because of wasted compactions
+constexpr uint32_t MAX_BACKOFF = 3;
+// Number of GC invocations without wasted compactions after which a table's backoff is lowered again
+constexpr uint64_t BACKOFF_DECAY_EPOCHS = 100;
+
+AccessObserver::AccessObserver(BlockCompactor *compactor, BlockEvictionManager *eviction_manager)
+    : compactor_(compactor), eviction_manager_(eviction_manager) {
+  // The compactor needs to tell us about the blocks it frees up
+  compactor_->SetAccessObserver(this);
+}
+
+void AccessObserver::TableState::RecordGap(const uint64_t gap) {
+  gap_histogram_[63 - __builtin_clzll(gap)]++;
+  if (++num_gaps_ == MAX_GAP_SAMPLES) {
+    num_gaps_ = 0;
+    for (auto &count : gap_histogram_) num_gaps_ += (count /= 2);
+  }
+  if (num_gaps_ < MIN_GAP_SAMPLES) return;
+
+  // Pick the threshold past which no more than one in ten writes to a block comes after a pause that long
+  uint64_t num_seen = 0;
+  for (uint32_t bucket = 0; bucket < gap_histogram_.size(); bucket++) {
+    num_seen += gap_histogram_[bucket];
+    if (num_seen * 10 >= num_gaps_ * 9) {
+      threshold_ = std::clamp(uint64_t(2) << bucket, uint64_t(MIN_COLD_DATA_EPOCH_THRESHOLD),
+                              uint64_t(MAX_COLD_DATA_EPOCH_THRESHOLD));
+      return;
+    }
+  }
+}
+
 void AccessObserver::ObserveGCInvocation() {
+  bool observer_metrics_enabled =
+      common::thread_context.metrics_store_ != nullptr &&
+      common::thread_context.metrics_store_->ComponentToRecord(metrics::MetricsComponent::ACCESS_OBSERVER);
+  if (observer_metrics_enabled) {
+    // start the operating unit resource tracker
+    common::thread_context.resource_tracker_.Start();
+  }
+  const Statistics before = statistics_;
+
   gc_epoch_++;
+  std::unordered_set<const DataTable *> pinned_tables;
+  std::vector<DataTable *> force_freeze_requests;
+  {
+    common::SpinLatch::ScopedSpinLatch guard(&requests_latch_);
+    pinned_tables = pinned_tables_;
+    force_freeze_requests.swap(force_freeze_requests_);
+  }
+
+  for (DataTable *table : force_freeze_requests) {
+    std::vector<RawBlock *> blocks;
+    {
+      common::SpinLatch::ScopedSpinLatch guard(&table->blocks_latch_);
+      for (RawBlock *block : table->blocks_) {
+        // The compactor is only concerned with blocks that are already full, and frozen ones have nothing left to do
+        if (table->retired_blocks_.count(block) != 0 || block->GetInsertHead() != table->GetBlockLayout().NumSlots() ||
+            block->controller_.GetBlockState()->load() != BlockState::HOT)
+          continue;
+        blocks.push_back(block);
+      }
+    }
+    for (RawBlock *block : blocks) {
+      last_touched_.erase(block);
+      Cool(block);
+      statistics_.num_forced_freezes_++;
+    }
+  }
+
   for (auto it = last_touched_.begin(), end = last_touched_.end(); it != end;) {
-    if (it->second + COLD_DATA_EPOCH_THRESHOLD < gc_epoch_) {
-      compactor_->PutInQueue(it->first);
+    const DataTable *table = it->first->data_table_;
+    if (pinned_tables.count(table) == 0 && it->second + ColdThreshold(table) < gc_epoch_) {
+      Cool(it->first);
       it = last_touched_.erase(it);
     } else {
       ++it;
     }
   }
+
+  // Tables that have gone a while without wasted compactions can go back to freezing blocks sooner
+  for (auto &entry : tables_) {
+    TableState &table = entry.second;
+    if (table.backoff_ > 0 && table.last_backoff_change_ + BACKOFF_DECAY_EPOCHS < gc_epoch_) {
+      table.backoff_--;
+      table.last_backoff_change_ = gc_epoch_;
+    }
+  }
+
+  if (observer_metrics_enabled) {
+    // Stop the resource tracker for this operating unit
+    common::thread_context.resource_tracker_.Stop();
+    const uint64_t num_cooled = statistics_.num_blocks_cooled_ - before.num_blocks_cooled_;
+    const uint64_t num_thawed = statistics_.num_blocks_thawed_ - before.num_blocks_thawed_;
+    if (num_cooled > 0 || num_thawed > 0) {
+      auto &resource_metrics = common::thread_context.resource_tracker_.GetMetrics();
+      common::thread_context.metrics_store_->RecordAccessObserverData(
+          num_cooled, num_thawed, statistics_.num_wasted_compactions_ - before.num_wasted_compactions_,
+          statistics_.num_forced_freezes_ - before.num_forced_freezes_, resource_metrics);
+    }
+  }
 }
 
 void AccessObserver::ObserveWrite(RawBlock *block) {
   // The compactor is only concerned with blocks that are already full. We assume that partially empty blocks are
   // always hot.
-  if (block->GetInsertHead() == block->data_table_->GetBlockLayout().NumSlots()) last_touched_[block] = gc_epoch_;
+  if (block->GetInsertHead() != block->data_table_->GetBlockLayout().NumSlots()) return;
+  // Writes from the compaction transaction itself happen while the block is cooling, and say nothing about whether
+  // the block is hot. They still need to be tracked, as that is how the block makes it back to the compactor.
+  const bool user_write = block->controller_.GetBlockState()->load() == BlockState::HOT;
+  TableState &table = tables_[block->data_table_];
+  auto cooled = cooled_.find(block);
+  if (user_write && cooled != cooled_.end()) {
+    statistics_.num_blocks_thawed_++;
+    // If the block is written to before it would even be considered cold again, freezing it did not pay off. The
+    // table backs off so its blocks need to stay untouched for longer.
+    if (cooled->second + table.EffectiveThreshold() >= gc_epoch_) {
+      statistics_.num_wasted_compactions_++;
+      table.backoff_ = std::min(table.backoff_ + 1, MAX_BACKOFF);
+      table.last_backoff_change_ = gc_epoch_;
+    }
+    cooled_.erase(cooled);
+  }
+
+  auto it = last_touched_.find(block);
+  if (it == last_touched_.end()) {
+    last_touched_[block] = gc_epoch_;
+    return;
+  }
+  if (user_write && it->second < gc_epoch_) table.RecordGap(gc_epoch_ - it->second);
+  it->second = gc_epoch_;
+}
+
+void AccessObserver::PinHot(const DataTable *table) {
+  common::SpinLatch::ScopedSpinLatch guard(&requests_latch_);
+  pinned_tables_.insert(table);
+}
+
+void AccessObserver::UnpinHot(const DataTable *table) {
+  common::SpinLatch::ScopedSpinLatch guard(&requests_latch_);
+  pinned_tables_.erase(table);
+}
+
+void AccessObserver::ForceFreeze(DataTable *table) {
+  common::SpinLatch::ScopedSpinLatch guard(&requests_latch_);
+  force_freeze_requests_.push_back(table);
+}
+
+void AccessObserver::Cool(RawBlock *block) {
+  compactor_->PutInQueue(block);
+  if (eviction_manager_ != nullptr) eviction_manager_->AddCandidate(block);
+  // A block is sent again once its compaction transaction is done with it, which does not count as another decision
+  if (cooled_.emplace(block, gc_epoch_).second) statistics_.num_blocks_cooled_++;
 }
 
 }  // namespace terrier::storage
@@ -1,10 +1,12 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <cstring>
-#include <fstream>
 #include <list>
 #include <string>
 #include <vector>
 
 #include "storage/arrow_serializer.h"
+#include "storage/write_ahead_log/log_io.h"
 
 namespace terrier::storage {
 
@@ -13,9 +15,17 @@ constexpr uint8_t ARROW_ALIGNMENT = 8;
 constexpr char ALIGNMENT[8] = {0};
 constexpr flatbuf::MetadataVersion METADATA_VERSION = flatbuf::MetadataVersion_V4;
 
-void ArrowSerializer::WriteDataBlock(std::ofstream &outfile, const char *src, size_t len) {
-  len = StorageUtil::PadUpToSize(ARROW_ALIGNMENT, len);
-  outfile.write(src, len);
+void ArrowSerializer::WriteDataBlock(const byte *src, size_t len) {
+  if (len == 0) return;
+  iovecs_.push_back({const_cast<byte *>(src), len});
+  auto padding = StorageUtil::PadUpToSize(ARROW_ALIGNMENT, len) - len;
+  if (padding != 0) iovecs_.push_back({const_cast<char *>(ALIGNMENT), padding});
+}
+
+void ArrowSerializer::FlushMessage(int out_fd, flatbuffers::FlatBufferBuilder *flatbuf_builder) {
+  PosixIoWrappers::WriteVFully(out_fd, iovecs_.data(), iovecs_.size());
+  iovecs_.clear();
+  flatbuf_builder->Clear();
 }
 
 void ArrowSerializer::AddBufferInfo(size_t *offset, size_t len, std::vector<flatbuf::Buffer> *buffers) {
@@ -24,23 +34,19 @@ void ArrowSerializer::AddBufferInfo(size_t *offset, size_t len, std::vector<flat
   *offset += len;
 }
 
-void ArrowSerializer::AssembleMetadataBuffer(std::ofstream &outfile, flatbuf::MessageHeader header_type,
-                                             flatbuffers::Offset<void> header, int64_t body_len,
-                                             flatbuffers::FlatBufferBuilder *flatbuf_builder) {
+void ArrowSerializer::AssembleMetadataBuffer(flatbuf::MessageHeader header_type, flatbuffers::Offset<void> header,
+                                             int64_t body_len, flatbuffers::FlatBufferBuilder *flatbuf_builder) {
+  TERRIER_ASSERT(iovecs_.empty(), "metadata_flatbuffer should be the first thing written in a message");
   auto message = flatbuf::CreateMessage(*flatbuf_builder, METADATA_VERSION, header_type, header, body_len);
   flatbuf_builder->Finish(message);
   int32_t flatbuf_size = flatbuf_builder->GetSize();
-  auto padded_flatbuf_size = StorageUtil::PadUpToSize(ARROW_ALIGNMENT, flatbuf_size);
-  outfile.write(reinterpret_cast<const char *>(&FLATBUF_CONTINUZATION), sizeof(int32_t));
-  outfile.write(reinterpret_cast<const char *>(&padded_flatbuf_size), sizeof(int32_t));
-  outfile.write(reinterpret_cast<const char *>(flatbuf_builder->GetBufferPointer()), flatbuf_size);
-  if (padded_flatbuf_size != static_cast<uint32_t>(flatbuf_size)) {
-    outfile.write(ALIGNMENT, padded_flatbuf_size - flatbuf_size);
-  }
-  outfile.flush();
+  metadata_prefix_[0] = FLATBUF_CONTINUZATION;
+  metadata_prefix_[1] = static_cast<int32_t>(StorageUtil::PadUpToSize(ARROW_ALIGNMENT, flatbuf_size));
+  iovecs_.push_back({metadata_prefix_, sizeof(metadata_prefix_)});
+  WriteDataBlock(reinterpret_cast<const byte *>(flatbuf_builder->GetBufferPointer()), flatbuf_size);
 }
 
-void ArrowSerializer::WriteSchemaMessage(std::ofstream &outfile, std::unordered_map<col_id_t, int64_t> *dictionary_ids,
+void ArrowSerializer::WriteSchemaMessage(int out_fd, std::unordered_map<col_id_t, int64_t> *dictionary_ids,
                                          std::vector<type::TypeId> *col_types,
                                          flatbuffers::FlatBufferBuilder *flatbuf_builder) {
   RawBlock *block = data_table_.blocks_.front();
@@ -119,11 +125,11 @@ void ArrowSerializer::WriteSchemaMessage(std::ofstream &outfile, std::unordered_
 
   auto schema =
       flatbuf::CreateSchema(*flatbuf_builder, flatbuf::Endianness_Little, flatbuf_builder->CreateVector(fields));
-  AssembleMetadataBuffer(outfile, flatbuf::MessageHeader_Schema, schema.Union(), 0, flatbuf_builder);
+  AssembleMetadataBuffer(flatbuf::MessageHeader_Schema, schema.Union(), 0, flatbuf_builder);
+  FlushMessage(out_fd, flatbuf_builder);
 }
 
-void ArrowSerializer::WriteDictionaryMessage(std::ofstream &outfile, int64_t dictionary_id,
-                                             const ArrowVarlenColumn &varlen_col,
+void ArrowSerializer::WriteDictionaryMessage(int out_fd, int64_t dictionary_id, const ArrowVarlenColumn &varlen_col,
                                              flatbuffers::FlatBufferBuilder *flatbuf_builder) {
   std::vector<flatbuf::FieldNode> field_nodes;
   std::vector<flatbuf::Buffer> buffers;
@@ -145,140 +151,500 @@ void ArrowSerializer::WriteDictionaryMessage(std::ofstream &outfile, int64_t dic
                                  flatbuf_builder->CreateVectorOfStructs(buffers));
   auto dictionary_batch = flatbuf::CreateDictionaryBatch(*flatbuf_builder, dictionary_id, record_batch);
   auto aligned_offset = StorageUtil::PadUpToSize(ARROW_ALIGNMENT, buffer_offset);
-  AssembleMetadataBuffer(outfile, flatbuf::MessageHeader_DictionaryBatch, dictionary_batch.Union(), aligned_offset,
+  AssembleMetadataBuffer(flatbuf::MessageHeader_DictionaryBatch, dictionary_batch.Union(), aligned_offset,
                          flatbuf_builder);
-  WriteDataBlock(outfile, reinterpret_cast<const char *>(varlen_col.Offsets()),
-                 varlen_col.OffsetsLength() * sizeof(uint64_t));
+  WriteDataBlock(reinterpret_cast<const byte *>(varlen_col.Offsets()), varlen_col.OffsetsLength() * sizeof(uint64_t));
+
+  WriteDataBlock(varlen_col.Values(), varlen_col.ValuesLength());
+
+  FlushMessage(out_fd, flatbuf_builder);
+}
+
+void ArrowSerializer::WriteRecordBatch(int out_fd, RawBlock *block,
+                                       std::unordered_map<col_id_t, int64_t> *dictionary_ids,
+                                       flatbuffers::FlatBufferBuilder *flatbuf_builder) {
+  const BlockLayout &layout = data_table_.accessor_.GetBlockLayout();
+  auto column_ids = layout.AllColumns();
+  std::vector<flatbuf::FieldNode> field_nodes;
+  std::vector<flatbuf::Buffer> buffers;
+
+  // Make sure varlen columns have correct data when reading
+  while (!block->controller_.TryAcquireInPlaceRead()) {
+    // Evicted blocks need to be brought back in first
+    data_table_.EnsureResident(block);
+  }
+  ArrowBlockMetadata &metadata = data_table_.accessor_.GetArrowBlockMetadata(block);
+  uint32_t num_slots = metadata.NumRecords();
+
+  size_t buffer_offset = 0;
+  size_t column_id_size = column_ids.size();
+
+  // First pass, write metadata_flatbuffer
+  for (size_t i = 0; i < column_id_size; ++i) {
+    auto col_id = column_ids[i];
+    common::RawConcurrentBitmap *column_bitmap = data_table_.accessor_.ColumnNullBitmap(block, col_id);
+    std::byte *column_start = data_table_.accessor_.ColumnStart(block, col_id);
+
+    ArrowColumnInfo &col_info = metadata.GetColumnInfo(layout, col_id);
+    field_nodes.emplace_back(num_slots, metadata.NullCount(col_id));
+
+    AddBufferInfo(&buffer_offset,
+                  reinterpret_cast<uintptr_t>(column_start) - reinterpret_cast<uintptr_t>(column_bitmap), &buffers);
+    if (layout.IsVarlen(col_id) && !(col_info.Type() == ArrowColumnType::FIXED_LENGTH)) {
+      switch (col_info.Type()) {
+        case ArrowColumnType::GATHERED_VARLEN: {
+          ArrowVarlenColumn &varlen_col = col_info.VarlenColumn();
+          AddBufferInfo(&buffer_offset, varlen_col.OffsetsLength() * sizeof(uint64_t), &buffers);
+          AddBufferInfo(&buffer_offset, varlen_col.ValuesLength(), &buffers);
+          break;
+        }
+        case ArrowColumnType::DICTIONARY_COMPRESSED: {
+          ArrowVarlenColumn &varlen_col = col_info.VarlenColumn();
+          WriteDictionaryMessage(out_fd, (*dictionary_ids)[col_id], varlen_col, flatbuf_builder);
+          AddBufferInfo(&buffer_offset, num_slots * sizeof(uint64_t), &buffers);
+          break;
+        }
+        default:
+          throw std::runtime_error("unexpected control flow");
+      }
+    } else {
+      int32_t cur_buffer_len;
+      // Calculate the length of the data region of current column. For the columns except the last one, we calculate
+      // their length by using the start of next column's bit map - the start of current column's data. For the
+      // last column, we calculate the length by using the beginning address of the next block - the start of current
+      // column data.
+      if (i == column_id_size - 1) {
+        auto casted_column_start = reinterpret_cast<uintptr_t>(column_start);
+        uintptr_t mask = common::Constants::BLOCK_SIZE - 1;
+        cur_buffer_len = ((casted_column_start + mask) & (~mask)) - casted_column_start;
+      } else {
+        cur_buffer_len =
+            reinterpret_cast<uintptr_t>(data_table_.accessor_.ColumnNullBitmap(block, column_ids[i + 1])) -
+            reinterpret_cast<uintptr_t>(column_start);
+      }
+      AddBufferInfo(&buffer_offset, cur_buffer_len, &buffers);
+    }
+  }
+  auto record_batch =
+      flatbuf::CreateRecordBatch(*flatbuf_builder, num_slots, flatbuf_builder->CreateVectorOfStructs(field_nodes),
+                                 flatbuf_builder->CreateVectorOfStructs(buffers));
+  auto aligned_offset = StorageUtil::PadUpToSize(ARROW_ALIGNMENT, buffer_offset);
+  AssembleMetadataBuffer(flatbuf::MessageHeader_RecordBatch, record_batch.Union(), aligned_offset, flatbuf_builder);
 
-  WriteDataBlock(outfile, reinterpret_cast<const char *>(varlen_col.Values()), varlen_col.ValuesLength());
+  // Second pass, queue up the data. Nothing is copied, the message body is gathered straight out of the block.
+  for (size_t i = 0; i < column_id_size; ++i) {
+    auto col_id = column_ids[i];
+    common::RawConcurrentBitmap *column_bitmap = data_table_.accessor_.ColumnNullBitmap(block, col_id);
+    std::byte *column_start = data_table_.accessor_.ColumnStart(block, col_id);
 
-  outfile.flush();
+    ArrowColumnInfo &col_info = metadata.GetColumnInfo(layout, col_id);
+
+    WriteDataBlock(reinterpret_cast<const byte *>(column_bitmap),
+                   reinterpret_cast<uintptr_t>(column_start) - reinterpret_cast<uintptr_t>(column_bitmap));
+
+    if (layout.IsVarlen(col_id) && !(col_info.Type() == ArrowColumnType::FIXED_LENGTH)) {
+      switch (col_info.Type()) {
+        case ArrowColumnType::GATHERED_VARLEN: {
+          ArrowVarlenColumn &varlen_col = col_info.VarlenColumn();
+          WriteDataBlock(reinterpret_cast<const byte *>(varlen_col.Offsets()),
+                         varlen_col.OffsetsLength() * sizeof(uint64_t));
+          WriteDataBlock(varlen_col.Values(), varlen_col.ValuesLength());
+          break;
+        }
+        case ArrowColumnType::DICTIONARY_COMPRESSED: {
+          auto indices = col_info.Indices();
+          WriteDataBlock(reinterpret_cast<const byte *>(indices), num_slots * sizeof(uint64_t));
+          break;
+        }
+        default:
+          throw std::runtime_error("unexpected control flow");
+      }
+    } else {
+      int32_t cur_buffer_len;
+      if (i == column_id_size - 1) {
+        auto casted_column_start = reinterpret_cast<uintptr_t>(column_start);
+        uintptr_t mask = common::Constants::BLOCK_SIZE - 1;
+        cur_buffer_len = ((casted_column_start + mask) & (~mask)) - casted_column_start;
+      } else {
+        cur_buffer_len =
+            reinterpret_cast<uintptr_t>(data_table_.accessor_.ColumnNullBitmap(block, column_ids[i + 1])) -
+            reinterpret_cast<uintptr_t>(column_start);
+      }
+      WriteDataBlock(column_start, cur_buffer_len);
+    }
+  }
+  // The block needs to stay frozen until the kernel is done reading out of it
+  FlushMessage(out_fd, flatbuf_builder);
+  block->controller_.ReleaseInPlaceRead();
 }
 
 void ArrowSerializer::ExportTable(const std::string &file_name, std::vector<type::TypeId> *col_types) {
   flatbuffers::FlatBufferBuilder flatbuf_builder;
-  std::ofstream outfile(file_name, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+  ScopedFileDescriptor out_fd(
+      PosixIoWrappers::Open(file_name.c_str(), O_WRONLY | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR));
   std::unordered_map<col_id_t, int64_t> dictionary_ids;
-  WriteSchemaMessage(outfile, &dictionary_ids, col_types, &flatbuf_builder);
+  WriteSchemaMessage(out_fd.Get(), &dictionary_ids, col_types, &flatbuf_builder);
 
-  const BlockLayout &layout = data_table_.accessor_.GetBlockLayout();
-  auto column_ids = layout.AllColumns();
   data_table_.blocks_latch_.Lock();
-  std::list<RawBlock *> tmp_blocks = data_table_.blocks_;
+  std::list<RawBlock *> tmp_blocks;
+  // Blocks emptied by compaction are on their way out and have nothing to export
+  for (RawBlock *block : data_table_.blocks_)
+    if (data_table_.retired_blocks_.count(block) == 0) tmp_blocks.push_back(block);
   data_table_.blocks_latch_.Unlock();
 
-  for (RawBlock *block : tmp_blocks) {
-    std::vector<flatbuf::FieldNode> field_nodes;
-    std::vector<flatbuf::Buffer> buffers;
+  for (RawBlock *block : tmp_blocks) WriteRecordBatch(out_fd.Get(), block, &dictionary_ids, &flatbuf_builder);
+  out_fd.Close();
+}
 
-    // Make sure varlen columns have correct data when reading
-    while (!block->controller_.TryAcquireInPlaceRead()) {
+uint64_t ArrowSerializer::ExportSnapshot(const std::string &file_name,
+                                         const common::ManagedPointer<transaction::TransactionContext> txn,
+                                         std::vector<TupleSlot> *tuple_slots) {
+  const TupleAccessStrategy &accessor = data_table_.accessor_;
+  const BlockLayout &layout = accessor.GetBlockLayout();
+  auto column_ids = layout.AllColumns();
+
+  // Without upper layers, the type of a column can only be told from its layout
+  std::vector<type::TypeId> col_types(layout.NumColumns(), type::TypeId::INVALID);
+  for (col_id_t col_id : column_ids) {
+    if (layout.IsVarlen(col_id)) {
+      col_types[!col_id] = type::TypeId::VARCHAR;
+      continue;
+    }
+    switch (layout.AttrSize(col_id)) {
+      case 1:
+        col_types[!col_id] = type::TypeId::TINYINT;
+        break;
+      case 2:
+        col_types[!col_id] = type::TypeId::SMALLINT;
+        break;
+      case 4:
+        col_types[!col_id] = type::TypeId::INTEGER;
+        break;
+      case 8:
+        col_types[!col_id] = type::TypeId::BIGINT;
+        break;
+      default:
+        throw std::runtime_error("unexpected attribute size");
     }
-    ArrowBlockMetadata &metadata = data_table_.accessor_.GetArrowBlockMetadata(block);
-    uint32_t num_slots = metadata.NumRecords();
+  }
+
+  // Live blocks are hot and versioned, so the snapshot is gathered into the single block of a staging table, frozen
+  // there and written out one block's worth of tuples at a time
+  DataTable staging_table(data_table_.block_store_, layout, data_table_.layout_version_);
+  ArrowSerializer staging_serializer(staging_table);
+  RawBlock *block = nullptr;
+  const auto new_staging_block = [&] {
+    block = staging_table.NewBlock();
+    ArrowBlockMetadata &metadata = accessor.GetArrowBlockMetadata(block);
+    for (col_id_t col_id : layout.Varlens())
+      metadata.GetColumnInfo(layout, col_id).Type() = ArrowColumnType::GATHERED_VARLEN;
+    common::SpinLatch::ScopedSpinLatch guard(&staging_table.blocks_latch_);
+    staging_table.blocks_.push_back(block);
+  };
+  new_staging_block();
+
+  flatbuffers::FlatBufferBuilder flatbuf_builder;
+  ScopedFileDescriptor out_fd(
+      PosixIoWrappers::Open(file_name.c_str(), O_WRONLY | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR));
+  std::unordered_map<col_id_t, int64_t> dictionary_ids;
+  staging_serializer.WriteSchemaMessage(out_fd.Get(), &dictionary_ids, &col_types, &flatbuf_builder);
+
+  ProjectedColumnsInitializer initializer(layout, column_ids, layout.NumSlots());
+  byte *buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedColumnsSize());
+  ProjectedColumns *columns = initializer.Initialize(buffer);
+  uint64_t num_tuples = 0;
+  auto it = data_table_.begin();
+  while (it != data_table_.end()) {
+    data_table_.Scan(txn, &it, columns);
+    const uint32_t num_records = columns->NumTuples();
+    if (num_records == 0) continue;
+
+    for (uint32_t i = 0; i < num_records; i++) {
+      TupleSlot slot;
+      bool UNUSED_ATTRIBUTE allocated = accessor.Allocate(block, &slot);
+      TERRIER_ASSERT(allocated, "staging block should have room for a full scan batch");
+      accessor.AccessForceNotNull(slot, VERSION_POINTER_COLUMN_ID);
+      const ProjectedColumns::RowView row = columns->InterpretAsRow(i);
+      for (uint16_t j = 0; j < row.NumColumns(); j++) StorageUtil::CopyAttrFromProjection(accessor, slot, row, j);
+      tuple_slots->push_back(columns->TupleSlots()[i]);
+    }
+
+    // Same as the block compactor, except that the entries are gathered out of the live table and never reclaimed
+    ArrowBlockMetadata &metadata = accessor.GetArrowBlockMetadata(block);
+    metadata.NumRecords() = num_records;
+    for (col_id_t col_id : column_ids) {
+      common::RawConcurrentBitmap *column_bitmap = accessor.ColumnNullBitmap(block, col_id);
+      auto *entries = reinterpret_cast<VarlenEntry *>(accessor.ColumnStart(block, col_id));
+      uint32_t varlen_size = 0;
+      metadata.NullCount(col_id) = 0;
+      for (uint32_t i = 0; i < num_records; i++) {
+        if (!column_bitmap->Test(i))
+          metadata.NullCount(col_id)++;
+        else if (layout.IsVarlen(col_id))
+          varlen_size += entries[i].Size();
+      }
+      if (!layout.IsVarlen(col_id)) continue;
+
+      ArrowVarlenColumn varlen_col(varlen_size, num_records + 1);
+      for (uint32_t i = 0, acc = 0; i < num_records; i++) {
+        varlen_col.Offsets()[i] = acc;
+        if (!column_bitmap->Test(i)) continue;
+        VarlenEntry &entry = entries[i];
+        std::memcpy(varlen_col.Values() + acc, entry.Content(), entry.Size());
+        // The staging block must not free what the live table owns when it is released
+        if (entry.Size() > VarlenEntry::InlineThreshold())
+          entry = VarlenEntry::Create(varlen_col.Values() + acc, entry.Size(), false);
+        acc += entry.Size();
+      }
+      varlen_col.Offsets()[num_records] = varlen_col.ValuesLength();
+      metadata.GetColumnInfo(layout, col_id).VarlenColumn() = std::move(varlen_col);
+    }
+    block->insert_head_ = layout.NumSlots();
+    block->controller_.GetBlockState()->store(BlockState::FROZEN);
+
+    staging_serializer.WriteRecordBatch(out_fd.Get(), block, &dictionary_ids, &flatbuf_builder);
+    num_tuples += num_records;
+    staging_table.ReleaseBlocks(1);
+    new_staging_block();
+  }
+  delete[] buffer;
 
-    size_t buffer_offset = 0;
-    size_t column_id_size = column_ids.size();
+  if (fsync(out_fd.Get()) == -1) throw std::runtime_error("fsync failed with errno " + std::to_string(errno));
+  out_fd.Close();
+  return num_tuples;
+}
+
+const byte *ArrowDeserializer::LocateBuffer(const flatbuffers::Vector<const flatbuf::Buffer *> *buffers, uint32_t index,
+                                            const byte *body, int64_t body_len, uint64_t min_len) {
+  if (buffers == nullptr || index >= buffers->size()) throw std::runtime_error("missing buffer in message");
+  const flatbuf::Buffer *buffer = buffers->Get(index);
+  if (buffer->offset() < 0 || buffer->length() < 0 || static_cast<uint64_t>(buffer->length()) < min_len ||
+      buffer->offset() + buffer->length() > body_len)
+    throw std::runtime_error("buffer out of bounds of message body");
+  return body + buffer->offset();
+}
 
-    // First pass, write metadata_flatbuffer
-    for (size_t i = 0; i < column_id_size; ++i) {
-      auto col_id = column_ids[i];
-      common::RawConcurrentBitmap *column_bitmap = data_table_.accessor_.ColumnNullBitmap(block, col_id);
-      std::byte *column_start = data_table_.accessor_.ColumnStart(block, col_id);
+void ArrowDeserializer::ReadSchemaMessage(const flatbuf::Schema *schema,
+                                          std::unordered_map<col_id_t, ArrowColumnType> *col_types,
+                                          std::unordered_map<col_id_t, int64_t> *dictionary_ids) {
+  const BlockLayout &layout = data_table_->accessor_.GetBlockLayout();
+  auto column_ids = layout.AllColumns();
+  if (schema->fields() == nullptr || schema->fields()->size() != column_ids.size())
+    throw std::runtime_error("number of columns in the file does not match the data table");
 
+  // The columns are exported in the order of AllColumns(), so the i-th field describes the i-th column
+  for (uint32_t i = 0; i < column_ids.size(); i++) {
+    col_id_t col_id = column_ids[i];
+    const flatbuf::Field *field = schema->fields()->Get(i);
+    ArrowColumnType type;
+    if (field->dictionary() != nullptr) {
+      type = ArrowColumnType::DICTIONARY_COMPRESSED;
+      dictionary_ids->emplace(col_id, field->dictionary()->id());
+    } else if (field->type_type() == flatbuf::Type_LargeBinary) {
+      type = ArrowColumnType::GATHERED_VARLEN;
+    } else {
+      type = ArrowColumnType::FIXED_LENGTH;
+    }
+    if (layout.IsVarlen(col_id) == (type == ArrowColumnType::FIXED_LENGTH))
+      throw std::runtime_error("column type in the file does not match the data table");
+    col_types->emplace(col_id, type);
+  }
+}
+
+ArrowDeserializer::Dictionary ArrowDeserializer::ReadDictionaryMessage(
+    const flatbuf::DictionaryBatch *dictionary_batch, const byte *body, int64_t body_len) {
+  const flatbuf::RecordBatch *record_batch = dictionary_batch->data();
+  if (record_batch == nullptr || record_batch->length() < 0) throw std::runtime_error("malformed dictionary message");
+  auto num_entries = static_cast<uint32_t>(record_batch->length());
+  // Buffer 0 is the fake validity buffer, followed by offsets and values
+  auto *offsets = reinterpret_cast<const uint64_t *>(
+      LocateBuffer(record_batch->buffers(), 1, body, body_len, (num_entries + 1) * sizeof(uint64_t)));
+  const byte *values = LocateBuffer(record_batch->buffers(), 2, body, body_len, offsets[num_entries]);
+  return {offsets, values, num_entries};
+}
+
+uint32_t ArrowDeserializer::ReadRecordBatchMessage(const flatbuf::RecordBatch *record_batch, const byte *body,
+                                                   int64_t body_len,
+                                                   const std::unordered_map<col_id_t, ArrowColumnType> &col_types,
+                                                   const std::unordered_map<col_id_t, int64_t> &dictionary_ids,
+                                                   const std::unordered_map<int64_t, Dictionary> &dictionaries,
+                                                   std::vector<TupleSlot> *imported_slots) {
+  const TupleAccessStrategy &accessor = data_table_->accessor_;
+  const BlockLayout &layout = accessor.GetBlockLayout();
+  auto column_ids = layout.AllColumns();
+  if (record_batch->length() < 0 || record_batch->length() > layout.NumSlots() || record_batch->nodes() == nullptr ||
+      record_batch->nodes()->size() != column_ids.size())
+    throw std::runtime_error("record batch does not match the data table");
+  auto num_records = static_cast<uint32_t>(record_batch->length());
+
+  RawBlock *block = data_table_->NewBlock();
+  ArrowBlockMetadata &metadata = accessor.GetArrowBlockMetadata(block);
+  const auto *buffers = record_batch->buffers();
+  uint32_t buffer_idx = 0;
+  try {
+    for (uint32_t i = 0; i < column_ids.size(); i++) {
+      col_id_t col_id = column_ids[i];
+      common::RawConcurrentBitmap *column_bitmap = accessor.ColumnNullBitmap(block, col_id);
+      std::byte *column_start = accessor.ColumnStart(block, col_id);
       ArrowColumnInfo &col_info = metadata.GetColumnInfo(layout, col_id);
-      field_nodes.emplace_back(num_slots, metadata.NullCount(col_id));
-
-      AddBufferInfo(&buffer_offset,
-                    reinterpret_cast<uintptr_t>(column_start) - reinterpret_cast<uintptr_t>(column_bitmap), &buffers);
-      if (layout.IsVarlen(col_id) && !(col_info.Type() == ArrowColumnType::FIXED_LENGTH)) {
-        switch (col_info.Type()) {
-          case ArrowColumnType::GATHERED_VARLEN: {
-            ArrowVarlenColumn &varlen_col = col_info.VarlenColumn();
-            AddBufferInfo(&buffer_offset, varlen_col.OffsetsLength() * sizeof(uint64_t), &buffers);
-            AddBufferInfo(&buffer_offset, varlen_col.ValuesLength(), &buffers);
-            break;
-          }
-          case ArrowColumnType::DICTIONARY_COMPRESSED: {
-            ArrowVarlenColumn &varlen_col = col_info.VarlenColumn();
-            WriteDictionaryMessage(outfile, dictionary_ids[col_id], varlen_col, &flatbuf_builder);
-            AddBufferInfo(&buffer_offset, num_slots * sizeof(uint64_t), &buffers);
-            break;
-          }
-          default:
-            throw std::runtime_error("unexpected control flow");
-        }
-      } else {
-        int32_t cur_buffer_len;
-        // Calculate the length of the data region of current column. For the columns except the last one, we calculate
-        // their length by using the start of next column's bit map - the start of current column's data. For the
-        // last column, we calculate the length by using the beginning address of the next block - the start of current
-        // column data.
-        if (i == column_id_size - 1) {
+      col_info.Type() = col_types.at(col_id);
+      metadata.NullCount(col_id) = static_cast<uint32_t>(record_batch->nodes()->Get(i)->null_count());
+
+      // The exported bitmap covers the whole bitmap region of the column, padding included
+      auto bitmap_len = reinterpret_cast<uintptr_t>(column_start) - reinterpret_cast<uintptr_t>(column_bitmap);
+      std::memcpy(column_bitmap, LocateBuffer(buffers, buffer_idx++, body, body_len, bitmap_len), bitmap_len);
+
+      if (col_info.Type() == ArrowColumnType::FIXED_LENGTH) {
+        // Same as in the serializer, a fixed length column spans until the next column's bitmap, or the end of block
+        uintptr_t data_len;
+        if (i == column_ids.size() - 1) {
           auto casted_column_start = reinterpret_cast<uintptr_t>(column_start);
           uintptr_t mask = common::Constants::BLOCK_SIZE - 1;
-          cur_buffer_len = ((casted_column_start + mask) & (~mask)) - casted_column_start;
+          data_len = ((casted_column_start + mask) & (~mask)) - casted_column_start;
         } else {
-          cur_buffer_len =
-              reinterpret_cast<uintptr_t>(data_table_.accessor_.ColumnNullBitmap(block, column_ids[i + 1])) -
-              reinterpret_cast<uintptr_t>(column_start);
+          data_len = reinterpret_cast<uintptr_t>(accessor.ColumnNullBitmap(block, column_ids[i + 1])) -
+                     reinterpret_cast<uintptr_t>(column_start);
         }
-        AddBufferInfo(&buffer_offset, cur_buffer_len, &buffers);
+        std::memcpy(column_start, LocateBuffer(buffers, buffer_idx++, body, body_len, data_len), data_len);
+        continue;
       }
-    }
-    auto record_batch =
-        flatbuf::CreateRecordBatch(flatbuf_builder, num_slots, flatbuf_builder.CreateVectorOfStructs(field_nodes),
-                                   flatbuf_builder.CreateVectorOfStructs(buffers));
-    auto aligned_offset = StorageUtil::PadUpToSize(ARROW_ALIGNMENT, buffer_offset);
-    AssembleMetadataBuffer(outfile, flatbuf::MessageHeader_RecordBatch, record_batch.Union(), aligned_offset,
-                           &flatbuf_builder);
-
-    // Second pass, write data.
-    for (size_t i = 0; i < column_id_size; ++i) {
-      auto col_id = column_ids[i];
-      common::RawConcurrentBitmap *column_bitmap = data_table_.accessor_.ColumnNullBitmap(block, col_id);
-      std::byte *column_start = data_table_.accessor_.ColumnStart(block, col_id);
 
-      ArrowColumnInfo &col_info = metadata.GetColumnInfo(layout, col_id);
-      field_nodes.emplace_back(num_slots, metadata.NullCount(col_id));
-
-      WriteDataBlock(outfile, reinterpret_cast<const char *>(column_bitmap),
-                     reinterpret_cast<uintptr_t>(column_start) - reinterpret_cast<uintptr_t>(column_bitmap));
-
-      if (layout.IsVarlen(col_id) && !(col_info.Type() == ArrowColumnType::FIXED_LENGTH)) {
-        switch (col_info.Type()) {
-          case ArrowColumnType::GATHERED_VARLEN: {
-            ArrowVarlenColumn &varlen_col = col_info.VarlenColumn();
-            WriteDataBlock(outfile, reinterpret_cast<const char *>(varlen_col.Offsets()),
-                           varlen_col.OffsetsLength() * sizeof(uint64_t));
-            WriteDataBlock(outfile, reinterpret_cast<const char *>(varlen_col.Values()), varlen_col.ValuesLength());
-            break;
-          }
-          case ArrowColumnType::DICTIONARY_COMPRESSED: {
-            auto indices = col_info.Indices();
-            WriteDataBlock(outfile, reinterpret_cast<const char *>(indices), num_slots * sizeof(uint64_t));
-            break;
-          }
-          default:
-            throw std::runtime_error("unexpected control flow");
-        }
+      const uint64_t *indices = nullptr;
+      ArrowVarlenColumn &varlen_col = col_info.VarlenColumn();
+      if (col_info.Type() == ArrowColumnType::GATHERED_VARLEN) {
+        auto *src_offsets = reinterpret_cast<const uint64_t *>(
+            LocateBuffer(buffers, buffer_idx++, body, body_len, (num_records + 1) * sizeof(uint64_t)));
+        const byte *src_values =
+            LocateBuffer(buffers, buffer_idx++, body, body_len, num_records == 0 ? 0 : src_offsets[num_records]);
+        varlen_col = {static_cast<uint32_t>(src_offsets[num_records]), num_records + 1};
+        std::memcpy(varlen_col.Offsets(), src_offsets, varlen_col.OffsetsLength() * sizeof(uint64_t));
+        std::memcpy(varlen_col.Values(), src_values, varlen_col.ValuesLength());
       } else {
-        int32_t cur_buffer_len;
-        if (i == column_id_size - 1) {
-          auto casted_column_start = reinterpret_cast<uintptr_t>(column_start);
-          uintptr_t mask = common::Constants::BLOCK_SIZE - 1;
-          cur_buffer_len = ((casted_column_start + mask) & (~mask)) - casted_column_start;
-        } else {
-          cur_buffer_len =
-              reinterpret_cast<uintptr_t>(data_table_.accessor_.ColumnNullBitmap(block, column_ids[i + 1])) -
-              reinterpret_cast<uintptr_t>(column_start);
+        // The most recent dictionary message with the column's id is the dictionary of this block
+        auto it = dictionaries.find(dictionary_ids.at(col_id));
+        if (it == dictionaries.end()) throw std::runtime_error("record batch refers to a missing dictionary");
+        const Dictionary &dictionary = it->second;
+        auto *src_indices = reinterpret_cast<const uint64_t *>(
+            LocateBuffer(buffers, buffer_idx++, body, body_len, num_records * sizeof(uint64_t)));
+        varlen_col = {static_cast<uint32_t>(dictionary.offsets_[dictionary.num_entries_]), dictionary.num_entries_ + 1};
+        std::memcpy(varlen_col.Offsets(), dictionary.offsets_, varlen_col.OffsetsLength() * sizeof(uint64_t));
+        std::memcpy(varlen_col.Values(), dictionary.values_, varlen_col.ValuesLength());
+        col_info.Indices() = common::AllocationUtil::AllocateAligned<uint64_t>(num_records);
+        std::memcpy(col_info.Indices(), src_indices, num_records * sizeof(uint64_t));
+        indices = col_info.Indices();
+      }
+      const uint64_t *offsets = varlen_col.Offsets();
+      const byte *values = varlen_col.Values();
+
+      // Point the varlen entries in the block at the arrow storage, as the block compactor would have
+      auto *entries = reinterpret_cast<VarlenEntry *>(column_start);
+      for (uint32_t slot = 0; slot < num_records; slot++) {
+        if (!column_bitmap->Test(slot)) continue;
+        uint64_t entry_idx = indices == nullptr ? slot : indices[slot];
+        if (entry_idx + 1 >= varlen_col.OffsetsLength() || offsets[entry_idx + 1] < offsets[entry_idx] ||
+            offsets[entry_idx + 1] > varlen_col.ValuesLength())
+          throw std::runtime_error("varlen offsets out of bounds");
+        auto size = static_cast<uint32_t>(offsets[entry_idx + 1] - offsets[entry_idx]);
+        const byte *content = values + offsets[entry_idx];
+        entries[slot] = size > VarlenEntry::InlineThreshold() ? VarlenEntry::Create(content, size, false)
+                                                              : VarlenEntry::CreateInline(content, size);
+      }
+    }
+  } catch (...) {
+    // Clean up the partially built block before giving up
+    for (col_id_t col_id : layout.Varlens()) metadata.GetColumnInfo(layout, col_id).Deallocate();
+    data_table_->block_store_->Release(block);
+    throw;
+  }
+
+  // Tuples in a frozen block are laid out contiguously and have no versions. Mark them as allocated and present.
+  for (uint32_t slot = 0; slot < num_records; slot++) {
+    TupleSlot result;
+    bool UNUSED_ATTRIBUTE allocated = accessor.Allocate(block, &result);
+    TERRIER_ASSERT(allocated, "freshly initialized block should have room for all records");
+    accessor.AccessForceNotNull(result, VERSION_POINTER_COLUMN_ID);
+    if (imported_slots != nullptr) imported_slots->push_back(result);
+  }
+  metadata.NumRecords() = num_records;
+  // No more inserts into the block, as they are only allowed into hot blocks
+  block->insert_head_ = layout.NumSlots();
+  block->controller_.GetBlockState()->store(BlockState::FROZEN);
+
+  common::SpinLatch::ScopedSpinLatch guard(&data_table_->blocks_latch_);
+  data_table_->blocks_.push_back(block);
+  return num_records;
+}
+
+uint64_t ArrowDeserializer::ImportTable(const std::string &file_name, std::vector<TupleSlot> *imported_slots) {
+  int in_fd = PosixIoWrappers::Open(file_name.c_str(), O_RDONLY);
+  struct stat file_stat;
+  if (fstat(in_fd, &file_stat) == -1) {
+    PosixIoWrappers::Close(in_fd);
+    throw std::runtime_error("fstat failed with errno " + std::to_string(errno));
+  }
+  auto file_size = static_cast<uint64_t>(file_stat.st_size);
+  if (file_size == 0) {
+    PosixIoWrappers::Close(in_fd);
+    return 0;
+  }
+  void *mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, in_fd, 0);
+  // The mapping stays valid after the fd is closed
+  PosixIoWrappers::Close(in_fd);
+  if (mapped == MAP_FAILED) throw std::runtime_error("mmap failed with errno " + std::to_string(errno));
+  // We read the file front to back exactly once
+  madvise(mapped, file_size, MADV_SEQUENTIAL);
+  const auto *file = reinterpret_cast<const byte *>(mapped);
+
+  std::unordered_map<col_id_t, ArrowColumnType> col_types;
+  std::unordered_map<col_id_t, int64_t> dictionary_ids;
+  std::unordered_map<int64_t, Dictionary> dictionaries;
+  bool schema_read = false;
+  uint64_t num_tuples = 0;
+  try {
+    uint64_t pos = 0;
+    while (pos + 2 * sizeof(int32_t) <= file_size) {
+      const auto *prefix = reinterpret_cast<const int32_t *>(file + pos);
+      if (prefix[0] != FLATBUF_CONTINUZATION) throw std::runtime_error("missing continuation marker");
+      // A metadata size of 0 marks the end of stream
+      if (prefix[1] == 0) break;
+      if (prefix[1] < 0 || pos + 2 * sizeof(int32_t) + prefix[1] > file_size)
+        throw std::runtime_error("metadata out of bounds of file");
+      const byte *metadata = file + pos + 2 * sizeof(int32_t);
+      flatbuffers::Verifier verifier(reinterpret_cast<const uint8_t *>(metadata), prefix[1]);
+      if (!flatbuf::VerifyMessageBuffer(verifier)) throw std::runtime_error("malformed metadata_flatbuffer");
+      const flatbuf::Message *message = flatbuf::GetMessage(metadata);
+
+      const byte *body = metadata + prefix[1];
+      int64_t body_len = message->bodyLength();
+      if (body_len < 0 || static_cast<uint64_t>(body - file) + body_len > file_size)
+        throw std::runtime_error("message body out of bounds of file");
+
+      switch (message->header_type()) {
+        case flatbuf::MessageHeader_Schema:
+          ReadSchemaMessage(message->header_as_Schema(), &col_types, &dictionary_ids);
+          schema_read = true;
+          break;
+        case flatbuf::MessageHeader_DictionaryBatch: {
+          const flatbuf::DictionaryBatch *dictionary_batch = message->header_as_DictionaryBatch();
+          dictionaries[dictionary_batch->id()] = ReadDictionaryMessage(dictionary_batch, body, body_len);
+          break;
         }
-        WriteDataBlock(outfile, reinterpret_cast<const char *>(column_start), cur_buffer_len);
+        case flatbuf::MessageHeader_RecordBatch:
+          if (!schema_read) throw std::runtime_error("record batch before schema");
+          num_tuples += ReadRecordBatchMessage(message->header_as_RecordBatch(), body, body_len, col_types,
+                                               dictionary_ids, dictionaries, imported_slots);
+          break;
+        default:
+          throw std::runtime_error("unexpected message type");
       }
+      pos = static_cast<uint64_t>(body - file) + body_len;
     }
-    outfile.flush();
-    block->controller_.ReleaseInPlaceRead();
+  } catch (...) {
+    munmap(mapped, file_size);
+    throw;
   }
-  outfile.close();
+  munmap(mapped, file_size);
+  return num_tuples;
 }
+
 }  // namespace terrier::storage
@@ -3,72 +3,185 @@
 #include <algorithm>
 #include <queue>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "common/thread_context.h"
+#include "metrics/metrics_store.h"
+#include "storage/access_observer.h"
 #include "storage/index/bwtree_index.h"
 #include "storage/index/index_defs.h"
 #include "storage/sql_table.h"
+#include "storage/varlen_arena.h"
 #include "transaction/transaction_util.h"
 
 namespace terrier::storage {
+BlockCompactor::BlockCompactor(const uint32_t num_workers, const uint32_t max_blocks_per_group,
+                               const double max_group_fill_factor)
+    : num_workers_(num_workers),
+      max_blocks_per_group_(max_blocks_per_group),
+      max_group_fill_factor_(max_group_fill_factor),
+      workers_(num_workers, {}) {
+  TERRIER_ASSERT(max_blocks_per_group_ > 0, "compaction groups need at least one block");
+  if (num_workers_ > 0) workers_.Startup();
+}
+
 void BlockCompactor::ProcessCompactionQueue(transaction::DeferredActionManager *deferred_action_manager,
                                             transaction::TransactionManager *txn_manager) {
-  std::queue<RawBlock *> to_process = std::move(compaction_queue_);
-  while (!to_process.empty()) {
+  bool compaction_metrics_enabled =
+      common::thread_context.metrics_store_ != nullptr &&
+      common::thread_context.metrics_store_->ComponentToRecord(metrics::MetricsComponent::COMPACTION);
+  if (compaction_metrics_enabled) {
+    // start the operating unit resource tracker
+    common::thread_context.resource_tracker_.Start();
+  }
+
+  std::queue<RawBlock *> to_process;
+  {
+    common::SpinLatch::ScopedSpinLatch guard(&queue_latch_);
+    to_process.swap(compaction_queue_);
+  }
+  CompactionStats stats;
+  // Hot blocks are grouped by table before being compacted, along with how many of their slots are taken
+  std::unordered_map<DataTable *, std::vector<std::pair<uint32_t, RawBlock *>>> hot_blocks;
+  std::unordered_set<RawBlock *> seen;
+  for (; !to_process.empty(); to_process.pop()) {
     RawBlock *block = to_process.front();
+    // The same block can be queued more than once. It must not end up in a compaction group twice.
+    if (!seen.insert(block).second) continue;
     BlockAccessController &controller = block->controller_;
     switch (controller.GetBlockState()->load()) {
       case BlockState::HOT: {
-        // TODO(Tianyu): The policy about how to group blocks together into compaction group can be a lot
-        // more sophisticated. Compacting more blocks together frees up more memory per compaction run,
-        // but makes the compaction transaction larger, which can have performance impact on the rest
-        // of the system. As it currently stands, no memory is freed from this one-block-per-group scheme.
-        CompactionGroup cg(txn_manager->BeginTransaction(), block->data_table_);
-        // TODO(Tianyu): Additionally, frozen blocks can still have empty slots within them. To make sure
-        // these memory are not gone forever, we still need to periodically shuffle tuples around within
-        // frozen blocks. Although code can be reused for doing the compaction, some logic needs to be
-        // written to enqueue these frozen blocks into the compaction queue.
-        cg.blocks_to_compact_.emplace(block, std::vector<uint32_t>());
-        if (EliminateGaps(&cg)) {
-          controller.GetBlockState()->store(BlockState::COOLING);
-          // If no compaction was performed, we still need to shut out any potentially racey transactions that
-          // are alive at the same time as us flipping the block status flag to cooling. However, we must manually
-          // ask the GC to enqueue this block, because no access will be observed from the empty compaction transaction.
-          if (cg.txn_->IsReadOnly())
-            deferred_action_manager->RegisterDeferredAction([this, block]() { PutInQueue(block); });
-          txn_manager->Commit(cg.txn_, transaction::TransactionUtil::EmptyCallback, nullptr);
-        } else {
-          txn_manager->Abort(cg.txn_);
-        }
+        const TupleAccessStrategy &accessor = block->data_table_->accessor_;
+        uint32_t num_filled = 0;
+        auto *bitmap = accessor.AllocationBitmap(block);
+        for (uint32_t offset = 0; offset < accessor.GetBlockLayout().NumSlots(); offset++)
+          if (bitmap->Test(offset)) num_filled++;
+        hot_blocks[block->data_table_].emplace_back(num_filled, block);
         break;
       }
-      case BlockState::COOLING: {
-        if (!CheckForVersionsAndGaps(block->data_table_->accessor_, block)) continue;
-        // This is used to clean up any dangling pointers using a deferred action in GC.
-        // We need this piece of memory to live on the heap, so its life time extends to
-        // beyond this function call.
-        auto *loose_ptrs = new std::vector<const byte *>;
-        GatherVarlens(loose_ptrs, block, block->data_table_);
-        controller.GetBlockState()->store(BlockState::FROZEN);
-        // When the old variable length values are no longer visible by running transactions, delete them.
-        deferred_action_manager->RegisterDeferredAction([=]() {
-          for (auto *loose_ptr : *loose_ptrs) delete[] loose_ptr;
-          delete loose_ptrs;
-        });
+      case BlockState::COOLING:
+        RunTask([=, stats = &stats] { FreezeBlock(block, deferred_action_manager, stats); });
         break;
-      }
       case BlockState::FROZEN:
         // This is okay. In a rare race, the block can show up in the compaction queue, be accessed, compacted,
         // and show up again because of the early access.
         break;
+      case BlockState::EVICTING:
+      case BlockState::EVICTED:
+        // Already frozen and handed off to the eviction manager, nothing to do.
+        break;
       default:
         throw std::runtime_error("unexpected control flow");
     }
-    to_process.pop();
+  }
+
+  for (auto &entry : hot_blocks) {
+    std::vector<std::pair<uint32_t, RawBlock *>> &blocks = entry.second;
+    const auto max_filled = static_cast<uint32_t>(max_group_fill_factor_ * entry.first->GetBlockLayout().NumSlots());
+    // Emptiest blocks first, so they end up in the same groups and collapse into as few blocks as possible
+    std::sort(blocks.begin(), blocks.end());
+    std::vector<RawBlock *> group;
+    for (auto &block : blocks) {
+      if (block.first > max_filled) {
+        RunTask([=, stats = &stats] {
+          CompactGroup({block.second}, deferred_action_manager, txn_manager, stats);
+        });
+        continue;
+      }
+      group.push_back(block.second);
+      if (group.size() == max_blocks_per_group_) {
+        RunTask([=, stats = &stats] { CompactGroup(group, deferred_action_manager, txn_manager, stats); });
+        group.clear();
+      }
+    }
+    if (!group.empty())
+      RunTask([=, stats = &stats] { CompactGroup(group, deferred_action_manager, txn_manager, stats); });
+  }
+  if (num_workers_ > 0) workers_.WaitUntilAllFinished();
+
+  if (compaction_metrics_enabled) {
+    // Stop the resource tracker for this operating unit
+    common::thread_context.resource_tracker_.Stop();
+    if (stats.num_groups_ > 0 || stats.num_blocks_frozen_ > 0) {
+      auto &resource_metrics = common::thread_context.resource_tracker_.GetMetrics();
+      common::thread_context.metrics_store_->RecordCompactionData(
+          stats.num_groups_, stats.num_groups_aborted_, stats.num_blocks_compacted_, stats.num_tuples_moved_,
+          stats.num_blocks_emptied_, stats.num_blocks_frozen_, resource_metrics);
+    }
   }
 }
 
+void BlockCompactor::CompactGroup(const std::vector<RawBlock *> &blocks,
+                                  transaction::DeferredActionManager *const deferred_action_manager,
+                                  transaction::TransactionManager *const txn_manager, CompactionStats *const stats) {
+  DataTable *table = blocks.front()->data_table_;
+  CompactionGroup cg(txn_manager->BeginTransaction(), table);
+  // TODO(Tianyu): Frozen blocks can still have empty slots within them. To make sure these memory are not gone
+  // forever, we still need to periodically shuffle tuples around within frozen blocks. Although code can be reused
+  // for doing the compaction, some logic needs to be written to enqueue these frozen blocks into the compaction queue.
+  for (RawBlock *block : blocks) cg.blocks_to_compact_.emplace(block, std::vector<uint32_t>());
+  stats->num_groups_++;
+  if (!EliminateGaps(&cg)) {
+    txn_manager->Abort(cg.txn_);
+    stats->num_groups_aborted_++;
+    return;
+  }
+
+  for (RawBlock *block : blocks) {
+    if (std::find(cg.blocks_emptied_.begin(), cg.blocks_emptied_.end(), block) != cg.blocks_emptied_.end()) continue;
+    block->controller_.GetBlockState()->store(BlockState::COOLING);
+    // If no compaction was performed, we still need to shut out any potentially racey transactions that
+    // are alive at the same time as us flipping the block status flag to cooling. However, we must manually
+    // ask the GC to enqueue this block, because no access will be observed from the empty compaction transaction.
+    if (cg.txn_->IsReadOnly())
+      deferred_action_manager->RegisterDeferredAction([this, block]() { PutInQueue(block); });
+  }
+  txn_manager->Commit(cg.txn_, transaction::TransactionUtil::EmptyCallback, nullptr);
+  stats->num_blocks_compacted_ += blocks.size();
+  stats->num_tuples_moved_ += cg.num_tuples_moved_;
+  stats->num_blocks_emptied_ += cg.blocks_emptied_.size();
+
+  if (cg.blocks_emptied_.empty()) return;
+  // Emptied blocks leave the table in two steps. Once no running transaction can see their tuples anymore, new scans
+  // and inserts are turned away from them. Once everyone that could have still been on them at that point is gone as
+  // well, they are handed back to the block store.
+  deferred_action_manager->RegisterDeferredAction(
+      [this, deferred_action_manager, table, emptied = std::move(cg.blocks_emptied_)]() {
+        for (RawBlock *block : emptied) table->RetireBlock(block);
+        deferred_action_manager->RegisterDeferredAction([this, table, emptied]() {
+          for (RawBlock *block : emptied) {
+            if (observer_ != nullptr) observer_->ObserveBlockReleased(block);
+            table->ReleaseRetiredBlock(block);
+          }
+        });
+      });
+}
+
+void BlockCompactor::FreezeBlock(RawBlock *const block,
+                                 transaction::DeferredActionManager *const deferred_action_manager,
+                                 CompactionStats *const stats) {
+  if (!CheckForVersionsAndGaps(block->data_table_->accessor_, block)) {
+    // Versions that are still around need to be pruned by the GC first, so try again next time. Otherwise someone
+    // wrote to the block in the meantime and it is up to the access observer to tell us when it cools down again.
+    if (block->controller_.GetBlockState()->load() == BlockState::COOLING) PutInQueue(block);
+    return;
+  }
+  // This is used to clean up any dangling pointers using a deferred action in GC.
+  // We need this piece of memory to live on the heap, so its life time extends to
+  // beyond this function call.
+  auto *loose_ptrs = new std::vector<const byte *>;
+  GatherVarlens(loose_ptrs, block, block->data_table_);
+  block->controller_.GetBlockState()->store(BlockState::FROZEN);
+  // When the old variable length values are no longer visible by running transactions, delete them.
+  deferred_action_manager->RegisterDeferredAction([=]() {
+    for (auto *loose_ptr : *loose_ptrs) VarlenArena::Free(loose_ptr);
+    delete loose_ptrs;
+  });
+  stats->num_blocks_frozen_++;
+}
+
 bool BlockCompactor::EliminateGaps(CompactionGroup *cg) {
   const TupleAccessStrategy &accessor = cg->table_->accessor_;
   const BlockLayout &layout = accessor.GetBlockLayout();
@@ -104,6 +217,11 @@ bool BlockCompactor::EliminateGaps(CompactionGroup *cg) {
     return a_empty < b_empty;
   });
 
+  // Number of tuples in each block, kept up to date as tuples are moved around
+  std::unordered_map<RawBlock *, uint32_t> num_filled;
+  for (auto &entry : cg->blocks_to_compact_)
+    num_filled[entry.first] = layout.NumSlots() - static_cast<uint32_t>(entry.second.size());
+
   cg->all_cols_initializer_.InitializeRow(cg->read_buffer_);
   // We assume that there are a lot more filled slots than empty slots, so we only store the list of empty slots
   // and construct the vector of filled slots on the fly in order to reduce the memory footprint.
@@ -117,10 +235,13 @@ bool BlockCompactor::EliminateGaps(CompactionGroup *cg) {
     std::vector<uint32_t> &taker_empty = cg->blocks_to_compact_.find(*taker)->second;
 
     for (uint32_t empty_offset : taker_empty) {
-      if (filled.empty()) {
+      // Skip over blocks that have no tuples left to give
+      while (filled.empty() && giver != taker) {
         giver--;
         ComputeFilled(layout, &filled, cg->blocks_to_compact_.find(*giver)->second);
       }
+      // Every remaining tuple is already in place
+      if (filled.empty()) break;
       TupleSlot empty_slot(*taker, empty_offset);
       // fill the first empty slot with the last filled slot, essentially
       // We will only shuffle tuples within a block if it is the last block to compact. Then, we can stop
@@ -131,14 +252,16 @@ bool BlockCompactor::EliminateGaps(CompactionGroup *cg) {
       if (taker == giver && filled_slot.GetOffset() < empty_slot.GetOffset()) break;
       // A failed move implies conflict
       if (!MoveTuple(cg, filled_slot, empty_slot)) return false;
+      num_filled[*giver]--;
+      num_filled[*taker]++;
+      cg->num_tuples_moved_++;
     }
   }
 
-  // TODO(Tianyu): This compaction process could leave blocks empty within a group and we will need to figure out
-  // how those blocks are garbage collected. These blocks should have the same life-cycle as the compacting
-  // transaction itself. (i.e. when the txn context is being GCed, we should be able to free these blocks as well)
-  // For now we are not implementing this because each compaction group is one block. This suggests the use of
-  // deferred action.
+  // Blocks that were given away all of their tuples are no longer needed. They share the life-cycle of the compacting
+  // transaction, and are released through deferred actions once it commits.
+  for (auto &entry : num_filled)
+    if (entry.second == 0) cg->blocks_emptied_.push_back(entry.first);
   return true;
 }
 
@@ -176,7 +299,7 @@ bool BlockCompactor::MoveTuple(CompactionGroup *cg, TupleSlot from, TupleSlot to
       *entry = VarlenEntry::CreateInline(entry->Content(), entry->Size());
     } else {
       // TODO(Tianyu): Copying for correctness. This is not yet shown to be expensive, but might be in the future.
-      byte *copied = common::AllocationUtil::AllocateAligned(entry->Size());
+      byte *copied = VarlenArena::Allocate(entry->Size());
       std::memcpy(copied, entry->Content(), entry->Size());
       *entry = VarlenEntry::Create(copied, entry->Size(), true);
     }
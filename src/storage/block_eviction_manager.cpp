@@ -0,0 +1,350 @@
+#include "storage/block_eviction_manager.h"
+
+#include <sys/mman.h>
+#include <exception>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/thread_context.h"
+#include "loggers/storage_logger.h"
+#include "metrics/metrics_store.h"
+#include "storage/arrow_block_metadata.h"
+#include "storage/data_table.h"
+#include "storage/write_ahead_log/log_io.h"
+#include "transaction/deferred_action_manager.h"
+
+namespace terrier::storage {
+
+BlockEvictionManager::BlockEvictionManager(
+    const common::ManagedPointer<transaction::DeferredActionManager> deferred_action_manager,
+    std::string block_file_path, const uint32_t max_resident_blocks)
+    : deferred_action_manager_(deferred_action_manager),
+      block_file_path_(std::move(block_file_path)),
+      max_resident_blocks_(max_resident_blocks),
+      block_file_(PosixIoWrappers::Open(block_file_path_.c_str(), O_RDWR | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR)),
+      resident_prefix_size_(static_cast<uint32_t>(sysconf(_SC_PAGESIZE))),
+      fault_in_pool_(1, {}) {
+  TERRIER_ASSERT(resident_prefix_size_ < common::Constants::BLOCK_SIZE, "block should span multiple pages");
+  fault_in_pool_.Startup();
+}
+
+BlockEvictionManager::~BlockEvictionManager() {
+  fault_in_pool_.Shutdown();
+  TERRIER_ASSERT(evicted_blocks_.empty(), "all tables with evicted blocks should be gone by now");
+  PosixIoWrappers::Close(block_file_);
+  unlink(block_file_path_.c_str());
+}
+
+void BlockEvictionManager::AddCandidate(RawBlock *const block) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (candidate_index_.count(block) != 0 || evicted_blocks_.count(block) != 0) return;
+  // The table needs to know who to ask to bring the block back once it is evicted
+  block->data_table_->eviction_manager_.store(this);
+  candidate_index_[block] = candidates_.insert(candidates_.end(), block);
+}
+
+uint32_t BlockEvictionManager::ProcessEvictionQueue() {
+  bool eviction_metrics_enabled =
+      common::thread_context.metrics_store_ != nullptr &&
+      common::thread_context.metrics_store_->ComponentToRecord(metrics::MetricsComponent::BLOCK_EVICTION);
+  if (eviction_metrics_enabled) {
+    // start the operating unit resource tracker
+    common::thread_context.resource_tracker_.Start();
+  }
+
+  uint32_t num_evicted = 0;
+  uint64_t num_bytes_written = 0;
+  std::vector<RawBlock *> to_write;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    // First write out the blocks that nobody could be reading transactionally anymore
+    for (auto &ready : ready_to_evict_) {
+      RawBlock *block = ready.first;
+      auto it = evicted_blocks_.find(block);
+      // The block has since been faulted in, forgotten, or marked again, in which case we are not done waiting yet
+      if (it == evicted_blocks_.end() || it->second.generation_ != ready.second || it->second.on_disk_) continue;
+      BlockState expected = BlockState::EVICTING;
+      if (block->controller_.GetBlockState()->compare_exchange_strong(expected, BlockState::EVICTED)) {
+        it->second.io_in_progress_ = true;
+        to_write.push_back(block);
+      } else {
+        // Someone accessed the block in the meantime and called off the eviction. If it is still frozen it is just as
+        // cold as before, otherwise it is up to the access observer to tell us when it cools down again.
+        evicted_blocks_.erase(it);
+        if (expected == BlockState::FROZEN) candidate_index_[block] = candidates_.insert(candidates_.end(), block);
+      }
+    }
+    ready_to_evict_.clear();
+
+    // Then pick the coldest blocks to go next. Blocks that are yet to be frozen stay in line.
+    for (auto to_check = candidates_.size(); to_check > 0 && candidates_.size() > max_resident_blocks_; to_check--) {
+      RawBlock *block = candidates_.front();
+      RemoveCandidate(block);
+      if (!MarkForEviction(block)) candidate_index_[block] = candidates_.insert(candidates_.end(), block);
+    }
+  }
+
+  // A block that fails to be written out stays in memory, which does not keep the others from being written out
+  std::exception_ptr failure = nullptr;
+  for (RawBlock *block : to_write) {
+    try {
+      num_bytes_written += Evict(block);
+      num_evicted++;
+    } catch (...) {
+      if (failure == nullptr) failure = std::current_exception();
+    }
+  }
+
+  if (eviction_metrics_enabled) {
+    // Stop the resource tracker for this operating unit
+    common::thread_context.resource_tracker_.Stop();
+    auto &resource_metrics = common::thread_context.resource_tracker_.GetMetrics();
+    common::thread_context.metrics_store_->RecordEvictionData(num_evicted, num_hits_.exchange(0),
+                                                              num_misses_.exchange(0), num_bytes_written,
+                                                              num_bytes_read_.exchange(0), resource_metrics);
+  }
+  if (failure != nullptr) std::rethrow_exception(failure);
+  return num_evicted;
+}
+
+void BlockEvictionManager::FaultIn(RawBlock *const block) {
+  // If the block has not been written out yet, we can simply call off the eviction
+  BlockState expected = BlockState::EVICTING;
+  if (block->controller_.GetBlockState()->compare_exchange_strong(expected, BlockState::FROZEN)) {
+    num_hits_++;
+    return;
+  }
+  if (expected != BlockState::EVICTED) return;
+
+  std::unique_lock<std::mutex> lock(latch_);
+  Restore(block, &lock);
+}
+
+void BlockEvictionManager::FaultInAsync(RawBlock *const block) {
+  fault_in_pool_.SubmitTask([this, block] {
+    std::unique_lock<std::mutex> lock(latch_);
+    // The table could have been dropped since, in which case we are not tracking the block anymore and leave it alone
+    try {
+      Restore(block, &lock);
+    } catch (const std::exception &e) {
+      // Nobody is waiting on the prefetch. The block stays evicted, and the access it was meant for tries again.
+      STORAGE_LOG_ERROR("Failed to prefetch evicted block: {}", e.what());
+    }
+  });
+}
+
+bool BlockEvictionManager::ForgetBlock(RawBlock *const block) {
+  std::unique_lock<std::mutex> lock(latch_);
+  // A background fault-in could still be reading the block back
+  EvictionEntry *entry = WaitForIo(block, &lock);
+  if (candidate_index_.count(block) != 0) RemoveCandidate(block);
+  if (entry == nullptr) return false;
+  bool on_disk = entry->on_disk_;
+  if (on_disk) FreeExtent(entry->file_offset_, entry->length_);
+  // Any pending grace period for this block will not find a matching entry anymore and does nothing
+  evicted_blocks_.erase(block);
+  return on_disk;
+}
+
+bool BlockEvictionManager::MarkForEviction(RawBlock *const block) {
+  BlockAccessController &controller = block->controller_;
+  // Only a frozen block without in-place readers can be evicted. Flipping the state turns away new in-place readers.
+  if (!controller.UpdateAtomically({BlockState::FROZEN, 0}, {BlockState::EVICTING, 0})) return false;
+  uint64_t generation = next_generation_++;
+  evicted_blocks_[block] = {generation, false, false, 0, 0};
+  // Transactional readers do not register with the access controller, so we must wait for every transaction that
+  // could have seen the block as frozen to finish before its contents can go away.
+  deferred_action_manager_->RegisterDeferredAction([this, block, generation]() {
+    std::lock_guard<std::mutex> guard(latch_);
+    ready_to_evict_.emplace_back(block, generation);
+  });
+  return true;
+}
+
+BlockEvictionManager::EvictionEntry *BlockEvictionManager::WaitForIo(RawBlock *const block,
+                                                                     std::unique_lock<std::mutex> *const lock) {
+  while (true) {
+    auto it = evicted_blocks_.find(block);
+    if (it == evicted_blocks_.end()) return nullptr;
+    if (!it->second.io_in_progress_) return &it->second;
+    // The entry could be gone by the time we wake up, so look it up again
+    io_done_cv_.wait(*lock);
+  }
+}
+
+uint64_t BlockEvictionManager::Evict(RawBlock *const block) {
+  const TupleAccessStrategy &accessor = block->data_table_->accessor_;
+  const BlockLayout &layout = accessor.GetBlockLayout();
+  ArrowBlockMetadata &metadata = accessor.GetArrowBlockMetadata(block);
+
+  // The block is written out as-is, followed by the Arrow buffers of its varlen columns, with a single writev
+  std::vector<struct iovec> iovecs;
+  iovecs.push_back({block->content_, sizeof(block->content_)});
+  for (col_id_t col_id : layout.Varlens()) {
+    ArrowColumnInfo &col_info = metadata.GetColumnInfo(layout, col_id);
+    if (col_info.Type() == ArrowColumnType::FIXED_LENGTH) continue;
+    ArrowVarlenColumn &varlen_col = col_info.VarlenColumn();
+    iovecs.push_back({varlen_col.Offsets(), varlen_col.OffsetsLength() * sizeof(uint64_t)});
+    iovecs.push_back({varlen_col.Values(), varlen_col.ValuesLength()});
+    if (col_info.Type() == ArrowColumnType::DICTIONARY_COMPRESSED)
+      iovecs.push_back({col_info.Indices(), metadata.NumRecords() * sizeof(uint64_t)});
+  }
+  uint64_t length = 0;
+  for (auto &iovec : iovecs) length += iovec.iov_len;
+
+  uint64_t file_offset;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    file_offset = AllocateExtent(length);
+  }
+  // The block is marked as being written out, so nobody touches it or its entry until we are done
+  try {
+    PosixIoWrappers::PwriteVFully(block_file_, iovecs.data(), iovecs.size(), static_cast<off_t>(file_offset));
+  } catch (...) {
+    // Nothing is released yet, so the block is still all there in memory. Call off the eviction.
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      FreeExtent(file_offset, length);
+      evicted_blocks_.erase(block);
+      candidate_index_[block] = candidates_.insert(candidates_.end(), block);
+      block->controller_.GetBlockState()->store(BlockState::FROZEN);
+    }
+    io_done_cv_.notify_all();
+    throw;
+  }
+
+  // Now give back the memory. The header needs to stay around as it is how everyone finds out the block is evicted.
+  for (col_id_t col_id : layout.Varlens()) {
+    ArrowColumnInfo &col_info = metadata.GetColumnInfo(layout, col_id);
+    if (col_info.Type() != ArrowColumnType::FIXED_LENGTH) col_info.Deallocate();
+  }
+  madvise(reinterpret_cast<byte *>(block) + resident_prefix_size_,
+          common::Constants::BLOCK_SIZE - resident_prefix_size_, MADV_DONTNEED);
+
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    EvictionEntry &entry = evicted_blocks_.find(block)->second;
+    entry.file_offset_ = file_offset;
+    entry.length_ = length;
+    entry.on_disk_ = true;
+    entry.io_in_progress_ = false;
+  }
+  io_done_cv_.notify_all();
+  return length;
+}
+
+void BlockEvictionManager::Restore(RawBlock *const block, std::unique_lock<std::mutex> *const lock) {
+  // Wait for the block to be written out if it is about to be, or for whoever else is already bringing it back
+  EvictionEntry *entry = WaitForIo(block, lock);
+  // Someone else brought the block back, or it has been forgotten
+  if (entry == nullptr || !entry->on_disk_) return;
+  // Claim the block and read it back without the latch. Its extent stays allocated until the read is done.
+  entry->io_in_progress_ = true;
+  const uint64_t file_offset = entry->file_offset_, length = entry->length_;
+  lock->unlock();
+
+  const TupleAccessStrategy &accessor = block->data_table_->accessor_;
+  const BlockLayout &layout = accessor.GetBlockLayout();
+
+  uint64_t read_offset = file_offset;
+  auto read_fully = [&](void *dest, size_t size) {
+    if (PosixIoWrappers::PreadFully(block_file_, dest, size, static_cast<off_t>(read_offset)) != size)
+      throw std::runtime_error("block file is shorter than expected");
+    read_offset += size;
+  };
+  // Columns given new buffers so far
+  std::vector<ArrowColumnInfo *> restored_cols;
+  try {
+    read_fully(block->content_, sizeof(block->content_));
+
+    ArrowBlockMetadata &metadata = accessor.GetArrowBlockMetadata(block);
+    for (col_id_t col_id : layout.Varlens()) {
+      ArrowColumnInfo &col_info = metadata.GetColumnInfo(layout, col_id);
+      ArrowColumnType type = col_info.Type();
+      if (type == ArrowColumnType::FIXED_LENGTH) continue;
+      // The column info read back still points to the buffers freed on eviction. Reset it without freeing them again.
+      uint32_t values_length = col_info.VarlenColumn().ValuesLength();
+      uint32_t offsets_length = col_info.VarlenColumn().OffsetsLength();
+      const byte *old_values = col_info.VarlenColumn().Values();
+      new (&col_info) ArrowColumnInfo();
+      col_info.Type() = type;
+      ArrowVarlenColumn &varlen_col = col_info.VarlenColumn() = {values_length, offsets_length};
+      restored_cols.push_back(&col_info);
+      read_fully(varlen_col.Offsets(), varlen_col.OffsetsLength() * sizeof(uint64_t));
+      read_fully(varlen_col.Values(), varlen_col.ValuesLength());
+      if (type == ArrowColumnType::DICTIONARY_COMPRESSED) {
+        col_info.Indices() = common::AllocationUtil::AllocateAligned<uint64_t>(metadata.NumRecords());
+        read_fully(col_info.Indices(), metadata.NumRecords() * sizeof(uint64_t));
+      }
+
+      // Swing the varlen entries in the block over to the new buffers. Inlined entries need no fixing.
+      for (uint32_t offset = 0; offset < layout.NumSlots(); offset++) {
+        TupleSlot slot(block, offset);
+        if (!accessor.Allocated(slot)) continue;
+        auto *entry = reinterpret_cast<VarlenEntry *>(accessor.AccessWithNullCheck(slot, col_id));
+        if (entry == nullptr || entry->Size() <= VarlenEntry::InlineThreshold()) continue;
+        *entry = VarlenEntry::Create(varlen_col.Values() + (entry->Content() - old_values), entry->Size(), false);
+      }
+    }
+  } catch (...) {
+    // The block stays evicted. Its copy on disk is intact and is read again on the next access, which does not know
+    // about the buffers read into so far.
+    for (ArrowColumnInfo *col_info : restored_cols) col_info->Deallocate();
+    lock->lock();
+    evicted_blocks_.find(block)->second.io_in_progress_ = false;
+    io_done_cv_.notify_all();
+    throw;
+  }
+
+  num_misses_++;
+  num_bytes_read_ += length;
+  lock->lock();
+  FreeExtent(file_offset, length);
+  evicted_blocks_.erase(block);
+  // The block is still cold as far as we know, and back in memory
+  candidate_index_[block] = candidates_.insert(candidates_.end(), block);
+  block->controller_.GetBlockState()->store(BlockState::FROZEN);
+  io_done_cv_.notify_all();
+}
+
+void BlockEvictionManager::RemoveCandidate(RawBlock *const block) {
+  auto it = candidate_index_.find(block);
+  candidates_.erase(it->second);
+  candidate_index_.erase(it);
+}
+
+uint64_t BlockEvictionManager::AllocateExtent(const uint64_t length) {
+  // First fit. Evicted blocks are all about the same size, so this should not fragment the file much.
+  for (auto it = free_extents_.begin(); it != free_extents_.end(); ++it) {
+    if (it->second < length) continue;
+    uint64_t offset = it->first, remaining = it->second - length;
+    free_extents_.erase(it);
+    if (remaining > 0) free_extents_.emplace(offset + length, remaining);
+    return offset;
+  }
+  uint64_t offset = file_end_;
+  file_end_ += length;
+  return offset;
+}
+
+void BlockEvictionManager::FreeExtent(uint64_t offset, uint64_t length) {
+  // Coalesce with the neighbouring free extents, if any
+  auto next = free_extents_.lower_bound(offset);
+  if (next != free_extents_.end() && offset + length == next->first) {
+    length += next->second;
+    next = free_extents_.erase(next);
+  }
+  if (next != free_extents_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      length += prev->second;
+      free_extents_.erase(prev);
+    }
+  }
+  free_extents_.emplace(offset, length);
+}
+
+}  // namespace terrier::storage
@@ -1,9 +1,15 @@
+#include <algorithm>
+#include <limits>
 #include <list>
 
 #include "common/allocator.h"
+#include "common/thread_context.h"
+#include "metrics/metrics_store.h"
 #include "storage/block_access_controller.h"
+#include "storage/block_eviction_manager.h"
 #include "storage/data_table.h"
 #include "storage/storage_util.h"
+#include "transaction/timestamp_manager.h"
 #include "transaction/transaction_context.h"
 #include "transaction/transaction_util.h"
 
@@ -24,14 +30,24 @@ DataTable::DataTable(const common::ManagedPointer<BlockStore> store, const Block
   insertion_head_ = blocks_.begin();
 }
 
-DataTable::~DataTable() {
+DataTable::~DataTable() { ReleaseBlocks(std::numeric_limits<uint32_t>::max()); }
+
+bool DataTable::ReleaseBlocks(const uint32_t max_blocks) {
   common::SpinLatch::ScopedSpinLatch guard(&blocks_latch_);
-  for (RawBlock *block : blocks_) {
-    StorageUtil::DeallocateVarlens(block, accessor_);
-    for (col_id_t i : accessor_.GetBlockLayout().Varlens())
-      accessor_.GetArrowBlockMetadata(block).GetColumnInfo(accessor_.GetBlockLayout(), i).Deallocate();
+  BlockEvictionManager *eviction_manager = eviction_manager_.load();
+  for (uint32_t released = 0; released < max_blocks && !blocks_.empty(); released++) {
+    RawBlock *const block = blocks_.front();
+    blocks_.pop_front();
+    retired_blocks_.erase(block);
+    // The varlens of a block on disk are already gone, and the block itself is no longer readable
+    if (eviction_manager == nullptr || !eviction_manager->ForgetBlock(block)) {
+      StorageUtil::DeallocateVarlens(block, accessor_);
+      for (col_id_t i : accessor_.GetBlockLayout().Varlens())
+        accessor_.GetArrowBlockMetadata(block).GetColumnInfo(accessor_.GetBlockLayout(), i).Deallocate();
+    }
     block_store_->Release(block);
   }
+  return blocks_.empty();
 }
 
 bool DataTable::Select(const common::ManagedPointer<transaction::TransactionContext> txn, TupleSlot slot,
@@ -49,6 +65,7 @@ void DataTable::Scan(const common::ManagedPointer<transaction::TransactionContex
   while (filled < out_buffer->MaxTuples() && *start_pos != end()) {
     ProjectedColumns::RowView row = out_buffer->InterpretAsRow(filled);
     const TupleSlot slot = **start_pos;
+    if (slot.GetOffset() == 0) PrefetchNextBlock(*start_pos);
     // Only fill the buffer with valid, visible tuples
     if (SelectIntoBuffer(txn, slot, &row)) {
       out_buffer->TupleSlots()[filled] = slot;
@@ -63,7 +80,7 @@ DataTable::SlotIterator &DataTable::SlotIterator::operator++() {
   common::SpinLatch::ScopedSpinLatch guard(&table_->blocks_latch_);
   // Jump to the next block if already the last slot in the block.
   if (current_slot_.GetOffset() == table_->accessor_.GetBlockLayout().NumSlots() - 1) {
-    ++block_;
+    block_ = table_->SkipRetiredBlocks(++block_);
     // Cannot dereference if the next block is end(), so just use nullptr to denote
     current_slot_ = {block_ == table_->blocks_.end() ? nullptr : *block_, 0};
   } else {
@@ -72,6 +89,47 @@ DataTable::SlotIterator &DataTable::SlotIterator::operator++() {
   return *this;
 }
 
+void DataTable::RetireBlock(RawBlock *const block) {
+  std::list<RawBlock *>::iterator it;
+  {
+    common::SpinLatch::ScopedSpinLatch guard(&blocks_latch_);
+    retired_blocks_.insert(block);
+    it = std::find(blocks_.begin(), blocks_.end(), block);
+  }
+  // Inserts start looking for free slots at the insertion head, so it must not be left on the block. The block is full,
+  // so this is the same as any other full block at the insertion head.
+  if (it != blocks_.end()) CheckMoveHead(it);
+}
+
+void DataTable::ReleaseRetiredBlock(RawBlock *const block) {
+  {
+    common::SpinLatch::ScopedSpinLatch guard(&blocks_latch_);
+    retired_blocks_.erase(block);
+    blocks_.remove(block);
+  }
+  BlockEvictionManager *eviction_manager = eviction_manager_.load();
+  if (eviction_manager != nullptr) eviction_manager->ForgetBlock(block);
+  StorageUtil::DeallocateVarlens(block, accessor_);
+  for (col_id_t i : accessor_.GetBlockLayout().Varlens())
+    accessor_.GetArrowBlockMetadata(block).GetColumnInfo(accessor_.GetBlockLayout(), i).Deallocate();
+  block_store_->Release(block);
+}
+
+void DataTable::FaultIn(RawBlock *const block) const {
+  BlockEvictionManager *eviction_manager = eviction_manager_.load();
+  TERRIER_ASSERT(eviction_manager != nullptr, "only blocks handed to an eviction manager can be evicted");
+  eviction_manager->FaultIn(block);
+}
+
+void DataTable::PrefetchNextBlock(const SlotIterator &pos) const {
+  BlockEvictionManager *eviction_manager = eviction_manager_.load();
+  if (eviction_manager == nullptr) return;
+  common::SpinLatch::ScopedSpinLatch guard(&blocks_latch_);
+  auto next = pos.block_;
+  if (next == blocks_.end() || ++next == blocks_.end()) return;
+  if ((*next)->controller_.GetBlockState()->load() == BlockState::EVICTED) eviction_manager->FaultInAsync(*next);
+}
+
 DataTable::SlotIterator DataTable::end() const {  // NOLINT for STL name compability
   common::SpinLatch::ScopedSpinLatch guard(&blocks_latch_);
   // TODO(Tianyu): Need to look in detail at how this interacts with compaction when that gets in.
@@ -94,6 +152,7 @@ bool DataTable::Update(const common::ManagedPointer<transaction::TransactionCont
                  "The input buffer cannot change the reserved columns, so it should have fewer attributes.");
   TERRIER_ASSERT(redo.NumColumns() > 0, "The input buffer should modify at least one attribute.");
   UndoRecord *const undo = txn->UndoRecordForUpdate(this, slot, redo);
+  EnsureResident(slot.GetBlock());
   slot.GetBlock()->controller_.WaitUntilHot();
   UndoRecord *version_ptr;
   do {
@@ -101,10 +160,13 @@ bool DataTable::Update(const common::ManagedPointer<transaction::TransactionCont
 
     // Since we disallow write-write conflicts, the version vector pointer is essentially an implicit
     // write lock on the tuple.
-    if (HasConflict(*txn, version_ptr) || !Visible(slot, accessor_)) {
+    const bool conflict = HasConflict(*txn, version_ptr);
+    if (conflict || !Visible(slot, accessor_)) {
       // Mark this UndoRecord as never installed by setting the table pointer to nullptr. This is inspected in the
       // TransactionManager's Rollback() and GC's Unlink logic
       undo->Table() = nullptr;
+      RecordWriteOutcome(slot,
+                         conflict ? metrics::WriteOutcome::WRITE_WRITE_CONFLICT : metrics::WriteOutcome::NOT_VISIBLE);
       return false;
     }
 
@@ -112,8 +174,9 @@ bool DataTable::Update(const common::ManagedPointer<transaction::TransactionCont
     for (uint16_t i = 0; i < undo->Delta()->NumColumns(); i++)
       StorageUtil::CopyAttrIntoProjection(accessor_, slot, undo->Delta(), i);
 
-    // Update the next pointer of the new head of the version chain
-    undo->Next() = version_ptr;
+    // Update the next pointer of the new head of the version chain. If no running transaction can see the old head
+    // anymore, none of the older versions are needed either and the chain can start over here.
+    undo->Next() = VersionNeeded(*txn, version_ptr) ? version_ptr : nullptr;
   } while (!CompareAndSwapVersionPtr(slot, accessor_, version_ptr, undo));
 
   // Update in place with the new value.
@@ -126,6 +189,8 @@ bool DataTable::Update(const common::ManagedPointer<transaction::TransactionCont
     StorageUtil::CopyAttrFromProjection(accessor_, slot, redo, i);
   }
   data_table_counter_.IncrementNumUpdate(1);
+  PruneVersionChainIfLong(txn, slot, undo);
+  RecordWriteOutcome(slot, metrics::WriteOutcome::SUCCESS);
 
   return true;
 }
@@ -194,7 +259,8 @@ TupleSlot DataTable::Insert(const common::ManagedPointer<transaction::Transactio
       CheckMoveHead(block);
     }
     // The block is full or the block is being inserted by other txn, try next block
-    ++block;
+    common::SpinLatch::ScopedSpinLatch guard(&blocks_latch_);
+    block = SkipRetiredBlocks(++block);
   }
 
   // Do not need to wait unit finish inserting,
@@ -230,25 +296,32 @@ void DataTable::InsertInto(const common::ManagedPointer<transaction::Transaction
 bool DataTable::Delete(const common::ManagedPointer<transaction::TransactionContext> txn, const TupleSlot slot) {
   data_table_counter_.IncrementNumDelete(1);
   UndoRecord *const undo = txn->UndoRecordForDelete(this, slot);
+  EnsureResident(slot.GetBlock());
   slot.GetBlock()->controller_.WaitUntilHot();
   UndoRecord *version_ptr;
   do {
     version_ptr = AtomicallyReadVersionPtr(slot, accessor_);
     // Since we disallow write-write conflicts, the version vector pointer is essentially an implicit
     // write lock on the tuple.
-    if (HasConflict(*txn, version_ptr) || !Visible(slot, accessor_)) {
+    const bool conflict = HasConflict(*txn, version_ptr);
+    if (conflict || !Visible(slot, accessor_)) {
       // Mark this UndoRecord as never installed by setting the table pointer to nullptr. This is inspected in the
       // TransactionManager's Rollback() and GC's Unlink logic
       undo->Table() = nullptr;
+      RecordWriteOutcome(slot,
+                         conflict ? metrics::WriteOutcome::WRITE_WRITE_CONFLICT : metrics::WriteOutcome::NOT_VISIBLE);
       return false;
     }
 
-    // Update the next pointer of the new head of the version chain
-    undo->Next() = version_ptr;
+    // Update the next pointer of the new head of the version chain. If no running transaction can see the old head
+    // anymore, none of the older versions are needed either and the chain can start over here.
+    undo->Next() = VersionNeeded(*txn, version_ptr) ? version_ptr : nullptr;
   } while (!CompareAndSwapVersionPtr(slot, accessor_, version_ptr, undo));
 
   // We have the write lock. Go ahead and flip the logically deleted bit to true
   accessor_.SetNull(slot, VERSION_POINTER_COLUMN_ID);
+  PruneVersionChainIfLong(txn, slot, undo);
+  RecordWriteOutcome(slot, metrics::WriteOutcome::SUCCESS);
   return true;
 }
 
@@ -258,6 +331,7 @@ bool DataTable::SelectIntoBuffer(const common::ManagedPointer<transaction::Trans
   TERRIER_ASSERT(out_buffer->NumColumns() <= accessor_.GetBlockLayout().NumColumns() - NUM_RESERVED_COLUMNS,
                  "The output buffer never returns the version pointer columns, so it should have "
                  "fewer attributes.");
+  EnsureResident(slot.GetBlock());
   TERRIER_ASSERT(out_buffer->NumColumns() > 0, "The output buffer should return at least one attribute.");
   // This cannot be visible if it's already deallocated.
   if (!accessor_.Allocated(slot)) return false;
@@ -312,6 +386,7 @@ bool DataTable::SelectIntoBuffer(const common::ManagedPointer<transaction::Trans
   }
 
   // Apply deltas until we reconstruct a version safe for us to read
+  uint32_t num_versions = 0;
   while (version_ptr != nullptr &&
          transaction::TransactionUtil::NewerThan(version_ptr->Timestamp().load(), txn->StartTime())) {
     switch (version_ptr->Type()) {
@@ -329,8 +404,12 @@ bool DataTable::SelectIntoBuffer(const common::ManagedPointer<transaction::Trans
         throw std::runtime_error("unexpected delta record type");
     }
     version_ptr = version_ptr->Next();
+    num_versions++;
   }
 
+  if (num_versions > 0) txn->RecordVersionChainWalk(num_versions);
+  // Having to walk this far means the tuple is being updated faster than the GC comes around
+  if (num_versions >= VERSION_CHAIN_PRUNE_THRESHOLD) PruneVersionChainOnRead(txn, slot);
   return visible;
 }
 
@@ -372,6 +451,15 @@ bool DataTable::HasConflict(const transaction::TransactionContext &txn, UndoReco
   return owned_by_other_txn || newer_committed_version;
 }
 
+void DataTable::RecordWriteOutcome(const TupleSlot slot, const metrics::WriteOutcome outcome) const {
+  if (common::thread_context.metrics_store_ != nullptr &&
+      common::thread_context.metrics_store_->ComponentToRecord(metrics::MetricsComponent::WRITE_CONFLICT)) {
+    common::thread_context.metrics_store_->RecordWriteConflictData(reinterpret_cast<uintptr_t>(this),
+                                                                   reinterpret_cast<uintptr_t>(slot.GetBlock()),
+                                                                   slot.GetOffset(), outcome);
+  }
+}
+
 bool DataTable::CompareAndSwapVersionPtr(const TupleSlot slot, const TupleAccessStrategy &accessor,
                                          UndoRecord *expected, UndoRecord *const desired) {
   // Okay to ignore presence bit, because we use that for logical delete, not for validity of the version pointer value
@@ -379,6 +467,88 @@ bool DataTable::CompareAndSwapVersionPtr(const TupleSlot slot, const TupleAccess
   return reinterpret_cast<std::atomic<UndoRecord *> *>(ptr_location)->compare_exchange_strong(expected, desired);
 }
 
+bool DataTable::VersionNeeded(const transaction::TransactionContext &txn, const UndoRecord *const version_ptr) const {
+  if (version_ptr == nullptr) return false;
+  const common::ManagedPointer<transaction::TimestampManager> timestamp_manager = txn.GetTimestampManager();
+  // Without a timestamp manager there is no telling which transactions are running
+  if (timestamp_manager == nullptr) return true;
+  // Uncommitted versions are never older than the oldest running transaction
+  return !transaction::TransactionUtil::NewerThan(timestamp_manager->CachedOldestTransactionStartTime(),
+                                                  version_ptr->Timestamp().load());
+}
+
+void DataTable::TruncateVersionChain(const TupleSlot slot, const transaction::timestamp_t oldest) {
+  UndoRecord *const version_ptr = AtomicallyReadVersionPtr(slot, accessor_);
+  // This is a legitimate case where we truncated the version chain but had to restart because the previous head
+  // was aborted.
+  if (version_ptr == nullptr) return;
+
+  // We need to special case the head of the version chain because contention with running transactions can happen
+  // here. Instead of a blind update we will need to CAS and prune the entire version chain if the head of the version
+  // chain can be GCed.
+  if (transaction::TransactionUtil::NewerThan(oldest, version_ptr->Timestamp().load())) {
+    if (!CompareAndSwapVersionPtr(slot, accessor_, version_ptr, nullptr))
+      // Keep retrying while there are conflicts, since we only invoke truncate once per GC period for every
+      // version chain.
+      TruncateVersionChain(slot, oldest);
+    return;
+  }
+
+  // Past the head, the only change to a version chain is another truncation cutting it short. Every truncation
+  // only ever cuts off versions that are invisible to all running transactions, so we are safe to traverse and update
+  // pointers without CAS, even if we end up writing to a record someone else has just cut off.
+  UndoRecord *curr = version_ptr;
+  UndoRecord *next;
+  // Traverse until we find the earliest UndoRecord that can be unlinked.
+  while (true) {
+    next = curr->Next();
+    // This is a legitimate case where we truncated the version chain but had to restart because the previous head
+    // was aborted. It is also what we see when someone else has truncated the chain since we read its head.
+    if (next == nullptr) break;
+    if (transaction::TransactionUtil::NewerThan(oldest, next->Timestamp().load())) {
+      // The rest of the version chain must also be invisible to any running transactions since our version
+      // is newest-to-oldest sorted.
+      curr->Next().store(nullptr);
+      break;
+    }
+    curr = next;
+  }
+
+  // If the head of the version chain was not committed, it could have been aborted and requires a retry.
+  if (curr == version_ptr && !transaction::TransactionUtil::Committed(version_ptr->Timestamp().load()) &&
+      AtomicallyReadVersionPtr(slot, accessor_) != version_ptr)
+    TruncateVersionChain(slot, oldest);
+}
+
+void DataTable::PruneVersionChain(const common::ManagedPointer<transaction::TransactionContext> txn,
+                                  const TupleSlot slot) {
+  const common::ManagedPointer<transaction::TimestampManager> timestamp_manager = txn->GetTimestampManager();
+  if (timestamp_manager == nullptr) return;
+  // Looking at all running transactions every time would cost every reader of a hot tuple, for as long as a
+  // long-running transaction holds its versions back, without ever cutting anything. Waiting for the GC to refresh the
+  // cached timestamp would leave the chain to grow until the next GC pass. Refreshing it every so many transactions
+  // keeps up with the tuple at a bounded cost. The writes after us also get to start over on a fresher timestamp.
+  const transaction::timestamp_t oldest = timestamp_manager->RecentOldestTransactionStartTime();
+  // Only go ahead if the oldest version is invisible to every running transaction, otherwise nothing can be cut. The
+  // records we pass stay valid while we are running, even if someone else truncates the chain under us.
+  const UndoRecord *tail = AtomicallyReadVersionPtr(slot, accessor_);
+  if (tail == nullptr) return;
+  for (const UndoRecord *next = tail->Next().load(); next != nullptr; next = next->Next().load()) tail = next;
+  if (!transaction::TransactionUtil::NewerThan(oldest, tail->Timestamp().load())) return;
+  TruncateVersionChain(slot, oldest);
+  data_table_counter_.IncrementNumVersionChainPrune(1);
+}
+
+void DataTable::PruneVersionChainIfLong(const common::ManagedPointer<transaction::TransactionContext> txn,
+                                        const TupleSlot slot, const UndoRecord *const head) {
+  uint32_t num_versions = 0;
+  for (const UndoRecord *curr = head->Next().load(); curr != nullptr; curr = curr->Next().load())
+    if (++num_versions == VERSION_CHAIN_PRUNE_THRESHOLD) {
+      PruneVersionChain(txn, slot);
+      return;
+    }
+}
+
 RawBlock *DataTable::NewBlock() {
   RawBlock *new_block = block_store_->Get();
   accessor_.InitializeRawBlock(this, new_block, layout_version_);
@@ -387,11 +557,13 @@ RawBlock *DataTable::NewBlock() {
 }
 
 bool DataTable::HasConflict(const transaction::TransactionContext &txn, const TupleSlot slot) const {
+  EnsureResident(slot.GetBlock());
   UndoRecord *const version_ptr = AtomicallyReadVersionPtr(slot, accessor_);
   return HasConflict(txn, version_ptr);
 }
 
 bool DataTable::IsVisible(const transaction::TransactionContext &txn, const TupleSlot slot) const {
+  EnsureResident(slot.GetBlock());
   UndoRecord *version_ptr;
   bool visible;
   do {
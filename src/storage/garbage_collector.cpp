@@ -1,6 +1,8 @@
 #include "storage/garbage_collector.h"
+#include <functional>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 #include "common/macros.h"
 #include "loggers/storage_logger.h"
 #include "storage/data_table.h"
@@ -92,6 +94,8 @@ uint32_t GarbageCollector::ProcessUnlinkQueue(transaction::timestamp_t oldest_tx
   // timestamp once, and the version chain is sorted by timestamp. Here we keep a set of slots to truncate to avoid
   // wasteful traversals of the version chain.
   std::unordered_set<TupleSlot> visited_slots;
+  // With workers, the records are only split up here and unlinked once all transactions safe to gc are known
+  std::vector<UnlinkPartition> partitions(num_workers_);
 
   // Process every transaction in the unlink queue
   while (!txns_to_unlink_.empty()) {
@@ -108,15 +112,23 @@ uint32_t GarbageCollector::ProcessUnlinkQueue(transaction::timestamp_t oldest_tx
       for (auto &undo_record : txn->undo_buffer_) {
         // It is possible for the table field to be null, for aborted transaction's last conflicting record
         DataTable *&table = undo_record.Table();
-        // Each version chain needs to be traversed and truncated at most once every GC period. Check
-        // if we have already visited this tuple slot; if not, proceed to prune the version chain.
-        if (table != nullptr && visited_slots.insert(undo_record.Slot()).second)
-          TruncateVersionChain(table, undo_record.Slot(), oldest_txn);
-        // Regardless of the version chain we will need to reclaim deleted slots and any dangling pointers to varlens,
-        // unless the transaction is aborted, and the record holds a version that is still visible.
-        if (!txn->Aborted()) {
-          ReclaimSlotIfDeleted(&undo_record);
-          ReclaimBufferIfVarlen(txn, &undo_record);
+        if (num_workers_ > 0) {
+          // All records pointing into the same block go to the same worker, so that no version chain is truncated
+          // by two threads at once
+          if (table != nullptr)
+            partitions[std::hash<RawBlock *>()(undo_record.Slot().GetBlock()) % num_workers_].records_.emplace_back(
+                txn, &undo_record);
+        } else {
+          // Each version chain needs to be traversed and truncated at most once every GC period. Check
+          // if we have already visited this tuple slot; if not, proceed to prune the version chain.
+          if (table != nullptr && visited_slots.insert(undo_record.Slot()).second)
+            table->TruncateVersionChain(undo_record.Slot(), oldest_txn);
+          // Regardless of the version chain we will need to reclaim deleted slots and any dangling pointers to
+          // varlens, unless the transaction is aborted, and the record holds a version that is still visible.
+          if (!txn->Aborted()) {
+            ReclaimSlotIfDeleted(&undo_record);
+            ReclaimBufferIfVarlen(&txn->loose_ptrs_, &undo_record);
+          }
         }
         if (observer_ != nullptr) observer_->ObserveWrite(undo_record.Slot().GetBlock());
         buffer_processed++;
@@ -132,6 +144,26 @@ uint32_t GarbageCollector::ProcessUnlinkQueue(transaction::timestamp_t oldest_tx
   // Requeue any txns that we were still visible to running transactions
   txns_to_unlink_ = transaction::TransactionQueue(std::move(requeue));
 
+  if (num_workers_ > 0) {
+    for (auto &partition : partitions) {
+      if (partition.records_.empty()) continue;
+      UnlinkPartition *const target = &partition;
+      workers_.SubmitTask([=] { ProcessUnlinkPartition(target, oldest_txn, gc_metrics_enabled); });
+    }
+    workers_.WaitUntilAllFinished();
+    for (uint32_t worker_id = 0; worker_id < num_workers_; worker_id++) {
+      UnlinkPartition &partition = partitions[worker_id];
+      if (partition.records_.empty()) continue;
+      // Every transaction unlinked in this invocation is deallocated at the same time, so it does not matter which of
+      // them the varlens are handed to
+      auto &loose_ptrs = txns_to_deallocate_.front()->loose_ptrs_;
+      loose_ptrs.insert(loose_ptrs.end(), partition.loose_ptrs_.begin(), partition.loose_ptrs_.end());
+      if (gc_metrics_enabled)
+        common::thread_context.metrics_store_->RecordUnlinkWorkerData(worker_id, partition.records_.size(),
+                                                                      partition.resource_metrics_);
+    }
+  }
+
   if (gc_metrics_enabled) {
     // Stop the resource tracker for this operating unit
     common::thread_context.resource_tracker_.Stop();
@@ -145,6 +177,27 @@ uint32_t GarbageCollector::ProcessUnlinkQueue(transaction::timestamp_t oldest_tx
   return txns_processed;
 }
 
+void GarbageCollector::ProcessUnlinkPartition(UnlinkPartition *const partition,
+                                              const transaction::timestamp_t oldest_txn,
+                                              const bool gc_metrics_enabled) const {
+  if (gc_metrics_enabled) common::thread_context.resource_tracker_.Start();
+  std::unordered_set<TupleSlot> visited_slots;
+  for (auto &entry : partition->records_) {
+    transaction::TransactionContext *const txn = entry.first;
+    UndoRecord *const undo_record = entry.second;
+    if (visited_slots.insert(undo_record->Slot()).second)
+      undo_record->Table()->TruncateVersionChain(undo_record->Slot(), oldest_txn);
+    if (!txn->Aborted()) {
+      ReclaimSlotIfDeleted(undo_record);
+      ReclaimBufferIfVarlen(&partition->loose_ptrs_, undo_record);
+    }
+  }
+  if (gc_metrics_enabled) {
+    common::thread_context.resource_tracker_.Stop();
+    partition->resource_metrics_ = common::thread_context.resource_tracker_.GetMetrics();
+  }
+}
+
 void GarbageCollector::ProcessDeferredActions(transaction::timestamp_t oldest_txn) {
   if (deferred_action_manager_ != DISABLED) {
     // TODO(Tianyu): Eventually we will remove the GC and implement version chain pruning with deferred actions
@@ -152,53 +205,11 @@ void GarbageCollector::ProcessDeferredActions(transaction::timestamp_t oldest_tx
   }
 }
 
-void GarbageCollector::TruncateVersionChain(DataTable *const table, const TupleSlot slot,
-                                            const transaction::timestamp_t oldest) const {
-  const TupleAccessStrategy &accessor = table->accessor_;
-  UndoRecord *const version_ptr = table->AtomicallyReadVersionPtr(slot, accessor);
-  // This is a legitimate case where we truncated the version chain but had to restart because the previous head
-  // was aborted.
-  if (version_ptr == nullptr) return;
-
-  // We need to special case the head of the version chain because contention with running transactions can happen
-  // here. Instead of a blind update we will need to CAS and prune the entire version chain if the head of the version
-  // chain can be GCed.
-  if (transaction::TransactionUtil::NewerThan(oldest, version_ptr->Timestamp().load())) {
-    if (!table->CompareAndSwapVersionPtr(slot, accessor, version_ptr, nullptr))
-      // Keep retrying while there are conflicts, since we only invoke truncate once per GC period for every
-      // version chain.
-      TruncateVersionChain(table, slot, oldest);
-    return;
-  }
-
-  // a version chain is guaranteed to not change when not at the head (assuming single-threaded GC), so we are safe
-  // to traverse and update pointers without CAS
-  UndoRecord *curr = version_ptr;
-  UndoRecord *next;
-  // Traverse until we find the earliest UndoRecord that can be unlinked.
-  while (true) {
-    next = curr->Next();
-    // This is a legitimate case where we truncated the version chain but had to restart because the previous head
-    // was aborted.
-    if (next == nullptr) return;
-    if (transaction::TransactionUtil::NewerThan(oldest, next->Timestamp().load())) break;
-    curr = next;
-  }
-  // The rest of the version chain must also be invisible to any running transactions since our version
-  // is newest-to-oldest sorted.
-  curr->Next().store(nullptr);
-
-  // If the head of the version chain was not committed, it could have been aborted and requires a retry.
-  if (curr == version_ptr && !transaction::TransactionUtil::Committed(version_ptr->Timestamp().load()) &&
-      table->AtomicallyReadVersionPtr(slot, accessor) != version_ptr)
-    TruncateVersionChain(table, slot, oldest);
-}
-
 void GarbageCollector::ReclaimSlotIfDeleted(UndoRecord *const undo_record) const {
   if (undo_record->Type() == DeltaRecordType::DELETE) undo_record->Table()->accessor_.Deallocate(undo_record->Slot());
 }
 
-void GarbageCollector::ReclaimBufferIfVarlen(transaction::TransactionContext *const txn,
+void GarbageCollector::ReclaimBufferIfVarlen(std::vector<const byte *> *const loose_ptrs,
                                              UndoRecord *const undo_record) const {
   const TupleAccessStrategy &accessor = undo_record->Table()->accessor_;
   const BlockLayout &layout = accessor.GetBlockLayout();
@@ -212,7 +223,7 @@ void GarbageCollector::ReclaimBufferIfVarlen(transaction::TransactionContext *co
         // Okay to include version vector, as it is never varlen
         if (layout.IsVarlen(col_id)) {
           auto *varlen = reinterpret_cast<VarlenEntry *>(accessor.AccessWithNullCheck(undo_record->Slot(), col_id));
-          if (varlen != nullptr && varlen->NeedReclaim()) txn->loose_ptrs_.push_back(varlen->Content());
+          if (varlen != nullptr && varlen->NeedReclaim()) loose_ptrs->push_back(varlen->Content());
         }
       }
       break;
@@ -222,7 +233,7 @@ void GarbageCollector::ReclaimBufferIfVarlen(transaction::TransactionContext *co
         col_id_t col_id = undo_record->Delta()->ColumnIds()[i];
         if (layout.IsVarlen(col_id)) {
           auto *varlen = reinterpret_cast<VarlenEntry *>(undo_record->Delta()->AccessWithNullCheck(i));
-          if (varlen != nullptr && varlen->NeedReclaim()) txn->loose_ptrs_.push_back(varlen->Content());
+          if (varlen != nullptr && varlen->NeedReclaim()) loose_ptrs->push_back(varlen->Content());
         }
       }
       break;
@@ -1,18 +1,67 @@
 #include "storage/garbage_collector_thread.h"
+
+#include <algorithm>
+
+#include "common/thread_context.h"
 #include "metrics/metrics_manager.h"
+#include "metrics/metrics_store.h"
 
 namespace terrier::storage {
+// Undo records piling up past this many bytes between two GC invocations mean the GC is falling behind
+constexpr uint64_t GC_UNDO_BYTES_PRESSURE = 1 << 20;
+// Reads walking this many versions on average mean version chains are growing faster than the GC prunes them
+constexpr double GC_CHAIN_LENGTH_PRESSURE = VERSION_CHAIN_PRUNE_THRESHOLD / 4.0;
+
 GarbageCollectorThread::GarbageCollectorThread(common::ManagedPointer<GarbageCollector> gc,
                                                std::chrono::milliseconds gc_period,
-                                               common::ManagedPointer<metrics::MetricsManager> metrics_manager)
+                                               common::ManagedPointer<metrics::MetricsManager> metrics_manager,
+                                               common::ManagedPointer<transaction::TransactionManager> txn_manager,
+                                               std::chrono::milliseconds min_gc_period,
+                                               std::chrono::milliseconds max_gc_period)
     : gc_(gc),
       metrics_manager_(metrics_manager),
+      txn_manager_(txn_manager),
+      min_gc_period_(min_gc_period),
+      max_gc_period_(max_gc_period),
       run_gc_(true),
       gc_paused_(false),
-      gc_period_(gc_period),
+      gc_period_(std::clamp(gc_period, min_gc_period, max_gc_period)),
       gc_thread_(std::thread([this] {
         if (metrics_manager_ != DISABLED) metrics_manager_->RegisterThread();
         GCThreadLoop();
-      })) {}
+      })) {
+  TERRIER_ASSERT(min_gc_period_ > std::chrono::milliseconds(0) && min_gc_period_ <= max_gc_period_,
+                 "GC period bounds must be positive and in order.");
+}
+
+void GarbageCollectorThread::AdaptGCPeriod() {
+  const bool gc_metrics_enabled =
+      common::thread_context.metrics_store_ != nullptr &&
+      common::thread_context.metrics_store_->ComponentToRecord(metrics::MetricsComponent::GARBAGECOLLECTION);
+  if (gc_metrics_enabled) common::thread_context.resource_tracker_.Start();
+
+  const transaction::TransactionManager::GCPressure pressure = txn_manager_->GetGCPressure();
+  const double avg_chain_length =
+      pressure.num_version_walks_ == 0
+          ? 0
+          : static_cast<double>(pressure.num_versions_walked_) / static_cast<double>(pressure.num_version_walks_);
+  std::chrono::milliseconds period = gc_period_.load();
+  if (pressure.undo_bytes_ >= GC_UNDO_BYTES_PRESSURE || avg_chain_length >= GC_CHAIN_LENGTH_PRESSURE)
+    period /= 2;
+  else if (pressure.num_txns_ == 0)
+    period *= 2;
+  else
+    period += std::chrono::milliseconds(1);
+  period = std::clamp(period, min_gc_period_, max_gc_period_);
+  gc_period_.store(period);
+
+  if (gc_metrics_enabled) {
+    common::thread_context.resource_tracker_.Stop();
+    auto &resource_metrics = common::thread_context.resource_tracker_.GetMetrics();
+    common::thread_context.metrics_store_->RecordGCIntervalData(static_cast<uint64_t>(period.count()),
+                                                                pressure.num_txns_, pressure.undo_bytes_,
+                                                                avg_chain_length, resource_metrics);
+  }
+}
 
 }  // namespace terrier::storage
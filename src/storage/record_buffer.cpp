@@ -13,6 +13,12 @@ byte *UndoBuffer::NewEntry(const uint32_t size) {
   return last_record_;
 }
 
+RedoBuffer::RedoBuffer(LogManager *const log_manager, RecordBufferSegmentPool *const buffer_pool)
+    : has_flushed_(false),
+      log_manager_(log_manager),
+      log_stream_(log_manager == DISABLED ? 0 : log_manager->StreamForCurrentThread()),
+      buffer_pool_(buffer_pool) {}
+
 byte *RedoBuffer::NewEntry(const uint32_t size) {
   if (buffer_seg_ == nullptr) {
     // this is the first write
@@ -20,7 +26,7 @@ byte *RedoBuffer::NewEntry(const uint32_t size) {
   } else if (!buffer_seg_->HasBytesLeft(size)) {
     // old log buffer is full
     if (log_manager_ != DISABLED) {
-      log_manager_->AddBufferToFlushQueue(buffer_seg_);
+      log_manager_->AddBufferToFlushQueue(buffer_seg_, log_stream_);
       has_flushed_ = true;
     } else {
       buffer_pool_->Release(buffer_seg_);
@@ -36,7 +42,7 @@ byte *RedoBuffer::NewEntry(const uint32_t size) {
 void RedoBuffer::Finalize(bool flush_buffer) {
   if (buffer_seg_ == nullptr) return;  // If we never initialized a buffer (logging was disabled), we don't do anything
   if (log_manager_ != DISABLED && flush_buffer) {
-    log_manager_->AddBufferToFlushQueue(buffer_seg_);
+    log_manager_->AddBufferToFlushQueue(buffer_seg_, log_stream_);
     has_flushed_ = true;
   } else {
     buffer_pool_->Release(buffer_seg_);
@@ -1,4 +1,5 @@
 #include "storage/recovery/abstract_log_provider.h"
+#include <cstring>
 #include <utility>
 #include <vector>
 #include "storage/projected_row.h"
@@ -9,15 +10,18 @@ std::pair<LogRecord *, std::vector<byte *>> AbstractLogProvider::ReadNextRecord(
   // Pointer to buffers for non-aligned varlen entries so we can clean them up down the road
   std::vector<byte *> varlen_contents;
   // Read in LogRecord header data
-  auto size = ReadValue<uint32_t>();
+  auto size = static_cast<uint32_t>(ReadVarint());
   byte *buf = common::AllocationUtil::AllocateAligned(size);
   auto record_type = ReadValue<storage::LogRecordType>();
-  auto txn_begin = ReadValue<transaction::timestamp_t>();
+  auto txn_begin = transaction::timestamp_t(ReadVarint());
 
   switch (record_type) {
     case (storage::LogRecordType::COMMIT): {
-      auto txn_commit = ReadValue<transaction::timestamp_t>();
-      auto oldest_active_txn = ReadValue<transaction::timestamp_t>();
+      // Both timestamps are written relative to the txn's begin
+      auto txn_commit =
+          transaction::timestamp_t(!txn_begin + static_cast<uint64_t>(LogEncoding::ZigZagDecode(ReadVarint())));
+      auto oldest_active_txn =
+          transaction::timestamp_t(!txn_begin - static_cast<uint64_t>(LogEncoding::ZigZagDecode(ReadVarint())));
       TERRIER_ASSERT(oldest_active_txn != transaction::INVALID_TXN_TIMESTAMP,
                      "INVALID_TXN_TIMESTAMP indicates this was a read only txn, which should "
                      "never have been flushed to disk/network");
@@ -33,30 +37,38 @@ std::pair<LogRecord *, std::vector<byte *>> AbstractLogProvider::ReadNextRecord(
       return {storage::AbortRecord::Initialize(buf, txn_begin, nullptr, nullptr), varlen_contents};
     }
 
+    case (storage::LogRecordType::WATERMARK): {
+      auto watermark = transaction::timestamp_t(ReadVarint());
+      return {storage::WatermarkRecord::Initialize(buf, watermark), varlen_contents};
+    }
+
     case (storage::LogRecordType::DELETE): {
-      auto database_oid = ReadValue<catalog::db_oid_t>();
-      auto table_oid = ReadValue<catalog::table_oid_t>();
+      auto database_oid = catalog::db_oid_t(static_cast<uint32_t>(ReadVarint()));
+      auto table_oid = catalog::table_oid_t(static_cast<uint32_t>(ReadVarint()));
       auto tuple_slot = ReadValue<storage::TupleSlot>();
       return {storage::DeleteRecord::Initialize(buf, txn_begin, database_oid, table_oid, tuple_slot), varlen_contents};
     }
 
     case (storage::LogRecordType::REDO): {
-      auto database_oid = ReadValue<catalog::db_oid_t>();
-      auto table_oid = ReadValue<catalog::table_oid_t>();
+      auto database_oid = catalog::db_oid_t(static_cast<uint32_t>(ReadVarint()));
+      auto table_oid = catalog::table_oid_t(static_cast<uint32_t>(ReadVarint()));
       auto tuple_slot = ReadValue<storage::TupleSlot>();
 
       // TODO(Gus, PR #468): Future addition of checksums should validate these values in case of data corruption.
-      auto num_cols = ReadValue<uint16_t>();
-      if (num_cols > common::Constants::MAX_COL) {
+      // The lowest bit tells whether the record has a null bitmap
+      const uint64_t num_cols_and_nulls = ReadVarint();
+      const bool has_nulls = (num_cols_and_nulls & 1) != 0;
+      if ((num_cols_and_nulls >> 1) > common::Constants::MAX_COL) {
         throw std::runtime_error("Number of columns deserialized exceeds max columns. possible data corrution");
       }
+      const auto num_cols = static_cast<uint16_t>(num_cols_and_nulls >> 1);
 
       // Read in col_ids
       // IDs read individually since we can't guarantee memory layout of vector
       std::vector<storage::col_id_t> col_ids;
       col_ids.reserve(num_cols);
       for (uint16_t i = 0; i < num_cols; i++) {
-        const auto col_id = ReadValue<storage::col_id_t>();
+        const auto col_id = storage::col_id_t(static_cast<uint16_t>(ReadVarint()));
         col_ids.push_back(col_id);
       }
 
@@ -64,7 +76,7 @@ std::pair<LogRecord *, std::vector<byte *>> AbstractLogProvider::ReadNextRecord(
       std::vector<uint16_t> attr_size_boundaries;
       attr_size_boundaries.reserve(NUM_ATTR_BOUNDARIES);
       for (uint16_t i = 0; i < NUM_ATTR_BOUNDARIES; i++) {
-        attr_size_boundaries.push_back(ReadValue<uint16_t>());
+        attr_size_boundaries.push_back(static_cast<uint16_t>(ReadVarint()));
       }
 
       // Compute attr sizes
@@ -85,9 +97,14 @@ std::pair<LogRecord *, std::vector<byte *>> AbstractLogProvider::ReadNextRecord(
 
       // Get an in memory copy of the record's null bitmap. Note: this is used to guide how the rest of the log file is
       // read in. It doesn't populate the delta's bitmap yet. This will happen naturally as we proceed column-by-column.
+      // A record without nulls is written without a bitmap, which is the same as one with every bit set.
       auto bitmap_num_bytes = common::RawBitmap::SizeInBytes(num_cols);
       auto *bitmap_buffer = new uint8_t[bitmap_num_bytes];
-      Read(bitmap_buffer, bitmap_num_bytes);
+      if (has_nulls) {
+        Read(bitmap_buffer, bitmap_num_bytes);
+      } else {
+        std::memset(bitmap_buffer, 0xFF, bitmap_num_bytes);
+      }
       auto *bitmap = reinterpret_cast<common::RawBitmap *>(bitmap_buffer);
 
       for (uint16_t i = 0; i < num_cols; i++) {
@@ -102,7 +119,7 @@ std::pair<LogRecord *, std::vector<byte *>> AbstractLogProvider::ReadNextRecord(
         // Need to mask off sign bit from VARLEN_COLUMN to get the varlen size
         if (attr_sizes[i] == AttrSizeBytes(VARLEN_COLUMN)) {
           // Read how many bytes this varlen actually is.
-          const auto varlen_attribute_size = ReadValue<uint32_t>();
+          const auto varlen_attribute_size = static_cast<uint32_t>(ReadVarint());
 
           // Create the varlen entry depending on whether it can be inlined or not
           storage::VarlenEntry varlen_entry;
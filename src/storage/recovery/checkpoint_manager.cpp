@@ -0,0 +1,192 @@
+#include "storage/recovery/checkpoint_manager.h"
+
+#include <sys/stat.h>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catalog/database_catalog.h"
+#include "catalog/postgres/pg_class.h"
+#include "catalog/postgres/pg_database.h"
+#include "storage/arrow_serializer.h"
+#include "storage/write_ahead_log/log_io.h"
+
+namespace terrier::storage {
+
+CheckpointManager::CheckpointMetadata CheckpointManager::TakeCheckpoint(const std::string &checkpoint_dir) {
+  if (mkdir(checkpoint_dir.c_str(), S_IRWXU) == -1 && errno != EEXIST)
+    throw std::runtime_error("Failed to create checkpoint directory with errno " + std::to_string(errno));
+  CheckpointMetadata previous;
+  const bool has_previous = ReadMetadata(checkpoint_dir, &previous);
+
+  // Everything that committed before the checkpoint txn started is in its snapshot, and nothing else
+  auto *const txn = txn_manager_->BeginTransaction(true);
+  CheckpointMetadata metadata;
+  metadata.checkpoint_time_ = txn->StartTime();
+  metadata.oldest_active_txn_ = timestamp_manager_->OldestTransactionStartTime();
+
+  auto tables = CollectTables(common::ManagedPointer(txn));
+  metadata.tables_.resize(tables.size());
+  // Failures are handed back from the workers, and only surface once no worker uses the txn anymore
+  std::vector<std::exception_ptr> failures(tables.size());
+  for (uint32_t i = 0; i < tables.size(); i++) {
+    metadata.tables_[i] = tables[i].first;
+    workers_.SubmitTask([&, i] {
+      try {
+        WriteTable(checkpoint_dir, common::ManagedPointer(txn), tables[i].second, &metadata.tables_[i]);
+      } catch (...) {
+        failures[i] = std::current_exception();
+      }
+    });
+  }
+  workers_.WaitUntilAllFinished();
+  txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  for (const auto &failure : failures) {
+    if (failure == nullptr) continue;
+    // Without the metadata file the checkpoint does not count, and the previous one stays in use. Its own files are
+    // named after a different timestamp, so only the leftovers of this one go.
+    RemoveTableFiles(checkpoint_dir, metadata);
+    std::rethrow_exception(failure);
+  }
+
+  WriteMetadata(checkpoint_dir, metadata);
+  // The previous checkpoint is no longer referred to by the metadata, so a crash from here on only leaves stray files
+  if (has_previous && previous.checkpoint_time_ != metadata.checkpoint_time_)
+    RemoveTableFiles(checkpoint_dir, previous);
+  return metadata;
+}
+
+std::vector<std::pair<CheckpointManager::CheckpointTable, common::ManagedPointer<SqlTable>>>
+CheckpointManager::CollectTables(const common::ManagedPointer<transaction::TransactionContext> txn) {
+  std::vector<std::pair<CheckpointTable, common::ManagedPointer<SqlTable>>> tables;
+
+  // Databases, from pg_database
+  std::vector<std::pair<catalog::db_oid_t, catalog::DatabaseCatalog *>> databases;
+  {
+    const std::vector<catalog::col_oid_t> cols{catalog::postgres::DATOID_COL_OID,
+                                               catalog::postgres::DAT_CATALOG_COL_OID};
+    const auto pci = catalog_->databases_->InitializerForProjectedColumns(cols, 100);
+    const auto pm = catalog_->databases_->ProjectionMapForOids(cols);
+    byte *buffer = common::AllocationUtil::AllocateAligned(pci.ProjectedColumnsSize());
+    auto *pc = pci.Initialize(buffer);
+    auto *db_oids = reinterpret_cast<catalog::db_oid_t *>(pc->ColumnStart(pm.at(catalog::postgres::DATOID_COL_OID)));
+    auto *db_ptrs =
+        reinterpret_cast<catalog::DatabaseCatalog **>(pc->ColumnStart(pm.at(catalog::postgres::DAT_CATALOG_COL_OID)));
+    auto table_iter = catalog_->databases_->begin();
+    while (table_iter != catalog_->databases_->end()) {
+      catalog_->databases_->Scan(txn, &table_iter, pc);
+      for (uint32_t i = 0; i < pc->NumTuples(); i++) databases.emplace_back(db_oids[i], db_ptrs[i]);
+    }
+    delete[] buffer;
+  }
+
+  // User tables of each database, from its pg_class. Catalog tables are rebuilt from the log instead.
+  const std::vector<catalog::col_oid_t> cols{catalog::postgres::RELOID_COL_OID, catalog::postgres::RELKIND_COL_OID,
+                                             catalog::postgres::REL_PTR_COL_OID};
+  for (const auto &database : databases) {
+    SqlTable *const pg_class = database.second->classes_;
+    const auto pci = pg_class->InitializerForProjectedColumns(cols, 100);
+    const auto pm = pg_class->ProjectionMapForOids(cols);
+    byte *buffer = common::AllocationUtil::AllocateAligned(pci.ProjectedColumnsSize());
+    auto *pc = pci.Initialize(buffer);
+    auto *oids = reinterpret_cast<uint32_t *>(pc->ColumnStart(pm.at(catalog::postgres::RELOID_COL_OID)));
+    auto *kinds =
+        reinterpret_cast<catalog::postgres::ClassKind *>(pc->ColumnStart(pm.at(catalog::postgres::RELKIND_COL_OID)));
+    auto *ptrs = reinterpret_cast<SqlTable **>(pc->ColumnStart(pm.at(catalog::postgres::REL_PTR_COL_OID)));
+    auto table_iter = pg_class->begin();
+    while (table_iter != pg_class->end()) {
+      pg_class->Scan(txn, &table_iter, pc);
+      for (uint32_t i = 0; i < pc->NumTuples(); i++) {
+        if (kinds[i] != catalog::postgres::ClassKind::REGULAR_TABLE || oids[i] < catalog::START_OID) continue;
+        // A table whose pointer is not set yet has never held any tuples
+        if (pc->ColumnNullBitmap(pm.at(catalog::postgres::REL_PTR_COL_OID))->Test(i) && ptrs[i] != nullptr)
+          tables.push_back({{database.first, catalog::table_oid_t(oids[i]), 0, 0}, common::ManagedPointer(ptrs[i])});
+      }
+    }
+    delete[] buffer;
+  }
+  return tables;
+}
+
+void CheckpointManager::WriteTable(const std::string &checkpoint_dir,
+                                   const common::ManagedPointer<transaction::TransactionContext> txn,
+                                   const common::ManagedPointer<SqlTable> sql_table, CheckpointTable *const table) {
+  const std::string table_path = TableFilePath(checkpoint_dir, txn->StartTime(), *table);
+  std::vector<TupleSlot> tuple_slots;
+  table->num_tuples_ = ArrowSerializer(*sql_table->table_.data_table_).ExportSnapshot(table_path, txn, &tuple_slots);
+
+  const std::string slots_path = TupleSlotsFilePath(checkpoint_dir, txn->StartTime(), *table);
+  ScopedFileDescriptor fd(PosixIoWrappers::Open(slots_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR));
+  PosixIoWrappers::WriteFully(fd.Get(), tuple_slots.data(), tuple_slots.size() * sizeof(TupleSlot));
+  if (fsync(fd.Get()) == -1) throw std::runtime_error("fsync failed with errno " + std::to_string(errno));
+  fd.Close();
+
+  struct stat table_stat;
+  if (stat(table_path.c_str(), &table_stat) == -1)
+    throw std::runtime_error("stat failed with errno " + std::to_string(errno));
+  table->num_bytes_ = static_cast<uint64_t>(table_stat.st_size) + tuple_slots.size() * sizeof(TupleSlot);
+}
+
+// The metadata is a text file. The first line holds the checkpoint time and the oldest txn running at the time, every
+// following line the database, oid, number of tuples and size of a table.
+bool CheckpointManager::ReadMetadata(const std::string &checkpoint_dir, CheckpointMetadata *const metadata) {
+  std::ifstream in(MetadataFilePath(checkpoint_dir));
+  if (!in.is_open()) return false;
+  uint64_t checkpoint_time, oldest_active_txn;
+  if (!(in >> checkpoint_time >> oldest_active_txn))
+    throw std::runtime_error("Malformed checkpoint metadata in " + checkpoint_dir);
+  metadata->checkpoint_time_ = transaction::timestamp_t(checkpoint_time);
+  metadata->oldest_active_txn_ = transaction::timestamp_t(oldest_active_txn);
+  metadata->tables_.clear();
+  uint32_t db_oid, table_oid;
+  uint64_t num_tuples, num_bytes;
+  while (in >> db_oid >> table_oid >> num_tuples >> num_bytes)
+    metadata->tables_.push_back({catalog::db_oid_t(db_oid), catalog::table_oid_t(table_oid), num_tuples, num_bytes});
+  if (!in.eof()) throw std::runtime_error("Malformed checkpoint metadata in " + checkpoint_dir);
+  return true;
+}
+
+std::vector<TupleSlot> CheckpointManager::ReadTupleSlots(const std::string &checkpoint_dir,
+                                                         const transaction::timestamp_t checkpoint_time,
+                                                         const CheckpointTable &table) {
+  std::vector<TupleSlot> tuple_slots(table.num_tuples_);
+  ScopedFileDescriptor fd(
+      PosixIoWrappers::Open(TupleSlotsFilePath(checkpoint_dir, checkpoint_time, table).c_str(), O_RDONLY));
+  const uint64_t size = table.num_tuples_ * sizeof(TupleSlot);
+  const uint64_t read = PosixIoWrappers::ReadFully(fd.Get(), tuple_slots.data(), size);
+  fd.Close();
+  if (read != size)
+    throw std::runtime_error("Checkpoint is missing tuple slots of table " + std::to_string(!table.table_oid_));
+  return tuple_slots;
+}
+
+void CheckpointManager::RemoveTableFiles(const std::string &checkpoint_dir, const CheckpointMetadata &metadata) {
+  for (const auto &table : metadata.tables_) {
+    std::remove(TableFilePath(checkpoint_dir, metadata.checkpoint_time_, table).c_str());
+    std::remove(TupleSlotsFilePath(checkpoint_dir, metadata.checkpoint_time_, table).c_str());
+  }
+}
+
+void CheckpointManager::WriteMetadata(const std::string &checkpoint_dir, const CheckpointMetadata &metadata) {
+  std::ostringstream contents;
+  contents << !metadata.checkpoint_time_ << ' ' << !metadata.oldest_active_txn_ << '\n';
+  for (const auto &table : metadata.tables_)
+    contents << !table.db_oid_ << ' ' << !table.table_oid_ << ' ' << table.num_tuples_ << ' ' << table.num_bytes_
+             << '\n';
+  const std::string data = contents.str();
+
+  const std::string path = MetadataFilePath(checkpoint_dir);
+  const std::string temp_path = path + ".tmp";
+  ScopedFileDescriptor fd(PosixIoWrappers::Open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR));
+  PosixIoWrappers::WriteFully(fd.Get(), data.data(), data.size());
+  if (fsync(fd.Get()) == -1) throw std::runtime_error("fsync failed with errno " + std::to_string(errno));
+  fd.Close();
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0)
+    throw std::runtime_error("Failed to rename checkpoint metadata with errno " + std::to_string(errno));
+}
+
+}  // namespace terrier::storage
@@ -2,6 +2,8 @@
 
 #include <catalog/postgres/pg_proc.h>
 #include <algorithm>
+#include <functional>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -16,19 +18,54 @@
 #include "catalog/postgres/pg_language.h"
 #include "catalog/postgres/pg_namespace.h"
 #include "catalog/postgres/pg_type.h"
+#include "storage/arrow_serializer.h"
 #include "storage/index/index_builder.h"
 #include "storage/write_ahead_log/log_io.h"
 
 namespace terrier::storage {
 
+void RecoveryManager::RecoverFromCheckpoint() {
+  if (checkpoint_dir_.empty()) return;
+  checkpoint_pending_ = CheckpointManager::ReadMetadata(checkpoint_dir_, &checkpoint_);
+}
+
 void RecoveryManager::RecoverFromLogs() {
-  // Replay logs until the log provider no longer gives us logs
-  while (true) {
-    auto pair = log_provider_->GetNextRecord();
+  // A txn only goes to one log stream, but the txns it has to be replayed after can be in any of them. The oldest
+  // active txn in a commit record tells us every txn that started before it had already been serialized, so all of
+  // them come before the commit record in their own stream. Thus a txn is safe to replay once it is older than the
+  // latest oldest active txn read from every stream that still has logs. With a single stream, this is the commit
+  // record's own.
+  // An invalid oldest active txn puts no bound on replay, as in ProcessDeferredTransactions.
+  // A stream that runs out may have lost commits that txns of the other streams depend on, except for the ones up to
+  // its last watermark. Txns that committed after it were never reported as committed, and are not replayed.
+  const auto num_streams = static_cast<uint32_t>(log_providers_.size());
+  std::vector<transaction::timestamp_t> stream_oldest_active(num_streams, transaction::INITIAL_TXN_TIMESTAMP);
+  std::vector<transaction::timestamp_t> stream_watermarks(num_streams, transaction::INITIAL_TXN_TIMESTAMP);
+  std::vector<bool> stream_exhausted(num_streams, false);
+  uint32_t num_streams_left = num_streams;
+  const auto replay_upper_bound = [&] {
+    auto upper_bound = transaction::INVALID_TXN_TIMESTAMP;
+    for (uint32_t i = 0; i < num_streams; i++) {
+      if (stream_exhausted[i] || stream_oldest_active[i] == transaction::INVALID_TXN_TIMESTAMP) continue;
+      if (upper_bound == transaction::INVALID_TXN_TIMESTAMP || stream_oldest_active[i] < upper_bound)
+        upper_bound = stream_oldest_active[i];
+    }
+    return upper_bound;
+  };
+
+  // Replay logs until the log providers no longer give us logs, reading a record from each stream in turn
+  for (uint32_t stream = 0; num_streams_left > 0; stream = (stream + 1) % num_streams) {
+    if (stream_exhausted[stream]) continue;
+    auto pair = log_providers_[stream]->GetNextRecord();
     auto *log_record = pair.first;
 
-    // If we have exhausted all the logs, break from the loop
-    if (log_record == nullptr) break;
+    // If we have exhausted all the logs of this stream, it no longer holds back the others
+    if (log_record == nullptr) {
+      stream_exhausted[stream] = true;
+      if (num_streams > 1) replay_commit_bound_ = std::min(replay_commit_bound_, stream_watermarks[stream]);
+      if (--num_streams_left > 0) recovered_txns_ += ReplayDeferredTransactions(replay_upper_bound());
+      continue;
+    }
 
     switch (log_record->RecordType()) {
       case (LogRecordType::ABORT): {
@@ -42,18 +79,34 @@ void RecoveryManager::RecoverFromLogs() {
       case (LogRecordType::COMMIT): {
         TERRIER_ASSERT(pair.second.empty(), "Commit records should not have any varlen pointers");
         auto *commit_record = log_record->GetUnderlyingRecordBodyAs<CommitRecord>();
-
-        // We defer all transactions initially
-        deferred_txns_.insert(log_record->TxnBegin());
+        max_commit_time_read_ = std::max(max_commit_time_read_, commit_record->CommitTime());
+        if (num_streams > 1) commit_times_[log_record->TxnBegin()] = commit_record->CommitTime();
+
+        // We defer all transactions initially. A txn the checkpoint holds only has its catalog changes left to replay,
+        // and a txn it does not hold has to wait until the checkpoint is loaded.
+        if (checkpoint_pending_ && commit_record->CommitTime() >= checkpoint_.checkpoint_time_) {
+          post_checkpoint_txns_.insert(log_record->TxnBegin());
+        } else {
+          if (checkpoint_pending_) DiscardCheckpointedChanges(log_record->TxnBegin());
+          deferred_txns_.insert(log_record->TxnBegin());
+        }
 
         // Process any deferred transactions that are safe to execute
-        recovered_txns_ += ProcessDeferredTransactions(commit_record->OldestActiveTxn());
+        stream_oldest_active[stream] = commit_record->OldestActiveTxn();
+        recovered_txns_ += ReplayDeferredTransactions(replay_upper_bound());
 
         // Clean up the log record
         deferred_action_manager_->RegisterDeferredAction([=] { delete[] reinterpret_cast<byte *>(log_record); });
         break;
       }
 
+      case (LogRecordType::WATERMARK): {
+        auto *watermark_record = log_record->GetUnderlyingRecordBodyAs<WatermarkRecord>();
+        stream_watermarks[stream] = std::max(stream_watermarks[stream], watermark_record->Watermark());
+        delete[] reinterpret_cast<byte *>(log_record);
+        break;
+      }
+
       default:
         TERRIER_ASSERT(
             log_record->RecordType() == LogRecordType::REDO || log_record->RecordType() == LogRecordType::DELETE,
@@ -61,8 +114,9 @@ void RecoveryManager::RecoverFromLogs() {
         buffered_changes_map_[log_record->TxnBegin()].push_back(pair);
     }
   }
-  // Process all deferred txns
-  ProcessDeferredTransactions(transaction::INVALID_TXN_TIMESTAMP);
+  // Process all deferred txns, but those that committed after the watermarks
+  max_commit_time_read_ = std::min(max_commit_time_read_, replay_commit_bound_);
+  ReplayDeferredTransactions(transaction::INVALID_TXN_TIMESTAMP);
   TERRIER_ASSERT(deferred_txns_.empty(), "We should have no unprocessed deferred transactions at the end of recovery");
 
   // If we have unprocessed buffered changes, then these transactions were in-process at the time of system shutdown.
@@ -88,6 +142,11 @@ void RecoveryManager::ProcessCommittedTransaction(terrier::transaction::timestam
 
     if (IsSpecialCaseCatalogRecord(buffered_record)) {
       idx += ProcessSpecialCaseCatalogRecord(txn, &buffered_changes_map_[txn_id], idx);
+    } else if (serve_reads_ && (!GetRecordTableOid(buffered_record)) >= catalog::START_OID) {
+      // Keeps the indexes on the table up to date, as the replay workers do
+      ReplayDataRecord(
+          txn, buffered_record,
+          LookupReplayTable(txn, GetRecordDatabaseOid(buffered_record), GetRecordTableOid(buffered_record)));
     } else if (buffered_record->RecordType() == LogRecordType::REDO) {
       ReplayRedoRecord(txn, buffered_record);
     } else {
@@ -125,20 +184,244 @@ uint32_t RecoveryManager::ProcessDeferredTransactions(terrier::transaction::time
       (upper_bound_ts == transaction::INVALID_TXN_TIMESTAMP) ? transaction::timestamp_t(INT64_MAX) : upper_bound_ts;
   auto upper_bound_it = deferred_txns_.upper_bound(upper_bound_ts);
 
+  // Consecutive txns that only change user tables are replayed together on the replay workers. A txn that changes the
+  // catalog is replayed on its own in between, once everything before it is in and before anything after it.
+  std::vector<transaction::timestamp_t> data_txns;
   for (auto it = deferred_txns_.begin(); it != upper_bound_it; it++) {
-    ProcessCommittedTransaction(*it);
+    // A txn that committed after the watermark of a stream that ran out is left out, like one that never committed
+    const auto commit_time = commit_times_.find(*it);
+    if (commit_time != commit_times_.end()) {
+      const bool committed_after_bound = commit_time->second > replay_commit_bound_;
+      commit_times_.erase(commit_time);
+      if (committed_after_bound) {
+        DeferRecordDeletes(*it, true);
+        buffered_changes_map_.erase(*it);
+        continue;
+      }
+    }
+    if (IsDataTransaction(*it)) {
+      data_txns.push_back(*it);
+    } else {
+      ProcessDataTransactions(data_txns);
+      data_txns.clear();
+      ProcessCommittedTransaction(*it);
+    }
     txns_processed++;
   }
+  ProcessDataTransactions(data_txns);
+
+  // Remove the txns we processed or left out from the set
+  deferred_txns_.erase(deferred_txns_.begin(), upper_bound_it);
+
+  // Once nothing older than the checkpoint can still be waiting to be read, every txn it holds has been replayed and
+  // the catalog is as of the checkpoint. Its tables go in, and the txns held back can be replayed on top of them.
+  if (checkpoint_pending_ && checkpoint_.checkpoint_time_ < upper_bound_ts) {
+    LoadCheckpointTables();
+    checkpoint_pending_ = false;
+    deferred_txns_.insert(post_checkpoint_txns_.begin(), post_checkpoint_txns_.end());
+    post_checkpoint_txns_.clear();
+    txns_processed += ProcessDeferredTransactions(upper_bound_ts);
+  }
+
+  return txns_processed;
+}
 
-  // If we actually processed some txns, remove them from the set
-  if (txns_processed > 0) deferred_txns_.erase(deferred_txns_.begin(), upper_bound_it);
+uint32_t RecoveryManager::ReplayDeferredTransactions(const transaction::timestamp_t upper_bound) {
+  if (!serve_reads_) return ProcessDeferredTransactions(upper_bound);
 
+  if (!snapshot_latch_held_) snapshot_latch_.LockExclusive();
+  const auto txns_processed = ProcessDeferredTransactions(upper_bound);
+  // Until the checkpoint is loaded, the user tables hold less than they ever did on the primary
+  snapshot_latch_held_ = checkpoint_pending_;
+  if (snapshot_latch_held_) return txns_processed;
+
+  // Every txn that began before the upper bound and committed has been replayed, and any txn that committed before it
+  // began before it. Without a bound, every txn read so far has been replayed.
+  const auto watermark = upper_bound == transaction::INVALID_TXN_TIMESTAMP ? max_commit_time_read_ + 1 : upper_bound;
+  if (watermark > replayed_watermark_.load()) replayed_watermark_.store(watermark);
+  snapshot_latch_.Unlock();
   return txns_processed;
 }
 
-void RecoveryManager::ReplayRedoRecord(transaction::TransactionContext *txn, LogRecord *record) {
+transaction::TransactionContext *RecoveryManager::BeginSnapshotTransaction(transaction::timestamp_t *const watermark) {
+  TERRIER_ASSERT(serve_reads_, "Snapshots need the recovery manager to serve reads");
+  // The snapshot starts after every commit of the replayed batches, and before any commit of the next one
+  common::SharedLatch::ScopedSharedLatch guard(&snapshot_latch_);
+  if (watermark != nullptr) *watermark = replayed_watermark_.load();
+  return txn_manager_->BeginTransaction(true /* read_only */);
+}
+
+void RecoveryManager::LoadCheckpointTables() {
+  auto *txn = txn_manager_->BeginTransaction();
+  for (const auto &table : checkpoint_.tables_) {
+    auto sql_table = GetSqlTable(txn, table.db_oid_, table.table_oid_);
+    std::vector<TupleSlot> new_slots;
+    new_slots.reserve(table.num_tuples_);
+    const auto table_path = CheckpointManager::TableFilePath(checkpoint_dir_, checkpoint_.checkpoint_time_, table);
+    ArrowDeserializer(sql_table->table_.data_table_).ImportTable(table_path, &new_slots);
+    const auto old_slots = CheckpointManager::ReadTupleSlots(checkpoint_dir_, checkpoint_.checkpoint_time_, table);
+    if (new_slots.size() != old_slots.size())
+      throw std::runtime_error("Checkpoint of table " + std::to_string(!table.table_oid_) + " is incomplete");
+    // Log records written after the checkpoint refer to the tuples by the slots they had. The loaded tuples go into
+    // the indexes along with the rest in RebuildIndexes, or right after this when serving reads.
+    for (uint64_t i = 0; i < new_slots.size(); i++) tuple_slot_map_[old_slots[i]] = new_slots[i];
+  }
+  txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+
+  // When serving reads, the indexes are already maintained by now, and take in the loaded tuples right away
+  if (serve_reads_) {
+    std::vector<std::pair<catalog::db_oid_t, catalog::table_oid_t>> tables;
+    for (const auto &table : checkpoint_.tables_) tables.emplace_back(table.db_oid_, table.table_oid_);
+    RebuildIndexes(tables);
+  }
+}
+
+void RecoveryManager::DiscardCheckpointedChanges(const transaction::timestamp_t txn_id) {
+  auto &buffered_changes = buffered_changes_map_[txn_id];
+  // Catalog tables are the only ones with oids below START_OID
+  const auto user_changes = std::stable_partition(
+      buffered_changes.begin(), buffered_changes.end(), [](const std::pair<LogRecord *, std::vector<byte *>> &change) {
+        return (!GetRecordTableOid(change.first)) < catalog::START_OID;
+      });
+  if (user_changes == buffered_changes.end()) return;
+  std::vector<std::pair<LogRecord *, std::vector<byte *>>> discarded(std::make_move_iterator(user_changes),
+                                                                      std::make_move_iterator(buffered_changes.end()));
+  buffered_changes.erase(user_changes, buffered_changes.end());
+  // The changes never make it into a table, so their varlens go along with them
+  deferred_action_manager_->RegisterDeferredAction([discarded{std::move(discarded)}]() {
+    for (auto &change : discarded) {
+      delete[] reinterpret_cast<byte *>(change.first);
+      for (auto *varlen_entry : change.second) delete[] varlen_entry;
+    }
+  });
+}
+
+bool RecoveryManager::IsDataTransaction(const transaction::timestamp_t txn_id) {
+  // Catalog tables are the only ones with oids below START_OID
+  const auto &buffered_changes = buffered_changes_map_[txn_id];
+  return std::all_of(buffered_changes.begin(), buffered_changes.end(),
+                     [](const std::pair<LogRecord *, std::vector<byte *>> &change) {
+                       return (!GetRecordTableOid(change.first)) >= catalog::START_OID;
+                     });
+}
+
+void RecoveryManager::ProcessDataTransactions(const std::vector<transaction::timestamp_t> &txn_ids) {
+  if (txn_ids.empty()) return;
+
+  // Tables are looked up here rather than on the workers, whose txns would contend for the lock on the database catalog
+  auto *lookup_txn = txn_manager_->BeginTransaction();
+  std::map<std::pair<catalog::db_oid_t, catalog::table_oid_t>, ReplayTable> tables;
+  const auto lookup_table = [&](const LogRecord *const record) -> const ReplayTable & {
+    const auto key = std::make_pair(GetRecordDatabaseOid(record), GetRecordTableOid(record));
+    auto it = tables.find(key);
+    if (it == tables.end()) it = tables.emplace(key, LookupReplayTable(lookup_txn, key.first, key.second)).first;
+    return it->second;
+  };
+
+  // Per partition, the records of every txn that has any in it, in the order of the txns. Blocks are aligned to their
+  // size, so their address divided by it spreads them evenly over the partitions.
+  using TxnRecords = std::vector<std::pair<LogRecord *, const ReplayTable *>>;
+  const uint32_t num_partitions = replay_workers_.NumWorkers();
+  std::vector<std::vector<TxnRecords>> partitions(num_partitions);
+  std::vector<uint64_t> last_txn(num_partitions, txn_ids.size());
+  for (uint64_t txn_idx = 0; txn_idx < txn_ids.size(); txn_idx++) {
+    for (const auto &change : buffered_changes_map_[txn_ids[txn_idx]]) {
+      LogRecord *record = change.first;
+      const TupleSlot old_slot = record->RecordType() == LogRecordType::REDO
+                                     ? record->GetUnderlyingRecordBodyAs<RedoRecord>()->GetTupleSlot()
+                                     : record->GetUnderlyingRecordBodyAs<DeleteRecord>()->GetTupleSlot();
+      const ReplayTable &table = lookup_table(record);
+      // A key of a unique index only moves to another tuple within the txn that removed it from the first one, or once
+      // that txn committed, so such a table is replayed in a single partition
+      const auto partition =
+          table.has_unique_index_
+              ? static_cast<uint32_t>(std::hash<const SqlTable *>()(table.sql_table_.Get()) % num_partitions)
+              : static_cast<uint32_t>(reinterpret_cast<uintptr_t>(old_slot.GetBlock()) / common::Constants::BLOCK_SIZE %
+                                      num_partitions);
+      if (last_txn[partition] != txn_idx) {
+        partitions[partition].emplace_back();
+        last_txn[partition] = txn_idx;
+      }
+      partitions[partition].back().emplace_back(record, &table);
+    }
+  }
+
+  for (auto &partition : partitions) {
+    if (partition.empty()) continue;
+    replay_workers_.SubmitTask([this, &partition] {
+      // Each txn gets a txn of its own in every partition, which commits before the next txn in it replays on top
+      for (const auto &txn_records : partition) {
+        auto *txn = txn_manager_->BeginTransaction();
+        for (const auto &record : txn_records) ReplayDataRecord(txn, record.first, *record.second);
+        txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+      }
+    });
+  }
+  replay_workers_.WaitUntilAllFinished();
+  txn_manager_->Commit(lookup_txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+
+  for (const auto txn_id : txn_ids) {
+    DeferRecordDeletes(txn_id, false);
+    buffered_changes_map_.erase(txn_id);
+  }
+}
+
+void RecoveryManager::RebuildIndexes(
+    const std::vector<std::pair<catalog::db_oid_t, catalog::table_oid_t>> &tables) {
+  auto *txn = txn_manager_->BeginTransaction();
+  for (const auto &table : tables) {
+    // Dropping a database drops its tables, and dropping a table drops its indexes
+    auto db_catalog = catalog_->GetDatabaseCatalog(common::ManagedPointer(txn), table.first);
+    if (db_catalog == nullptr) continue;
+    const auto indexes = db_catalog->GetIndexes(common::ManagedPointer(txn), table.second);
+    if (indexes.empty()) continue;
+    const auto sql_table = db_catalog->GetTable(common::ManagedPointer(txn), table.second);
+    const auto &table_schema = db_catalog->GetSchema(common::ManagedPointer(txn), table.second);
+    for (const auto &index : indexes) {
+      replay_workers_.SubmitTask([this, sql_table, &table_schema, index] {
+        auto *index_txn = txn_manager_->BeginTransaction();
+        RebuildIndex(index_txn, sql_table, table_schema, index.first, index.second);
+        txn_manager_->Commit(index_txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+      });
+    }
+  }
+  replay_workers_.WaitUntilAllFinished();
+  txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+}
+
+void RecoveryManager::RebuildIndex(transaction::TransactionContext *const txn,
+                                   const common::ManagedPointer<SqlTable> sql_table,
+                                   const catalog::Schema &table_schema,
+                                   const common::ManagedPointer<index::Index> index,
+                                   const catalog::IndexSchema &index_schema) {
+  std::vector<catalog::col_oid_t> all_table_oids;
+  for (const auto &col : table_schema.GetColumns()) {
+    all_table_oids.push_back(col.Oid());
+  }
+  auto initializer = sql_table->InitializerForProjectedRow(all_table_oids);
+  const auto pr_map = sql_table->ProjectionMapForOids(all_table_oids);
+  auto *table_buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedRowSize());
+  auto *table_pr = initializer.InitializeRow(table_buffer);
+  auto *index_buffer = common::AllocationUtil::AllocateAligned(index->GetProjectedRowInitializer().ProjectedRowSize());
+
+  for (auto it = sql_table->begin(); it != sql_table->end(); it++) {
+    // Slots of deleted tuples are not visible anymore
+    if (!sql_table->Select(common::ManagedPointer(txn), *it, table_pr)) continue;
+    auto *index_pr = index->GetProjectedRowInitializer().InitializeRow(index_buffer);
+    PopulateIndexKey(index, index_schema, pr_map, *table_pr, index_pr);
+    bool result UNUSED_ATTRIBUTE = index_schema.Unique()
+                                       ? index->InsertUnique(common::ManagedPointer(txn), *index_pr, *it)
+                                       : index->Insert(common::ManagedPointer(txn), *index_pr, *it);
+    TERRIER_ASSERT(result, "Insert into index should always succeed for a committed transaction");
+  }
+
+  delete[] index_buffer;
+  delete[] table_buffer;
+}
+
+void RecoveryManager::ReplayRedoRecord(transaction::TransactionContext *txn, LogRecord *record,
+                                       const common::ManagedPointer<SqlTable> sql_table_ptr) {
   auto *redo_record = record->GetUnderlyingRecordBodyAs<RedoRecord>();
-  auto sql_table_ptr = GetSqlTable(txn, redo_record->GetDatabaseOid(), redo_record->GetTableOid());
   if (IsInsertRecord(redo_record)) {
     // Save the old tuple slot, and reset the tuple slot in the record
     auto old_tuple_slot = redo_record->GetTupleSlot();
@@ -151,14 +434,16 @@ void RecoveryManager::ReplayRedoRecord(transaction::TransactionContext *txn, Log
                    "ProjectedRow of original and staged records must be identical");
     // Insert will always succeed
     auto new_tuple_slot = sql_table_ptr->Insert(common::ManagedPointer(txn), staged_record);
-    UpdateIndexesOnTable(txn, staged_record->GetDatabaseOid(), staged_record->GetTableOid(), sql_table_ptr,
-                         new_tuple_slot, staged_record->Delta(), true /* insert */);
+    // Indexes on user tables are filled in RebuildIndexes, or by ReplayDataRecord when serving reads
+    if ((!staged_record->GetTableOid()) < catalog::START_OID)
+      UpdateIndexesOnTable(txn, staged_record->GetDatabaseOid(), staged_record->GetTableOid(), sql_table_ptr,
+                           new_tuple_slot, staged_record->Delta(), true /* insert */);
     TERRIER_ASSERT(staged_record->GetTupleSlot() == new_tuple_slot,
                    "Insert should update redo record with new tuple slot");
     // Create a mapping of the old to new tuple. The new tuple slot should be used for future updates and deletes.
-    tuple_slot_map_[old_tuple_slot] = new_tuple_slot;
+    SetTupleSlotMapping(old_tuple_slot, new_tuple_slot);
   } else {
-    auto new_tuple_slot = tuple_slot_map_[redo_record->GetTupleSlot()];
+    auto new_tuple_slot = GetTupleSlotMapping(redo_record->GetTupleSlot());
     redo_record->SetTupleSlot(new_tuple_slot);
     // Stage the write. This way the recovery operation is logged if logging is enabled
     auto staged_record = txn->StageRecoveryWrite(record);
@@ -168,17 +453,26 @@ void RecoveryManager::ReplayRedoRecord(transaction::TransactionContext *txn, Log
   }
 }
 
-void RecoveryManager::ReplayDeleteRecord(transaction::TransactionContext *txn, LogRecord *record) {
+void RecoveryManager::ReplayDeleteRecord(transaction::TransactionContext *txn, LogRecord *record,
+                                         const common::ManagedPointer<SqlTable> sql_table_ptr) {
   auto *delete_record = record->GetUnderlyingRecordBodyAs<DeleteRecord>();
   // Get tuple slot
   auto new_tuple_slot = GetTupleSlotMapping(delete_record->GetTupleSlot());
-  auto db_catalog_ptr = GetDatabaseCatalog(txn, delete_record->GetDatabaseOid());
-  auto sql_table_ptr = db_catalog_ptr->GetTable(common::ManagedPointer(txn), delete_record->GetTableOid());
-  const auto &schema = GetTableSchema(txn, db_catalog_ptr, delete_record->GetTableOid());
 
   // Stage the delete. This way the recovery operation is logged if logging is enabled
   txn->StageDelete(delete_record->GetDatabaseOid(), delete_record->GetTableOid(), new_tuple_slot);
 
+  // Indexes on user tables are filled in RebuildIndexes, or kept up to date by ReplayDataRecord when serving reads, so
+  // the tuple is only in the indexes of a catalog table
+  if ((!delete_record->GetTableOid()) >= catalog::START_OID) {
+    bool result UNUSED_ATTRIBUTE = sql_table_ptr->Delete(common::ManagedPointer(txn), new_tuple_slot);
+    TERRIER_ASSERT(result, "Buffered changes should always succeed during commit");
+    RemoveTupleSlotMapping(delete_record->GetTupleSlot());
+    return;
+  }
+  auto db_catalog_ptr = GetDatabaseCatalog(txn, delete_record->GetDatabaseOid());
+  const auto &schema = GetTableSchema(txn, db_catalog_ptr, delete_record->GetTableOid());
+
   // Fetch all the values so we can construct index keys after deleting from the sql table
   std::vector<catalog::col_oid_t> all_table_oids;
   for (const auto &col : schema.GetColumns()) {
@@ -197,7 +491,58 @@ void RecoveryManager::ReplayDeleteRecord(transaction::TransactionContext *txn, L
   UpdateIndexesOnTable(txn, delete_record->GetDatabaseOid(), delete_record->GetTableOid(), sql_table_ptr,
                        new_tuple_slot, pr, false /* delete */);
   // We can delete the TupleSlot from the map
-  tuple_slot_map_.erase(delete_record->GetTupleSlot());
+  RemoveTupleSlotMapping(delete_record->GetTupleSlot());
+  delete[] buffer;
+}
+
+RecoveryManager::ReplayTable RecoveryManager::LookupReplayTable(transaction::TransactionContext *txn,
+                                                               const catalog::db_oid_t db_oid,
+                                                               const catalog::table_oid_t table_oid) {
+  auto db_catalog = catalog_->GetDatabaseCatalog(common::ManagedPointer(txn), db_oid);
+  TERRIER_ASSERT(db_catalog != nullptr, "No catalog for given database oid");
+  ReplayTable table;
+  table.sql_table_ = db_catalog->GetTable(common::ManagedPointer(txn), table_oid);
+  TERRIER_ASSERT(table.sql_table_ != nullptr, "Table is not in the catalog for the given oid");
+  if (serve_reads_) {
+    table.indexes_ = db_catalog->GetIndexes(common::ManagedPointer(txn), table_oid);
+    table.schema_ = &db_catalog->GetSchema(common::ManagedPointer(txn), table_oid);
+    for (const auto &index : table.indexes_) table.has_unique_index_ |= index.second.Unique();
+  }
+  return table;
+}
+
+void RecoveryManager::ReplayDataRecord(transaction::TransactionContext *txn, LogRecord *record,
+                                       const ReplayTable &table) {
+  if (record->RecordType() == LogRecordType::REDO) {
+    auto *redo_record = record->GetUnderlyingRecordBodyAs<RedoRecord>();
+    const auto old_tuple_slot = redo_record->GetTupleSlot();
+    // An update leaves the indexes alone, since an update of an indexed column is logged as a delete and an insert
+    const bool insert = !table.indexes_.empty() && IsInsertRecord(redo_record);
+    ReplayRedoRecord(txn, record, table.sql_table_);
+    if (insert)
+      UpdateIndexes(txn, table.indexes_, *table.schema_, table.sql_table_, GetTupleSlotMapping(old_tuple_slot),
+                    redo_record->Delta(), true /* insert */);
+    return;
+  }
+
+  if (table.indexes_.empty()) {
+    ReplayDeleteRecord(txn, record, table.sql_table_);
+    return;
+  }
+  // Fetch all the values so we can construct index keys after deleting from the sql table
+  auto *delete_record = record->GetUnderlyingRecordBodyAs<DeleteRecord>();
+  const auto new_tuple_slot = GetTupleSlotMapping(delete_record->GetTupleSlot());
+  std::vector<catalog::col_oid_t> all_table_oids;
+  for (const auto &col : table.schema_->GetColumns()) {
+    all_table_oids.push_back(col.Oid());
+  }
+  auto initializer = table.sql_table_->InitializerForProjectedRow(all_table_oids);
+  auto *buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedRowSize());
+  auto *pr = initializer.InitializeRow(buffer);
+  table.sql_table_->Select(common::ManagedPointer(txn), new_tuple_slot, pr);
+
+  ReplayDeleteRecord(txn, record, table.sql_table_);
+  UpdateIndexes(txn, table.indexes_, *table.schema_, table.sql_table_, new_tuple_slot, pr, false /* delete */);
   delete[] buffer;
 }
 
@@ -301,6 +646,15 @@ void RecoveryManager::UpdateIndexesOnTable(transaction::TransactionContext *txn,
   // If there's no indexes on the table, we can return
   if (index_objects.empty()) return;
 
+  UpdateIndexes(txn, index_objects, GetTableSchema(txn, db_catalog_ptr, table_oid), table_ptr, tuple_slot, table_pr,
+                insert);
+}
+
+void RecoveryManager::UpdateIndexes(
+    transaction::TransactionContext *txn,
+    const std::vector<std::pair<common::ManagedPointer<index::Index>, const catalog::IndexSchema &>> &index_objects,
+    const catalog::Schema &table_schema, const common::ManagedPointer<storage::SqlTable> table_ptr,
+    const TupleSlot &tuple_slot, ProjectedRow *table_pr, const bool insert) {
   // Compute largest PR size we need for index PRs.
   uint32_t max_index_key_pr_size = 0;
   for (const auto &index_obj : index_objects) {
@@ -310,7 +664,6 @@ void RecoveryManager::UpdateIndexesOnTable(transaction::TransactionContext *txn,
   auto *index_buffer = common::AllocationUtil::AllocateAligned(max_index_key_pr_size);
 
   // Build a PR map for all columns in the table, as the table pr should have values for every column
-  const auto &table_schema = GetTableSchema(txn, db_catalog_ptr, table_oid);
   std::vector<catalog::col_oid_t> all_table_oids;
   for (const auto &col : table_schema.GetColumns()) {
     all_table_oids.push_back(col.Oid());
@@ -323,26 +676,10 @@ void RecoveryManager::UpdateIndexesOnTable(transaction::TransactionContext *txn,
   for (const auto &index_obj : index_objects) {
     auto index = index_obj.first;
     const auto &schema = index_obj.second;
-    const auto &indexed_attributes = schema.GetIndexedColOids();
 
     // Build the index PR
     auto *index_pr = index->GetProjectedRowInitializer().InitializeRow(index_buffer);
-
-    // Copy in each value from the table PR into the index PR
-    auto num_index_cols = schema.GetColumns().size();
-    TERRIER_ASSERT(num_index_cols == indexed_attributes.size(), "Only support index keys that are a single column oid");
-    for (uint32_t col_idx = 0; col_idx < num_index_cols; col_idx++) {
-      const auto &col = schema.GetColumn(col_idx);
-      auto index_col_oid = col.Oid();
-      const catalog::col_oid_t &table_col_oid = indexed_attributes[col_idx];
-      if (table_pr->IsNull(pr_map[table_col_oid])) {
-        index_pr->SetNull(index->GetKeyOidToOffsetMap().at(index_col_oid));
-      } else {
-        auto size = AttrSizeBytes(col.AttrSize());
-        std::memcpy(index_pr->AccessForceNotNull(index->GetKeyOidToOffsetMap().at(index_col_oid)),
-                    table_pr->AccessWithNullCheck(pr_map[table_col_oid]), size);
-      }
-    }
+    PopulateIndexKey(index, schema, pr_map, *table_pr, index_pr);
 
     if (insert) {
       bool result UNUSED_ATTRIBUTE = (index->metadata_.GetSchema().Unique())
@@ -357,6 +694,27 @@ void RecoveryManager::UpdateIndexesOnTable(transaction::TransactionContext *txn,
   delete[] index_buffer;
 }
 
+void RecoveryManager::PopulateIndexKey(const common::ManagedPointer<index::Index> index,
+                                       const catalog::IndexSchema &index_schema, const ProjectionMap &pr_map,
+                                       const ProjectedRow &table_pr, ProjectedRow *const index_pr) {
+  // Copy in each value from the table PR into the index PR
+  const auto &indexed_attributes = index_schema.GetIndexedColOids();
+  auto num_index_cols = index_schema.GetColumns().size();
+  TERRIER_ASSERT(num_index_cols == indexed_attributes.size(), "Only support index keys that are a single column oid");
+  for (uint32_t col_idx = 0; col_idx < num_index_cols; col_idx++) {
+    const auto &col = index_schema.GetColumn(col_idx);
+    auto index_col_oid = col.Oid();
+    const catalog::col_oid_t &table_col_oid = indexed_attributes[col_idx];
+    if (table_pr.IsNull(pr_map.at(table_col_oid))) {
+      index_pr->SetNull(index->GetKeyOidToOffsetMap().at(index_col_oid));
+    } else {
+      auto size = AttrSizeBytes(col.AttrSize());
+      std::memcpy(index_pr->AccessForceNotNull(index->GetKeyOidToOffsetMap().at(index_col_oid)),
+                  table_pr.AccessWithNullCheck(pr_map.at(table_col_oid)), size);
+    }
+  }
+}
+
 uint32_t RecoveryManager::ProcessSpecialCaseCatalogRecord(
     transaction::TransactionContext *txn, std::vector<std::pair<LogRecord *, std::vector<byte *>>> *buffered_changes,
     uint32_t start_idx) {
@@ -604,6 +962,7 @@ uint32_t RecoveryManager::ProcessSpecialCasePGClassRecord(
               sql_table = GetSqlTable(txn, redo_record->GetDatabaseOid(), catalog::table_oid_t(class_oid)).operator->();
             } else {
               sql_table = new SqlTable(block_store_, *schema);
+              recovered_tables_.emplace_back(redo_record->GetDatabaseOid(), catalog::table_oid_t(class_oid));
             }
             result =
                 db_catalog->SetTablePointer(common::ManagedPointer(txn), catalog::table_oid_t(class_oid), sql_table);
@@ -632,9 +991,9 @@ uint32_t RecoveryManager::ProcessSpecialCasePGClassRecord(
 
             // NOLINTNEXTLINE
             col_oids.clear();
-            col_oids = {catalog::postgres::INDISUNIQUE_COL_OID, catalog::postgres::INDISPRIMARY_COL_OID,
+            col_oids = {catalog::postgres::INDISUNIQUE_COL_OID,    catalog::postgres::INDISPRIMARY_COL_OID,
                         catalog::postgres::INDISEXCLUSION_COL_OID, catalog::postgres::INDIMMEDIATE_COL_OID,
-                        catalog::postgres::IND_TYPE_COL_OID};
+                        catalog::postgres::IND_TYPE_COL_OID,       catalog::postgres::INDRELID_COL_OID};
             auto pg_index_pr_init = db_catalog->indexes_->InitializerForProjectedRow(col_oids);
             auto pg_index_pr_map = db_catalog->indexes_->ProjectionMapForOids(col_oids);
             delete[] buffer;  // Delete old buffer, it won't be large enough for this PR
@@ -671,7 +1030,17 @@ uint32_t RecoveryManager::ProcessSpecialCasePGClassRecord(
             result = db_catalog->SetIndexPointer(common::ManagedPointer(txn), catalog::index_oid_t(class_oid), index);
             TERRIER_ASSERT(result, "Setting index pointer should succeed, entry should be in pg_class already");
 
-            // Step 6: Update catalog oid
+            // Step 6: When serving reads, indexes on user tables are kept up to date during replay, so a new one takes
+            // in the tuples its table already holds
+            if (serve_reads_ && class_oid >= catalog::START_OID) {
+              const catalog::table_oid_t table_oid(*reinterpret_cast<uint32_t *>(
+                  pr->AccessWithNullCheck(pg_index_pr_map[catalog::postgres::INDRELID_COL_OID])));
+              RebuildIndex(txn, GetSqlTable(txn, redo_record->GetDatabaseOid(), table_oid),
+                           db_catalog->GetSchema(common::ManagedPointer(txn), table_oid),
+                           common::ManagedPointer(index), *index_schema);
+            }
+
+            // Step 7: Update catalog oid
             db_catalog->UpdateNextOid(class_oid);
 
             delete[] buffer;
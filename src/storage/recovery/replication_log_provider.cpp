@@ -0,0 +1,88 @@
+#include "storage/recovery/replication_log_provider.h"
+
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "loggers/storage_logger.h"
+
+namespace terrier::storage {
+
+void ReplicationLogProvider::HandBufferToReplication(std::unique_ptr<network::ReadBuffer> buffer) {
+  const auto size = buffer->BytesAvailable();
+  // An empty batch would read as the end of the log
+  if (size == 0) return;
+  std::vector<char> batch(size);
+  buffer->ReadIntoView(size).Read(size, batch.data());
+  handed_batches_.Enqueue(std::move(batch));
+}
+
+bool ReplicationLogProvider::HasMoreRecords() {
+  // Batches can end anywhere, even in the middle of a record, so this may only be the end of a batch
+  while (batch_offset_ == batch_.size()) {
+    if (!NextBatch()) return false;
+  }
+  return true;
+}
+
+bool ReplicationLogProvider::Read(void *const dest, uint32_t size) {
+  auto *out = reinterpret_cast<char *>(dest);
+  while (size > 0) {
+    if (batch_offset_ == batch_.size() && !NextBatch()) return false;
+    const auto num_bytes = static_cast<uint32_t>(std::min<uint64_t>(size, batch_.size() - batch_offset_));
+    std::memcpy(out, batch_.data() + batch_offset_, num_bytes);
+    out += num_bytes;
+    batch_offset_ += num_bytes;
+    size -= num_bytes;
+  }
+  return true;
+}
+
+bool ReplicationLogProvider::NextBatch() {
+  if (ended_) return false;
+  bytes_read_ += batch_.size();
+  batch_.clear();
+  batch_offset_ = 0;
+
+  if (primary_fd_ == -1) {
+    handed_batches_.Dequeue(&batch_);
+    ended_ = batch_.empty();
+    return !ended_;
+  }
+
+  // Acknowledge before waiting, so that the primary is never held back by its window while we wait for it
+  if (bytes_read_ > 0) {
+    // If the primary is gone, we find out when receiving the next batch
+    if (send(primary_fd_, &bytes_read_, sizeof(bytes_read_), MSG_NOSIGNAL) != sizeof(bytes_read_))
+      STORAGE_LOG_WARN("Failed to acknowledge shipped logs with errno {}", errno);
+  }
+  uint64_t size;
+  if (Receive(&size, sizeof(size)) < sizeof(size)) {
+    ended_ = true;
+    return false;
+  }
+  batch_.resize(size);
+  if (Receive(batch_.data(), size) < size) {
+    STORAGE_LOG_ERROR("Shipped logs ended in the middle of a batch");
+    batch_.clear();
+    ended_ = true;
+    return false;
+  }
+  return true;
+}
+
+uint64_t ReplicationLogProvider::Receive(void *const dest, const uint64_t size) {
+  uint64_t received = 0;
+  while (received < size) {
+    const ssize_t ret = recv(primary_fd_, reinterpret_cast<char *>(dest) + received, size - received, 0);
+    if (ret == -1 && errno == EINTR) continue;
+    if (ret == -1) STORAGE_LOG_ERROR("Receiving shipped logs failed with errno {}", errno);
+    if (ret <= 0) break;
+    received += static_cast<uint64_t>(ret);
+  }
+  return received;
+}
+
+}  // namespace terrier::storage
@@ -3,6 +3,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/macros.h"
@@ -54,7 +55,7 @@ SqlTable::SqlTable(const common::ManagedPointer<BlockStore> store, const catalog
   }
 
   auto layout = storage::BlockLayout(attr_sizes);
-  table_ = {new DataTable(block_store_, layout, layout_version_t(0)), layout, col_oid_to_id};
+  table_ = {new DataTable(block_store_, layout, layout_version_t(0)), layout, col_oid_to_id, layout_version_t(0)};
 }
 
 std::vector<col_id_t> SqlTable::ColIdsForOids(const std::vector<catalog::col_oid_t> &col_oids) const {
@@ -71,7 +72,55 @@ std::vector<col_id_t> SqlTable::ColIdsForOids(const std::vector<catalog::col_oid
   return col_ids;
 }
 
-ProjectionMap SqlTable::ProjectionMapForOids(const std::vector<catalog::col_oid_t> &col_oids) {
+const ProjectedColumnsInitializer &SqlTable::InitializerForProjectedColumns(
+    const std::vector<catalog::col_oid_t> &col_oids, const uint32_t max_tuples) const {
+  TERRIER_ASSERT((std::set<catalog::col_oid_t>(col_oids.cbegin(), col_oids.cend())).size() == col_oids.size(),
+                 "There should not be any duplicated in the col_ids!");
+  {
+    common::SharedLatch::ScopedSharedLatch guard(&projection_cache_latch_);
+    const CachedProjection *cached = FindCachedProjection(col_oids);
+    if (cached != nullptr) {
+      auto it = cached->columns_initializers_.find(max_tuples);
+      if (it != cached->columns_initializers_.end()) return it->second;
+    }
+  }
+  auto col_ids = ColIdsForOids(col_oids);
+  TERRIER_ASSERT(col_ids.size() == col_oids.size(),
+                 "Projection should be the same number of columns as requested col_oids.");
+  ProjectedColumnsInitializer initializer(table_.layout_, col_ids, max_tuples);
+  common::SharedLatch::ScopedExclusiveLatch guard(&projection_cache_latch_);
+  // If another thread got here first, its initializer is kept as it may already be in use
+  CachedProjection &cached = projection_caches_[table_.layout_version_][col_oids];
+  return cached.columns_initializers_.emplace(max_tuples, std::move(initializer)).first->second;
+}
+
+const ProjectedRowInitializer &SqlTable::InitializerForProjectedRow(
+    const std::vector<catalog::col_oid_t> &col_oids) const {
+  TERRIER_ASSERT((std::set<catalog::col_oid_t>(col_oids.cbegin(), col_oids.cend())).size() == col_oids.size(),
+                 "There should not be any duplicated in the col_ids!");
+  {
+    common::SharedLatch::ScopedSharedLatch guard(&projection_cache_latch_);
+    const CachedProjection *cached = FindCachedProjection(col_oids);
+    if (cached != nullptr && cached->row_initializer_.has_value()) return *cached->row_initializer_;
+  }
+  auto col_ids = ColIdsForOids(col_oids);
+  TERRIER_ASSERT(col_ids.size() == col_oids.size(),
+                 "Projection should be the same number of columns as requested col_oids.");
+  auto initializer = ProjectedRowInitializer::Create(table_.layout_, col_ids);
+  common::SharedLatch::ScopedExclusiveLatch guard(&projection_cache_latch_);
+  // If another thread got here first, its initializer is kept as it may already be in use
+  CachedProjection &cached = projection_caches_[table_.layout_version_][col_oids];
+  if (!cached.row_initializer_.has_value()) cached.row_initializer_.emplace(std::move(initializer));
+  return *cached.row_initializer_;
+}
+
+const ProjectionMap &SqlTable::ProjectionMapForOids(const std::vector<catalog::col_oid_t> &col_oids) const {
+  {
+    common::SharedLatch::ScopedSharedLatch guard(&projection_cache_latch_);
+    const CachedProjection *cached = FindCachedProjection(col_oids);
+    if (cached != nullptr && cached->projection_map_.has_value()) return *cached->projection_map_;
+  }
+
   // Resolve OIDs to storage IDs
   auto col_ids = ColIdsForOids(col_oids);
 
@@ -84,7 +133,19 @@ ProjectionMap SqlTable::ProjectionMapForOids(const std::vector<catalog::col_oid_
   uint16_t i = 0;
   for (auto &iter : inverse_map) projection_map[iter.second] = i++;
 
-  return projection_map;
+  common::SharedLatch::ScopedExclusiveLatch guard(&projection_cache_latch_);
+  // If another thread got here first, its map is kept as it may already be in use
+  CachedProjection &cached = projection_caches_[table_.layout_version_][col_oids];
+  if (!cached.projection_map_.has_value()) cached.projection_map_.emplace(std::move(projection_map));
+  return *cached.projection_map_;
+}
+
+const SqlTable::CachedProjection *SqlTable::FindCachedProjection(
+    const std::vector<catalog::col_oid_t> &col_oids) const {
+  auto version = projection_caches_.find(table_.layout_version_);
+  if (version == projection_caches_.end()) return nullptr;
+  auto it = version->second.find(col_oids);
+  return it == version->second.end() ? nullptr : &it->second;
 }
 
 catalog::col_oid_t SqlTable::OidForColId(const col_id_t col_id) const {
@@ -7,6 +7,7 @@
 #include "storage/projected_columns.h"
 #include "storage/tuple_access_strategy.h"
 #include "storage/undo_record.h"
+#include "storage/varlen_arena.h"
 namespace terrier::storage {
 
 template <class RowType>
@@ -200,7 +201,7 @@ void StorageUtil::DeallocateVarlens(RawBlock *block, const TupleAccessStrategy &
       if (!accessor.Allocated(slot)) continue;
       auto *entry = reinterpret_cast<VarlenEntry *>(accessor.AccessWithNullCheck(slot, col));
       // If entry is null here, the varlen entry is a null SQL value.
-      if (entry != nullptr && entry->NeedReclaim()) delete[] entry->Content();
+      if (entry != nullptr && entry->NeedReclaim()) VarlenArena::Free(entry->Content());
     }
   }
 }
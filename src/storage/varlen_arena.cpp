@@ -0,0 +1,98 @@
+#include "storage/varlen_arena.h"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <unordered_set>
+
+#include "common/macros.h"
+#include "common/shared_latch.h"
+
+namespace terrier::storage {
+namespace {
+// Lives at the beginning of the slab's memory, followed by the varlens allocated from it
+struct Slab {
+  explicit Slab(const uint32_t class_size) : class_size_(class_size) {}
+  // Number of varlens allocated from this slab that are still alive, plus one while a thread still allocates from it
+  std::atomic<uint32_t> refcount_ = 1;
+  const uint32_t class_size_;
+  // Offset of the next free byte in the slab, only accessed by the allocating thread
+  uint64_t next_ = FirstOffset();
+
+  static constexpr uint64_t FirstOffset() { return (sizeof(Slab) + 15) / 16 * 16; }
+};
+
+// Base addresses of all live slabs, so Free can tell whether a pointer came from a slab
+common::SharedLatch slabs_latch;
+std::unordered_set<uintptr_t> slabs;
+std::atomic<uint64_t> num_slabs = 0;
+
+Slab *NewSlab(const uint32_t class_size) {
+  void *memory = std::aligned_alloc(VarlenArena::SLAB_SIZE, VarlenArena::SLAB_SIZE);
+  if (memory == nullptr) throw std::bad_alloc();
+  {
+    common::SharedLatch::ScopedExclusiveLatch guard(&slabs_latch);
+    slabs.insert(reinterpret_cast<uintptr_t>(memory));
+  }
+  num_slabs++;
+  return new (memory) Slab(class_size);
+}
+
+void Release(Slab *const slab) {
+  if (slab->refcount_.fetch_sub(1) != 1) return;
+  {
+    common::SharedLatch::ScopedExclusiveLatch guard(&slabs_latch);
+    slabs.erase(reinterpret_cast<uintptr_t>(slab));
+  }
+  num_slabs--;
+  slab->~Slab();
+  std::free(slab);
+}
+
+// The slabs the current thread allocates from, one per size class
+struct ThreadCache {
+  ThreadCache() = default;
+  DISALLOW_COPY_AND_MOVE(ThreadCache)
+  ~ThreadCache() {
+    for (Slab *slab : active_)
+      if (slab != nullptr) Release(slab);
+  }
+  std::array<Slab *, VarlenArena::NUM_SIZE_CLASSES> active_{};
+};
+
+thread_local ThreadCache thread_cache;
+}  // namespace
+
+byte *VarlenArena::Allocate(const uint32_t size) {
+  if (size > MAX_CLASS_SIZE) return common::AllocationUtil::AllocateAligned(size);
+  // Round up to the next power of two, starting from MIN_CLASS_SIZE
+  const uint32_t size_class = size <= MIN_CLASS_SIZE ? 0 : 64 - __builtin_clzll(size - 1) - 4;
+  const uint32_t class_size = MIN_CLASS_SIZE << size_class;
+  Slab *&slab = thread_cache.active_[size_class];
+  if (slab == nullptr || slab->next_ + class_size > SLAB_SIZE) {
+    // The thread is done with a full slab, which goes away once its varlens do
+    if (slab != nullptr) Release(slab);
+    slab = NewSlab(class_size);
+  }
+  byte *result = reinterpret_cast<byte *>(slab) + slab->next_;
+  slab->next_ += class_size;
+  slab->refcount_.fetch_add(1, std::memory_order_relaxed);
+  return result;
+}
+
+void VarlenArena::Free(const byte *const ptr) {
+  const uintptr_t base = reinterpret_cast<uintptr_t>(ptr) & ~(SLAB_SIZE - 1);
+  bool from_slab;
+  {
+    common::SharedLatch::ScopedSharedLatch guard(&slabs_latch);
+    from_slab = slabs.count(base) != 0;
+  }
+  // The slab cannot go away in between, as the varlen being freed still holds a reference to it
+  if (from_slab)
+    Release(reinterpret_cast<Slab *>(base));
+  else
+    delete[] ptr;
+}
+
+uint64_t VarlenArena::NumSlabs() { return num_slabs.load(); }
+}  // namespace terrier::storage
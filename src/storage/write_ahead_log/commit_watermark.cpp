@@ -0,0 +1,48 @@
+#include "storage/write_ahead_log/commit_watermark.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace terrier::storage {
+
+void CommitWatermark::NotifySerialized() {
+  // Taking the latch orders this after a waiter checked for new commits and before it blocks, so it can't miss them
+  { std::lock_guard<std::mutex> guard(serialized_latch_); }
+  serialized_cv_.notify_all();
+}
+
+void CommitWatermark::WaitForSerialized(const transaction::timestamp_t watermark,
+                                        const std::chrono::microseconds timeout) {
+  std::unique_lock<std::mutex> lock(serialized_latch_);
+  serialized_cv_.wait_for(lock, timeout, [&] { return max_serialized_.load() > watermark; });
+}
+
+void CommitWatermark::Persisted(const uint32_t stream, const transaction::timestamp_t watermark,
+                                const std::vector<transaction::timestamp_t> &commit_times,
+                                const std::vector<CommitCallback> &commit_callbacks) {
+  std::vector<CommitCallback> released;
+  {
+    common::SpinLatch::ScopedSpinLatch guard(&latch_);
+    // Persists in flight can finish out of order, but a later one covers everything an earlier one did
+    stream_watermarks_[stream] = std::max(stream_watermarks_[stream], watermark);
+    const auto durable = DurableWatermark();
+    for (uint64_t i = 0; i < commit_callbacks.size(); i++) {
+      if (commit_times[i] <= durable)
+        released.push_back(commit_callbacks[i]);
+      else
+        pending_commits_.emplace(commit_times[i], commit_callbacks[i]);
+    }
+    while (!pending_commits_.empty() && pending_commits_.top().first <= durable) {
+      released.push_back(pending_commits_.top().second);
+      pending_commits_.pop();
+    }
+  }
+  // Callbacks can take a while, so they run outside of the latch
+  for (const auto &callback : released) callback.first(callback.second);
+}
+
+transaction::timestamp_t CommitWatermark::DurableWatermark() const {
+  return *std::min_element(stream_watermarks_.begin(), stream_watermarks_.end());
+}
+
+}  // namespace terrier::storage
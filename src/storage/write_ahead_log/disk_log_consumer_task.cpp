@@ -1,4 +1,7 @@
 #include "storage/write_ahead_log/disk_log_consumer_task.h"
+#include <array>
+#include <utility>
+#include <vector>
 #include "common/resource_tracker.h"
 #include "common/scoped_timer.h"
 #include "common/thread_context.h"
@@ -26,33 +29,189 @@ void DiskLogConsumerTask::WriteBuffersToLogFile() {
   while (!filled_buffer_queue_->Empty()) {
     // Dequeue filled buffers and flush them to disk, as well as storing commit callbacks
     filled_buffer_queue_->Dequeue(&logs);
-    if (logs.first != nullptr) {
+    // Only sampled commits make us read the clock
+    const bool sampled = !logs.commit_samples_.empty();
+    const auto dequeued =
+        sampled ? std::chrono::high_resolution_clock::now() : std::chrono::high_resolution_clock::time_point();
+    bool segment_full = false;
+    if (logs.buffer_ != nullptr) {
       // Need the nullptr check because read-only txns don't serialize any buffers, but generate callbacks to be invoked
-      current_data_written_ += logs.first->FlushBuffer();
+      PreallocateLogFile(logs.buffer_);
+      segment_min_txn_begin_ = std::min(segment_min_txn_begin_, logs.buffer_->MinTxnBegin());
+      segment_max_txn_begin_ = std::max(segment_max_txn_begin_, logs.buffer_->MaxTxnBegin());
+      const bool ends_on_record = logs.buffer_->EndsOnRecord();
+      // This blocks while the replica lags too far behind
+      if (shipper_ != nullptr) {
+        for (const auto &write : logs.buffer_->BufferedWrites())
+          shipper_->ShipLogs(reinterpret_cast<const char *>(write.iov_base), write.iov_len);
+      }
+      const auto flushed = logs.buffer_->FlushBuffer();
+      current_data_written_ += flushed;
+      file_size_ += flushed;
+      segment_full = ends_on_record && SegmentFull();
+    }
+    if (sampled) {
+      const auto written = std::chrono::high_resolution_clock::now();
+      for (auto &sample : logs.commit_samples_) {
+        // The callbacks join the ones of the open group
+        sample.callback_index_ += commit_callbacks_.size();
+        sample.dequeued_ = dequeued;
+        sample.written_ = written;
+        commit_samples_.push_back(sample);
+      }
+    }
+    // The first commit or watermark written after a persist opens a new group
+    const bool new_watermark = logs.watermark_ > written_watermark_;
+    if (!GroupOpen() && (!logs.commit_callbacks_.empty() || new_watermark))
+      group_start_ = std::chrono::high_resolution_clock::now();
+    commit_callbacks_.insert(commit_callbacks_.end(), logs.commit_callbacks_.begin(), logs.commit_callbacks_.end());
+    commit_times_.insert(commit_times_.end(), logs.commit_times_.begin(), logs.commit_times_.end());
+    if (new_watermark) {
+      written_watermark_ = logs.watermark_;
+      watermark_unpersisted_ = true;
     }
-    commit_callbacks_.insert(commit_callbacks_.end(), logs.second.begin(), logs.second.end());
     // Enqueue the flushed buffer to the empty buffer queue
-    if (logs.first != nullptr) {
+    if (logs.buffer_ != nullptr) {
       // nullptr check for the same reason as above
-      empty_buffer_queue_->Enqueue(logs.first);
+      empty_buffer_queue_->Enqueue(logs.buffer_);
     }
+    // Everything after this buffer goes to the next segment
+    if (segment_full) RotateLogSegment();
   }
 }
 
-uint64_t DiskLogConsumerTask::PersistLogFile() {
+void DiskLogConsumerTask::RotateLogSegment() {
+  // The segment is durable before the manifest says it is closed. The commits in it are released along the way.
+  PersistLogFile();
+  WaitForPersistsInFlight();
+  const std::string segment_path = manifest_->CloseSegment(segment_min_txn_begin_, segment_max_txn_begin_);
+  // Buffers the serializer is filling only have their file switched, their contents belong to the new segment
+  for (auto &buffer : *buffers_) buffer.Reopen(segment_path.c_str());
+  segment_min_txn_begin_ = transaction::timestamp_t(UINT64_MAX);
+  segment_max_txn_begin_ = transaction::INITIAL_TXN_TIMESTAMP;
+  current_data_written_ = 0;
+  file_size_ = preallocated_end_ = 0;
+}
+
+bool DiskLogConsumerTask::GroupCommitDue() const {
+  if (!GroupOpen()) return false;
+  return commit_callbacks_.size() >= group_commit_size_ ||
+         std::chrono::high_resolution_clock::now() - group_start_ >= group_commit_window_.load();
+}
+
+void DiskLogConsumerTask::AdaptGroupCommitWindow(const std::chrono::microseconds latency) {
+  common::SpinLatch::ScopedSpinLatch guard(&fsync_latency_latch_);
+  if (record_persist_latencies_) persist_latencies_.push_back(latency);
+  constexpr double weight = 0.2;
+  fsync_latency_ = fsync_latency_ == 0 ? static_cast<double>(latency.count())
+                                       : (1 - weight) * fsync_latency_ + weight * static_cast<double>(latency.count());
+  group_commit_window_.store(
+      std::min(max_group_commit_window_, std::chrono::microseconds(static_cast<int64_t>(fsync_latency_))));
+}
+
+void DiskLogConsumerTask::PreallocateLogFile(BufferedLogWriter *const writer) {
+  if (preallocate_size_ == 0 || file_size_ + writer->BufferedSize() <= preallocated_end_) return;
+  // If the file system can't preallocate, the file just grows on demand, so we move on either way
+  const uint64_t start = std::max(file_size_, preallocated_end_);
+  writer->Preallocate(start, preallocate_size_);
+  preallocated_end_ = start + preallocate_size_;
+}
+
+void DiskLogConsumerTask::PersistGroup(const std::vector<storage::CommitCallback> &commit_callbacks,
+                                       const std::vector<transaction::timestamp_t> &commit_times,
+                                       const transaction::timestamp_t watermark,
+                                       std::vector<storage::CommitLatencySample> commit_samples,
+                                       const uint64_t shipped_offset) {
+  const auto start = std::chrono::high_resolution_clock::now();
+  auto end = start;
   // buffers_ may be empty but we have callbacks to invoke due to read-only txns
   if (!buffers_->empty()) {
     // Force the buffers to be written to disk. Because all buffers log to the same file, it suffices to call persist on
     // any buffer.
     buffers_->front().Persist();
+    end = std::chrono::high_resolution_clock::now();
+    AdaptGroupCommitWindow(std::chrono::duration_cast<std::chrono::microseconds>(end - start));
   }
+  if (shipper_ != nullptr) shipper_->MarkDurable(shipped_offset);
+  // With several streams, the watermark executes the callbacks once every stream has caught up with them, which may
+  // already be the case
+  if (commit_watermark_ != nullptr) commit_watermark_->Persisted(stream_, watermark, commit_times, commit_callbacks);
+  // Execute the callbacks for the whole group of transactions that have been persisted back to back, so that all of
+  // their waiting clients are released together
+  auto sample = commit_samples.begin();
+  for (uint64_t i = 0; i < commit_callbacks.size(); i++) {
+    if (commit_watermark_ == nullptr) commit_callbacks[i].first(commit_callbacks[i].second);
+    if (sample != commit_samples.end() && sample->callback_index_ == i) {
+      sample->persisting_ = start;
+      sample->persisted_ = end;
+      sample->notified_ = std::chrono::high_resolution_clock::now();
+      ++sample;
+    }
+  }
+  if (!commit_samples.empty()) {
+    common::SpinLatch::ScopedSpinLatch guard(&fsync_latency_latch_);
+    finished_commit_samples_.insert(finished_commit_samples_.end(), commit_samples.begin(), commit_samples.end());
+  }
+}
+
+uint64_t DiskLogConsumerTask::PersistLogFile() {
   const auto num_buffers = commit_callbacks_.size();
-  // Execute the callbacks for the transactions that have been persisted
-  for (auto &callback : commit_callbacks_) callback.first(callback.second);
+  // Everything handed to the shipper so far has been written to the log file, and is covered by this persist
+  const uint64_t shipped_offset = shipper_ == nullptr ? 0 : shipper_->SealBatch();
+  if (max_persists_in_flight_ == 0) {
+    PersistGroup(commit_callbacks_, commit_times_, written_watermark_, std::move(commit_samples_), shipped_offset);
+  } else {
+    // Everything in the group was written before the persist starts, so a persist in flight makes its whole group
+    // durable no matter what gets written after it. We just can't have more of them in flight than workers.
+    {
+      std::unique_lock<std::mutex> lock(persists_in_flight_latch_);
+      persists_in_flight_cv_.wait(lock, [&] { return persists_in_flight_ < max_persists_in_flight_; });
+      persists_in_flight_++;
+    }
+    persist_workers_.SubmitTask([this, commit_callbacks{commit_callbacks_}, commit_times{commit_times_},
+                                 watermark{written_watermark_}, commit_samples{std::move(commit_samples_)},
+                                 shipped_offset]() mutable {
+      PersistGroup(commit_callbacks, commit_times, watermark, std::move(commit_samples), shipped_offset);
+      {
+        std::unique_lock<std::mutex> lock(persists_in_flight_latch_);
+        persists_in_flight_--;
+      }
+      persists_in_flight_cv_.notify_one();
+    });
+  }
   commit_callbacks_.clear();
+  commit_times_.clear();
+  commit_samples_.clear();
+  watermark_unpersisted_ = false;
   return num_buffers;
 }
 
+void DiskLogConsumerTask::RecordCommitLatencies() {
+  std::vector<storage::CommitLatencySample> samples;
+  {
+    common::SpinLatch::ScopedSpinLatch guard(&fsync_latency_latch_);
+    samples.swap(finished_commit_samples_);
+  }
+  if (common::thread_context.metrics_store_ == nullptr ||
+      !common::thread_context.metrics_store_->ComponentEnabled(metrics::MetricsComponent::LOGGING))
+    return;
+  const auto micros = [](const auto from, const auto to) {
+    // The clock is not guaranteed to be steady, so it may have been set back between two stamps
+    return to > from ? static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count())
+                     : 0;
+  };
+  for (const auto &sample : samples) {
+    // Every stage of CommitStage runs from one point to the next
+    const std::array<std::chrono::high_resolution_clock::time_point, metrics::NUM_COMMIT_STAGES + 1> points = {
+        sample.handed_,  sample.serializing_, sample.serialized_, sample.dequeued_,
+        sample.written_, sample.persisting_,  sample.persisted_,  sample.notified_};
+    std::array<uint64_t, metrics::NUM_COMMIT_STAGES> stages;
+    for (uint8_t stage = 0; stage < metrics::NUM_COMMIT_STAGES; stage++)
+      stages[stage] = micros(points[stage], points[stage + 1]);
+    common::thread_context.metrics_store_->RecordCommitLatency(stages);
+  }
+}
+
 void DiskLogConsumerTask::DiskLogConsumerTaskLoop() {
   // input for this operating unit
   uint64_t num_bytes = 0, num_buffers = 0;
@@ -65,9 +224,12 @@ void DiskLogConsumerTask::DiskLogConsumerTaskLoop() {
     // start the operating unit resource tracker
     common::thread_context.resource_tracker_.Start();
   }
+  record_persist_latencies_ = logging_metrics_enabled;
 
   // Keeps track of how much data we've written to the log file since the last persist
   current_data_written_ = 0;
+  // The log file may already hold logs from an earlier run, which count towards its preallocation and segment size
+  if (!buffers_->empty()) file_size_ = preallocated_end_ = buffers_->front().FileSize();
   // Time since last log file persist
   auto last_persist = std::chrono::high_resolution_clock::now();
   // Disk log consumer task thread spins in this loop. When notified or periodically, we wake up and process serialized
@@ -76,12 +238,19 @@ void DiskLogConsumerTask::DiskLogConsumerTaskLoop() {
     {
       // Wait until we are told to flush buffers
       std::unique_lock<std::mutex> lock(persist_lock_);
+      // If a group of commits is open, we need to wake up in time to persist it
+      std::chrono::microseconds wait_time = persist_interval_;
+      if (GroupOpen()) {
+        const auto group_age = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - group_start_);
+        wait_time = std::max(std::chrono::microseconds(0), std::min(wait_time, GetGroupCommitWindow() - group_age));
+      }
       // Wake up the task thread if:
       // 1) The serializer thread has signalled to persist all non-empty buffers to disk
       // 2) There is a filled buffer to write to the disk
       // 3) LogManager has shut down the task
-      // 4) Our persist interval timed out
-      disk_log_writer_thread_cv_.wait_for(lock, persist_interval_,
+      // 4) Our persist interval or the group commit window timed out
+      disk_log_writer_thread_cv_.wait_for(lock, wait_time,
                                           [&] { return do_persist_ || !filled_buffer_queue_->Empty() || !run_task_; });
     }
 
@@ -91,13 +260,16 @@ void DiskLogConsumerTask::DiskLogConsumerTaskLoop() {
     // We persist the log file if the following conditions are met
     // 1) The persist interval amount of time has passed since the last persist
     // 2) We have written more data since the last persist than the threshold
-    // 3) We are signaled to persist
-    // 4) We are shutting down this task
+    // 3) The open group of commits is due
+    // 4) We are signaled to persist
+    // 5) We are shutting down this task
     bool timeout = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() -
                                                                          last_persist) > persist_interval_;
-    if (timeout || current_data_written_ > persist_threshold_ || do_persist_ || !run_task_) {
+    if (timeout || current_data_written_ > persist_threshold_ || GroupCommitDue() || do_persist_ || !run_task_) {
       std::unique_lock<std::mutex> lock(persist_lock_);
       num_buffers = PersistLogFile();
+      // Whoever forced the persist expects the logs to be durable when we signal them
+      if (do_persist_ || !run_task_) WaitForPersistsInFlight();
       num_bytes = current_data_written_;
       // Reset meta data
       last_persist = std::chrono::high_resolution_clock::now();
@@ -115,13 +287,23 @@ void DiskLogConsumerTask::DiskLogConsumerTaskLoop() {
         auto &resource_metrics = common::thread_context.resource_tracker_.GetMetrics();
         common::thread_context.metrics_store_->RecordConsumerData(num_bytes, num_buffers, resource_metrics);
       }
+      std::vector<std::chrono::microseconds> persist_latencies;
+      {
+        common::SpinLatch::ScopedSpinLatch guard(&fsync_latency_latch_);
+        persist_latencies.swap(persist_latencies_);
+      }
+      for (const auto latency : persist_latencies)
+        common::thread_context.metrics_store_->RecordPersistLatency(static_cast<uint64_t>(latency.count()));
       num_bytes = num_buffers = 0;
       // start the operating unit resource tracker
       common::thread_context.resource_tracker_.Start();
     }
+    // Unlike the other logging metrics, the samples are not dropped just because this round is not recorded
+    RecordCommitLatencies();
   } while (run_task_);
   // Be extra sure we processed everything
   WriteBuffersToLogFile();
   PersistLogFile();
+  WaitForPersistsInFlight();
 }
 }  // namespace terrier::storage
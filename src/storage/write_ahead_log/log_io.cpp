@@ -1,5 +1,8 @@
 #include "storage/write_ahead_log/log_io.h"
 #include <algorithm>
+#include <climits>
+#include <vector>
+#include "transaction/timestamp_manager.h"
 namespace terrier::storage {
 void PosixIoWrappers::Close(int fd) {
   while (true) {
@@ -38,6 +41,117 @@ void PosixIoWrappers::WriteFully(int fd, const void *buf, size_t nbyte) {
   }
 }
 
+void PosixIoWrappers::WriteVFully(int fd, struct iovec *iov, size_t iovcnt) {
+  while (iovcnt > 0) {
+    ssize_t ret = writev(fd, iov, static_cast<int>(std::min<size_t>(iovcnt, IOV_MAX)));
+    if (ret == -1) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error("Writev failed with errno " + std::to_string(errno));
+    }
+    // Skip over the buffers that were fully written, and advance into the one that was partially written, if any
+    auto written = static_cast<size_t>(ret);
+    while (iovcnt > 0 && written >= iov->iov_len) {
+      written -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (written > 0) {
+      iov->iov_base = reinterpret_cast<char *>(iov->iov_base) + written;
+      iov->iov_len -= written;
+    }
+  }
+}
+
+uint32_t PosixIoWrappers::PreadFully(int fd, void *buf, size_t nbyte, off_t offset) {
+  ssize_t bytes_read = 0;
+  while (bytes_read < static_cast<ssize_t>(nbyte)) {
+    ssize_t ret = pread(fd, reinterpret_cast<char *>(buf) + bytes_read, static_cast<ssize_t>(nbyte) - bytes_read,
+                        offset + bytes_read);
+    if (ret == -1) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error("Pread failed with errno " + std::to_string(errno));
+    }
+    if (ret == 0) break;  // no more bytes left in the file
+    bytes_read += ret;
+  }
+  return static_cast<uint32_t>(bytes_read);
+}
+
+void PosixIoWrappers::PwriteVFully(int fd, struct iovec *iov, size_t iovcnt, off_t offset) {
+  while (iovcnt > 0) {
+    ssize_t ret = pwritev(fd, iov, static_cast<int>(std::min<size_t>(iovcnt, IOV_MAX)), offset);
+    if (ret == -1) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error("Pwritev failed with errno " + std::to_string(errno));
+    }
+    offset += ret;
+    // Skip over the buffers that were fully written, and advance into the one that was partially written, if any
+    auto written = static_cast<size_t>(ret);
+    while (iovcnt > 0 && written >= iov->iov_len) {
+      written -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (written > 0) {
+      iov->iov_base = reinterpret_cast<char *>(iov->iov_base) + written;
+      iov->iov_len -= written;
+    }
+  }
+}
+
+bool PosixIoWrappers::Preallocate(int fd, off_t offset, off_t len) {
+  while (true) {
+    int ret = fallocate(fd, FALLOC_FL_KEEP_SIZE, offset, len);
+    if (ret == -1) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    return true;
+  }
+}
+
+uint64_t PosixIoWrappers::FileSize(int fd) {
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1) throw std::runtime_error("fstat failed with errno " + std::to_string(errno));
+  return static_cast<uint64_t>(file_stat.st_size);
+}
+
+std::vector<struct iovec> BufferedLogWriter::BufferedWrites() const {
+  std::vector<struct iovec> writes;
+  writes.reserve(2 * references_.size() + 1);
+  uint32_t buffer_offset = 0;
+  // Interleave the buffered bytes with the references made in between them
+  for (const auto &reference : references_) {
+    if (reference.offset_ > buffer_offset)
+      writes.push_back({const_cast<char *>(buffer_ + buffer_offset), reference.offset_ - buffer_offset});
+    writes.push_back({const_cast<void *>(reference.data_), reference.size_});
+    buffer_offset = reference.offset_;
+  }
+  if (buffer_size_ > buffer_offset)
+    writes.push_back({const_cast<char *>(buffer_ + buffer_offset), buffer_size_ - buffer_offset});
+  return writes;
+}
+
+uint64_t BufferedLogWriter::FlushBuffer() {
+  const auto size = BufferedSize();
+  if (references_.empty()) {
+    PosixIoWrappers::WriteFully(out_, buffer_, buffer_size_);
+  } else {
+    std::vector<struct iovec> writes = BufferedWrites();
+    PosixIoWrappers::WriteVFully(out_, writes.data(), writes.size());
+  }
+  // The referenced memory is in the log file now, so GC may free it
+  for (const auto &txns : pinned_txns_) txns.first->RemoveTransactions(txns.second);
+  pinned_txns_.clear();
+  references_.clear();
+  referenced_size_ = 0;
+  buffer_size_ = 0;
+  min_txn_begin_ = transaction::timestamp_t(UINT64_MAX);
+  max_txn_begin_ = transaction::INITIAL_TXN_TIMESTAMP;
+  ends_on_record_ = false;
+  return size;
+}
+
 bool BufferedLogReader::Read(void *dest, uint32_t size) {
   if (read_head_ + size <= filled_size_) {
     // bytes to read are already buffered.
@@ -1,4 +1,7 @@
 #include "storage/write_ahead_log/log_manager.h"
+
+#include <atomic>
+
 #include "storage/write_ahead_log/log_serializer_task.h"
 #include "transaction/transaction_context.h"
 
@@ -7,66 +10,157 @@ namespace terrier::storage {
 void LogManager::Start() {
   TERRIER_ASSERT(!run_log_manager_, "Can't call Start on already started LogManager");
   // Initialize buffers for logging
-  for (size_t i = 0; i < num_buffers_; i++) {
-    buffers_.emplace_back(BufferedLogWriter(log_file_path_.c_str()));
-  }
-  for (size_t i = 0; i < num_buffers_; i++) {
-    empty_buffer_queue_.Enqueue(&buffers_[i]);
+  for (auto &stream : streams_) {
+    // Pick up writing the log where the last run left off
+    stream->manifest_ = std::make_unique<LogSegmentManifest>(stream->file_path_);
+    const std::string segment_path = stream->OpenSegmentPath();
+    for (size_t i = 0; i < num_buffers_; i++) {
+      stream->buffers_.emplace_back(BufferedLogWriter(segment_path.c_str()));
+    }
+    for (size_t i = 0; i < num_buffers_; i++) {
+      stream->empty_buffer_queue_.Enqueue(&stream->buffers_[i]);
+    }
   }
 
   run_log_manager_ = true;
 
-  // Register DiskLogConsumerTask
-  disk_log_writer_task_ = thread_registry_->RegisterDedicatedThread<DiskLogConsumerTask>(
-      this /* requester */, persist_interval_, persist_threshold_, &buffers_, &empty_buffer_queue_,
-      &filled_buffer_queue_);
+  for (uint32_t i = 0; i < streams_.size(); i++) {
+    auto &stream = streams_[i];
+    // Register LogShipperTask, which has to be shipping before the consumer hands it logs
+    if (stream->replica_fd_ != -1) {
+      stream->log_shipper_task_ = thread_registry_->RegisterDedicatedThread<LogShipperTask>(
+          this /* requester */, stream->replica_fd_, stream->replica_offset_, replication_batch_size_,
+          replication_window_);
+      // A new replica first gets the log kept on disk, which nothing writes to until the consumer starts
+      if (!stream->replica_caught_up_) {
+        const uint64_t catalog_log = stream->manifest_->CatalogLog();
+        if (catalog_log != 0) {
+          stream->log_shipper_task_->ShipLogFile(
+              LogSegmentManifest::CatalogLogFilePath(stream->file_path_, catalog_log));
+        }
+        for (const auto &segment : stream->manifest_->ClosedSegments())
+          stream->log_shipper_task_->ShipLogFile(LogSegmentManifest::SegmentFilePath(stream->file_path_, segment.id_));
+        stream->log_shipper_task_->ShipLogFile(stream->OpenSegmentPath());
+        stream->replica_caught_up_ = true;
+      }
+    }
 
-  // Register LogSerializerTask
-  log_serializer_task_ = thread_registry_->RegisterDedicatedThread<LogSerializerTask>(
-      this /* requester */, serialization_interval_, buffer_pool_, &empty_buffer_queue_, &filled_buffer_queue_,
-      &disk_log_writer_task_->disk_log_writer_thread_cv_);
+    // Register DiskLogConsumerTask
+    stream->disk_log_writer_task_ = thread_registry_->RegisterDedicatedThread<DiskLogConsumerTask>(
+        this /* requester */, persist_interval_, persist_threshold_, max_group_commit_window_, group_commit_size_,
+        &stream->buffers_, &stream->empty_buffer_queue_, &stream->filled_buffer_queue_, preallocate_size_,
+        max_persists_in_flight_, stream->manifest_.get(), segment_size_, stream->log_shipper_task_.Get(),
+        commit_watermark_.get(), i);
+
+    // Register LogSerializerTask
+    stream->log_serializer_task_ = thread_registry_->RegisterDedicatedThread<LogSerializerTask>(
+        this /* requester */, serialization_interval_, buffer_pool_, &stream->empty_buffer_queue_,
+        &stream->filled_buffer_queue_, &stream->disk_log_writer_task_->disk_log_writer_thread_cv_,
+        commit_watermark_.get());
+  }
+}
+
+void LogManager::SerializeAllStreams() {
+  for (auto &stream : streams_) stream->log_serializer_task_->Process();
+  // A stream that went before the others has a watermark from before their commits, so it has to go again
+  if (commit_watermark_ != nullptr) {
+    for (auto &stream : streams_) stream->log_serializer_task_->Process();
+  }
 }
 
 void LogManager::ForceFlush() {
-  // Force the serializer task to serialize buffers
-  log_serializer_task_->Process();
-  // Signal the disk log consumer task thread to persist the buffers to disk
-  std::unique_lock<std::mutex> lock(disk_log_writer_task_->persist_lock_);
-  disk_log_writer_task_->do_persist_ = true;
-  disk_log_writer_task_->disk_log_writer_thread_cv_.notify_one();
-
-  // Wait for the disk log consumer task thread to persist the logs
-  disk_log_writer_task_->persist_cv_.wait(lock, [&] { return !disk_log_writer_task_->do_persist_; });
+  // Force the serializer tasks to serialize buffers
+  SerializeAllStreams();
+
+  // Signal every disk log consumer task thread to persist the buffers to disk, so the streams persist in parallel
+  for (auto &stream : streams_) {
+    std::unique_lock<std::mutex> lock(stream->disk_log_writer_task_->persist_lock_);
+    stream->disk_log_writer_task_->do_persist_ = true;
+    stream->disk_log_writer_task_->disk_log_writer_thread_cv_.notify_one();
+  }
+
+  // Wait for the disk log consumer task threads to persist the logs
+  for (auto &stream : streams_) {
+    auto *const task = stream->disk_log_writer_task_.Get();
+    std::unique_lock<std::mutex> lock(task->persist_lock_);
+    task->persist_cv_.wait(lock, [&] { return !task->do_persist_; });
+  }
 }
 
 void LogManager::PersistAndStop() {
   TERRIER_ASSERT(run_log_manager_, "Can't call PersistAndStop on an un-started LogManager");
   run_log_manager_ = false;
+  // Each serializer serializes what is left when it stops, but the streams stop one after the other, and the first ones
+  // would be left with watermarks that hold back the commits of the others
+  SerializeAllStreams();
 
   // Signal all tasks to stop. The shutdown of the tasks will trigger any remaining logs to be serialized, writen to the
   // log file, and persisted. The order in which we shut down the tasks is important, we must first serialize, then
   // shutdown the disk consumer task (reverse order of Start())
-  auto result UNUSED_ATTRIBUTE =
-      thread_registry_->StopTask(this, log_serializer_task_.CastManagedPointerTo<common::DedicatedThreadTask>());
-  TERRIER_ASSERT(result, "LogSerializerTask should have been stopped");
+  for (auto &stream : streams_) {
+    auto result UNUSED_ATTRIBUTE = thread_registry_->StopTask(
+        this, stream->log_serializer_task_.CastManagedPointerTo<common::DedicatedThreadTask>());
+    TERRIER_ASSERT(result, "LogSerializerTask should have been stopped");
+
+    result = thread_registry_->StopTask(
+        this, stream->disk_log_writer_task_.CastManagedPointerTo<common::DedicatedThreadTask>());
+    TERRIER_ASSERT(result, "DiskLogConsumerTask should have been stopped");
+    TERRIER_ASSERT(stream->filled_buffer_queue_.Empty(),
+                   "disk log consumer task should have processed all filled buffers\n");
+
+    // The shipper goes last, once it has sent everything the consumer persisted on its way out
+    if (stream->log_shipper_task_ != nullptr) {
+      stream->replica_offset_ = stream->log_shipper_task_->BytesWritten();
+      result = thread_registry_->StopTask(
+          this, stream->log_shipper_task_.CastManagedPointerTo<common::DedicatedThreadTask>());
+      TERRIER_ASSERT(result, "LogShipperTask should have been stopped");
+      stream->log_shipper_task_ = common::ManagedPointer<LogShipperTask>(nullptr);
+    }
 
-  result = thread_registry_->StopTask(this, disk_log_writer_task_.CastManagedPointerTo<common::DedicatedThreadTask>());
-  TERRIER_ASSERT(result, "DiskLogConsumerTask should have been stopped");
-  TERRIER_ASSERT(filled_buffer_queue_.Empty(), "disk log consumer task should have processed all filled buffers\n");
+    // Close the buffers corresponding to the log file
+    for (auto buf : stream->buffers_) {
+      buf.Close();
+    }
+    // Clear buffer queues
+    stream->empty_buffer_queue_.Clear();
+    stream->filled_buffer_queue_.Clear();
+    stream->buffers_.clear();
+  }
+}
 
-  // Close the buffers corresponding to the log file
-  for (auto buf : buffers_) {
-    buf.Close();
+void LogManager::SetReplicas(std::vector<int> replica_fds, const uint64_t batch_size,
+                             const uint64_t max_bytes_in_flight) {
+  TERRIER_ASSERT(!run_log_manager_, "Can't change the replicas of a running LogManager");
+  TERRIER_ASSERT(replica_fds.empty() || replica_fds.size() == streams_.size(), "Every stream needs its own replica");
+  for (uint32_t i = 0; i < streams_.size(); i++) {
+    streams_[i]->replica_fd_ = replica_fds.empty() ? -1 : replica_fds[i];
+    streams_[i]->replica_offset_ = 0;
+    streams_[i]->replica_caught_up_ = false;
   }
-  // Clear buffer queues
-  empty_buffer_queue_.Clear();
-  filled_buffer_queue_.Clear();
-  buffers_.clear();
+  replication_batch_size_ = batch_size;
+  replication_window_ = max_bytes_in_flight;
 }
 
-void LogManager::AddBufferToFlushQueue(RecordBufferSegment *const buffer_segment) {
+void LogManager::AddBufferToFlushQueue(RecordBufferSegment *const buffer_segment, const uint32_t stream) {
   TERRIER_ASSERT(run_log_manager_, "Must call Start on log manager before handing it buffers");
-  log_serializer_task_->AddBufferToFlushQueue(buffer_segment);
+  TERRIER_ASSERT(stream < streams_.size(), "Log stream out of range");
+  streams_[stream]->log_serializer_task_->AddBufferToFlushQueue(buffer_segment);
+}
+
+uint64_t LogManager::TruncateLog(const transaction::timestamp_t oldest_needed_begin) {
+  uint64_t num_truncated = 0;
+  for (auto &stream : streams_) {
+    if (stream->manifest_ != nullptr) num_truncated += stream->manifest_->Truncate(oldest_needed_begin);
+  }
+  return num_truncated;
+}
+
+uint32_t LogManager::StreamForCurrentThread() const {
+  if (streams_.size() == 1) return 0;
+  // Every thread draws a ticket the first time it gets here, which spreads threads evenly over the streams
+  static std::atomic<uint32_t> next_ticket{0};
+  static thread_local const uint32_t ticket = next_ticket++;
+  return ticket % static_cast<uint32_t>(streams_.size());
 }
 
 }  // namespace terrier::storage
@@ -0,0 +1,181 @@
+#include "storage/write_ahead_log/log_segment_manifest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "catalog/catalog_defs.h"
+#include "storage/recovery/abstract_log_provider.h"
+#include "storage/write_ahead_log/log_io.h"
+#include "storage/write_ahead_log/log_record.h"
+
+namespace terrier::storage {
+
+namespace {
+// Reads the records of a segment, and keeps the bytes of the last one read so that it can be copied as it is
+class SegmentRecordReader : public AbstractLogProvider {
+ public:
+  explicit SegmentRecordReader(const std::string &segment_path) : in_(segment_path.c_str()) {}
+
+  std::pair<LogRecord *, std::vector<byte *>> NextRecord() {
+    record_bytes_.clear();
+    return GetNextRecord();
+  }
+
+  const std::vector<byte> &RecordBytes() const { return record_bytes_; }
+
+ protected:
+  bool HasMoreRecords() override { return in_.HasMore(); }
+
+  bool Read(void *dest, uint32_t size) override {
+    if (!in_.Read(dest, size)) return false;
+    const auto *bytes = reinterpret_cast<const byte *>(dest);
+    record_bytes_.insert(record_bytes_.end(), bytes, bytes + size);
+    return true;
+  }
+
+ private:
+  BufferedLogReader in_;
+  std::vector<byte> record_bytes_;
+};
+}  // namespace
+
+// The manifest is a text file. The first line holds the number of the open segment and of the catalog log, followed by
+// the txns left open in the catalog log. Every following line holds the number of a closed segment and the range of
+// begin timestamps of the txns with records in it.
+LogSegmentManifest::LogSegmentManifest(std::string log_file_path) : log_file_path_(std::move(log_file_path)) {
+  std::ifstream in(ManifestFilePath(log_file_path_));
+  if (!in.is_open()) return;
+  std::string first_line;
+  std::getline(in, first_line);
+  std::istringstream header(first_line);
+  if (!(header >> open_segment_ >> catalog_log_))
+    throw std::runtime_error("Malformed log segment manifest for " + log_file_path_);
+  uint64_t txn_begin;
+  while (header >> txn_begin) open_catalog_txns_.emplace_back(txn_begin);
+  if (!header.eof()) throw std::runtime_error("Malformed log segment manifest for " + log_file_path_);
+  uint64_t id, min_txn_begin, max_txn_begin;
+  while (in >> id >> min_txn_begin >> max_txn_begin)
+    closed_segments_.push_back({id, transaction::timestamp_t(min_txn_begin), transaction::timestamp_t(max_txn_begin)});
+  if (!in.eof()) throw std::runtime_error("Malformed log segment manifest for " + log_file_path_);
+}
+
+std::string LogSegmentManifest::CloseSegment(const transaction::timestamp_t min_txn_begin,
+                                             const transaction::timestamp_t max_txn_begin) {
+  std::lock_guard<std::mutex> guard(latch_);
+  closed_segments_.push_back({open_segment_, min_txn_begin, max_txn_begin});
+  open_segment_++;
+  WriteManifest();
+  return SegmentFilePath(log_file_path_, open_segment_);
+}
+
+uint64_t LogSegmentManifest::Truncate(const transaction::timestamp_t oldest_needed_begin) {
+  std::lock_guard<std::mutex> truncate_guard(truncate_latch_);
+  std::vector<Segment> truncated;
+  uint64_t catalog_log;
+  std::vector<transaction::timestamp_t> open_catalog_txns;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    // Only a prefix of the segments can go, so that what is left of the log stays contiguous
+    auto it = closed_segments_.begin();
+    while (it != closed_segments_.end() && it->max_txn_begin_ < oldest_needed_begin) it++;
+    if (it == closed_segments_.begin()) return 0;
+    truncated.assign(closed_segments_.begin(), it);
+    catalog_log = catalog_log_;
+    open_catalog_txns = open_catalog_txns_;
+  }
+
+  // Closed segments never change, and the consumer only adds new ones meanwhile. A failure leaves a stray catalog log
+  // behind, which the next truncation overwrites.
+  const bool catalog_log_written = WriteCatalogLog(truncated, catalog_log, &open_catalog_txns);
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    closed_segments_.erase(closed_segments_.begin(), closed_segments_.begin() + truncated.size());
+    if (catalog_log_written) catalog_log_ = catalog_log + 1;
+    open_catalog_txns_ = std::move(open_catalog_txns);
+    // The manifest stops referring to the segments before they are gone, so a crash in between only leaves stray files
+    WriteManifest();
+  }
+  for (const auto &segment : truncated) std::remove(SegmentFilePath(log_file_path_, segment.id_).c_str());
+  if (catalog_log_written && catalog_log != 0) std::remove(CatalogLogFilePath(log_file_path_, catalog_log).c_str());
+  return truncated.size();
+}
+
+bool LogSegmentManifest::WriteCatalogLog(const std::vector<Segment> &segments, const uint64_t catalog_log,
+                                         std::vector<transaction::timestamp_t> *const open_catalog_txns) const {
+  std::unordered_set<transaction::timestamp_t> open_txns(open_catalog_txns->begin(), open_catalog_txns->end());
+  std::vector<byte> kept, watermark;
+  for (const auto &segment : segments) {
+    SegmentRecordReader reader(SegmentFilePath(log_file_path_, segment.id_));
+    for (auto record = reader.NextRecord(); record.first != nullptr; record = reader.NextRecord()) {
+      const LogRecord *const log_record = record.first;
+      bool keep = false;
+      switch (log_record->RecordType()) {
+        case LogRecordType::REDO:
+        case LogRecordType::DELETE: {
+          const auto table_oid = log_record->RecordType() == LogRecordType::REDO
+                                     ? log_record->GetUnderlyingRecordBodyAs<RedoRecord>()->GetTableOid()
+                                     : log_record->GetUnderlyingRecordBodyAs<DeleteRecord>()->GetTableOid();
+          // Catalog tables are the only ones with oids below START_OID
+          keep = (!table_oid) < catalog::START_OID;
+          if (keep) open_txns.insert(log_record->TxnBegin());
+          break;
+        }
+        case LogRecordType::COMMIT:
+        case LogRecordType::ABORT:
+          keep = open_txns.erase(log_record->TxnBegin()) > 0;
+          break;
+        case LogRecordType::WATERMARK:
+          // Recovery only goes by the newest watermark of a stream, which goes at the end
+          watermark = reader.RecordBytes();
+          break;
+      }
+      if (keep) kept.insert(kept.end(), reader.RecordBytes().begin(), reader.RecordBytes().end());
+      delete[] reinterpret_cast<const byte *>(log_record);
+      for (auto *varlen_entry : record.second) delete[] varlen_entry;
+    }
+  }
+  open_catalog_txns->assign(open_txns.begin(), open_txns.end());
+  kept.insert(kept.end(), watermark.begin(), watermark.end());
+  if (kept.empty()) return false;
+
+  const std::string path = CatalogLogFilePath(log_file_path_, catalog_log + 1);
+  ScopedFileDescriptor out(PosixIoWrappers::Open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR));
+  if (catalog_log != 0) {
+    ScopedFileDescriptor in(PosixIoWrappers::Open(CatalogLogFilePath(log_file_path_, catalog_log).c_str(), O_RDONLY));
+    std::vector<byte> buffer(common::Constants::LOG_BUFFER_SIZE);
+    uint32_t read;
+    while ((read = PosixIoWrappers::ReadFully(in.Get(), buffer.data(), buffer.size())) > 0)
+      PosixIoWrappers::WriteFully(out.Get(), buffer.data(), read);
+    in.Close();
+  }
+  PosixIoWrappers::WriteFully(out.Get(), kept.data(), kept.size());
+  if (fsync(out.Get()) == -1) throw std::runtime_error("fsync failed with errno " + std::to_string(errno));
+  out.Close();
+  return true;
+}
+
+void LogSegmentManifest::WriteManifest() const {
+  std::ostringstream contents;
+  contents << open_segment_ << ' ' << catalog_log_;
+  for (const auto txn_begin : open_catalog_txns_) contents << ' ' << !txn_begin;
+  contents << '\n';
+  for (const auto &segment : closed_segments_)
+    contents << segment.id_ << ' ' << !segment.min_txn_begin_ << ' ' << !segment.max_txn_begin_ << '\n';
+  const std::string data = contents.str();
+
+  const std::string path = ManifestFilePath(log_file_path_);
+  const std::string temp_path = path + ".tmp";
+  const int fd = PosixIoWrappers::Open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  PosixIoWrappers::WriteFully(fd, data.data(), data.size());
+  if (fsync(fd) == -1) throw std::runtime_error("fsync failed with errno " + std::to_string(errno));
+  PosixIoWrappers::Close(fd);
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0)
+    throw std::runtime_error("Failed to rename log segment manifest with errno " + std::to_string(errno));
+}
+
+}  // namespace terrier::storage
@@ -16,15 +16,22 @@ void LogSerializerTask::LogSerializerTaskLoop() {
   // TODO(Gus): Make max back-off a settings manager setting
   const auto max_sleep =
       serialization_interval_ * (1u << 10u);  // We cap the back-off in case of long gaps with no transactions
+  auto seen_watermark = transaction::INITIAL_TXN_TIMESTAMP;
   do {
     // Serializing is now on the "critical txn path" because txns wait to commit until their logs are serialized. Thus,
     // a sleep is not fast enough. We perform exponential back-off, doubling the sleep duration if we don't process any
     // buffers in our call to Process. Calls to Process will process as long as new buffers are available.
-    std::this_thread::sleep_for(curr_sleep);
+    // With several streams, the commits of the other streams wait for this one to write out a watermark, so a backed
+    // off stream wakes up as soon as they serialize one
+    if (commit_watermark_ != nullptr && curr_sleep > serialization_interval_)
+      commit_watermark_->WaitForSerialized(seen_watermark, curr_sleep);
+    else
+      std::this_thread::sleep_for(curr_sleep);
     // If Process did not find any new buffers, we perform exponential back-off to reduce our rate of polling for new
     // buffers. We cap the maximum back-off, since in the case of large gaps of no txns, we don't want to unboundedly
     // sleep
     curr_sleep = std::min(Process() ? serialization_interval_ : curr_sleep * 2, max_sleep);
+    if (commit_watermark_ != nullptr) seen_watermark = commit_watermark_->MaxSerialized();
   } while (run_task_);
   // To be extra sure we processed everything
   Process();
@@ -47,6 +54,11 @@ bool LogSerializerTask::Process() {
     common::SpinLatch::ScopedSpinLatch serialization_guard(&serialization_latch_);
     TERRIER_ASSERT(serialized_txns_.empty(),
                    "Aggregated txn timestamps should have been handed off to TimestampManager");
+    sample_commits_ = common::thread_context.metrics_store_ != nullptr &&
+                      common::thread_context.metrics_store_->ComponentEnabled(metrics::MetricsComponent::LOGGING);
+    // Everything handed to us before we find the queue empty makes it into this round (see CommitWatermark)
+    const auto watermark =
+        commit_watermark_ == nullptr ? transaction::INITIAL_TXN_TIMESTAMP : commit_watermark_->MaxSerialized();
     // We continually grab all the buffers until we find there are no new buffers. This way we serialize buffers that
     // came in during the previous serialization loop
 
@@ -61,12 +73,16 @@ bool LogSerializerTask::Process() {
         if (flush_queue_.empty()) break;
 
         temp_flush_queue_ = std::move(flush_queue_);
-        flush_queue_ = std::queue<RecordBufferSegment *>();
+        flush_queue_ = {};
       }
 
       // Loop over all the new buffers we found
       while (!temp_flush_queue_.empty()) {
-        RecordBufferSegment *buffer = temp_flush_queue_.front();
+        RecordBufferSegment *buffer = temp_flush_queue_.front().first;
+        segment_handed_ = temp_flush_queue_.front().second;
+        segment_serializing_ = segment_handed_ == std::chrono::high_resolution_clock::time_point()
+                                   ? segment_handed_
+                                   : std::chrono::high_resolution_clock::now();
         temp_flush_queue_.pop();
 
         // Serialize the Redo buffer and release it to the buffer pool
@@ -80,7 +96,15 @@ bool LogSerializerTask::Process() {
       buffers_processed = true;
     }
 
-    // Mark the last buffer that was written to as full
+    // With several streams, the round ends on the watermark it started with, unless it is already written out
+    if (commit_watermark_ != nullptr && watermark > watermark_written_) {
+      SerializeWatermark(watermark);
+      buffers_processed = true;
+    }
+
+    // Mark the last buffer that was written to as full. It ends on a record boundary, where the consumer can switch
+    // to a new log segment
+    if (filled_buffer_ != nullptr) filled_buffer_->MarkEndsOnRecord();
     if (buffers_processed) HandFilledBufferToWriter();
 
     // Mark the last buffer that was written to as full
@@ -92,6 +116,10 @@ bool LogSerializerTask::Process() {
       txns.first->RemoveTransactions(txns.second);
     }
     serialized_txns_.clear();
+
+    // The serializers of idle streams have a new watermark to write out
+    if (commit_watermark_ != nullptr && commit_watermark_->MaxSerialized() > watermark)
+      commit_watermark_->NotifySerialized();
   }
 
   if (logging_metrics_enabled) {
@@ -121,12 +149,20 @@ BufferedLogWriter *LogSerializerTask::GetCurrentWriteBuffer() {
  * Hand over the current buffer and commit callbacks for commit records in that buffer to the log consumer task
  */
 void LogSerializerTask::HandFilledBufferToWriter() {
+  if (!commit_samples_in_buffer_.empty()) {
+    const auto now = std::chrono::high_resolution_clock::now();
+    for (auto &sample : commit_samples_in_buffer_) sample.serialized_ = now;
+  }
   // Hand over the filled buffer
-  filled_buffer_queue_->Enqueue(std::make_pair(filled_buffer_, commits_in_buffer_));
+  filled_buffer_queue_->Enqueue(
+      {filled_buffer_, commits_in_buffer_, commit_times_in_buffer_, commit_samples_in_buffer_, watermark_in_buffer_});
   // Signal disk log consumer task thread that a buffer has been handed over
   disk_log_writer_thread_cv_->notify_one();
   // Mark that the task doesn't have a buffer in its possession to which it can write to
   commits_in_buffer_.clear();
+  commit_times_in_buffer_.clear();
+  commit_samples_in_buffer_.clear();
+  watermark_in_buffer_ = transaction::INITIAL_TXN_TIMESTAMP;
   filled_buffer_ = nullptr;
 }
 
@@ -144,9 +180,27 @@ std::pair<uint64_t, uint64_t> LogSerializerTask::SerializeBuffer(
         // necessary for the transaction's callback function to be invoked, but there is no need to serialize it, as
         // it corresponds to a transaction with nothing to redo.
         if (!commit_record->IsReadOnly()) num_bytes += SerializeRecord(record);
-        commits_in_buffer_.emplace_back(commit_record->CommitCallback(), commit_record->CommitCallbackArg());
+        if (commit_watermark_ != nullptr) commit_watermark_->Serialized(commit_record->CommitTime());
+        if (commit_record->SynchronousCommit()) {
+          commits_in_buffer_.emplace_back(commit_record->CommitCallback(), commit_record->CommitCallbackArg());
+          if (commit_watermark_ != nullptr) commit_times_in_buffer_.push_back(commit_record->CommitTime());
+          // Whoever forces a serialization may not record metrics, even if the serializer thread does
+          if (segment_handed_ != std::chrono::high_resolution_clock::time_point() &&
+              common::thread_context.metrics_store_ != nullptr &&
+              common::thread_context.metrics_store_->ComponentToRecord(metrics::MetricsComponent::LOGGING)) {
+            CommitLatencySample sample{};
+            sample.callback_index_ = commits_in_buffer_.size() - 1;
+            sample.handed_ = segment_handed_;
+            sample.serializing_ = segment_serializing_;
+            commit_samples_in_buffer_.push_back(sample);
+          }
+        } else {
+          // The transaction does not wait for its commit to be persisted, and accepts losing it if the system crashes
+          // before the next persist
+          commit_record->CommitCallback()(commit_record->CommitCallbackArg());
+        }
         // Once serialization is done, we notify the txn manager to let GC know this txn is ready to clean up
-        serialized_txns_[commit_record->TimestampManager()].push_back(record.TxnBegin());
+        ReleaseSerializedTxn(commit_record->TimestampManager(), record.TxnBegin());
         break;
       }
 
@@ -154,7 +208,7 @@ std::pair<uint64_t, uint64_t> LogSerializerTask::SerializeBuffer(
         // If an abort record shows up at all, the transaction cannot be read-only
         num_bytes += SerializeRecord(record);
         auto *abord_record = record.GetUnderlyingRecordBodyAs<AbortRecord>();
-        serialized_txns_[abord_record->TimestampManager()].push_back(record.TxnBegin());
+        ReleaseSerializedTxn(abord_record->TimestampManager(), record.TxnBegin());
         break;
       }
 
@@ -177,23 +231,31 @@ uint64_t LogSerializerTask::SerializeRecord(const terrier::storage::LogRecord &r
   // manager generates in this function. In particular, the later value is very likely to be strictly smaller when the
   // LogRecordType is REDO. On recovery, the goal is to turn the serialized format back into an in-memory log record of
   // this size.
-  num_bytes += WriteValue(record.Size());
+  // Integers are written as varints (see LogEncoding), and the timestamps of a commit record relative to the txn's
+  // begin.
+  // Every buffer the record ends up in remembers the txn, so that log segments know which txns they hold records of
+  current_txn_begin_ = record.TxnBegin();
+  GetCurrentWriteBuffer()->AddTxn(current_txn_begin_);
+  num_bytes += WriteVarint(record.Size());
 
   num_bytes += WriteValue(record.RecordType());
-  num_bytes += WriteValue(record.TxnBegin());
+  num_bytes += WriteVarint(!record.TxnBegin());
 
   switch (record.RecordType()) {
     case LogRecordType::REDO: {
       auto *record_body = record.GetUnderlyingRecordBodyAs<RedoRecord>();
-      num_bytes += WriteValue(record_body->GetDatabaseOid());
-      num_bytes += WriteValue(record_body->GetTableOid());
+      num_bytes += WriteVarint(!record_body->GetDatabaseOid());
+      num_bytes += WriteVarint(!record_body->GetTableOid());
       num_bytes += WriteValue(record_body->GetTupleSlot());
 
       auto *delta = record_body->Delta();
-      // Write out which column ids this redo record is concerned with. On recovery, we can construct the appropriate
-      // ProjectedRowInitializer from these ids and their corresponding block layout.
-      num_bytes += WriteValue(delta->NumColumns());
-      num_bytes += WriteValue(delta->ColumnIds(), static_cast<uint32_t>(sizeof(col_id_t)) * delta->NumColumns());
+      // Write out which column ids this redo record is concerned with, along with whether any of them is null. On
+      // recovery, we can construct the appropriate ProjectedRowInitializer from these ids and their corresponding block
+      // layout.
+      bool has_nulls = false;
+      for (uint16_t i = 0; i < delta->NumColumns(); i++) has_nulls = has_nulls || delta->IsNull(i);
+      num_bytes += WriteVarint((static_cast<uint64_t>(delta->NumColumns()) << 1) | (has_nulls ? 1 : 0));
+      for (uint16_t i = 0; i < delta->NumColumns(); i++) num_bytes += WriteVarint(!delta->ColumnIds()[i]);
 
       // Write out the attr sizes boundaries, this way we can deserialize the records without the need of the block
       // layout
@@ -201,10 +263,10 @@ uint64_t LogSerializerTask::SerializeRecord(const terrier::storage::LogRecord &r
       uint16_t boundaries[NUM_ATTR_BOUNDARIES];
       memset(boundaries, 0, sizeof(uint16_t) * NUM_ATTR_BOUNDARIES);
       StorageUtil::ComputeAttributeSizeBoundaries(block_layout, delta->ColumnIds(), delta->NumColumns(), boundaries);
-      WriteValue(boundaries, sizeof(uint16_t) * NUM_ATTR_BOUNDARIES);
+      for (const auto boundary : boundaries) num_bytes += WriteVarint(boundary);
 
-      // Write out the null bitmap.
-      num_bytes += WriteValue(&(delta->Bitmap()), common::RawBitmap::SizeInBytes(delta->NumColumns()));
+      // Write out the null bitmap, only if there is something in it. Most redo records don't set anything to null.
+      if (has_nulls) num_bytes += WriteValue(&(delta->Bitmap()), common::RawBitmap::SizeInBytes(delta->NumColumns()));
 
       // Write out attribute values
       for (uint16_t i = 0; i < delta->NumColumns(); i++) {
@@ -221,10 +283,13 @@ uint64_t LogSerializerTask::SerializeRecord(const terrier::storage::LogRecord &r
           // Inline column value is a pointer to a VarlenEntry, so reinterpret as such.
           const auto *varlen_entry = reinterpret_cast<const VarlenEntry *>(column_value_address);
           // Serialize out length of the varlen entry.
-          num_bytes += WriteValue(varlen_entry->Size());
+          num_bytes += WriteVarint(varlen_entry->Size());
           if (varlen_entry->IsInlined()) {
             // Serialize out the prefix of the varlen entry.
             num_bytes += WriteValue(varlen_entry->Prefix(), varlen_entry->Size());
+          } else if (varlen_entry->NeedReclaim() && varlen_entry->Size() >= MIN_REFERENCED_VARLEN_SIZE) {
+            // The content belongs to the txn until GC frees it, so it can be written out from where it is
+            num_bytes += WriteReference(varlen_entry->Content(), varlen_entry->Size());
           } else {
             // Serialize out the content field of the varlen entry.
             num_bytes += WriteValue(varlen_entry->Content(), varlen_entry->Size());
@@ -240,26 +305,44 @@ uint64_t LogSerializerTask::SerializeRecord(const terrier::storage::LogRecord &r
     }
     case LogRecordType::DELETE: {
       auto *record_body = record.GetUnderlyingRecordBodyAs<DeleteRecord>();
-      num_bytes += WriteValue(record_body->GetDatabaseOid());
-      num_bytes += WriteValue(record_body->GetTableOid());
+      num_bytes += WriteVarint(!record_body->GetDatabaseOid());
+      num_bytes += WriteVarint(!record_body->GetTableOid());
       num_bytes += WriteValue(record_body->GetTupleSlot());
       break;
     }
     case LogRecordType::COMMIT: {
       auto *record_body = record.GetUnderlyingRecordBodyAs<CommitRecord>();
-      num_bytes += WriteValue(record_body->CommitTime());
-      num_bytes += WriteValue(record_body->OldestActiveTxn());
+      // Both are close to the txn's begin, the commit time after it and the oldest active txn before it
+      num_bytes += WriteVarint(
+          LogEncoding::ZigZagEncode(static_cast<int64_t>(!record_body->CommitTime() - !record.TxnBegin())));
+      num_bytes += WriteVarint(
+          LogEncoding::ZigZagEncode(static_cast<int64_t>(!record.TxnBegin() - !record_body->OldestActiveTxn())));
       break;
     }
     case LogRecordType::ABORT: {
       // AbortRecord does not hold any additional metadata
       break;
     }
+    case LogRecordType::WATERMARK: {
+      // Txns never hand watermarks over, the serializer writes them itself in SerializeWatermark
+      TERRIER_ASSERT(false, "Watermarks do not belong to txns");
+      break;
+    }
   }
 
   return num_bytes;
 }
 
+void LogSerializerTask::SerializeWatermark(const transaction::timestamp_t watermark) {
+  // Laid out like any other record, with no txn of its own. The buffer does not remember one for it either, so that it
+  // does not hold back truncating the log segment.
+  WriteVarint(WatermarkRecord::Size());
+  WriteValue(LogRecordType::WATERMARK);
+  WriteVarint(!transaction::INITIAL_TXN_TIMESTAMP);
+  WriteVarint(!watermark);
+  watermark_written_ = watermark_in_buffer_ = watermark;
+}
+
 uint32_t LogSerializerTask::WriteValue(const void *val, const uint32_t size) {
   // Serialize the value and copy it to the buffer
   BufferedLogWriter *out = GetCurrentWriteBuffer();
@@ -273,9 +356,37 @@ uint32_t LogSerializerTask::WriteValue(const void *val, const uint32_t size) {
       HandFilledBufferToWriter();
       // Get an empty buffer for writing this value
       out = GetCurrentWriteBuffer();
+      out->AddTxn(current_txn_begin_);
     }
   }
   return size;
 }
 
+uint32_t LogSerializerTask::WriteReference(const void *val, const uint32_t size) {
+  BufferedLogWriter *out = GetCurrentWriteBuffer();
+  out->BufferWriteReference(val, size);
+  referencing_txns_.insert(current_txn_begin_);
+  if (out->IsBufferFull()) {
+    HandFilledBufferToWriter();
+    out = GetCurrentWriteBuffer();
+    out->AddTxn(current_txn_begin_);
+  }
+  return size;
+}
+
+void LogSerializerTask::ReleaseSerializedTxn(transaction::TimestampManager *const timestamp_manager,
+                                             const transaction::timestamp_t txn_begin) {
+  if (referencing_txns_.erase(txn_begin) == 0) {
+    serialized_txns_[timestamp_manager].push_back(txn_begin);
+    return;
+  }
+  // The buffer holding the txn's last record is flushed after every buffer referencing its values
+  GetCurrentWriteBuffer()->PinTxn(timestamp_manager, txn_begin);
+}
+
+uint32_t LogSerializerTask::WriteVarint(const uint64_t val) {
+  uint8_t encoded[LogEncoding::MAX_VARINT_SIZE];
+  return WriteValue(encoded, LogEncoding::EncodeVarint(val, encoded));
+}
+
 }  // namespace terrier::storage
@@ -0,0 +1,172 @@
+#include "storage/write_ahead_log/log_shipper_task.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+#include "common/thread_context.h"
+#include "loggers/storage_logger.h"
+#include "metrics/metrics_store.h"
+#include "storage/write_ahead_log/log_io.h"
+
+namespace terrier::storage {
+
+void LogShipperTask::RunTask() {
+  while (true) {
+    std::deque<Batch> batches;
+    bool terminated;
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      // Without anything to send we still wake up now and then to pick up acknowledgements
+      shipper_cv_.wait_for(lock, ACK_POLL_INTERVAL, [&] {
+        return terminated_ || (!sealed_batches_.empty() && sealed_batches_.front().end_ <= bytes_durable_);
+      });
+      while (!sealed_batches_.empty() && sealed_batches_.front().end_ <= bytes_durable_) {
+        batches.emplace_back(std::move(sealed_batches_.front()));
+        sealed_batches_.pop_front();
+      }
+      // The consumer is stopped before the shipper, so everything it wrote is durable and taken by now
+      terminated = terminated_;
+    }
+
+    // Sending happens outside of the latch, so the consumer keeps writing the next batch meanwhile
+    for (const auto &batch : batches) {
+      if (!Connected() || !SendBatch(batch)) break;
+      const auto now = std::chrono::high_resolution_clock::now();
+      unacknowledged_batches_.push_back({batch.end_, now});
+      std::lock_guard<std::mutex> guard(latch_);
+      bytes_sent_ = batch.end_;
+    }
+    if (Connected()) ReceiveAcknowledgements();
+    if (terminated) break;
+  }
+}
+
+void LogShipperTask::Terminate() {
+  std::lock_guard<std::mutex> guard(latch_);
+  terminated_ = true;
+  shipper_cv_.notify_one();
+}
+
+void LogShipperTask::ShipLogs(const char *const data, const uint64_t size) {
+  std::unique_lock<std::mutex> lock(latch_);
+  // Back-pressure: the replica has to catch up before we take more logs
+  window_cv_.wait(lock, [&] { return !connected_ || bytes_durable_ - bytes_acknowledged_ < max_bytes_in_flight_; });
+  if (!connected_) return;
+  open_batch_.insert(open_batch_.end(), data, data + size);
+  bytes_written_ += size;
+  if (open_batch_.size() >= batch_size_) SealOpenBatch();
+}
+
+void LogShipperTask::ShipLogFile(const std::string &log_file_path) {
+  const int fd = PosixIoWrappers::Open(log_file_path.c_str(), O_RDONLY);
+  std::vector<char> buffer(batch_size_);
+  uint32_t read;
+  while ((read = PosixIoWrappers::ReadFully(fd, buffer.data(), buffer.size())) > 0) {
+    ShipLogs(buffer.data(), read);
+    // The whole file is durable already, so every batch can go out right away
+    MarkDurable(SealBatch());
+    if (read < buffer.size()) break;
+  }
+  PosixIoWrappers::Close(fd);
+}
+
+uint64_t LogShipperTask::SealBatch() {
+  std::lock_guard<std::mutex> guard(latch_);
+  SealOpenBatch();
+  return bytes_written_;
+}
+
+void LogShipperTask::MarkDurable(const uint64_t offset) {
+  std::lock_guard<std::mutex> guard(latch_);
+  // Persists in flight may finish out of order, but each one covers everything written before it
+  bytes_durable_ = std::max(bytes_durable_, offset);
+  shipper_cv_.notify_one();
+}
+
+void LogShipperTask::SealOpenBatch() {
+  if (open_batch_.empty()) return;
+  sealed_batches_.push_back({bytes_written_, std::move(open_batch_)});
+  open_batch_.clear();
+}
+
+bool LogShipperTask::SendBatch(const Batch &batch) {
+  const uint64_t header = batch.data_.size();
+  struct iovec iov[2] = {{const_cast<uint64_t *>(&header), sizeof(header)},
+                         {const_cast<char *>(batch.data_.data()), batch.data_.size()}};
+  struct msghdr message {};
+  message.msg_iov = iov;
+  message.msg_iovlen = 2;
+  while (message.msg_iovlen > 0) {
+    // MSG_NOSIGNAL so that a replica going away fails the send instead of killing the process with SIGPIPE
+    const ssize_t sent = sendmsg(replica_fd_, &message, MSG_NOSIGNAL);
+    if (sent == -1) {
+      if (errno == EINTR) continue;
+      Disconnect("send");
+      return false;
+    }
+    // Skip over what went out, which may end in the middle of either part
+    auto remaining = static_cast<size_t>(sent);
+    while (message.msg_iovlen > 0 && remaining >= message.msg_iov->iov_len) {
+      remaining -= message.msg_iov->iov_len;
+      message.msg_iov++;
+      message.msg_iovlen--;
+    }
+    if (message.msg_iovlen > 0) {
+      message.msg_iov->iov_base = reinterpret_cast<char *>(message.msg_iov->iov_base) + remaining;
+      message.msg_iov->iov_len -= remaining;
+    }
+  }
+  return true;
+}
+
+void LogShipperTask::ReceiveAcknowledgements() {
+  struct pollfd replica = {replica_fd_, POLLIN, 0};
+  while (poll(&replica, 1, 0) > 0) {
+    const ssize_t received =
+        recv(replica_fd_, reinterpret_cast<char *>(&ack_) + ack_size_, sizeof(ack_) - ack_size_, 0);
+    if (received == -1 && errno == EINTR) continue;
+    if (received <= 0) {
+      // Either the socket failed, or the replica closed it and will not read anything we send from now on
+      Disconnect("receive");
+      return;
+    }
+    ack_size_ += static_cast<uint32_t>(received);
+    if (ack_size_ < sizeof(ack_)) continue;
+    ack_size_ = 0;
+
+    // Replicas acknowledge at the end of a batch, so the ack tells us how long ago the newest batch it covers was sent
+    const auto now = std::chrono::high_resolution_clock::now();
+    std::chrono::high_resolution_clock::time_point acknowledged_sent = now;
+    while (!unacknowledged_batches_.empty() && unacknowledged_batches_.front().end_ <= ack_) {
+      acknowledged_sent = unacknowledged_batches_.front().sent_;
+      unacknowledged_batches_.pop_front();
+    }
+    uint64_t lag_bytes;
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      bytes_acknowledged_ = std::max(bytes_acknowledged_, ack_);
+      lag_bytes = bytes_sent_ - bytes_acknowledged_;
+      window_cv_.notify_all();
+    }
+
+    if (common::thread_context.metrics_store_ != nullptr &&
+        common::thread_context.metrics_store_->ComponentToRecord(metrics::MetricsComponent::REPLICATION)) {
+      const auto lag_us = std::chrono::duration_cast<std::chrono::microseconds>(now - acknowledged_sent).count();
+      common::thread_context.metrics_store_->RecordReplicationLag(lag_bytes, static_cast<uint64_t>(lag_us));
+    }
+  }
+}
+
+void LogShipperTask::Disconnect(const char *const operation) {
+  STORAGE_LOG_ERROR("Stopped shipping logs to the replica, {} failed with errno {}", operation, errno);
+  std::lock_guard<std::mutex> guard(latch_);
+  connected_ = false;
+  sealed_batches_.clear();
+  open_batch_.clear();
+  window_cv_.notify_all();
+}
+
+}  // namespace terrier::storage
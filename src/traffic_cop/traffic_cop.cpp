@@ -20,6 +20,7 @@
 #include "optimizer/statistics/stats_storage.h"
 #include "parser/postgresparser.h"
 #include "planner/plannodes/abstract_plan_node.h"
+#include "storage/recovery/recovery_manager.h"
 #include "traffic_cop/traffic_cop_defs.h"
 #include "traffic_cop/traffic_cop_util.h"
 #include "transaction/transaction_manager.h"
@@ -31,10 +32,14 @@ static void CommitCallback(void *const callback_arg) {
   promise->set_value(true);
 }
 
-void TrafficCop::BeginTransaction(const common::ManagedPointer<network::ConnectionContext> connection_ctx) const {
+void TrafficCop::BeginTransaction(const common::ManagedPointer<network::ConnectionContext> connection_ctx,
+                                  const bool read_only) const {
   TERRIER_ASSERT(connection_ctx->TransactionState() == network::NetworkTransactionStateType::IDLE,
                  "Invalid ConnectionContext state, already in a transaction.");
-  const auto txn = txn_manager_->BeginTransaction();
+  // On a replica, a write fails like any other in a read-only txn
+  const auto txn =
+      replica_ != DISABLED ? replica_->BeginSnapshotTransaction() : txn_manager_->BeginTransaction(read_only);
+  txn->SetSynchronousCommit(connection_ctx->SynchronousCommit());
   connection_ctx->SetTransaction(common::ManagedPointer(txn));
   connection_ctx->SetAccessor(catalog_->GetAccessor(common::ManagedPointer(txn), connection_ctx->GetDatabaseOid()));
 }
@@ -63,6 +68,22 @@ void TrafficCop::EndTransaction(const common::ManagedPointer<network::Connection
   connection_ctx->SetAccessor(nullptr);
 }
 
+void TrafficCop::ExecuteSetStatement(const common::ManagedPointer<network::ConnectionContext> connection_ctx,
+                                     const common::ManagedPointer<network::PostgresPacketWriter> out,
+                                     const common::ManagedPointer<parser::ParseResult> parse_result) const {
+  const auto statement = parse_result->GetStatement(0).CastManagedPointerTo<parser::VariableSetStatement>();
+  if (statement->GetName() == "synchronous_commit") {
+    // As in postgres, anything but off leaves the commit synchronous. An empty value resets to the default (on).
+    const std::string &value = statement->GetValue();
+    const bool synchronous_commit = !(value == "off" || value == "false" || value == "0");
+    // SET LOCAL only lasts until the end of the current txn, and is a no-op outside of one
+    if (!statement->IsLocal()) connection_ctx->SetSynchronousCommit(synchronous_commit);
+    const auto txn = connection_ctx->Transaction();
+    if (txn != nullptr) txn->SetSynchronousCommit(synchronous_commit);
+  }
+  out->WriteCommandComplete(network::QueryType::QUERY_SET, 0);
+}
+
 void TrafficCop::HandBufferToReplication(std::unique_ptr<network::ReadBuffer> buffer) {
   TERRIER_ASSERT(replication_log_provider_ != DISABLED, "Should not be handing off logs if no log provider was given");
   replication_log_provider_->HandBufferToReplication(std::move(buffer));
@@ -70,6 +91,7 @@ void TrafficCop::HandBufferToReplication(std::unique_ptr<network::ReadBuffer> bu
 
 void TrafficCop::ExecuteTransactionStatement(const common::ManagedPointer<network::ConnectionContext> connection_ctx,
                                              const common::ManagedPointer<network::PostgresPacketWriter> out,
+                                             const common::ManagedPointer<parser::ParseResult> parse_result,
                                              const terrier::network::QueryType query_type) const {
   TERRIER_ASSERT(query_type == network::QueryType::QUERY_COMMIT || query_type == network::QueryType::QUERY_ROLLBACK ||
                      query_type == network::QueryType::QUERY_BEGIN,
@@ -82,7 +104,8 @@ void TrafficCop::ExecuteTransactionStatement(const common::ManagedPointer<networ
         out->WriteNoticeResponse("WARNING:  there is already a transaction in progress");
         break;
       }
-      BeginTransaction(connection_ctx);
+      const auto statement = parse_result->GetStatement(0).CastManagedPointerTo<parser::TransactionStatement>();
+      BeginTransaction(connection_ctx, statement->IsReadOnly());
       break;
     }
     case network::QueryType::QUERY_COMMIT: {
@@ -273,7 +296,12 @@ void TrafficCop::ExecuteStatement(const common::ManagedPointer<network::Connecti
                                   const terrier::network::QueryType query_type) const {
   // This logic relies on ordering of values in the enum's definition and is documented there as well.
   if (query_type <= network::QueryType::QUERY_ROLLBACK) {
-    ExecuteTransactionStatement(connection_ctx, out, query_type);
+    ExecuteTransactionStatement(connection_ctx, out, parse_result, query_type);
+    return;
+  }
+
+  if (query_type == network::QueryType::QUERY_SET) {
+    ExecuteSetStatement(connection_ctx, out, parse_result);
     return;
   }
 
@@ -286,13 +314,17 @@ void TrafficCop::ExecuteStatement(const common::ManagedPointer<network::Connecti
 
   const bool single_statement_txn = connection_ctx->TransactionState() == network::NetworkTransactionStateType::IDLE;
 
-  // Begin a transaction if necessary
+  // Begin a transaction if necessary. Most traffic is single SELECTs, which can take the read-only fast path.
   if (single_statement_txn) {
-    BeginTransaction(connection_ctx);
+    BeginTransaction(connection_ctx, query_type == network::QueryType::QUERY_SELECT);
   }
 
-  // Try to bind the parsed statement
-  if (BindStatement(connection_ctx, out, parse_result, query_type)) {
+  // Try to bind the parsed statement, unless it writes in a read-only transaction
+  if (query_type != network::QueryType::QUERY_SELECT && connection_ctx->Transaction()->IsDeclaredReadOnly()) {
+    out->WriteErrorResponse("ERROR:  cannot execute statement in a read-only transaction");
+    // as in postgres, this fails the transaction
+    connection_ctx->Transaction()->SetMustAbort();
+  } else if (BindStatement(connection_ctx, out, parse_result, query_type)) {
     // Binding succeeded, optimize to generate a physical plan and then execute
     auto cost_model = std::make_unique<optimizer::TrivialCostModel>();
     auto physical_plan = trafficcop::TrafficCopUtil::Optimize(
@@ -363,6 +395,15 @@ void TrafficCop::CodegenAndRunPhysicalPlan(const common::ManagedPointer<network:
 
 std::pair<catalog::db_oid_t, catalog::namespace_oid_t> TrafficCop::CreateTempNamespace(
     const network::connection_id_t connection_id, const std::string &database_name) {
+  if (replica_ != DISABLED) {
+    // Nothing but replay may change the catalog of a replica, so the connection makes do with the default namespace
+    auto *const txn = replica_->BeginSnapshotTransaction();
+    const auto db_oid = catalog_->GetDatabaseOid(common::ManagedPointer(txn), database_name);
+    txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+    if (db_oid == catalog::INVALID_DATABASE_OID) return {catalog::INVALID_DATABASE_OID, catalog::INVALID_NAMESPACE_OID};
+    return {db_oid, catalog::postgres::NAMESPACE_DEFAULT_NAMESPACE_OID};
+  }
+
   auto *const txn = txn_manager_->BeginTransaction();
   const auto db_oid = catalog_->GetDatabaseOid(common::ManagedPointer(txn), database_name);
 
@@ -389,6 +430,8 @@ std::pair<catalog::db_oid_t, catalog::namespace_oid_t> TrafficCop::CreateTempNam
 bool TrafficCop::DropTempNamespace(const catalog::db_oid_t db_oid, const catalog::namespace_oid_t ns_oid) {
   TERRIER_ASSERT(db_oid != catalog::INVALID_DATABASE_OID, "Called DropTempNamespace() with an invalid database oid.");
   TERRIER_ASSERT(ns_oid != catalog::INVALID_NAMESPACE_OID, "Called DropTempNamespace() with an invalid namespace oid.");
+  // Connections to a replica were given the default namespace, which stays
+  if (replica_ != DISABLED) return true;
   auto *const txn = txn_manager_->BeginTransaction();
   const auto db_accessor = catalog_->GetAccessor(common::ManagedPointer(txn), db_oid);
 
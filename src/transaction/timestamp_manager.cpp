@@ -1,30 +1,75 @@
 #include "transaction/timestamp_manager.h"
 #include <algorithm>
+#include <array>
+#include <functional>
+#include <thread>  // NOLINT
 #include <vector>
 
 namespace terrier::transaction {
 
 timestamp_t TimestampManager::OldestTransactionStartTime() {
-  common::SpinLatch::ScopedSpinLatch guard(&curr_running_txns_latch_);
-  const auto &oldest_txn = std::min_element(curr_running_txns_.cbegin(), curr_running_txns_.cend());
-  timestamp_t result = (oldest_txn != curr_running_txns_.end()) ? *oldest_txn : time_.load();
+  // Any txn that has not yet announced itself starts no earlier than this
+  timestamp_t result = time_.load();
+  last_oldest_txn_refresh_.store(result);
+  // Txns in the middle of beginning may not have made it into a shard yet, but they have published a lower bound on
+  // their start time. These need to be looked at before the shards: a txn that is done beginning by the time we see
+  // its slot free is already in its shard.
+  for (const auto &slot : begin_slots_) result = std::min(result, slot.start_.load());
+  for (auto &shard : running_txns_) {
+    common::SpinLatch::ScopedSpinLatch guard(&shard.latch_);
+    if (!shard.txns_.empty()) result = std::min(result, *shard.txns_.begin());
+  }
   cached_oldest_txn_start_time_.store(result);  // Cache the timestamp
   return result;
 }
 
 timestamp_t TimestampManager::CachedOldestTransactionStartTime() { return cached_oldest_txn_start_time_.load(); }
 
+timestamp_t TimestampManager::RecentOldestTransactionStartTime() {
+  const timestamp_t now = time_.load();
+  timestamp_t last_refresh = last_oldest_txn_refresh_.load();
+  // Whoever moves the refresh time along does the refresh, everyone else makes do with the cached timestamp
+  if (!now >= !last_refresh + OLDEST_TXN_REFRESH_INTERVAL &&
+      last_oldest_txn_refresh_.compare_exchange_strong(last_refresh, now))
+    return OldestTransactionStartTime();
+  return CachedOldestTransactionStartTime();
+}
+
+std::atomic<timestamp_t> *TimestampManager::AcquireBeginSlot() {
+  // Threads start looking where they last found a free slot, so that each mostly keeps to a slot of its own
+  static thread_local uint32_t hint = std::hash<std::thread::id>()(std::this_thread::get_id()) % NUM_BEGIN_SLOTS;
+  while (true) {
+    for (uint32_t i = 0; i < NUM_BEGIN_SLOTS; i++) {
+      const uint32_t index = (hint + i) % NUM_BEGIN_SLOTS;
+      std::atomic<timestamp_t> &slot = begin_slots_[index].start_;
+      timestamp_t expected = INVALID_TXN_TIMESTAMP;
+      if (slot.load(std::memory_order_relaxed) == INVALID_TXN_TIMESTAMP &&
+          slot.compare_exchange_strong(expected, time_.load())) {
+        hint = index;
+        return &slot;
+      }
+    }
+  }
+}
+
 void TimestampManager::RemoveTransaction(timestamp_t timestamp) {
-  common::SpinLatch::ScopedSpinLatch guard(&curr_running_txns_latch_);
-  const size_t ret UNUSED_ATTRIBUTE = curr_running_txns_.erase(timestamp);
+  RunningTxnShard &shard = ShardOf(timestamp);
+  common::SpinLatch::ScopedSpinLatch guard(&shard.latch_);
+  const size_t ret UNUSED_ATTRIBUTE = shard.txns_.erase(timestamp);
   TERRIER_ASSERT(ret == 1, "erased timestamp did not exist");
 }
 
 void TimestampManager::RemoveTransactions(const std::vector<terrier::transaction::timestamp_t> &timestamps) {
-  common::SpinLatch::ScopedSpinLatch guard(&curr_running_txns_latch_);
-  for (const auto &timestamp : timestamps) {
-    const size_t ret UNUSED_ATTRIBUTE = curr_running_txns_.erase(timestamp);
-    TERRIER_ASSERT(ret == 1, "erased timestamp did not exist");
+  std::array<std::vector<timestamp_t>, NUM_RUNNING_TXN_SHARDS> by_shard;
+  for (const auto &timestamp : timestamps) by_shard[!timestamp % NUM_RUNNING_TXN_SHARDS].push_back(timestamp);
+  for (uint32_t i = 0; i < NUM_RUNNING_TXN_SHARDS; i++) {
+    if (by_shard[i].empty()) continue;
+    RunningTxnShard &shard = running_txns_[i];
+    common::SpinLatch::ScopedSpinLatch guard(&shard.latch_);
+    for (const auto &timestamp : by_shard[i]) {
+      const size_t ret UNUSED_ATTRIBUTE = shard.txns_.erase(timestamp);
+      TERRIER_ASSERT(ret == 1, "erased timestamp did not exist");
+    }
   }
 }
 
@@ -8,7 +8,7 @@
 #include "metrics/metrics_store.h"
 
 namespace terrier::transaction {
-TransactionContext *TransactionManager::BeginTransaction() {
+TransactionContext *TransactionManager::BeginTransaction(const bool read_only) {
   timestamp_t start_time;
   TransactionContext *result;
 
@@ -19,7 +19,8 @@ TransactionContext *TransactionManager::BeginTransaction() {
   // start the operating unit resource tracker
   if (txn_metrics_enabled) common::thread_context.resource_tracker_.Start();
   start_time = timestamp_manager_->BeginTransaction();
-  result = new TransactionContext(start_time, start_time + INT64_MIN, buffer_pool_, log_manager_);
+  result = new TransactionContext(start_time, start_time + INT64_MIN, buffer_pool_, log_manager_, read_only);
+  result->timestamp_manager_ = timestamp_manager_;
   // Ensure we do not return from this function if there are ongoing write commits
   txn_gate_.Traverse();
 
@@ -42,7 +43,7 @@ void TransactionManager::LogCommit(TransactionContext *const txn, const timestam
     byte *const commit_record = txn->redo_buffer_.NewEntry(storage::CommitRecord::Size());
     storage::CommitRecord::Initialize(commit_record, txn->StartTime(), commit_time, commit_callback,
                                       commit_callback_arg, oldest_active_txn, txn->IsReadOnly(), txn,
-                                      timestamp_manager_.Get());
+                                      timestamp_manager_.Get(), txn->SynchronousCommit());
   } else {
     // Otherwise, logging is disabled. We should pretend to have serialized and flushed the record so the rest of the
     // system proceeds correctly
@@ -52,7 +53,10 @@ void TransactionManager::LogCommit(TransactionContext *const txn, const timestam
   txn->redo_buffer_.Finalize(true);
 }
 
-timestamp_t TransactionManager::UpdatingCommitCriticalSection(TransactionContext *const txn) {
+timestamp_t TransactionManager::UpdatingCommitCriticalSection(TransactionContext *const txn,
+                                                              const callback_fn commit_callback,
+                                                              void *const commit_callback_arg,
+                                                              const timestamp_t oldest_active_txn) {
   // WARNING: This operation has to happen appear atomic to new transactions:
   // transaction 1        transaction 2
   //   begin
@@ -72,6 +76,11 @@ timestamp_t TransactionManager::UpdatingCommitCriticalSection(TransactionContext
 
   // flip all timestamps to be committed
   for (auto &it : txn->undo_buffer_) it.Timestamp().store(commit_time);
+
+  // Txns that begin after this see the commit, and may log their own commits to another log stream. Our commit record
+  // has to be handed to the log before they begin, so that theirs are not made durable without it (see
+  // storage::CommitWatermark).
+  if (log_manager_ != DISABLED) LogCommit(txn, commit_time, commit_callback, commit_callback_arg, oldest_active_txn);
   return commit_time;
 }
 
@@ -88,7 +97,27 @@ timestamp_t TransactionManager::Commit(TransactionContext *const txn, transactio
   TERRIER_ASSERT(!txn->must_abort_,
                  "This txn was marked that it must abort. Set a breakpoint at TransactionContext::MustAbort() to see a "
                  "stack trace for when this flag is getting tripped.");
-  result = txn->IsReadOnly() ? timestamp_manager_->CheckOutTimestamp() : UpdatingCommitCriticalSection(txn);
+  TERRIER_ASSERT(!txn->IsDeclaredReadOnly() || txn->IsReadOnly(), "Read-only transactions cannot write");
+  const bool read_only = txn->IsReadOnly();
+  const bool synchronous_commit = txn->SynchronousCommit();
+  // A txn begun as read-only has seen nothing newer than its start time, so it can just as well commit as of it
+  const bool fast_path = txn->IsDeclaredReadOnly() && read_only;
+
+  // If logging is enabled and our txn is not read only, we need to persist the oldest active txn at the time we
+  // committed. This will allow us to correctly order and execute transactions during recovery.
+  timestamp_t oldest_active_txn = INVALID_TXN_TIMESTAMP;
+  if (log_manager_ != DISABLED && !read_only) {
+    // TODO(Gus): Getting the cached timestamp may cause replication delays, as the cached timestamp is a stale value,
+    // so transactions may wait for longer than they need to. We should analyze the impact of this when replication is
+    // added.
+    oldest_active_txn = timestamp_manager_->CachedOldestTransactionStartTime();
+  }
+
+  if (fast_path)
+    result = txn->StartTime();
+  else
+    result = read_only ? timestamp_manager_->CheckOutTimestamp()
+                       : UpdatingCommitCriticalSection(txn, callback, callback_arg, oldest_active_txn);
 
   txn->finish_time_.store(result);
 
@@ -98,30 +127,30 @@ timestamp_t TransactionManager::Commit(TransactionContext *const txn, transactio
     txn->commit_actions_.pop_front();
   }
 
-  // If logging is enabled and our txn is not read only, we need to persist the oldest active txn at the time we
-  // committed. This will allow us to correctly order and execute transactions during recovery.
-  timestamp_t oldest_active_txn = INVALID_TXN_TIMESTAMP;
-  if (log_manager_ != DISABLED && !txn->IsReadOnly()) {
-    // TODO(Gus): Getting the cached timestamp may cause replication delays, as the cached timestamp is a stale value,
-    // so transactions may wait for longer than they need to. We should analyze the impact of this when replication is
-    // added.
-    oldest_active_txn = timestamp_manager_->CachedOldestTransactionStartTime();
+  if (fast_path) {
+    // There is nothing to make durable, so the commit is complete right away
+    EndReadOnly(txn);
+    callback(callback_arg);
+    if (txn_metrics_enabled) {
+      common::thread_context.resource_tracker_.Stop();
+      auto &resource_metrics = common::thread_context.resource_tracker_.GetMetrics();
+      common::thread_context.metrics_store_->RecordCommitData(
+          static_cast<uint64_t>(read_only), static_cast<uint64_t>(synchronous_commit), resource_metrics);
+    }
+    return result;
   }
-  LogCommit(txn, result, callback, callback_arg, oldest_active_txn);
+
+  // An updating txn has already logged its commit in the critical section, unless logging is off
+  if (read_only || log_manager_ == DISABLED) LogCommit(txn, result, callback, callback_arg, oldest_active_txn);
 
   // We hand off txn to GC, however, it won't be GC'd until the LogManager marks it as serialized
-  if (gc_enabled_) {
-    common::SpinLatch::ScopedSpinLatch guard(&timestamp_manager_->curr_running_txns_latch_);
-    // It is not necessary to have to GC process read-only transactions, but it's probably faster to call free off
-    // the critical path there anyway
-    // Also note here that GC will figure out what varlen entries to GC, as opposed to in the abort case.
-    completed_txns_.push_front(txn);
-  }
+  if (gc_enabled_) HandOffToGC(txn);
 
   if (txn_metrics_enabled) {
     common::thread_context.resource_tracker_.Stop();
     auto &resource_metrics = common::thread_context.resource_tracker_.GetMetrics();
-    common::thread_context.metrics_store_->RecordCommitData(static_cast<uint64_t>(txn->IsReadOnly()), resource_metrics);
+    common::thread_context.metrics_store_->RecordCommitData(
+        static_cast<uint64_t>(read_only), static_cast<uint64_t>(synchronous_commit), resource_metrics);
   }
 
   return result;
@@ -160,6 +189,15 @@ timestamp_t TransactionManager::Abort(TransactionContext *const txn) {
     txn->abort_actions_.pop_front();
   }
 
+  if (txn->IsDeclaredReadOnly() && txn->IsReadOnly()) {
+    // There is nothing to roll back, and no one else can have seen the txn
+    const timestamp_t abort_time = txn->StartTime();
+    txn->finish_time_.store(abort_time);
+    txn->aborted_ = true;
+    EndReadOnly(txn);
+    return abort_time;
+  }
+
   // We need to beware not to rollback a version chain multiple times, as that is just wasted computation
   std::unordered_set<storage::TupleSlot> slots_rolled_back;
   for (auto &record : txn->undo_buffer_) {
@@ -187,17 +225,35 @@ timestamp_t TransactionManager::Abort(TransactionContext *const txn) {
   LogAbort(txn);
 
   // We hand off txn to GC, however, it won't be GC'd until the LogManager marks it as serialized
-  if (gc_enabled_) {
-    common::SpinLatch::ScopedSpinLatch guard(&timestamp_manager_->curr_running_txns_latch_);
-    // It is not necessary to have to GC process read-only transactions, but it's probably faster to call free off
-    // the critical path there anyway
-    // Also note here that GC will figure out what varlen entries to GC, as opposed to in the abort case.
-    completed_txns_.push_front(txn);
-  }
+  if (gc_enabled_) HandOffToGC(txn);
 
   return abort_time;
 }
 
+void TransactionManager::EndReadOnly(TransactionContext *const txn) {
+  // The txn has no undo records for others to reach, and nothing that has to wait for the log, so once it stops
+  // counting as running no one can be referring to it anymore
+  txn->redo_buffer_.Finalize(false);
+  timestamp_manager_->RemoveTransaction(txn->StartTime());
+  delete txn;
+}
+
+void TransactionManager::HandOffToGC(TransactionContext *const txn) {
+  // Size up the txn outside of the critical section
+  const uint64_t undo_bytes = txn->undo_buffer_.Size();
+  const uint64_t num_version_walks = txn->num_version_walks_.load(std::memory_order_relaxed);
+  const uint64_t num_versions_walked = txn->num_versions_walked_.load(std::memory_order_relaxed);
+  common::SpinLatch::ScopedSpinLatch guard(&completed_txns_latch_);
+  // It is not necessary to have to GC process read-only transactions, but it's probably faster to call free off
+  // the critical path there anyway
+  // Also note here that GC will figure out what varlen entries to GC, as opposed to in the abort case.
+  completed_txns_.push_front(txn);
+  gc_queue_txns_.fetch_add(1, std::memory_order_relaxed);
+  gc_queue_undo_bytes_.fetch_add(undo_bytes, std::memory_order_relaxed);
+  gc_queue_version_walks_.fetch_add(num_version_walks, std::memory_order_relaxed);
+  gc_queue_versions_walked_.fetch_add(num_versions_walked, std::memory_order_relaxed);
+}
+
 void TransactionManager::GCLastUpdateOnAbort(TransactionContext *const txn) {
   auto *last_log_record = reinterpret_cast<storage::LogRecord *>(txn->redo_buffer_.LastRecord());
   auto *last_undo_record = reinterpret_cast<storage::UndoRecord *>(txn->undo_buffer_.LastRecord());
@@ -233,7 +289,11 @@ void TransactionManager::GCLastUpdateOnAbort(TransactionContext *const txn) {
 }
 
 TransactionQueue TransactionManager::CompletedTransactionsForGC() {
-  common::SpinLatch::ScopedSpinLatch guard(&timestamp_manager_->curr_running_txns_latch_);
+  common::SpinLatch::ScopedSpinLatch guard(&completed_txns_latch_);
+  gc_queue_txns_.store(0, std::memory_order_relaxed);
+  gc_queue_undo_bytes_.store(0, std::memory_order_relaxed);
+  gc_queue_version_walks_.store(0, std::memory_order_relaxed);
+  gc_queue_versions_walked_.store(0, std::memory_order_relaxed);
   return std::move(completed_txns_);
 }
 
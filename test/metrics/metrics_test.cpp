@@ -99,6 +99,8 @@ TEST_F(MetricsTests, LoggingCSVTest) {
   metrics_manager_->ToCSV();
   EXPECT_EQ(aggregated_data->serializer_data_.size(), 0);
   EXPECT_EQ(aggregated_data->consumer_data_.size(), 0);
+  for (const auto num_persists : aggregated_data->persist_latency_histogram_) EXPECT_EQ(num_persists, 0);
+  for (const auto &histogram : aggregated_data->commit_latency_histograms_) EXPECT_EQ(histogram.TotalCount(), 0);
 
   Insert();
   Insert();
@@ -142,6 +144,42 @@ TEST_F(MetricsTests, LoggingCSVTest) {
                              setter_callback);
 }
 
+/**
+ *  Testing the bucketing and percentiles of latency histograms
+ */
+// NOLINTNEXTLINE
+TEST(LatencyHistogramTests, BucketTest) {
+  // Every value falls into a bucket whose bounds hold it, and which is narrow relative to the value
+  for (const uint64_t value : {UINT64_C(0), UINT64_C(1), UINT64_C(7), UINT64_C(8), UINT64_C(15), UINT64_C(16),
+                               UINT64_C(17), UINT64_C(1000), UINT64_C(123456789), UINT64_MAX}) {
+    const uint32_t bucket = LatencyHistogram::BucketOf(value);
+    ASSERT_LT(bucket, LatencyHistogram::NUM_BUCKETS);
+    EXPECT_LE(LatencyHistogram::BucketLowerBound(bucket), value);
+    EXPECT_GE(LatencyHistogram::BucketUpperBound(bucket), value);
+    EXPECT_LE(LatencyHistogram::BucketUpperBound(bucket) - LatencyHistogram::BucketLowerBound(bucket),
+              value / LatencyHistogram::SUB_BUCKETS);
+  }
+  // Buckets are contiguous
+  for (uint32_t bucket = 1; bucket < LatencyHistogram::NUM_BUCKETS; bucket++)
+    EXPECT_EQ(LatencyHistogram::BucketLowerBound(bucket), LatencyHistogram::BucketUpperBound(bucket - 1) + 1);
+
+  LatencyHistogram histogram, other;
+  EXPECT_EQ(histogram.ValueAtPercentile(99), 0);
+  for (uint64_t value = 1; value <= 99; value++) histogram.Record(value);
+  other.Record(100000);
+  histogram.Merge(&other);
+  EXPECT_EQ(other.TotalCount(), 0);
+  EXPECT_EQ(histogram.TotalCount(), 100);
+  EXPECT_EQ(histogram.ValueAtPercentile(0), 1);
+  // The median is 50, which is counted in [48, 51]
+  EXPECT_EQ(histogram.ValueAtPercentile(50), 51);
+  EXPECT_GE(histogram.ValueAtPercentile(99), 99);
+  EXPECT_LT(histogram.ValueAtPercentile(99), 100000);
+  EXPECT_GE(histogram.ValueAtPercentile(100), 100000);
+  histogram.Reset();
+  EXPECT_EQ(histogram.TotalCount(), 0);
+}
+
 /**
  *  Testing transaction metric stats collection and persistence, single thread
  */
@@ -200,4 +238,57 @@ TEST_F(MetricsTests, TransactionCSVTest) {
 
   metrics_manager_->UnregisterThread();
 }
+
+/**
+ *  Testing write conflict metric stats collection and persistence, single thread
+ */
+// NOLINTNEXTLINE
+TEST_F(MetricsTests, WriteConflictCSVTest) {
+  for (const auto &file : metrics::WriteConflictMetricRawData::FILES) unlink(std::string(file).c_str());
+  metrics_manager_->EnableMetric(MetricsComponent::WRITE_CONFLICT, 0);
+  metrics_manager_->RegisterThread();
+
+  const storage::ProjectedRowInitializer tuple_initializer =
+      sql_table_->InitializerForProjectedRow({catalog::col_oid_t(0)});
+  auto *const insert_txn = txn_manager_->BeginTransaction();
+  auto *const insert_redo =
+      insert_txn->StageWrite(CatalogTestUtil::TEST_DB_OID, CatalogTestUtil::TEST_TABLE_OID, tuple_initializer);
+  *reinterpret_cast<int32_t *>(insert_redo->Delta()->AccessForceNotNull(0)) = 15721;
+  const storage::TupleSlot slot = sql_table_->Insert(common::ManagedPointer(insert_txn), insert_redo);
+  txn_manager_->Commit(insert_txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+
+  // The first writer holds the write lock on the tuple until it commits, so the second one conflicts
+  auto *const first_txn = txn_manager_->BeginTransaction();
+  auto *const second_txn = txn_manager_->BeginTransaction();
+  auto *const first_redo =
+      first_txn->StageWrite(CatalogTestUtil::TEST_DB_OID, CatalogTestUtil::TEST_TABLE_OID, tuple_initializer);
+  *reinterpret_cast<int32_t *>(first_redo->Delta()->AccessForceNotNull(0)) = 1;
+  first_redo->SetTupleSlot(slot);
+  EXPECT_TRUE(sql_table_->Update(common::ManagedPointer(first_txn), first_redo));
+  auto *const second_redo =
+      second_txn->StageWrite(CatalogTestUtil::TEST_DB_OID, CatalogTestUtil::TEST_TABLE_OID, tuple_initializer);
+  *reinterpret_cast<int32_t *>(second_redo->Delta()->AccessForceNotNull(0)) = 2;
+  second_redo->SetTupleSlot(slot);
+  EXPECT_FALSE(sql_table_->Update(common::ManagedPointer(second_txn), second_redo));
+  txn_manager_->Commit(first_txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  txn_manager_->Abort(second_txn);
+
+  metrics_manager_->Aggregate();
+  const auto aggregated_data = reinterpret_cast<WriteConflictMetricRawData *>(
+      metrics_manager_->AggregatedMetrics().at(static_cast<uint8_t>(MetricsComponent::WRITE_CONFLICT)).get());
+  EXPECT_NE(aggregated_data, nullptr);
+  EXPECT_EQ(aggregated_data->table_data_.size(), 1);
+  const auto &table = aggregated_data->table_data_.begin()->second;
+  EXPECT_EQ(table.num_writes_, 2);
+  EXPECT_EQ(table.num_conflicts_, 1);
+  EXPECT_EQ(table.num_not_visible_, 0);
+  EXPECT_EQ(table.slot_conflicts_.size(), 1);
+  EXPECT_EQ(table.slot_conflicts_.begin()->first.first, reinterpret_cast<uintptr_t>(slot.GetBlock()));
+  EXPECT_EQ(table.slot_conflicts_.begin()->first.second, slot.GetOffset());
+  metrics_manager_->ToCSV();
+  EXPECT_TRUE(aggregated_data->table_data_.empty());
+
+  metrics_manager_->DisableMetric(MetricsComponent::WRITE_CONFLICT);
+  metrics_manager_->UnregisterThread();
+}
 }  // namespace terrier::metrics
@@ -1272,6 +1272,53 @@ TEST_F(ParserTestBase, OldTransactionTest) {
   EXPECT_EQ(transac_stmt->GetTransactionType(), TransactionStatement::kRollback);
 }
 
+// NOLINTNEXTLINE
+TEST_F(ParserTestBase, ReadOnlyTransactionTest) {
+  std::string query = "BEGIN READ ONLY;";
+  auto result = parser::PostgresParser::BuildParseTree(query);
+  auto transac_stmt = result->GetStatement(0).CastManagedPointerTo<TransactionStatement>();
+  EXPECT_EQ(transac_stmt->GetTransactionType(), TransactionStatement::kBegin);
+  EXPECT_TRUE(transac_stmt->IsReadOnly());
+
+  query = "BEGIN TRANSACTION ISOLATION LEVEL SERIALIZABLE READ ONLY;";
+  result = parser::PostgresParser::BuildParseTree(query);
+  transac_stmt = result->GetStatement(0).CastManagedPointerTo<TransactionStatement>();
+  EXPECT_TRUE(transac_stmt->IsReadOnly());
+
+  query = "BEGIN READ WRITE;";
+  result = parser::PostgresParser::BuildParseTree(query);
+  transac_stmt = result->GetStatement(0).CastManagedPointerTo<TransactionStatement>();
+  EXPECT_FALSE(transac_stmt->IsReadOnly());
+
+  query = "BEGIN;";
+  result = parser::PostgresParser::BuildParseTree(query);
+  transac_stmt = result->GetStatement(0).CastManagedPointerTo<TransactionStatement>();
+  EXPECT_FALSE(transac_stmt->IsReadOnly());
+}
+
+// NOLINTNEXTLINE
+TEST_F(ParserTestBase, VariableSetTest) {
+  std::string query = "SET synchronous_commit = off;";
+  auto result = parser::PostgresParser::BuildParseTree(query);
+  auto set_stmt = result->GetStatement(0).CastManagedPointerTo<VariableSetStatement>();
+  EXPECT_EQ(set_stmt->GetType(), StatementType::VARIABLE_SET);
+  EXPECT_EQ(set_stmt->GetName(), "synchronous_commit");
+  EXPECT_EQ(set_stmt->GetValue(), "off");
+  EXPECT_FALSE(set_stmt->IsLocal());
+
+  query = "SET LOCAL synchronous_commit TO on;";
+  result = parser::PostgresParser::BuildParseTree(query);
+  set_stmt = result->GetStatement(0).CastManagedPointerTo<VariableSetStatement>();
+  EXPECT_EQ(set_stmt->GetValue(), "on");
+  EXPECT_TRUE(set_stmt->IsLocal());
+
+  query = "RESET synchronous_commit;";
+  result = parser::PostgresParser::BuildParseTree(query);
+  set_stmt = result->GetStatement(0).CastManagedPointerTo<VariableSetStatement>();
+  EXPECT_EQ(set_stmt->GetName(), "synchronous_commit");
+  EXPECT_TRUE(set_stmt->GetValue().empty());
+}
+
 // NOLINTNEXTLINE
 TEST_F(ParserTestBase, OldCreateIndexTest) {
   std::string query = "CREATE UNIQUE INDEX IDX_ORDER ON oorder (O_W_ID, O_D_ID);";
@@ -57,6 +57,72 @@ TEST(AccessObserverTest, FilledBlocksObserved) {
   for (uint32_t i = 0; i <= COLD_DATA_EPOCH_THRESHOLD; i++) tested.ObserveGCInvocation();
   delete fake_block;
 }
+
+// Tests that blocks of a pinned table are never sent to the compactor until the table is unpinned
+// NOLINTNEXTLINE
+TEST(AccessObserverTest, PinnedTableNotObserved) {
+  std::default_random_engine generator;
+  storage::BlockLayout layout = StorageTestUtil::RandomLayoutNoVarlen(100, &generator);
+  storage::TupleAccessStrategy accessor(layout);
+  storage::DataTable table(nullptr, layout, storage::layout_version_t(0));
+  auto *fake_block = new storage::RawBlock;
+  accessor.InitializeRawBlock(&table, fake_block, storage::layout_version_t(0));
+
+  MockBlockCompactor mock_compactor;
+  EXPECT_CALL(mock_compactor, PutInQueue(::testing::_)).Times(0);
+  storage::AccessObserver tested(&mock_compactor);
+  tested.PinHot(&table);
+
+  fake_block->insert_head_ = layout.NumSlots();
+  tested.ObserveWrite(fake_block);
+  for (uint32_t i = 0; i <= 2 * COLD_DATA_EPOCH_THRESHOLD; i++) tested.ObserveGCInvocation();
+  ::testing::Mock::VerifyAndClearExpectations(&mock_compactor);
+
+  // The block has been cold for long enough, and goes out as soon as the table is unpinned
+  // NOLINTNEXTLINE
+  EXPECT_CALL(mock_compactor, PutInQueue(fake_block)).Times(1);
+  tested.UnpinHot(&table);
+  tested.ObserveGCInvocation();
+  EXPECT_EQ(tested.GetStatistics().num_blocks_cooled_, 1);
+  delete fake_block;
+}
+
+// Tests that a block written to right after being sent to the compactor makes its table wait longer next time
+// NOLINTNEXTLINE
+TEST(AccessObserverTest, WastedCompactionBacksOff) {
+  std::default_random_engine generator;
+  storage::BlockLayout layout = StorageTestUtil::RandomLayoutNoVarlen(100, &generator);
+  storage::TupleAccessStrategy accessor(layout);
+  storage::DataTable table(nullptr, layout, storage::layout_version_t(0));
+  auto *fake_block = new storage::RawBlock;
+  accessor.InitializeRawBlock(&table, fake_block, storage::layout_version_t(0));
+
+  MockBlockCompactor mock_compactor;
+  // NOLINTNEXTLINE
+  EXPECT_CALL(mock_compactor, PutInQueue(fake_block)).Times(1);
+  storage::AccessObserver tested(&mock_compactor);
+
+  fake_block->insert_head_ = layout.NumSlots();
+  tested.ObserveWrite(fake_block);
+  for (uint32_t i = 0; i <= COLD_DATA_EPOCH_THRESHOLD; i++) tested.ObserveGCInvocation();
+  ::testing::Mock::VerifyAndClearExpectations(&mock_compactor);
+
+  // The block is written to again right away, so the table backs off
+  tested.ObserveWrite(fake_block);
+  auto statistics = tested.GetStatistics();
+  EXPECT_EQ(statistics.num_blocks_thawed_, 1);
+  EXPECT_EQ(statistics.num_wasted_compactions_, 1);
+  EXPECT_EQ(tested.ColdThreshold(&table), 2 * COLD_DATA_EPOCH_THRESHOLD);
+
+  // The old threshold is no longer enough
+  EXPECT_CALL(mock_compactor, PutInQueue(fake_block)).Times(0);
+  for (uint32_t i = 0; i <= COLD_DATA_EPOCH_THRESHOLD; i++) tested.ObserveGCInvocation();
+  ::testing::Mock::VerifyAndClearExpectations(&mock_compactor);
+  // NOLINTNEXTLINE
+  EXPECT_CALL(mock_compactor, PutInQueue(fake_block)).Times(1);
+  for (uint32_t i = 0; i < COLD_DATA_EPOCH_THRESHOLD; i++) tested.ObserveGCInvocation();
+  delete fake_block;
+}
 }  // namespace terrier
 
 int main(int argc, char **argv) {
@@ -1,6 +1,7 @@
 #include "storage/block_compactor.h"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/hash_util.h"
@@ -387,4 +388,80 @@ TEST_F(BlockCompactorTest, DictionaryCompressionTest) {
   }
 }
 
+// This test compacts several sparsely populated blocks of the same table together on a worker pool. It then verifies
+// that the tuples end up in a single block, and that the emptied blocks are removed from the table.
+// NOLINTNEXTLINE
+TEST_F(BlockCompactorTest, MultiBlockCompactionTest) {
+  const uint32_t num_blocks = 4, keep_every = 8;
+  storage::BlockLayout layout = StorageTestUtil::RandomLayoutNoVarlen(100, &generator_);
+  storage::DataTable table(common::ManagedPointer<storage::BlockStore>(&block_store_), layout,
+                           storage::layout_version_t(0));
+
+  transaction::TimestampManager timestamp_manager;
+  transaction::DeferredActionManager deferred_action_manager{common::ManagedPointer(&timestamp_manager)};
+  transaction::TransactionManager txn_manager{common::ManagedPointer(&timestamp_manager),
+                                              common::ManagedPointer(&deferred_action_manager),
+                                              common::ManagedPointer(&buffer_pool_), true, DISABLED};
+  storage::GarbageCollector gc{common::ManagedPointer(&timestamp_manager),
+                               common::ManagedPointer(&deferred_action_manager), common::ManagedPointer(&txn_manager),
+                               DISABLED};
+
+  // Fill up the blocks, then delete most of the tuples
+  auto initializer =
+      storage::ProjectedRowInitializer::Create(layout, StorageTestUtil::ProjectionListAllColumns(layout));
+  byte *buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedRowSize());
+  auto *row = initializer.InitializeRow(buffer);
+  std::vector<storage::TupleSlot> slots;
+  std::vector<storage::RawBlock *> blocks;
+  transaction::TransactionContext *txn = txn_manager.BeginTransaction();
+  for (uint32_t i = 0; i < num_blocks * layout.NumSlots(); i++) {
+    StorageTestUtil::PopulateRandomRow(row, layout, 0.1, &generator_);
+    slots.push_back(table.Insert(common::ManagedPointer(txn), *row));
+    if (blocks.empty() || blocks.back() != slots.back().GetBlock()) blocks.push_back(slots.back().GetBlock());
+  }
+  txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  ASSERT_EQ(blocks.size(), num_blocks);
+  txn = txn_manager.BeginTransaction();
+  uint32_t num_kept = 0;
+  for (uint32_t i = 0; i < slots.size(); i++) {
+    if (i % keep_every == 0)
+      num_kept++;
+    else
+      EXPECT_TRUE(table.Delete(common::ManagedPointer(txn), slots[i]));
+  }
+  txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  // Prune the versions and reclaim the deleted slots
+  gc.PerformGarbageCollection();
+  gc.PerformGarbageCollection();
+
+  storage::BlockCompactor compactor(2, num_blocks, 1.0);
+  for (storage::RawBlock *block : blocks) compactor.PutInQueue(block);
+  compactor.ProcessCompactionQueue(&deferred_action_manager, &txn_manager);
+  // The emptied blocks leave the table over the next couple of GC runs
+  for (uint32_t i = 0; i < 4; i++) gc.PerformGarbageCollection();
+
+  std::unordered_set<storage::RawBlock *> remaining_blocks;
+  uint32_t num_visible = 0;
+  txn = txn_manager.BeginTransaction();
+  for (auto it = table.begin(); it != table.end(); it++) {
+    remaining_blocks.insert(it->GetBlock());
+    if (table.Select(common::ManagedPointer(txn), *it, row)) num_visible++;
+  }
+  txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  EXPECT_EQ(num_visible, num_kept);
+  ASSERT_EQ(remaining_blocks.size(), 1);
+
+  // What is left can now be frozen
+  storage::RawBlock *block = *remaining_blocks.begin();
+  EXPECT_EQ(block->controller_.GetBlockState()->load(), storage::BlockState::COOLING);
+  gc.PerformGarbageCollection();
+  compactor.PutInQueue(block);
+  compactor.ProcessCompactionQueue(&deferred_action_manager, &txn_manager);
+  EXPECT_EQ(block->controller_.GetBlockState()->load(), storage::BlockState::FROZEN);
+
+  delete[] buffer;
+  gc.PerformGarbageCollection();
+  gc.PerformGarbageCollection();  // Second call to deallocate.
+}
+
 }  // namespace terrier
@@ -0,0 +1,132 @@
+#include <unordered_map>
+#include <vector>
+
+#include "storage/block_access_controller.h"
+#include "storage/block_compactor.h"
+#include "storage/block_eviction_manager.h"
+#include "storage/garbage_collector.h"
+#include "storage/storage_defs.h"
+#include "storage/tuple_access_strategy.h"
+#include "test_util/storage_test_util.h"
+#include "test_util/test_harness.h"
+#include "transaction/deferred_action_manager.h"
+
+#define BLOCK_FILE_NAME "test_evicted_blocks"
+
+namespace terrier {
+
+struct BlockEvictionManagerTest : public ::terrier::TerrierTest {
+  storage::BlockStore block_store_{5000, 5000};
+  std::default_random_engine generator_;
+  storage::RecordBufferSegmentPool buffer_pool_{100000, 100000};
+  double percent_empty_ = 0.5;
+};
+
+// NOLINTNEXTLINE
+TEST_F(BlockEvictionManagerTest, EvictAndFaultInTest) {
+  storage::BlockLayout layout = StorageTestUtil::RandomLayoutWithVarlens(100, &generator_);
+  storage::TupleAccessStrategy accessor(layout);
+
+  transaction::TimestampManager timestamp_manager;
+  transaction::DeferredActionManager deferred_action_manager{common::ManagedPointer(&timestamp_manager)};
+  transaction::TransactionManager txn_manager{common::ManagedPointer(&timestamp_manager),
+                                              common::ManagedPointer(&deferred_action_manager),
+                                              common::ManagedPointer(&buffer_pool_), true, DISABLED};
+  storage::GarbageCollector gc{common::ManagedPointer(&timestamp_manager),
+                               common::ManagedPointer(&deferred_action_manager), common::ManagedPointer(&txn_manager),
+                               DISABLED};
+  // No cold block is allowed to stay in memory. The table tells the manager about its blocks when it goes away, so the
+  // manager needs to outlive it.
+  storage::BlockEvictionManager eviction_manager{common::ManagedPointer(&deferred_action_manager), BLOCK_FILE_NAME, 0};
+  storage::DataTable table(common::ManagedPointer<storage::BlockStore>(&block_store_), layout,
+                           storage::layout_version_t(0));
+  storage::RawBlock *block = table.begin()->GetBlock();
+  accessor.InitializeRawBlock(&table, block, storage::layout_version_t(0));
+  auto tuples = StorageTestUtil::PopulateBlockRandomly(&table, block, percent_empty_, &generator_);
+
+  // Mix both kinds of varlen columns in the same block
+  auto &arrow_metadata = accessor.GetArrowBlockMetadata(block);
+  bool dictionary_compressed = false;
+  for (storage::col_id_t col_id : layout.AllColumns()) {
+    if (layout.IsVarlen(col_id)) {
+      arrow_metadata.GetColumnInfo(layout, col_id).Type() = dictionary_compressed
+                                                                 ? storage::ArrowColumnType::DICTIONARY_COMPRESSED
+                                                                 : storage::ArrowColumnType::GATHERED_VARLEN;
+      dictionary_compressed = !dictionary_compressed;
+    } else {
+      arrow_metadata.GetColumnInfo(layout, col_id).Type() = storage::ArrowColumnType::FIXED_LENGTH;
+    }
+  }
+
+  storage::BlockCompactor compactor;
+  compactor.PutInQueue(block);
+  compactor.ProcessCompactionQueue(&deferred_action_manager, &txn_manager);  // compaction pass
+  gc.PerformGarbageCollection();
+  compactor.PutInQueue(block);
+  compactor.ProcessCompactionQueue(&deferred_action_manager, &txn_manager);  // gathering pass
+  ASSERT_EQ(block->controller_.GetBlockState()->load(), storage::BlockState::FROZEN);
+
+  // Take a deep copy of the block's contents, as its varlen buffers go away on eviction
+  auto initializer =
+      storage::ProjectedRowInitializer::Create(layout, StorageTestUtil::ProjectionListAllColumns(layout));
+  byte *buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedRowSize());
+  auto *read_row = initializer.InitializeRow(buffer);
+  std::unordered_map<uint32_t, storage::ProjectedRow *> expected_rows;
+  transaction::TransactionContext *txn = txn_manager.BeginTransaction();
+  for (uint32_t offset = 0; offset < layout.NumSlots(); offset++) {
+    if (table.Select(common::ManagedPointer(txn), {block, offset}, read_row))
+      expected_rows[offset] = StorageTestUtil::ProjectedRowDeepCopy(layout, *read_row);
+  }
+  txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  EXPECT_EQ(expected_rows.size(), tuples.size());
+
+  // The block is only marked on the first pass, as transactions may still be reading it
+  eviction_manager.AddCandidate(block);
+  EXPECT_EQ(eviction_manager.ProcessEvictionQueue(), 0);
+  EXPECT_EQ(block->controller_.GetBlockState()->load(), storage::BlockState::EVICTING);
+  gc.PerformGarbageCollection();
+  gc.PerformGarbageCollection();
+  EXPECT_EQ(eviction_manager.ProcessEvictionQueue(), 1);
+  EXPECT_EQ(block->controller_.GetBlockState()->load(), storage::BlockState::EVICTED);
+  EXPECT_EQ(eviction_manager.NumEvictedBlocks(), 1);
+
+  // Reading from the block brings it back in
+  txn = txn_manager.BeginTransaction();
+  for (uint32_t offset = 0; offset < layout.NumSlots(); offset++) {
+    bool visible = table.Select(common::ManagedPointer(txn), {block, offset}, read_row);
+    auto it = expected_rows.find(offset);
+    EXPECT_EQ(visible, it != expected_rows.end());
+    if (visible && it != expected_rows.end())
+      EXPECT_TRUE(StorageTestUtil::ProjectionListEqualDeep(layout, it->second, read_row));
+  }
+  txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  EXPECT_EQ(block->controller_.GetBlockState()->load(), storage::BlockState::FROZEN);
+  EXPECT_EQ(eviction_manager.NumEvictedBlocks(), 0);
+
+  // The block is still cold, so it gets marked again. An access before the grace period ends calls off the eviction.
+  EXPECT_EQ(eviction_manager.ProcessEvictionQueue(), 0);
+  EXPECT_EQ(block->controller_.GetBlockState()->load(), storage::BlockState::EVICTING);
+  txn = txn_manager.BeginTransaction();
+  table.Select(common::ManagedPointer(txn), {block, 0}, read_row);
+  txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  EXPECT_EQ(block->controller_.GetBlockState()->load(), storage::BlockState::FROZEN);
+  gc.PerformGarbageCollection();
+  gc.PerformGarbageCollection();
+  EXPECT_EQ(eviction_manager.ProcessEvictionQueue(), 0);
+  EXPECT_EQ(eviction_manager.NumEvictedBlocks(), 0);
+
+  delete[] buffer;
+  for (auto &entry : expected_rows) {
+    for (uint16_t i = 0; i < entry.second->NumColumns(); i++) {
+      if (!layout.IsVarlen(entry.second->ColumnIds()[i])) continue;
+      auto *varlen = reinterpret_cast<storage::VarlenEntry *>(entry.second->AccessWithNullCheck(i));
+      if (varlen != nullptr && varlen->NeedReclaim()) delete[] varlen->Content();
+    }
+    delete[] reinterpret_cast<byte *>(entry.second);
+  }
+  for (auto &entry : tuples) delete[] reinterpret_cast<byte *>(entry.second);  // reclaim memory used for bookkeeping
+  gc.PerformGarbageCollection();
+  gc.PerformGarbageCollection();  // Second call to deallocate.
+}
+
+}  // namespace terrier
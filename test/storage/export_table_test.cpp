@@ -341,4 +341,96 @@ TEST_F(ExportTableTest, ExportVarlenTableTest) {
   gc.PerformGarbageCollection();  // Second call to deallocate.
 }
 
+// NOLINTNEXTLINE
+TEST_F(ExportTableTest, ImportExportedTableTest) {
+  unlink(EXPORT_TABLE_NAME);
+  generator_.seed(
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+          .count());
+  storage::BlockLayout layout = StorageTestUtil::RandomLayoutWithVarlens(100, &generator_);
+  storage::TupleAccessStrategy accessor(layout);
+  storage::DataTable table(common::ManagedPointer<storage::BlockStore>(&block_store_), layout,
+                           storage::layout_version_t(0));
+  storage::RawBlock *block = table.begin()->GetBlock();
+  accessor.InitializeRawBlock(&table, block, storage::layout_version_t(0));
+
+  // Enable GC to cleanup transactions started by the block compactor
+  transaction::TimestampManager timestamp_manager;
+  transaction::DeferredActionManager deferred_action_manager{common::ManagedPointer(&timestamp_manager)};
+  transaction::TransactionManager txn_manager{common::ManagedPointer(&timestamp_manager),
+                                              common::ManagedPointer(&deferred_action_manager),
+                                              common::ManagedPointer(&buffer_pool_), true, DISABLED};
+  storage::GarbageCollector gc{common::ManagedPointer(&timestamp_manager),
+                               common::ManagedPointer(&deferred_action_manager), common::ManagedPointer(&txn_manager),
+                               DISABLED};
+  auto tuples = StorageTestUtil::PopulateBlockRandomly(&table, block, percent_empty_, &generator_);
+
+  // Mix both kinds of varlen columns in the same table
+  auto &arrow_metadata = accessor.GetArrowBlockMetadata(block);
+  std::vector<type::TypeId> column_types;
+  column_types.resize(layout.NumColumns());
+  bool dictionary_compressed = false;
+  for (storage::col_id_t col_id : layout.AllColumns()) {
+    if (layout.IsVarlen(col_id)) {
+      arrow_metadata.GetColumnInfo(layout, col_id).Type() = dictionary_compressed
+                                                                 ? storage::ArrowColumnType::DICTIONARY_COMPRESSED
+                                                                 : storage::ArrowColumnType::GATHERED_VARLEN;
+      dictionary_compressed = !dictionary_compressed;
+      column_types[!col_id] = type::TypeId::VARCHAR;
+    } else {
+      arrow_metadata.GetColumnInfo(layout, col_id).Type() = storage::ArrowColumnType::FIXED_LENGTH;
+      column_types[!col_id] = type::TypeId::INTEGER;
+    }
+  }
+
+  storage::BlockCompactor compactor;
+  compactor.PutInQueue(block);
+  compactor.ProcessCompactionQueue(&deferred_action_manager, &txn_manager);  // compaction pass
+
+  // Need to prune the version chain in order to make sure that the second pass succeeds
+  gc.PerformGarbageCollection();
+  compactor.PutInQueue(block);
+  compactor.ProcessCompactionQueue(&deferred_action_manager, &txn_manager);  // gathering pass
+
+  storage::ArrowSerializer arrow_serializer(table);
+  arrow_serializer.ExportTable(EXPORT_TABLE_NAME, &column_types);
+
+  storage::DataTable imported_table(common::ManagedPointer<storage::BlockStore>(&block_store_), layout,
+                                    storage::layout_version_t(0));
+  storage::ArrowDeserializer arrow_deserializer(&imported_table);
+  EXPECT_EQ(arrow_deserializer.ImportTable(EXPORT_TABLE_NAME), tuples.size());
+
+  auto initializer =
+      storage::ProjectedRowInitializer::Create(layout, StorageTestUtil::ProjectionListAllColumns(layout));
+  byte *expected_buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedRowSize());
+  byte *imported_buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedRowSize());
+  auto *expected_row = initializer.InitializeRow(expected_buffer);
+  auto *imported_row = initializer.InitializeRow(imported_buffer);
+  transaction::TransactionContext *txn = txn_manager.BeginTransaction();
+  // The imported block comes after the empty block every table starts with, and is laid out the same as the original
+  storage::RawBlock *empty_block = imported_table.begin()->GetBlock();
+  uint32_t num_imported_slots = 0;
+  for (auto it = imported_table.begin(); it != imported_table.end(); it++) {
+    if (it->GetBlock() == empty_block) continue;
+    num_imported_slots++;
+    EXPECT_EQ(it->GetBlock()->controller_.GetBlockState()->load(), storage::BlockState::FROZEN);
+    bool expected_visible =
+        table.Select(common::ManagedPointer(txn), storage::TupleSlot(block, it->GetOffset()), expected_row);
+    bool imported_visible = imported_table.Select(common::ManagedPointer(txn), *it, imported_row);
+    EXPECT_EQ(expected_visible, imported_visible);
+    if (expected_visible && imported_visible) {
+      EXPECT_TRUE(StorageTestUtil::ProjectionListEqualDeep(layout, expected_row, imported_row));
+    }
+  }
+  EXPECT_EQ(num_imported_slots, layout.NumSlots());
+  txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  delete[] expected_buffer;
+  delete[] imported_buffer;
+
+  unlink(EXPORT_TABLE_NAME);
+  for (auto &entry : tuples) delete[] reinterpret_cast<byte *>(entry.second);  // reclaim memory used for bookkeeping
+  gc.PerformGarbageCollection();
+  gc.PerformGarbageCollection();  // Second call to deallocate.
+}
+
 }  // namespace terrier
@@ -699,4 +699,109 @@ TEST_F(GarbageCollectorTests, InsertUpdate1) {
     EXPECT_EQ(std::make_pair(2U, 0U), gc->PerformGarbageCollection());
   }
 }
+
+// Update tuples spread over several blocks a few times, and unlink all of the versions on a pool of GC workers. Confirm
+// that the counts match those of the single-threaded GC and that every tuple still reads its latest version.
+// NOLINTNEXTLINE
+TEST_F(GarbageCollectorTests, ParallelUnlink) {
+  const uint32_t num_workers = 4;
+  const uint32_t num_tuples = 5000;
+  const uint32_t num_rounds = 3;
+  auto db_main = DBMain::Builder().SetUseGC(true).SetGCNumWorkers(num_workers).Build();
+  auto txn_manager = db_main->GetTransactionLayer()->GetTransactionManager();
+  auto gc = db_main->GetStorageLayer()->GetGarbageCollector();
+
+  GarbageCollectorDataTableTestObject tested(db_main->GetStorageLayer()->GetBlockStore().Get(), max_columns_,
+                                             &generator_);
+
+  std::vector<storage::TupleSlot> slots;
+  std::vector<storage::ProjectedRow *> latest;
+  auto *txn = txn_manager->BeginTransaction();
+  for (uint32_t i = 0; i < num_tuples; i++) {
+    latest.push_back(tested.GenerateRandomTuple(&generator_));
+    slots.push_back(tested.table_.Insert(common::ManagedPointer(txn), *latest.back()));
+  }
+  txn_manager->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  EXPECT_EQ(std::make_pair(0U, 1U), gc->PerformGarbageCollection());
+  EXPECT_EQ(std::make_pair(1U, 0U), gc->PerformGarbageCollection());
+
+  for (uint32_t round = 0; round < num_rounds; round++) {
+    txn = txn_manager->BeginTransaction();
+    for (uint32_t i = 0; i < num_tuples; i++) {
+      // A full tuple is a valid delta covering all of the columns
+      latest[i] = tested.GenerateRandomTuple(&generator_);
+      EXPECT_TRUE(tested.table_.Update(common::ManagedPointer(txn), slots[i], *latest[i]));
+    }
+    txn_manager->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  }
+
+  EXPECT_EQ(std::make_pair(0U, num_rounds), gc->PerformGarbageCollection());
+  EXPECT_EQ(std::make_pair(num_rounds, 0U), gc->PerformGarbageCollection());
+
+  txn = txn_manager->BeginTransaction();
+  for (uint32_t i = 0; i < num_tuples; i++) {
+    storage::ProjectedRow *select_tuple = tested.SelectIntoBuffer(txn, slots[i]);
+    EXPECT_TRUE(tested.select_result_);
+    EXPECT_TRUE(StorageTestUtil::ProjectionListEqualShallow(tested.Layout(), select_tuple, latest[i]));
+  }
+  txn_manager->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  EXPECT_EQ(std::make_pair(0U, 1U), gc->PerformGarbageCollection());
+}
+
+// Update a single tuple many times between GC passes, so that writers and readers prune its version chain themselves.
+// Confirm that a transaction that started before all of the updates still reads the original version, that the chain
+// does get pruned once that transaction is gone, and that the GC still processes every transaction exactly once.
+// NOLINTNEXTLINE
+TEST_F(GarbageCollectorTests, EagerVersionChainPruning) {
+  const uint32_t num_updates = 10 * storage::VERSION_CHAIN_PRUNE_THRESHOLD;
+  auto db_main = DBMain::Builder().SetUseGC(true).Build();
+  auto txn_manager = db_main->GetTransactionLayer()->GetTransactionManager();
+  auto gc = db_main->GetStorageLayer()->GetGarbageCollector();
+
+  GarbageCollectorDataTableTestObject tested(db_main->GetStorageLayer()->GetBlockStore().Get(), max_columns_,
+                                             &generator_);
+
+  auto *insert_tuple = tested.GenerateRandomTuple(&generator_);
+  auto *txn = txn_manager->BeginTransaction();
+  storage::TupleSlot slot = tested.table_.Insert(common::ManagedPointer(txn), *insert_tuple);
+  txn_manager->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  EXPECT_EQ(std::make_pair(0U, 1U), gc->PerformGarbageCollection());
+  EXPECT_EQ(std::make_pair(1U, 0U), gc->PerformGarbageCollection());
+
+  auto *old_reader = txn_manager->BeginTransaction();
+  storage::ProjectedRow *latest = insert_tuple;
+  auto update_once = [&] {
+    // A full tuple is a valid delta covering all of the columns
+    latest = tested.GenerateRandomTuple(&generator_);
+    auto *writer = txn_manager->BeginTransaction();
+    EXPECT_TRUE(tested.table_.Update(common::ManagedPointer(writer), slot, *latest));
+    txn_manager->Commit(writer, transaction::TransactionUtil::EmptyCallback, nullptr);
+  };
+  for (uint32_t i = 0; i < num_updates; i++) update_once();
+
+  // The old reader walks the whole chain, and none of it may have been cut off while it is running
+  storage::ProjectedRow *select_tuple = tested.SelectIntoBuffer(old_reader, slot);
+  EXPECT_TRUE(tested.select_result_);
+  EXPECT_TRUE(StorageTestUtil::ProjectionListEqualShallow(tested.Layout(), select_tuple, insert_tuple));
+  txn_manager->Commit(old_reader, transaction::TransactionUtil::EmptyCallback, nullptr);
+  // Performance counters are only compiled into debug builds
+#ifndef NDEBUG
+  EXPECT_EQ(0U, tested.table_.GetDataTableCounter()->GetNumVersionChainPrune());
+#endif
+
+  // With the old reader gone, writers are free to cut the chain short, without waiting for a GC pass
+  for (uint32_t i = 0; i < num_updates; i++) update_once();
+#ifndef NDEBUG
+  EXPECT_GT(tested.table_.GetDataTableCounter()->GetNumVersionChainPrune(), 0U);
+#endif
+  txn = txn_manager->BeginTransaction();
+  select_tuple = tested.SelectIntoBuffer(txn, slot);
+  EXPECT_TRUE(tested.select_result_);
+  EXPECT_TRUE(StorageTestUtil::ProjectionListEqualShallow(tested.Layout(), select_tuple, latest));
+  txn_manager->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+
+  // Pruning does not take any transactions away from the GC, read-only ones included
+  EXPECT_EQ(std::make_pair(0U, 2 * num_updates + 2), gc->PerformGarbageCollection());
+  EXPECT_EQ(std::make_pair(2 * num_updates, 0U), gc->PerformGarbageCollection());
+}
 }  // namespace terrier
@@ -0,0 +1,93 @@
+#include "storage/garbage_collector_thread.h"
+
+#include <chrono>  // NOLINT
+#include <functional>
+#include <thread>  // NOLINT
+
+#include "storage/garbage_collector.h"
+#include "test_util/storage_test_util.h"
+#include "test_util/test_harness.h"
+#include "transaction/deferred_action_manager.h"
+#include "transaction/transaction_manager.h"
+
+namespace terrier {
+
+struct GarbageCollectorThreadTests : public ::terrier::TerrierTest {
+  // Waits for the GC thread to settle on the given period, or gives up after a while
+  static bool WaitForPeriod(const storage::GarbageCollectorThread &gc_thread, const std::chrono::milliseconds period,
+                            const std::function<void()> &work) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+      if (gc_thread.GetGCPeriod() == period) return true;
+      work();
+    }
+    return false;
+  }
+
+  storage::BlockStore block_store_{100, 100};
+  storage::RecordBufferSegmentPool buffer_pool_{10000, 10000};
+  std::default_random_engine generator_;
+  const std::chrono::milliseconds min_period_{1}, max_period_{32};
+};
+
+// With no transactions going on, the GC thread backs off to the upper bound of its interval
+// NOLINTNEXTLINE
+TEST_F(GarbageCollectorThreadTests, IdleBacksOff) {
+  transaction::TimestampManager timestamp_manager;
+  transaction::DeferredActionManager deferred_action_manager{common::ManagedPointer(&timestamp_manager)};
+  transaction::TransactionManager txn_manager{common::ManagedPointer(&timestamp_manager),
+                                              common::ManagedPointer(&deferred_action_manager),
+                                              common::ManagedPointer(&buffer_pool_), true, DISABLED};
+  storage::GarbageCollector gc{common::ManagedPointer(&timestamp_manager),
+                               common::ManagedPointer(&deferred_action_manager), common::ManagedPointer(&txn_manager),
+                               DISABLED};
+  storage::GarbageCollectorThread gc_thread{common::ManagedPointer(&gc), std::chrono::milliseconds(4), DISABLED,
+                                            common::ManagedPointer(&txn_manager), min_period_, max_period_};
+
+  EXPECT_TRUE(WaitForPeriod(gc_thread, max_period_, [] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }));
+}
+
+// Readers that keep having to walk version chains make the GC thread run as often as it is allowed to
+// NOLINTNEXTLINE
+TEST_F(GarbageCollectorThreadTests, LongVersionChainsSpeedUp) {
+  transaction::TimestampManager timestamp_manager;
+  transaction::DeferredActionManager deferred_action_manager{common::ManagedPointer(&timestamp_manager)};
+  transaction::TransactionManager txn_manager{common::ManagedPointer(&timestamp_manager),
+                                              common::ManagedPointer(&deferred_action_manager),
+                                              common::ManagedPointer(&buffer_pool_), true, DISABLED};
+  storage::GarbageCollector gc{common::ManagedPointer(&timestamp_manager),
+                               common::ManagedPointer(&deferred_action_manager), common::ManagedPointer(&txn_manager),
+                               DISABLED};
+
+  storage::BlockLayout layout = StorageTestUtil::RandomLayoutNoVarlen(10, &generator_);
+  storage::DataTable table(common::ManagedPointer<storage::BlockStore>(&block_store_), layout,
+                           storage::layout_version_t(0));
+  auto initializer =
+      storage::ProjectedRowInitializer::Create(layout, StorageTestUtil::ProjectionListAllColumns(layout));
+  byte *buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedRowSize());
+  storage::ProjectedRow *row = initializer.InitializeRow(buffer);
+  StorageTestUtil::PopulateRandomRow(row, layout, 0, &generator_);
+
+  auto *txn = txn_manager.BeginTransaction();
+  const storage::TupleSlot slot = table.Insert(common::ManagedPointer(txn), *row);
+  txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+
+  {
+    storage::GarbageCollectorThread gc_thread{common::ManagedPointer(&gc), max_period_, DISABLED,
+                                              common::ManagedPointer(&txn_manager), min_period_, max_period_};
+    EXPECT_TRUE(WaitForPeriod(gc_thread, min_period_, [&] {
+      // Every read has to walk past the updates made since it started
+      auto *reader = txn_manager.BeginTransaction();
+      for (uint32_t i = 0; i < storage::VERSION_CHAIN_PRUNE_THRESHOLD / 2; i++) {
+        auto *writer = txn_manager.BeginTransaction();
+        EXPECT_TRUE(table.Update(common::ManagedPointer(writer), slot, *row));
+        txn_manager.Commit(writer, transaction::TransactionUtil::EmptyCallback, nullptr);
+      }
+      EXPECT_TRUE(table.Select(common::ManagedPointer(reader), slot, row));
+      txn_manager.Commit(reader, transaction::TransactionUtil::EmptyCallback, nullptr);
+    }));
+  }
+  delete[] buffer;
+}
+
+}  // namespace terrier
@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <future>  // NOLINT
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/dedicated_thread_registry.h"
@@ -9,8 +12,10 @@
 #include "gtest/gtest.h"
 #include "main/db_main.h"
 #include "storage/projected_row.h"
+#include "storage/recovery/disk_log_provider.h"
 #include "storage/sql_table.h"
 #include "storage/storage_defs.h"
+#include "storage/write_ahead_log/log_encoding.h"
 #include "storage/write_ahead_log/log_manager.h"
 #include "test_util/catalog_test_util.h"
 #include "test_util/data_table_test_util.h"
@@ -57,13 +62,15 @@ class WriteAheadLoggingTests : public TerrierTest {
    * @warning If the serialization format of logs ever changes, this function will need to be updated.
    */
   storage::LogRecord *ReadNextRecord(storage::BufferedLogReader *in) {
-    auto size = in->ReadValue<uint32_t>();
+    auto size = static_cast<uint32_t>(in->ReadVarint());
     byte *buf = common::AllocationUtil::AllocateAligned(size);
     auto record_type = in->ReadValue<storage::LogRecordType>();
-    auto txn_begin = in->ReadValue<transaction::timestamp_t>();
+    auto txn_begin = transaction::timestamp_t(in->ReadVarint());
     if (record_type == storage::LogRecordType::COMMIT) {
-      auto txn_commit = in->ReadValue<transaction::timestamp_t>();
-      auto oldest_active_txn = in->ReadValue<transaction::timestamp_t>();
+      auto txn_commit =
+          transaction::timestamp_t(!txn_begin + static_cast<uint64_t>(LogEncoding::ZigZagDecode(in->ReadVarint())));
+      auto oldest_active_txn =
+          transaction::timestamp_t(!txn_begin - static_cast<uint64_t>(LogEncoding::ZigZagDecode(in->ReadVarint())));
 
       // Okay to fill in null since nobody will invoke the callback.
       // is_read_only argument is set to false, because we do not write out a commit record for a transaction if it is
@@ -75,8 +82,8 @@ class WriteAheadLoggingTests : public TerrierTest {
     if (record_type == storage::LogRecordType::ABORT)
       return storage::AbortRecord::Initialize(buf, txn_begin, nullptr, nullptr);
 
-    auto database_oid = in->ReadValue<catalog::db_oid_t>();
-    auto table_oid = in->ReadValue<catalog::table_oid_t>();
+    auto database_oid = catalog::db_oid_t(static_cast<uint32_t>(in->ReadVarint()));
+    auto table_oid = catalog::table_oid_t(static_cast<uint32_t>(in->ReadVarint()));
     auto tuple_slot = in->ReadValue<storage::TupleSlot>();
 
     if (record_type == storage::LogRecordType::DELETE) {
@@ -88,10 +95,13 @@ class WriteAheadLoggingTests : public TerrierTest {
 
     // Read in col_ids
     // IDs read individually since we can't guarantee memory layout of vector
-    auto num_cols = in->ReadValue<uint16_t>();
+    // The lowest bit tells whether the record has a null bitmap
+    const uint64_t num_cols_and_nulls = in->ReadVarint();
+    const bool has_nulls = (num_cols_and_nulls & 1) != 0;
+    const auto num_cols = static_cast<uint16_t>(num_cols_and_nulls >> 1);
     std::vector<storage::col_id_t> col_ids(num_cols);
     for (uint16_t i = 0; i < num_cols; i++) {
-      const auto col_id = in->ReadValue<storage::col_id_t>();
+      const auto col_id = storage::col_id_t(static_cast<uint16_t>(in->ReadVarint()));
       col_ids[i] = col_id;
     }
 
@@ -99,7 +109,7 @@ class WriteAheadLoggingTests : public TerrierTest {
     std::vector<uint16_t> attr_size_boundaries;
     attr_size_boundaries.reserve(NUM_ATTR_BOUNDARIES);
     for (uint16_t i = 0; i < NUM_ATTR_BOUNDARIES; i++) {
-      attr_size_boundaries.push_back(in->ReadValue<uint16_t>());
+      attr_size_boundaries.push_back(static_cast<uint16_t>(in->ReadVarint()));
     }
 
     // Compute attr sizes
@@ -120,7 +130,11 @@ class WriteAheadLoggingTests : public TerrierTest {
     // read in. It doesn't populate the delta's bitmap yet. This will happen naturally as we proceed column-by-column.
     auto bitmap_num_bytes = common::RawBitmap::SizeInBytes(num_cols);
     auto *bitmap_buffer = new uint8_t[bitmap_num_bytes];
-    in->Read(bitmap_buffer, bitmap_num_bytes);
+    if (has_nulls) {
+      in->Read(bitmap_buffer, bitmap_num_bytes);
+    } else {
+      std::memset(bitmap_buffer, 0xFF, bitmap_num_bytes);
+    }
     auto *bitmap = reinterpret_cast<common::RawBitmap *>(bitmap_buffer);
 
     for (uint16_t i = 0; i < num_cols; i++) {
@@ -134,7 +148,7 @@ class WriteAheadLoggingTests : public TerrierTest {
       auto *column_value_address = delta->AccessForceNotNull(i);
       if (attr_sizes[i] == AttrSizeBytes(VARLEN_COLUMN)) {
         // Read how many bytes this varlen actually is.
-        const auto varlen_attribute_size = in->ReadValue<uint32_t>();
+        const auto varlen_attribute_size = static_cast<uint32_t>(in->ReadVarint());
         // Allocate a varlen buffer of this many bytes.
         auto *varlen_attribute_content = common::AllocationUtil::AllocateAligned(varlen_attribute_size);
         // Fill the entry with the next bytes from the log file.
@@ -451,4 +465,319 @@ TEST_F(WriteAheadLoggingTests, ReadOnlyCallbackTest) {
   // DeferredAction
   db_main_->GetTransactionLayer()->GetDeferredActionManager()->RegisterDeferredAction([=]() { delete sql_table; });
 }
+
+// Tests that concurrent commits are made durable in groups without anyone forcing a flush, and that the group commit
+// window stays within its bound
+// NOLINTNEXTLINE
+TEST_F(WriteAheadLoggingTests, GroupCommitTest) {
+  const uint32_t num_threads = 8;
+  const uint32_t num_txns = 50;
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([&] {
+      for (uint32_t j = 0; j < num_txns; j++) {
+        auto *const txn = txn_manager_->BeginTransaction();
+        std::promise<bool> promise;
+        auto future = promise.get_future();
+        txn_manager_->Commit(txn, TestCommitCallback, &promise);
+        EXPECT_TRUE(future.get());
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+
+  EXPECT_LE(log_manager_->GetGroupCommitWindow(), std::chrono::microseconds(1000));
+  log_manager_->PersistAndStop();
+}
+
+// Tests that integers round trip through the compact encoding of log records, and that small ones stay small
+// NOLINTNEXTLINE
+TEST_F(WriteAheadLoggingTests, CompactEncodingTest) {
+  uint8_t encoded[LogEncoding::MAX_VARINT_SIZE];
+  for (const uint64_t value :
+       {UINT64_C(0), UINT64_C(127), UINT64_C(128), UINT64_C(300), UINT64_C(1) << 35, UINT64_MAX}) {
+    const uint32_t size = LogEncoding::EncodeVarint(value, encoded);
+    uint32_t read_head = 0;
+    EXPECT_EQ(LogEncoding::DecodeVarint([&] { return encoded[read_head++]; }), value);
+    EXPECT_EQ(read_head, size);
+  }
+  EXPECT_EQ(LogEncoding::EncodeVarint(127, encoded), 1);
+  EXPECT_EQ(LogEncoding::EncodeVarint(128, encoded), 2);
+  EXPECT_EQ(LogEncoding::EncodeVarint(UINT64_MAX, encoded), LogEncoding::MAX_VARINT_SIZE);
+
+  for (const int64_t value : {INT64_C(0), INT64_C(-1), INT64_C(1), INT64_C(-64), INT64_MIN, INT64_MAX})
+    EXPECT_EQ(LogEncoding::ZigZagDecode(LogEncoding::ZigZagEncode(value)), value);
+  EXPECT_EQ(LogEncoding::ZigZagEncode(-1), 1);
+  EXPECT_EQ(LogEncoding::ZigZagEncode(1), 2);
+}
+
+// Tests that commits are acknowledged and end up in the log when persists run in the background, and that a
+// preallocated log file reads back with nothing past the last record
+// NOLINTNEXTLINE
+TEST_F(WriteAheadLoggingTests, PersistsInFlightTest) {
+  db_main_.reset();
+  unlink(LOG_FILE_NAME);
+  db_main_ = terrier::DBMain::Builder()
+                 .SetLogFilePath(LOG_FILE_NAME)
+                 .SetLogPreallocateSize(1 << 20)
+                 .SetLogMaxPersistsInFlight(4)
+                 .SetUseLogging(true)
+                 .SetUseGC(true)
+                 .Build();
+  txn_manager_ = db_main_->GetTransactionLayer()->GetTransactionManager();
+  log_manager_ = db_main_->GetLogManager();
+  store_ = db_main_->GetStorageLayer()->GetBlockStore();
+
+  // Create SQLTable
+  auto col = catalog::Schema::Column(
+      "attribute", type::TypeId::INTEGER, false,
+      parser::ConstantValueExpression(type::TransientValueFactory::GetNull(type::TypeId::INTEGER)));
+  StorageTestUtil::ForceOid(&(col), catalog::col_oid_t(0));
+  auto table_schema = catalog::Schema(std::vector<catalog::Schema::Column>({col}));
+  auto *const sql_table = new storage::SqlTable(store_, table_schema);
+  auto tuple_initializer = sql_table->InitializerForProjectedRow({catalog::col_oid_t(0)});
+
+  const uint32_t num_threads = 8;
+  const uint32_t num_txns = 50;
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      for (uint32_t j = 0; j < num_txns; j++) {
+        auto *const txn = txn_manager_->BeginTransaction();
+        auto *const redo =
+            txn->StageWrite(CatalogTestUtil::TEST_DB_OID, CatalogTestUtil::TEST_TABLE_OID, tuple_initializer);
+        *reinterpret_cast<int32_t *>(redo->Delta()->AccessForceNotNull(0)) = static_cast<int32_t>(i * num_txns + j);
+        sql_table->Insert(common::ManagedPointer(txn), redo);
+        std::promise<bool> promise;
+        auto future = promise.get_future();
+        txn_manager_->Commit(txn, TestCommitCallback, &promise);
+        EXPECT_TRUE(future.get());
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  log_manager_->PersistAndStop();
+
+  uint32_t num_commit_records = 0;
+  storage::BufferedLogReader in(LOG_FILE_NAME);
+  while (in.HasMore()) {
+    storage::LogRecord *log_record = ReadNextRecord(&in);
+    if (log_record->RecordType() == LogRecordType::COMMIT) num_commit_records++;
+    delete[] reinterpret_cast<byte *>(log_record);
+  }
+  EXPECT_EQ(num_commit_records, num_threads * num_txns);
+
+  // the table can't be freed until after all GC on it is guaranteed to be done. The easy way to do that is to use a
+  // DeferredAction
+  db_main_->GetTransactionLayer()->GetDeferredActionManager()->RegisterDeferredAction([=]() { delete sql_table; });
+}
+
+// Tests that the log rotates into segments that can each be read on their own, and that truncation only deletes the
+// oldest segments
+// NOLINTNEXTLINE
+TEST_F(WriteAheadLoggingTests, SegmentRotationTest) {
+  db_main_.reset();
+  unlink(LOG_FILE_NAME);
+  db_main_ = terrier::DBMain::Builder()
+                 .SetLogFilePath(LOG_FILE_NAME)
+                 .SetLogSegmentSize(common::Constants::LOG_BUFFER_SIZE)
+                 .SetUseLogging(true)
+                 .SetUseGC(true)
+                 .Build();
+  txn_manager_ = db_main_->GetTransactionLayer()->GetTransactionManager();
+  log_manager_ = db_main_->GetLogManager();
+  store_ = db_main_->GetStorageLayer()->GetBlockStore();
+
+  // Create SQLTable
+  auto col = catalog::Schema::Column(
+      "attribute", type::TypeId::INTEGER, false,
+      parser::ConstantValueExpression(type::TransientValueFactory::GetNull(type::TypeId::INTEGER)));
+  StorageTestUtil::ForceOid(&(col), catalog::col_oid_t(0));
+  auto table_schema = catalog::Schema(std::vector<catalog::Schema::Column>({col}));
+  auto *const sql_table = new storage::SqlTable(store_, table_schema);
+  auto tuple_initializer = sql_table->InitializerForProjectedRow({catalog::col_oid_t(0)});
+
+  const uint32_t num_txns = 1000;
+  for (uint32_t i = 0; i < num_txns; i++) {
+    auto *const txn = txn_manager_->BeginTransaction();
+    auto *const redo =
+        txn->StageWrite(CatalogTestUtil::TEST_DB_OID, CatalogTestUtil::TEST_TABLE_OID, tuple_initializer);
+    *reinterpret_cast<int32_t *>(redo->Delta()->AccessForceNotNull(0)) = static_cast<int32_t>(i);
+    sql_table->Insert(common::ManagedPointer(txn), redo);
+    std::promise<bool> promise;
+    auto future = promise.get_future();
+    txn_manager_->Commit(txn, TestCommitCallback, &promise);
+    EXPECT_TRUE(future.get());
+  }
+  log_manager_->PersistAndStop();
+
+  // Every segment starts on a record, and only holds records of the txns its manifest entry says it does
+  const std::vector<LogSegmentManifest::Segment> segments = LogSegmentManifest(LOG_FILE_NAME).ClosedSegments();
+  ASSERT_GT(segments.size(), 2);
+  uint32_t num_commit_records = 0;
+  for (uint64_t i = 0; i <= segments.size(); i++) {
+    storage::BufferedLogReader in(LogSegmentManifest::SegmentFilePath(LOG_FILE_NAME, i).c_str());
+    while (in.HasMore()) {
+      storage::LogRecord *log_record = ReadNextRecord(&in);
+      if (i < segments.size()) {
+        EXPECT_EQ(segments[i].id_, i);
+        EXPECT_LE(segments[i].min_txn_begin_, log_record->TxnBegin());
+        EXPECT_GE(segments[i].max_txn_begin_, log_record->TxnBegin());
+      }
+      if (log_record->RecordType() == LogRecordType::COMMIT) num_commit_records++;
+      delete[] reinterpret_cast<byte *>(log_record);
+    }
+  }
+  EXPECT_EQ(num_commit_records, num_txns);
+
+  // Nothing goes if every segment holds a txn that is still needed, and the oldest segments go once they don't
+  EXPECT_EQ(log_manager_->TruncateLog(segments.front().min_txn_begin_), 0);
+  log_manager_->Start();
+  EXPECT_EQ(log_manager_->TruncateLog(transaction::timestamp_t(!segments[1].max_txn_begin_ + 1)), 2);
+  EXPECT_NE(access(LOG_FILE_NAME, F_OK), 0);
+  EXPECT_NE(access(LogSegmentManifest::SegmentFilePath(LOG_FILE_NAME, 1).c_str(), F_OK), 0);
+  LogSegmentManifest manifest(LOG_FILE_NAME);
+  EXPECT_EQ(manifest.FirstSegment(), 2);
+  EXPECT_EQ(manifest.OpenSegment(), segments.size());
+  log_manager_->PersistAndStop();
+
+  // The test table has an oid in the range of catalog tables, so the truncated segments are kept in the catalog log,
+  // which the log is read from before the segments left
+  ASSERT_EQ(manifest.CatalogLog(), 1);
+  num_commit_records = 0;
+  DiskLogProvider log_provider(LOG_FILE_NAME);
+  for (auto record = log_provider.GetNextRecord(); record.first != nullptr; record = log_provider.GetNextRecord()) {
+    if (record.first->RecordType() == LogRecordType::COMMIT) num_commit_records++;
+    delete[] reinterpret_cast<byte *>(record.first);
+  }
+  EXPECT_EQ(num_commit_records, num_txns);
+
+  for (uint64_t i = 0; i <= segments.size(); i++) unlink(LogSegmentManifest::SegmentFilePath(LOG_FILE_NAME, i).c_str());
+  unlink(LogSegmentManifest::CatalogLogFilePath(LOG_FILE_NAME, 1).c_str());
+  unlink(LogSegmentManifest::ManifestFilePath(LOG_FILE_NAME).c_str());
+
+  // the table can't be freed until after all GC on it is guaranteed to be done. The easy way to do that is to use a
+  // DeferredAction
+  db_main_->GetTransactionLayer()->GetDeferredActionManager()->RegisterDeferredAction([=]() { delete sql_table; });
+}
+
+// Tests that an asynchronous commit is acknowledged once it is serialized, and still ends up in the log
+// NOLINTNEXTLINE
+TEST_F(WriteAheadLoggingTests, AsynchronousCommitTest) {
+  // Create SQLTable
+  auto col = catalog::Schema::Column(
+      "attribute", type::TypeId::INTEGER, false,
+      parser::ConstantValueExpression(type::TransientValueFactory::GetNull(type::TypeId::INTEGER)));
+  StorageTestUtil::ForceOid(&(col), catalog::col_oid_t(0));
+  auto table_schema = catalog::Schema(std::vector<catalog::Schema::Column>({col}));
+  auto *const sql_table = new storage::SqlTable(store_, table_schema);
+  auto tuple_initializer = sql_table->InitializerForProjectedRow({catalog::col_oid_t(0)});
+
+  auto *const txn = txn_manager_->BeginTransaction();
+  txn->SetSynchronousCommit(false);
+  auto *const redo = txn->StageWrite(CatalogTestUtil::TEST_DB_OID, CatalogTestUtil::TEST_TABLE_OID, tuple_initializer);
+  *reinterpret_cast<int32_t *>(redo->Delta()->AccessForceNotNull(0)) = 1;
+  sql_table->Insert(common::ManagedPointer(txn), redo);
+
+  std::promise<bool> promise;
+  auto future = promise.get_future();
+  const transaction::timestamp_t commit_time = txn_manager_->Commit(txn, TestCommitCallback, &promise);
+  EXPECT_TRUE(future.get());
+
+  // Shut down log manager, which persists everything that was serialized
+  log_manager_->PersistAndStop();
+
+  bool found_commit_record = false;
+  storage::BufferedLogReader in(LOG_FILE_NAME);
+  while (in.HasMore()) {
+    storage::LogRecord *log_record = ReadNextRecord(&in);
+    if (log_record->RecordType() == LogRecordType::COMMIT &&
+        log_record->GetUnderlyingRecordBodyAs<storage::CommitRecord>()->CommitTime() == commit_time) {
+      found_commit_record = true;
+    }
+    delete[] reinterpret_cast<byte *>(log_record);
+  }
+  EXPECT_TRUE(found_commit_record);
+
+  // the table can't be freed until after all GC on it is guaranteed to be done. The easy way to do that is to use a
+  // DeferredAction
+  db_main_->GetTransactionLayer()->GetDeferredActionManager()->RegisterDeferredAction([=]() { delete sql_table; });
+}
+
+// Tests that varlen values of every size, including the ones written out from where they are instead of being copied
+// into the log buffers, end up in the log intact even when they are overwritten and GC'd right after
+// NOLINTNEXTLINE
+TEST_F(WriteAheadLoggingTests, ReferencedVarlenTest) {
+  // Create SQLTable
+  auto col = catalog::Schema::Column(
+      "attribute", type::TypeId::VARCHAR, 1 << 16, false,
+      parser::ConstantValueExpression(type::TransientValueFactory::GetNull(type::TypeId::VARCHAR)));
+  StorageTestUtil::ForceOid(&(col), catalog::col_oid_t(0));
+  auto table_schema = catalog::Schema(std::vector<catalog::Schema::Column>({col}));
+  auto *const sql_table = new storage::SqlTable(store_, table_schema);
+  auto tuple_initializer = sql_table->InitializerForProjectedRow({catalog::col_oid_t(0)});
+
+  // Small values are copied, large ones are referenced, some of them spanning more than a log buffer
+  const std::vector<uint32_t> sizes = {5, 100, 511, 512, 600, 5000, 20000, 50000};
+  const auto write_value = [](RedoRecord *const redo, const std::string &value) {
+    auto *const entry = reinterpret_cast<VarlenEntry *>(redo->Delta()->AccessForceNotNull(0));
+    const auto size = static_cast<uint32_t>(value.size());
+    if (size <= VarlenEntry::InlineThreshold()) {
+      *entry = VarlenEntry::CreateInline(reinterpret_cast<const byte *>(value.data()), size);
+    } else {
+      auto *const content = new byte[size];
+      std::memcpy(content, value.data(), size);
+      *entry = VarlenEntry::Create(content, size, true);
+    }
+  };
+
+  // Every tuple is inserted by one txn and overwritten by the next, in the order the values are logged
+  std::unordered_set<transaction::timestamp_t> txns;
+  std::vector<TupleSlot> slots;
+  std::vector<std::vector<std::string>> values(sizes.size());
+  for (uint32_t round = 0; round < 4; round++) {
+    auto *const txn = txn_manager_->BeginTransaction();
+    txns.insert(txn->StartTime());
+    for (uint32_t i = 0; i < sizes.size(); i++) {
+      values[i].emplace_back(sizes[i], static_cast<char>('a' + (i + round) % 26));
+      auto *const redo =
+          txn->StageWrite(CatalogTestUtil::TEST_DB_OID, CatalogTestUtil::TEST_TABLE_OID, tuple_initializer);
+      write_value(redo, values[i].back());
+      if (round == 0) {
+        slots.push_back(sql_table->Insert(common::ManagedPointer(txn), redo));
+      } else {
+        redo->SetTupleSlot(slots[i]);
+        EXPECT_TRUE(sql_table->Update(common::ManagedPointer(txn), redo));
+      }
+    }
+    std::promise<bool> promise;
+    auto future = promise.get_future();
+    txn_manager_->Commit(txn, TestCommitCallback, &promise);
+    EXPECT_TRUE(future.get());
+  }
+  log_manager_->PersistAndStop();
+
+  std::vector<uint32_t> num_read(sizes.size(), 0);
+  storage::BufferedLogReader in(LOG_FILE_NAME);
+  while (in.HasMore()) {
+    storage::LogRecord *log_record = ReadNextRecord(&in);
+    if (log_record->RecordType() == LogRecordType::REDO && txns.count(log_record->TxnBegin()) > 0) {
+      auto *const redo = log_record->GetUnderlyingRecordBodyAs<storage::RedoRecord>();
+      const auto slot_it = std::find(slots.begin(), slots.end(), redo->GetTupleSlot());
+      ASSERT_NE(slot_it, slots.end());
+      const auto i = static_cast<uint32_t>(slot_it - slots.begin());
+      const auto *const entry = reinterpret_cast<const VarlenEntry *>(redo->Delta()->AccessWithNullCheck(0));
+      ASSERT_NE(entry, nullptr);
+      ASSERT_LT(num_read[i], values[i].size());
+      EXPECT_EQ(entry->StringView(), values[i][num_read[i]]);
+      num_read[i]++;
+    }
+    delete[] reinterpret_cast<byte *>(log_record);
+  }
+  for (uint32_t i = 0; i < sizes.size(); i++) EXPECT_EQ(num_read[i], values[i].size());
+
+  // the table can't be freed until after all GC on it is guaranteed to be done. The easy way to do that is to use a
+  // DeferredAction
+  db_main_->GetTransactionLayer()->GetDeferredActionManager()->RegisterDeferredAction([=]() { delete sql_table; });
+}
 }  // namespace terrier::storage
@@ -1,5 +1,10 @@
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <vector>
 
@@ -9,10 +14,13 @@
 #include "main/db_main.h"
 #include "storage/garbage_collector_thread.h"
 #include "storage/index/index_builder.h"
+#include "storage/recovery/checkpoint_manager.h"
 #include "storage/recovery/disk_log_provider.h"
 #include "storage/recovery/recovery_manager.h"
+#include "storage/recovery/replication_log_provider.h"
 #include "storage/sql_table.h"
 #include "storage/write_ahead_log/log_manager.h"
+#include "storage/write_ahead_log/log_segment_manifest.h"
 #include "test_util/catalog_test_util.h"
 #include "test_util/sql_table_test_util.h"
 #include "test_util/storage_test_util.h"
@@ -24,6 +32,7 @@
 // executions will read old test's data, and the cause of the errors will be hard to identify. Trust me it will drive
 // you nuts...
 #define LOG_FILE_NAME "./test.log"
+#define CHECKPOINT_DIR "./test_checkpoint"
 
 namespace terrier::storage {
 class RecoveryTests : public TerrierTest {
@@ -45,6 +54,9 @@ class RecoveryTests : public TerrierTest {
   common::ManagedPointer<catalog::Catalog> recovery_catalog_;
   common::ManagedPointer<common::DedicatedThreadRegistry> recovery_thread_registry_;
 
+  // Number of streams the original log is split into
+  uint32_t num_log_streams_ = 1;
+
   void SetUp() override {
     // Unlink log file incase one exists from previous test iteration
     unlink(LOG_FILE_NAME);
@@ -76,8 +88,17 @@ class RecoveryTests : public TerrierTest {
   }
 
   void TearDown() override {
-    // Delete log file
-    unlink(LOG_FILE_NAME);
+    RemoveLogFiles();
+    // Delete the checkpoint, if the test took one
+    CheckpointManager::CheckpointMetadata checkpoint;
+    if (CheckpointManager::ReadMetadata(CHECKPOINT_DIR, &checkpoint)) {
+      for (const auto &table : checkpoint.tables_) {
+        unlink(CheckpointManager::TableFilePath(CHECKPOINT_DIR, checkpoint.checkpoint_time_, table).c_str());
+        unlink(CheckpointManager::TupleSlotsFilePath(CHECKPOINT_DIR, checkpoint.checkpoint_time_, table).c_str());
+      }
+      unlink(CheckpointManager::MetadataFilePath(CHECKPOINT_DIR).c_str());
+      rmdir(CHECKPOINT_DIR);
+    }
   }
 
   catalog::IndexSchema DummyIndexSchema() {
@@ -171,6 +192,41 @@ class RecoveryTests : public TerrierTest {
     db_main_->GetGarbageCollectorThread()->StartGC();
   }
 
+  // Deletes the log files of every stream, along with their segments and catalog logs
+  void RemoveLogFiles() {
+    for (uint32_t i = 0; i < num_log_streams_; i++) {
+      const std::string log_file = LogManager::StreamFilePath(LOG_FILE_NAME, i);
+      LogSegmentManifest manifest(log_file);
+      for (uint64_t segment = 0; segment <= manifest.OpenSegment(); segment++)
+        unlink(LogSegmentManifest::SegmentFilePath(log_file, segment).c_str());
+      if (manifest.CatalogLog() != 0)
+        unlink(LogSegmentManifest::CatalogLogFilePath(log_file, manifest.CatalogLog()).c_str());
+      unlink(LogSegmentManifest::ManifestFilePath(log_file).c_str());
+    }
+  }
+
+  // Rebuilds the original system with its log split into the given number of streams, which rotate into segments of
+  // the given size if there is one
+  void SetUpLogStreams(const uint32_t num_log_streams, const uint64_t log_segment_size = 0) {
+    db_main_.reset();
+    num_log_streams_ = num_log_streams;
+    RemoveLogFiles();
+
+    db_main_ = terrier::DBMain::Builder()
+                   .SetLogFilePath(LOG_FILE_NAME)
+                   .SetNumLogStreams(num_log_streams)
+                   .SetLogSegmentSize(log_segment_size)
+                   .SetUseLogging(true)
+                   .SetUseGC(true)
+                   .SetUseGCThread(true)
+                   .SetUseCatalog(true)
+                   .Build();
+    txn_manager_ = db_main_->GetTransactionLayer()->GetTransactionManager();
+    log_manager_ = db_main_->GetLogManager();
+    block_store_ = db_main_->GetStorageLayer()->GetBlockStore();
+    catalog_ = db_main_->GetCatalogLayer()->GetCatalog();
+  }
+
   // Most tests do a single recovery pass into the recovery DBMain
   void SingleRecovery() {
     DiskLogProvider log_provider(LOG_FILE_NAME);
@@ -184,22 +240,39 @@ class RecoveryTests : public TerrierTest {
     recovery_manager.WaitForRecoveryToFinish();
   }
 
-  void RunTest(const LargeSqlTableTestConfiguration &config) {
+  void RunTest(const LargeSqlTableTestConfiguration &config, const bool checkpoint = false,
+               const bool truncate = false) {
     // Run workload
     auto *tested =
         new LargeSqlTableTestObject(config, txn_manager_.Get(), catalog_.Get(), block_store_.Get(), &generator_);
     tested->SimulateOltp(100, 4);
 
+    // Checkpoint halfway through, so that recovery has to load the checkpoint and replay the rest of the log on top
+    if (checkpoint) {
+      CheckpointManager checkpoint_manager(catalog_, txn_manager_,
+                                           db_main_->GetTransactionLayer()->GetTimestampManager(), 2);
+      const auto metadata = checkpoint_manager.TakeCheckpoint(CHECKPOINT_DIR);
+      // Everything but the catalog changes can then go from the log before the checkpoint
+      if (truncate) EXPECT_GT(log_manager_->TruncateLog(metadata.oldest_active_txn_), 0);
+      tested->SimulateOltp(100, 4);
+    }
+
     ShutdownAndRestartSystem();
 
-    // Instantiate recovery manager, and recover the tables.
-    DiskLogProvider log_provider{LOG_FILE_NAME};
-    RecoveryManager recovery_manager{common::ManagedPointer<AbstractLogProvider>(&log_provider),
+    // Instantiate recovery manager, and recover the tables from all of the log streams
+    std::vector<std::unique_ptr<DiskLogProvider>> log_providers;
+    std::vector<common::ManagedPointer<AbstractLogProvider>> log_provider_ptrs;
+    for (uint32_t i = 0; i < num_log_streams_; i++) {
+      log_providers.emplace_back(std::make_unique<DiskLogProvider>(LogManager::StreamFilePath(LOG_FILE_NAME, i)));
+      log_provider_ptrs.emplace_back(common::ManagedPointer<AbstractLogProvider>(log_providers.back().get()));
+    }
+    RecoveryManager recovery_manager{log_provider_ptrs,
                                      recovery_catalog_,
                                      recovery_txn_manager_,
                                      recovery_deferred_action_manager_,
                                      recovery_thread_registry_,
-                                     recovery_block_store_};
+                                     recovery_block_store_,
+                                     checkpoint ? CHECKPOINT_DIR : ""};
     recovery_manager.StartRecovery();
     recovery_manager.WaitForRecoveryToFinish();
 
@@ -283,6 +356,230 @@ TEST_F(RecoveryTests, MultiDatabaseTest) {
   RecoveryTests::RunTest(config);
 }
 
+// This test runs a workload with the log split into several streams, one per worker thread. It then recovers the tables
+// from all of the streams, and verifies that the recovered tables are equal to the test tables.
+// NOLINTNEXTLINE
+TEST_F(RecoveryTests, MultiStreamTest) {
+  SetUpLogStreams(4);
+  LargeSqlTableTestConfiguration config = LargeSqlTableTestConfiguration::Builder()
+                                              .SetNumDatabases(1)
+                                              .SetNumTables(3)
+                                              .SetMaxColumns(5)
+                                              .SetInitialTableSize(1000)
+                                              .SetTxnLength(5)
+                                              .SetInsertUpdateSelectDeleteRatio({0.2, 0.5, 0.2, 0.1})
+                                              .SetVarlenAllowed(true)
+                                              .Build();
+  RecoveryTests::RunTest(config);
+}
+
+// This test crashes one of two log streams in the middle of a flush, so that it loses a txn that inserts a tuple while
+// the other stream still holds the txn that updates the tuple. Recovery has to leave out the update too, instead of
+// replaying it onto a tuple that was never inserted.
+// NOLINTNEXTLINE
+TEST_F(RecoveryTests, TruncatedStreamTest) {
+  SetUpLogStreams(2);
+  std::string database_name = "testdb";
+  auto namespace_oid = catalog::postgres::NAMESPACE_DEFAULT_NAMESPACE_OID;
+
+  // Create database and table, and make them durable
+  auto *txn = txn_manager_->BeginTransaction();
+  auto db_oid = CreateDatabase(txn, catalog_, database_name);
+  auto db_catalog = catalog_->GetDatabaseCatalog(common::ManagedPointer(txn), db_oid);
+  auto table_oid = CreateTable(txn, db_catalog, namespace_oid, "testtable");
+  auto table_ptr = db_catalog->GetTable(common::ManagedPointer(txn), table_oid);
+  const auto col_oid = db_catalog->GetSchema(common::ManagedPointer(txn), table_oid).GetColumn(0).Oid();
+  txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  log_manager_->ForceFlush();
+  auto initializer = table_ptr->InitializerForProjectedRow({col_oid});
+  std::vector<off_t> flushed_sizes;
+  for (uint32_t i = 0; i < num_log_streams_; i++) {
+    struct stat log_stat;
+    ASSERT_EQ(0, stat(LogManager::StreamFilePath(LOG_FILE_NAME, i).c_str(), &log_stat));
+    flushed_sizes.push_back(log_stat.st_size);
+  }
+
+  // Insert a tuple on one stream, then update it from a thread that logs to the other stream
+  uint32_t insert_stream = 0;
+  TupleSlot slot;
+  std::thread([&] {
+    insert_stream = log_manager_->StreamForCurrentThread();
+    auto *insert_txn = txn_manager_->BeginTransaction();
+    auto *redo_record = insert_txn->StageWrite(db_oid, table_oid, initializer);
+    *reinterpret_cast<int32_t *>(redo_record->Delta()->AccessForceNotNull(0)) = 1;
+    slot = table_ptr->Insert(common::ManagedPointer(insert_txn), redo_record);
+    txn_manager_->Commit(insert_txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  }).join();
+  // Threads are handed out to the streams in turn, so one of the next few threads logs to the other stream
+  bool updated = false;
+  while (!updated) {
+    std::thread([&] {
+      if (log_manager_->StreamForCurrentThread() == insert_stream) return;
+      auto *update_txn = txn_manager_->BeginTransaction();
+      auto *redo_record = update_txn->StageWrite(db_oid, table_oid, initializer);
+      *reinterpret_cast<int32_t *>(redo_record->Delta()->AccessForceNotNull(0)) = 2;
+      redo_record->SetTupleSlot(slot);
+      EXPECT_TRUE(table_ptr->Update(common::ManagedPointer(update_txn), redo_record));
+      txn_manager_->Commit(update_txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+      updated = true;
+    }).join();
+  }
+
+  // Shut down, and cut the stream of the insert back to what was flushed before it, as if the system crashed while the
+  // stream was flushing the insert
+  db_main_->GetGarbageCollectorThread()->StopGC();
+  db_main_->GetTransactionLayer()->GetDeferredActionManager()->FullyPerformGC(
+      db_main_->GetStorageLayer()->GetGarbageCollector(), log_manager_);
+  log_manager_->PersistAndStop();
+  EXPECT_EQ(0, truncate(LogManager::StreamFilePath(LOG_FILE_NAME, insert_stream).c_str(),
+                        flushed_sizes[insert_stream]));
+
+  // Recover from both streams
+  std::vector<std::unique_ptr<DiskLogProvider>> log_providers;
+  std::vector<common::ManagedPointer<AbstractLogProvider>> log_provider_ptrs;
+  for (uint32_t i = 0; i < num_log_streams_; i++) {
+    log_providers.emplace_back(std::make_unique<DiskLogProvider>(LogManager::StreamFilePath(LOG_FILE_NAME, i)));
+    log_provider_ptrs.emplace_back(common::ManagedPointer<AbstractLogProvider>(log_providers.back().get()));
+  }
+  RecoveryManager recovery_manager{log_provider_ptrs,
+                                   recovery_catalog_,
+                                   recovery_txn_manager_,
+                                   recovery_deferred_action_manager_,
+                                   recovery_thread_registry_,
+                                   recovery_block_store_};
+  recovery_manager.StartRecovery();
+  recovery_manager.WaitForRecoveryToFinish();
+  log_manager_->Start();
+  db_main_->GetGarbageCollectorThread()->StartGC();
+
+  // The table made it, but neither the insert nor the update that depends on it did
+  txn = recovery_txn_manager_->BeginTransaction();
+  db_catalog = recovery_catalog_->GetDatabaseCatalog(common::ManagedPointer(txn), db_oid);
+  ASSERT_TRUE(db_catalog != nullptr);
+  auto recovered_table = db_catalog->GetTable(common::ManagedPointer(txn), table_oid);
+  ASSERT_TRUE(recovered_table != nullptr);
+  auto *buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedRowSize());
+  auto *row = initializer.InitializeRow(buffer);
+  int32_t num_tuples = 0;
+  for (auto it = recovered_table->begin(); it != recovered_table->end(); it++) {
+    if (recovered_table->Select(common::ManagedPointer(txn), *it, row)) num_tuples++;
+  }
+  EXPECT_EQ(0, num_tuples);
+  delete[] buffer;
+  recovery_txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+}
+
+// This test takes a checkpoint in the middle of a workload over multiple tables. It then recovers the tables from the
+// checkpoint and the log written after it, and verifies that the recovered tables are equal to the test tables.
+// NOLINTNEXTLINE
+TEST_F(RecoveryTests, CheckpointTest) {
+  LargeSqlTableTestConfiguration config = LargeSqlTableTestConfiguration::Builder()
+                                              .SetNumDatabases(2)
+                                              .SetNumTables(3)
+                                              .SetMaxColumns(5)
+                                              .SetInitialTableSize(1000)
+                                              .SetTxnLength(5)
+                                              .SetInsertUpdateSelectDeleteRatio({0.2, 0.5, 0.2, 0.1})
+                                              .SetVarlenAllowed(true)
+                                              .Build();
+  RecoveryTests::RunTest(config, true);
+}
+
+// This test truncates the log after a checkpoint, so that the catalog changes from before it are only left in the
+// catalog log. It then recovers the tables from the checkpoint, the catalog log and the rest of the log, and verifies
+// that the recovered tables are equal to the test tables.
+// NOLINTNEXTLINE
+TEST_F(RecoveryTests, CheckpointTruncateTest) {
+  SetUpLogStreams(1, common::Constants::LOG_BUFFER_SIZE);
+  LargeSqlTableTestConfiguration config = LargeSqlTableTestConfiguration::Builder()
+                                              .SetNumDatabases(2)
+                                              .SetNumTables(3)
+                                              .SetMaxColumns(5)
+                                              .SetInitialTableSize(1000)
+                                              .SetTxnLength(5)
+                                              .SetInsertUpdateSelectDeleteRatio({0.2, 0.5, 0.2, 0.1})
+                                              .SetVarlenAllowed(true)
+                                              .Build();
+  RecoveryTests::RunTest(config, true, true);
+}
+
+// Tests that the indexes on user tables, which are only filled once replay is done, hold exactly the tuples left after
+// inserts, updates and deletes spread over many txns are replayed concurrently.
+// NOLINTNEXTLINE
+TEST_F(RecoveryTests, IndexRebuildTest) {
+  std::string database_name = "testdb";
+  auto namespace_oid = catalog::postgres::NAMESPACE_DEFAULT_NAMESPACE_OID;
+  const int32_t num_keys = 1000;
+
+  // Create database, table and a unique index on it
+  auto *txn = txn_manager_->BeginTransaction();
+  auto db_oid = CreateDatabase(txn, catalog_, database_name);
+  auto db_catalog = catalog_->GetDatabaseCatalog(common::ManagedPointer(txn), db_oid);
+  auto table_oid = CreateTable(txn, db_catalog, namespace_oid, "testtable");
+  auto index_oid = CreateIndex(txn, db_catalog, namespace_oid, table_oid, "testindex");
+  txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+
+  // Insert every key in its own txn, then delete the even keys and move the odd keys above num_keys
+  txn = txn_manager_->BeginTransaction();
+  db_catalog = catalog_->GetDatabaseCatalog(common::ManagedPointer(txn), db_oid);
+  auto table_ptr = db_catalog->GetTable(common::ManagedPointer(txn), table_oid);
+  const auto &schema = db_catalog->GetSchema(common::ManagedPointer(txn), table_oid);
+  auto initializer = table_ptr->InitializerForProjectedRow({schema.GetColumn(0).Oid()});
+  txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  std::vector<TupleSlot> slots;
+  for (int32_t key = 0; key < num_keys; key++) {
+    txn = txn_manager_->BeginTransaction();
+    auto *redo_record = txn->StageWrite(db_oid, table_oid, initializer);
+    *reinterpret_cast<int32_t *>(redo_record->Delta()->AccessForceNotNull(0)) = key;
+    slots.push_back(table_ptr->Insert(common::ManagedPointer(txn), redo_record));
+    txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  }
+  for (int32_t key = 0; key < num_keys; key++) {
+    txn = txn_manager_->BeginTransaction();
+    if (key % 2 == 0) {
+      txn->StageDelete(db_oid, table_oid, slots[key]);
+      EXPECT_TRUE(table_ptr->Delete(common::ManagedPointer(txn), slots[key]));
+    } else {
+      auto *redo_record = txn->StageWrite(db_oid, table_oid, initializer);
+      *reinterpret_cast<int32_t *>(redo_record->Delta()->AccessForceNotNull(0)) = key + num_keys;
+      redo_record->SetTupleSlot(slots[key]);
+      EXPECT_TRUE(table_ptr->Update(common::ManagedPointer(txn), redo_record));
+    }
+    txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  }
+
+  ShutdownAndRestartSystem();
+
+  // Recover on more workers than the default
+  DiskLogProvider log_provider(LOG_FILE_NAME);
+  RecoveryManager recovery_manager{common::ManagedPointer<AbstractLogProvider>(&log_provider),
+                                   recovery_catalog_,
+                                   recovery_txn_manager_,
+                                   recovery_deferred_action_manager_,
+                                   recovery_thread_registry_,
+                                   recovery_block_store_,
+                                   "",
+                                   8};
+  recovery_manager.StartRecovery();
+  recovery_manager.WaitForRecoveryToFinish();
+
+  // Only the updated keys are in the index
+  txn = recovery_txn_manager_->BeginTransaction();
+  db_catalog = recovery_catalog_->GetDatabaseCatalog(common::ManagedPointer(txn), db_oid);
+  auto index = db_catalog->GetIndex(common::ManagedPointer(txn), index_oid);
+  ASSERT_TRUE(index != nullptr);
+  auto *buffer = common::AllocationUtil::AllocateAligned(index->GetProjectedRowInitializer().ProjectedRowSize());
+  auto *key_pr = index->GetProjectedRowInitializer().InitializeRow(buffer);
+  for (int32_t key = 0; key < 2 * num_keys; key++) {
+    *reinterpret_cast<int32_t *>(key_pr->AccessForceNotNull(0)) = key;
+    std::vector<TupleSlot> results;
+    index->ScanKey(*txn, *key_pr, &results);
+    EXPECT_EQ(key >= num_keys && key % 2 == 1 ? 1 : 0, results.size());
+  }
+  delete[] buffer;
+  recovery_txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+}
+
 // Tests that we correctly process records corresponding to a drop database command.
 // NOLINTNEXTLINE
 TEST_F(RecoveryTests, DropDatabaseTest) {
@@ -768,4 +1065,213 @@ TEST_F(RecoveryTests, DoubleRecoveryTest) {
       [=]() { unlink(secondary_log_file.c_str()); });
 }
 
+// This test ships the log to a replica over a socketpair while a workload runs on the primary. The replica replays it
+// as it comes in, and ends up with the same tables as the primary.
+// NOLINTNEXTLINE
+TEST_F(RecoveryTests, ReplicationTest) {
+  LargeSqlTableTestConfiguration config = LargeSqlTableTestConfiguration::Builder()
+                                              .SetNumDatabases(1)
+                                              .SetNumTables(2)
+                                              .SetMaxColumns(5)
+                                              .SetInitialTableSize(1000)
+                                              .SetTxnLength(5)
+                                              .SetInsertUpdateSelectDeleteRatio({0.2, 0.5, 0.2, 0.1})
+                                              .SetVarlenAllowed(true)
+                                              .Build();
+  int sockets[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+
+  // The replica has to be reading before the primary starts shipping, which begins with the log it wrote while
+  // bootstrapping. Small batches and a small window make the workload only go through if the replica keeps up.
+  ReplicationLogProvider log_provider(sockets[1]);
+  RecoveryManager replica{common::ManagedPointer<AbstractLogProvider>(&log_provider),
+                          recovery_catalog_,
+                          recovery_txn_manager_,
+                          recovery_deferred_action_manager_,
+                          recovery_thread_registry_,
+                          recovery_block_store_};
+  replica.StartRecovery();
+  log_manager_->PersistAndStop();
+  log_manager_->SetReplicas({sockets[0]}, 4096, 1 << 16);
+  log_manager_->Start();
+
+  auto *tested =
+      new LargeSqlTableTestObject(config, txn_manager_.Get(), catalog_.Get(), block_store_.Get(), &generator_);
+  tested->SimulateOltp(100, 4);
+
+  // Stopping the log manager ships everything that is durable, and closing the socket ends the replica's log
+  db_main_->GetGarbageCollectorThread()->StopGC();
+  db_main_->GetTransactionLayer()->GetDeferredActionManager()->FullyPerformGC(
+      db_main_->GetStorageLayer()->GetGarbageCollector(), log_manager_);
+  log_manager_->PersistAndStop();
+  shutdown(sockets[0], SHUT_WR);
+  replica.WaitForRecoveryToFinish();
+
+  // The replica read the whole log file
+  struct stat log_stat;
+  ASSERT_EQ(stat(LOG_FILE_NAME, &log_stat), 0);
+  EXPECT_EQ(log_provider.BytesRead(), static_cast<uint64_t>(log_stat.st_size));
+
+  for (auto &database : tested->GetTables()) {
+    auto database_oid = database.first;
+    for (auto &table_oid : database.second) {
+      auto original_txn = txn_manager_->BeginTransaction();
+      auto original_sql_table = catalog_->GetDatabaseCatalog(common::ManagedPointer(original_txn), database_oid)
+                                    ->GetTable(common::ManagedPointer(original_txn), table_oid);
+
+      auto *replica_txn = recovery_txn_manager_->BeginTransaction();
+      auto db_catalog = recovery_catalog_->GetDatabaseCatalog(common::ManagedPointer(replica_txn), database_oid);
+      EXPECT_TRUE(db_catalog != nullptr);
+      auto replicated_sql_table = db_catalog->GetTable(common::ManagedPointer(replica_txn), table_oid);
+      EXPECT_TRUE(replicated_sql_table != nullptr);
+
+      EXPECT_TRUE(StorageTestUtil::SqlTableEqualDeep(
+          GetBlockLayout(original_sql_table), original_sql_table, replicated_sql_table,
+          tested->GetTupleSlotsForTable(database_oid, table_oid), replica.tuple_slot_map_, txn_manager_.Get(),
+          recovery_txn_manager_.Get()));
+      txn_manager_->Commit(original_txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+      recovery_txn_manager_->Commit(replica_txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+    }
+  }
+
+  // Back to logging without a replica, so that the system shuts down as usual
+  log_manager_->SetReplicas({});
+  log_manager_->Start();
+  db_main_->GetGarbageCollectorThread()->StartGC();
+  close(sockets[0]);
+  close(sockets[1]);
+  db_main_->GetTransactionLayer()->GetDeferredActionManager()->RegisterDeferredAction([=]() { delete tested; });
+}
+
+// Serves reads on a replica while it replays the log shipped by the primary. Every txn of the primary moves a key from
+// a table with a unique index to a table without one, and adds a new key to the first. Snapshots on the replica must
+// never see half of a txn, and the index has to agree with the table at every snapshot.
+// NOLINTNEXTLINE
+TEST_F(RecoveryTests, ReplicaReadTest) {
+  auto namespace_oid = catalog::postgres::NAMESPACE_DEFAULT_NAMESPACE_OID;
+  const int32_t num_keys = 200;
+  int sockets[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+
+  ReplicationLogProvider log_provider(sockets[1]);
+  RecoveryManager replica{common::ManagedPointer<AbstractLogProvider>(&log_provider),
+                          recovery_catalog_,
+                          recovery_txn_manager_,
+                          recovery_deferred_action_manager_,
+                          recovery_thread_registry_,
+                          recovery_block_store_};
+  replica.ServeReads();
+  replica.StartRecovery();
+  log_manager_->PersistAndStop();
+  log_manager_->SetReplicas({sockets[0]}, 4096, 1 << 16);
+  log_manager_->Start();
+
+  // Create the database, both tables and the index, and fill the first table, all in one txn
+  auto *txn = txn_manager_->BeginTransaction();
+  auto db_oid = CreateDatabase(txn, catalog_, "testdb");
+  auto db_catalog = catalog_->GetDatabaseCatalog(common::ManagedPointer(txn), db_oid);
+  auto keys_oid = CreateTable(txn, db_catalog, namespace_oid, "keys");
+  auto index_oid = CreateIndex(txn, db_catalog, namespace_oid, keys_oid, "keys_index");
+  auto moved_oid = CreateTable(txn, db_catalog, namespace_oid, "moved");
+  auto keys_table = db_catalog->GetTable(common::ManagedPointer(txn), keys_oid);
+  auto moved_table = db_catalog->GetTable(common::ManagedPointer(txn), moved_oid);
+  const auto col_oid = db_catalog->GetSchema(common::ManagedPointer(txn), keys_oid).GetColumn(0).Oid();
+  auto initializer = keys_table->InitializerForProjectedRow({col_oid});
+  const auto insert = [&](transaction::TransactionContext *const insert_txn, const catalog::table_oid_t table_oid,
+                          const common::ManagedPointer<SqlTable> table, const int32_t key) {
+    auto *redo_record = insert_txn->StageWrite(db_oid, table_oid, initializer);
+    *reinterpret_cast<int32_t *>(redo_record->Delta()->AccessForceNotNull(0)) = key;
+    return table->Insert(common::ManagedPointer(insert_txn), redo_record);
+  };
+  std::vector<TupleSlot> slots;
+  for (int32_t key = 0; key < num_keys; key++) slots.push_back(insert(txn, keys_oid, keys_table, key));
+  txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+
+  // Snapshots on the replica while it replays
+  std::atomic<bool> done = false;
+  std::atomic<uint32_t> num_snapshots = 0;
+  const auto check_snapshot = [&] {
+    transaction::timestamp_t watermark;
+    auto *snapshot = replica.BeginSnapshotTransaction(&watermark);
+    auto replica_catalog = recovery_catalog_->GetDatabaseCatalog(common::ManagedPointer(snapshot), db_oid);
+    // The txn that creates everything may not have been replayed yet, but then nothing else has been either
+    if (replica_catalog == nullptr) {
+      recovery_txn_manager_->Commit(snapshot, transaction::TransactionUtil::EmptyCallback, nullptr);
+      return watermark;
+    }
+    auto replica_keys = replica_catalog->GetTable(common::ManagedPointer(snapshot), keys_oid);
+    auto replica_moved = replica_catalog->GetTable(common::ManagedPointer(snapshot), moved_oid);
+    auto replica_index = replica_catalog->GetIndex(common::ManagedPointer(snapshot), index_oid);
+    EXPECT_TRUE(replica_keys != nullptr && replica_moved != nullptr && replica_index != nullptr);
+    auto replica_initializer = replica_keys->InitializerForProjectedRow({col_oid});
+    auto *buffer = common::AllocationUtil::AllocateAligned(replica_initializer.ProjectedRowSize());
+    auto *row = replica_initializer.InitializeRow(buffer);
+    auto *key_buffer =
+        common::AllocationUtil::AllocateAligned(replica_index->GetProjectedRowInitializer().ProjectedRowSize());
+    auto *key_pr = replica_index->GetProjectedRowInitializer().InitializeRow(key_buffer);
+
+    // Every key in the first table is in the index with its tuple, and every key moved out of it is in the other one
+    int32_t num_keys_left = 0, num_original_keys_left = 0, num_moved = 0;
+    for (auto it = replica_keys->begin(); it != replica_keys->end(); it++) {
+      if (!replica_keys->Select(common::ManagedPointer(snapshot), *it, row)) continue;
+      const auto key = *reinterpret_cast<int32_t *>(row->AccessWithNullCheck(0));
+      num_keys_left++;
+      if (key < num_keys) num_original_keys_left++;
+      *reinterpret_cast<int32_t *>(key_pr->AccessForceNotNull(0)) = key;
+      std::vector<TupleSlot> results;
+      replica_index->ScanKey(*snapshot, *key_pr, &results);
+      EXPECT_EQ(results, std::vector<TupleSlot>{*it});
+    }
+    for (auto it = replica_moved->begin(); it != replica_moved->end(); it++) {
+      if (replica_moved->Select(common::ManagedPointer(snapshot), *it, row)) num_moved++;
+    }
+    EXPECT_EQ(num_keys_left, num_keys);
+    EXPECT_EQ(num_original_keys_left + num_moved, num_keys);
+    delete[] key_buffer;
+    delete[] buffer;
+    recovery_txn_manager_->Commit(snapshot, transaction::TransactionUtil::EmptyCallback, nullptr);
+    num_snapshots++;
+    return watermark;
+  };
+  std::thread reader([&] {
+    auto last_watermark = transaction::INVALID_TXN_TIMESTAMP;
+    while (!done) {
+      const auto watermark = check_snapshot();
+      EXPECT_GE(watermark, last_watermark);
+      last_watermark = watermark;
+    }
+  });
+
+  // Move every original key, one per txn
+  auto last_commit_time = transaction::INVALID_TXN_TIMESTAMP;
+  for (int32_t key = 0; key < num_keys; key++) {
+    txn = txn_manager_->BeginTransaction();
+    txn->StageDelete(db_oid, keys_oid, slots[key]);
+    EXPECT_TRUE(keys_table->Delete(common::ManagedPointer(txn), slots[key]));
+    insert(txn, moved_oid, moved_table, key);
+    insert(txn, keys_oid, keys_table, key + num_keys);
+    last_commit_time = txn_manager_->Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  }
+
+  db_main_->GetGarbageCollectorThread()->StopGC();
+  db_main_->GetTransactionLayer()->GetDeferredActionManager()->FullyPerformGC(
+      db_main_->GetStorageLayer()->GetGarbageCollector(), log_manager_);
+  log_manager_->PersistAndStop();
+  shutdown(sockets[0], SHUT_WR);
+  replica.WaitForRecoveryToFinish();
+  done = true;
+  reader.join();
+
+  // Once the whole log is replayed, the watermark covers every commit, and the last snapshot sees all of them
+  EXPECT_GT(replica.ReplayedWatermark(), last_commit_time);
+  check_snapshot();
+  EXPECT_GT(num_snapshots, 0);
+
+  log_manager_->SetReplicas({});
+  log_manager_->Start();
+  db_main_->GetGarbageCollectorThread()->StartGC();
+  close(sockets[0]);
+  close(sockets[1]);
+}
+
 }  // namespace terrier::storage
@@ -0,0 +1,51 @@
+#include "storage/sql_table.h"
+
+#include <vector>
+
+#include "catalog/schema.h"
+#include "parser/expression/constant_value_expression.h"
+#include "test_util/storage_test_util.h"
+#include "test_util/test_harness.h"
+#include "type/transient_value_factory.h"
+
+namespace terrier {
+struct SqlTableTests : public TerrierTest {
+  storage::BlockStore block_store_{100, 100};
+
+  catalog::Schema MakeSchema() {
+    std::vector<catalog::Schema::Column> columns;
+    columns.emplace_back("a", type::TypeId::INTEGER, false,
+                         parser::ConstantValueExpression(type::TransientValueFactory::GetNull(type::TypeId::INTEGER)));
+    columns.emplace_back("b", type::TypeId::VARCHAR, 100, true,
+                         parser::ConstantValueExpression(type::TransientValueFactory::GetNull(type::TypeId::VARCHAR)));
+    columns.emplace_back("c", type::TypeId::BIGINT, false,
+                         parser::ConstantValueExpression(type::TransientValueFactory::GetNull(type::TypeId::BIGINT)));
+    for (uint32_t i = 0; i < columns.size(); i++) StorageTestUtil::ForceOid(&columns[i], catalog::col_oid_t(i + 1));
+    return catalog::Schema(columns);
+  }
+};
+
+// Tests that initializers and projection maps are only computed once per list of columns
+// NOLINTNEXTLINE
+TEST_F(SqlTableTests, CachedProjections) {
+  storage::SqlTable table(common::ManagedPointer<storage::BlockStore>(&block_store_), MakeSchema());
+  const std::vector<catalog::col_oid_t> col_oids = {catalog::col_oid_t(3), catalog::col_oid_t(1)};
+  const std::vector<catalog::col_oid_t> other_col_oids = {catalog::col_oid_t(2)};
+
+  const auto &row_initializer = table.InitializerForProjectedRow(col_oids);
+  EXPECT_EQ(row_initializer.NumColumns(), 2);
+  EXPECT_EQ(&table.InitializerForProjectedRow(col_oids), &row_initializer);
+  EXPECT_NE(&table.InitializerForProjectedRow(other_col_oids), &row_initializer);
+
+  const auto &projection_map = table.ProjectionMapForOids(col_oids);
+  EXPECT_EQ(projection_map.size(), 2);
+  EXPECT_EQ(&table.ProjectionMapForOids(col_oids), &projection_map);
+
+  // Initializers for different numbers of tuples are separate
+  const auto &columns_initializer = table.InitializerForProjectedColumns(col_oids, 10);
+  EXPECT_EQ(columns_initializer.MaxTuples(), 10);
+  EXPECT_EQ(&table.InitializerForProjectedColumns(col_oids, 10), &columns_initializer);
+  EXPECT_EQ(table.InitializerForProjectedColumns(col_oids, 20).MaxTuples(), 20);
+  EXPECT_EQ(&table.InitializerForProjectedColumns(col_oids, 10), &columns_initializer);
+}
+}  // namespace terrier
@@ -0,0 +1,49 @@
+#include "storage/varlen_arena.h"
+
+#include <cstring>
+#include <random>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "test_util/storage_test_util.h"
+#include "test_util/test_harness.h"
+
+namespace terrier {
+// Tests that varlens allocated from the arena hold their contents, and that a slab goes away once all of its varlens
+// are freed and its thread is done with it
+// NOLINTNEXTLINE
+TEST(VarlenArenaTests, SlabReclamation) {
+  std::default_random_engine generator;
+  std::uniform_int_distribution<uint32_t> size_dist(storage::VarlenEntry::InlineThreshold() + 1,
+                                                    storage::VarlenArena::MAX_CLASS_SIZE);
+  const uint64_t num_slabs = storage::VarlenArena::NumSlabs();
+  std::vector<std::pair<byte *, std::vector<byte>>> allocated;
+
+  // Allocate on a separate thread, so its slabs are given up when the thread exits
+  std::thread allocator([&] {
+    for (uint32_t i = 0; i < 10000; i++) {
+      const uint32_t size = size_dist(generator);
+      byte *varlen = storage::VarlenArena::Allocate(size);
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(varlen) % 8, 0);
+      std::vector<byte> expected(size);
+      StorageTestUtil::FillWithRandomBytes(size, expected.data(), &generator);
+      std::memcpy(varlen, expected.data(), size);
+      allocated.emplace_back(varlen, std::move(expected));
+    }
+  });
+  allocator.join();
+  EXPECT_GT(storage::VarlenArena::NumSlabs(), num_slabs);
+
+  for (auto &entry : allocated) {
+    EXPECT_EQ(std::memcmp(entry.first, entry.second.data(), entry.second.size()), 0);
+    storage::VarlenArena::Free(entry.first);
+  }
+  EXPECT_EQ(storage::VarlenArena::NumSlabs(), num_slabs);
+
+  // Buffers that did not come from the arena are freed as usual
+  storage::VarlenArena::Free(storage::VarlenArena::Allocate(storage::VarlenArena::MAX_CLASS_SIZE + 1));
+  storage::VarlenArena::Free(common::AllocationUtil::AllocateAligned(100));
+  EXPECT_EQ(storage::VarlenArena::NumSlabs(), num_slabs);
+}
+}  // namespace terrier
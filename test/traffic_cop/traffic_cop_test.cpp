@@ -130,6 +130,23 @@ TEST_F(TrafficCopTests, BadBindingTest) {
   }
 }
 
+// NOLINTNEXTLINE
+TEST_F(TrafficCopTests, ReadOnlyWriteTest) {
+  try {
+    pqxx::connection connection(fmt::format("host=127.0.0.1 port={0} user={1} sslmode=disable application_name=psql",
+                                            port_, catalog::DEFAULT_DATABASE));
+
+    pqxx::nontransaction txn1(connection);
+    txn1.exec("BEGIN READ ONLY;");
+    pqxx::result r = txn1.exec("CREATE TABLE FOO (ID INT);");
+    EXPECT_TRUE(false);
+  } catch (const std::exception &e) {
+    std::string error(e.what());
+    std::string expect("ERROR:  cannot execute statement in a read-only transaction\n");
+    EXPECT_EQ(error, expect);
+  }
+}
+
 // NOLINTNEXTLINE
 TEST_F(TrafficCopTests, DISABLED_BasicTest) {
   try {
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -241,4 +242,68 @@ TEST_F(DeferredActionsTest, CommitBootstrapDefer) {
   EXPECT_TRUE(defer1);
   EXPECT_TRUE(defer2);
 }
+
+// Test that a chunked action gets a slice of work per GC pass without workers, and does not hold up cheap actions
+// NOLINTNEXTLINE
+TEST_F(DeferredActionsTest, ChunkedDefer) {
+  uint32_t chunks = 0;
+  bool cheap = false;
+  deferred_action_manager_->RegisterChunkedDeferredAction([&](transaction::timestamp_t /*unused*/) {
+    return ++chunks == 3;
+  });
+  deferred_action_manager_->RegisterDeferredAction([&]() { cheap = true; });
+
+  // The chunked action is handed off on the first pass, and sliced over the following ones
+  gc_->PerformGarbageCollection();
+  EXPECT_EQ(chunks, 0);
+  EXPECT_TRUE(cheap);
+  EXPECT_EQ(deferred_action_manager_->ExpensiveActionsInFlight(), 1);
+
+  gc_->PerformGarbageCollection();
+  EXPECT_EQ(chunks, 1);
+  gc_->PerformGarbageCollection();
+  EXPECT_EQ(chunks, 2);
+  EXPECT_EQ(deferred_action_manager_->ExpensiveActionsInFlight(), 1);
+  gc_->PerformGarbageCollection();
+  EXPECT_EQ(chunks, 3);
+  EXPECT_EQ(deferred_action_manager_->ExpensiveActionsInFlight(), 0);
+
+  gc_->PerformGarbageCollection();
+  EXPECT_EQ(chunks, 3);
+}
+
+// Test that expensive actions run on the workers, and that fully performing GC waits for them to finish
+// NOLINTNEXTLINE
+TEST_F(DeferredActionsTest, ExpensiveDeferOnWorkers) {
+  storage::RecordBufferSegmentPool buffer_pool{10000, 10000};
+  transaction::TimestampManager timestamp_manager;
+  transaction::DeferredActionManager deferred_action_manager{common::ManagedPointer(&timestamp_manager), 4};
+  transaction::TransactionManager txn_manager{common::ManagedPointer(&timestamp_manager),
+                                              common::ManagedPointer(&deferred_action_manager),
+                                              common::ManagedPointer(&buffer_pool), true, DISABLED};
+  storage::GarbageCollector gc{common::ManagedPointer(&timestamp_manager),
+                               common::ManagedPointer(&deferred_action_manager), common::ManagedPointer(&txn_manager),
+                               DISABLED};
+
+  const uint32_t num_actions = 16;
+  std::atomic<uint32_t> expensive = 0, chunks = 0;
+  for (uint32_t i = 0; i < num_actions; i++) {
+    deferred_action_manager.RegisterDeferredAction([&]() { expensive++; }, transaction::DeferredActionCost::EXPENSIVE);
+    deferred_action_manager.RegisterChunkedDeferredAction(
+        [&](transaction::timestamp_t /*unused*/) { return ++chunks % 4 == 0; });
+  }
+
+  // An action that is not yet safe is never handed off
+  auto *txn = txn_manager.BeginTransaction();
+  deferred_action_manager.RegisterDeferredAction([&]() { expensive++; }, transaction::DeferredActionCost::EXPENSIVE);
+  deferred_action_manager.FullyPerformGC(common::ManagedPointer(&gc), DISABLED);
+  EXPECT_EQ(expensive.load(), num_actions);
+  EXPECT_EQ(chunks.load(), 4 * num_actions);
+  EXPECT_EQ(deferred_action_manager.ExpensiveActionsInFlight(), 0);
+
+  txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  deferred_action_manager.FullyPerformGC(common::ManagedPointer(&gc), DISABLED);
+  EXPECT_EQ(expensive.load(), num_actions + 1);
+  EXPECT_EQ(deferred_action_manager.ExpensiveActionsInFlight(), 0);
+}
 }  // namespace terrier
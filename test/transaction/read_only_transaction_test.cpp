@@ -0,0 +1,98 @@
+#include <memory>
+#include <vector>
+
+#include "main/db_main.h"
+#include "storage/data_table.h"
+#include "storage/garbage_collector.h"
+#include "test_util/storage_test_util.h"
+#include "test_util/test_harness.h"
+#include "transaction/transaction_context.h"
+#include "transaction/transaction_manager.h"
+
+namespace terrier {
+
+class ReadOnlyTransactionTests : public TerrierTest {
+ protected:
+  void SetUp() override {
+    db_main_ = terrier::DBMain::Builder().SetUseGC(true).Build();
+    txn_manager_ = db_main_->GetTransactionLayer()->GetTransactionManager();
+    timestamp_manager_ = db_main_->GetTransactionLayer()->GetTimestampManager();
+    block_store_ = db_main_->GetStorageLayer()->GetBlockStore();
+    gc_ = db_main_->GetStorageLayer()->GetGarbageCollector();
+  }
+
+  std::unique_ptr<DBMain> db_main_;
+  common::ManagedPointer<transaction::TransactionManager> txn_manager_;
+  common::ManagedPointer<transaction::TimestampManager> timestamp_manager_;
+  common::ManagedPointer<storage::BlockStore> block_store_;
+  common::ManagedPointer<storage::GarbageCollector> gc_;
+  std::default_random_engine generator_;
+};
+
+// A read-only txn commits as of its start time, without going through the GC
+// NOLINTNEXTLINE
+TEST_F(ReadOnlyTransactionTests, CommitBypassesGC) {
+  auto *txn = txn_manager_->BeginTransaction(true);
+  EXPECT_TRUE(txn->IsDeclaredReadOnly());
+  const transaction::timestamp_t start_time = txn->StartTime();
+
+  bool committed = false;
+  const transaction::timestamp_t commit_time = txn_manager_->Commit(
+      txn, [](void *arg) { *reinterpret_cast<bool *>(arg) = true; }, &committed);
+
+  EXPECT_TRUE(committed);
+  EXPECT_EQ(commit_time, start_time);
+  EXPECT_EQ(txn_manager_->GetGCPressure().num_txns_, 0);
+  EXPECT_EQ(timestamp_manager_->OldestTransactionStartTime(), timestamp_manager_->CurrentTime());
+
+  txn = txn_manager_->BeginTransaction(true);
+  txn_manager_->Abort(txn);
+  EXPECT_EQ(txn_manager_->GetGCPressure().num_txns_, 0);
+  EXPECT_EQ(timestamp_manager_->OldestTransactionStartTime(), timestamp_manager_->CurrentTime());
+}
+
+// A read-only txn sees the snapshot as of its start time, and keeps the versions it needs from being gc-ed
+// NOLINTNEXTLINE
+TEST_F(ReadOnlyTransactionTests, ReadsSnapshot) {
+  storage::BlockLayout layout = StorageTestUtil::RandomLayoutNoVarlen(10, &generator_);
+  storage::DataTable table(block_store_, layout, storage::layout_version_t(0));
+  auto initializer =
+      storage::ProjectedRowInitializer::Create(layout, StorageTestUtil::ProjectionListAllColumns(layout));
+  byte *original_buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedRowSize());
+  byte *update_buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedRowSize());
+  byte *select_buffer = common::AllocationUtil::AllocateAligned(initializer.ProjectedRowSize());
+  storage::ProjectedRow *original = initializer.InitializeRow(original_buffer);
+  storage::ProjectedRow *update = initializer.InitializeRow(update_buffer);
+  storage::ProjectedRow *select = initializer.InitializeRow(select_buffer);
+  StorageTestUtil::PopulateRandomRow(original, layout, 0, &generator_);
+  StorageTestUtil::PopulateRandomRow(update, layout, 0, &generator_);
+
+  auto *writer = txn_manager_->BeginTransaction();
+  const storage::TupleSlot slot = table.Insert(common::ManagedPointer(writer), *original);
+  txn_manager_->Commit(writer, transaction::TransactionUtil::EmptyCallback, nullptr);
+
+  auto *reader = txn_manager_->BeginTransaction(true);
+
+  writer = txn_manager_->BeginTransaction();
+  EXPECT_TRUE(table.Update(common::ManagedPointer(writer), slot, *update));
+  txn_manager_->Commit(writer, transaction::TransactionUtil::EmptyCallback, nullptr);
+  gc_->PerformGarbageCollection();
+  gc_->PerformGarbageCollection();
+
+  EXPECT_TRUE(table.Select(common::ManagedPointer(reader), slot, select));
+  EXPECT_TRUE(StorageTestUtil::ProjectionListEqualShallow(layout, original, select));
+  txn_manager_->Commit(reader, transaction::TransactionUtil::EmptyCallback, nullptr);
+
+  auto *late_reader = txn_manager_->BeginTransaction(true);
+  EXPECT_TRUE(table.Select(common::ManagedPointer(late_reader), slot, select));
+  EXPECT_TRUE(StorageTestUtil::ProjectionListEqualShallow(layout, update, select));
+  txn_manager_->Commit(late_reader, transaction::TransactionUtil::EmptyCallback, nullptr);
+
+  gc_->PerformGarbageCollection();
+  gc_->PerformGarbageCollection();
+  delete[] original_buffer;
+  delete[] update_buffer;
+  delete[] select_buffer;
+}
+
+}  // namespace terrier
@@ -0,0 +1,115 @@
+#include "transaction/timestamp_manager.h"
+
+#include <vector>
+
+#include "common/worker_pool.h"
+#include "storage/garbage_collector.h"
+#include "test_util/multithread_test_util.h"
+#include "test_util/test_harness.h"
+#include "transaction/deferred_action_manager.h"
+#include "transaction/transaction_manager.h"
+
+namespace terrier {
+
+class TimestampManagerTests : public TerrierTest {
+ public:
+  storage::RecordBufferSegmentPool buffer_pool_{10000, 10000};
+  const uint32_t num_threads_ = MultiThreadTestUtil::HardwareConcurrency();
+  const uint32_t num_txns_ = 1000;
+};
+
+// The oldest running txn is the oldest txn that has not yet been removed, and the current time when there are none
+// NOLINTNEXTLINE
+TEST_F(TimestampManagerTests, OldestTransaction) {
+  transaction::TimestampManager timestamp_manager;
+  transaction::DeferredActionManager deferred_action_manager{common::ManagedPointer(&timestamp_manager)};
+  transaction::TransactionManager txn_manager{common::ManagedPointer(&timestamp_manager),
+                                              common::ManagedPointer(&deferred_action_manager),
+                                              common::ManagedPointer(&buffer_pool_), true, DISABLED};
+  storage::GarbageCollector gc{common::ManagedPointer(&timestamp_manager),
+                               common::ManagedPointer(&deferred_action_manager), common::ManagedPointer(&txn_manager),
+                               DISABLED};
+
+  // Enough txns to land in every shard more than once
+  std::vector<transaction::TransactionContext *> txns;
+  for (uint32_t i = 0; i < 2 * transaction::NUM_RUNNING_TXN_SHARDS; i++) txns.push_back(txn_manager.BeginTransaction());
+
+  for (auto *const txn : txns) {
+    EXPECT_EQ(timestamp_manager.OldestTransactionStartTime(), txn->StartTime());
+    EXPECT_EQ(timestamp_manager.CachedOldestTransactionStartTime(), txn->StartTime());
+    txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  }
+
+  const transaction::timestamp_t now = timestamp_manager.CurrentTime();
+  EXPECT_EQ(timestamp_manager.OldestTransactionStartTime(), now);
+
+  gc.PerformGarbageCollection();
+  gc.PerformGarbageCollection();
+}
+
+// The recent oldest running txn is only refreshed once enough timestamps have been checked out since the last refresh
+// NOLINTNEXTLINE
+TEST_F(TimestampManagerTests, RecentOldestTransaction) {
+  transaction::TimestampManager timestamp_manager;
+  transaction::DeferredActionManager deferred_action_manager{common::ManagedPointer(&timestamp_manager)};
+  transaction::TransactionManager txn_manager{common::ManagedPointer(&timestamp_manager),
+                                              common::ManagedPointer(&deferred_action_manager),
+                                              common::ManagedPointer(&buffer_pool_), true, DISABLED};
+  storage::GarbageCollector gc{common::ManagedPointer(&timestamp_manager),
+                               common::ManagedPointer(&deferred_action_manager), common::ManagedPointer(&txn_manager),
+                               DISABLED};
+
+  const transaction::timestamp_t refreshed = timestamp_manager.OldestTransactionStartTime();
+  auto *txn = txn_manager.BeginTransaction();
+  txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  auto *const old_txn = txn_manager.BeginTransaction();
+  const transaction::timestamp_t old_start_time = old_txn->StartTime();
+  EXPECT_NE(refreshed, old_start_time);
+
+  // Too few timestamps have been checked out since the refresh, so the running txns are not looked at
+  EXPECT_EQ(timestamp_manager.RecentOldestTransactionStartTime(), refreshed);
+  for (uint64_t i = 0; i < transaction::OLDEST_TXN_REFRESH_INTERVAL; i++) {
+    txn = txn_manager.BeginTransaction();
+    txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  }
+  EXPECT_EQ(timestamp_manager.RecentOldestTransactionStartTime(), old_start_time);
+
+  // The old txn is gone, but the refresh has only just happened
+  txn_manager.Commit(old_txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+  EXPECT_EQ(timestamp_manager.RecentOldestTransactionStartTime(), old_start_time);
+  EXPECT_EQ(timestamp_manager.OldestTransactionStartTime(), timestamp_manager.CurrentTime());
+
+  gc.PerformGarbageCollection();
+  gc.PerformGarbageCollection();
+}
+
+// The oldest running txn never moves past a txn that is still running, while other threads keep beginning and
+// committing txns
+// NOLINTNEXTLINE
+TEST_F(TimestampManagerTests, ConcurrentOldestTransaction) {
+  transaction::TimestampManager timestamp_manager;
+  transaction::DeferredActionManager deferred_action_manager{common::ManagedPointer(&timestamp_manager)};
+  transaction::TransactionManager txn_manager{common::ManagedPointer(&timestamp_manager),
+                                              common::ManagedPointer(&deferred_action_manager),
+                                              common::ManagedPointer(&buffer_pool_), true, DISABLED};
+  storage::GarbageCollector gc{common::ManagedPointer(&timestamp_manager),
+                               common::ManagedPointer(&deferred_action_manager), common::ManagedPointer(&txn_manager),
+                               DISABLED};
+
+  common::WorkerPool thread_pool(num_threads_, {});
+  auto workload = [&](uint32_t) {
+    for (uint32_t i = 0; i < num_txns_; i++) {
+      auto *const txn = txn_manager.BeginTransaction();
+      EXPECT_FALSE(transaction::TransactionUtil::NewerThan(timestamp_manager.OldestTransactionStartTime(),
+                                                           txn->StartTime()));
+      txn_manager.Commit(txn, transaction::TransactionUtil::EmptyCallback, nullptr);
+    }
+  };
+  MultiThreadTestUtil::RunThreadsUntilFinish(&thread_pool, num_threads_, workload);
+
+  EXPECT_EQ(timestamp_manager.OldestTransactionStartTime(), timestamp_manager.CurrentTime());
+  gc.PerformGarbageCollection();
+  gc.PerformGarbageCollection();
+}
+
+}  // namespace terrier